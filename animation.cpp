@@ -0,0 +1,570 @@
+/*======================================================================
+FILE:
+animation.cpp
+
+CREATOR:
+Sean Foley
+
+GENERAL DESCRIPTION:
+The animations, and the registry that holds them.
+
+PUBLIC CLASSES AND FUNCTIONS:
+AnimationFrame
+AnimationRegistry
+
+INITIALIZATION AND SEQUENCING REQUIREMENTS:
+None.
+
+Copyright (C) 2017 Sean Foley  All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted.  Enjoy.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+======================================================================*/
+
+//======================================================================
+// INCLUDES AND VARIABLE DEFINITIONS
+//======================================================================
+
+//----------------------------------------------------------------------
+// Defines
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Include Files
+//----------------------------------------------------------------------
+
+#include <string.h>
+
+#include <Adafruit_NeoPixel.h>
+
+#include "animation.h"
+#include "colorengine.h"
+
+//----------------------------------------------------------------------
+// Type Declarations
+//----------------------------------------------------------------------
+
+// The animations themselves.  These are only ever used through the
+// registry table below, so they don't need to be visible outside of
+// this file.
+
+// All of the pixels off
+class OffAnimation : public Animation
+{
+    public:
+
+    virtual const char *Name() const { return "off"; }
+    virtual void Render( AnimationFrame &frame, uint64_t t ) const;
+    virtual bool IsStatic() const { return true; }
+    virtual uint32_t DemoDurationMS() const { return 1000; }
+};
+
+// All of the pixels on with the frame color
+class OnAnimation : public Animation
+{
+    public:
+
+    virtual const char *Name() const { return "on"; }
+    virtual void Render( AnimationFrame &frame, uint64_t t ) const;
+    virtual bool IsStatic() const { return true; }
+
+    // Let's make it green
+    virtual uint32_t DemoColor() const { return Adafruit_NeoPixel::Color( 0, 255, 0, 0 ); }
+};
+
+// All of the pixels cycling thru the color wheel
+class ColorWheelAnimation : public Animation
+{
+    public:
+
+    virtual const char *Name() const { return "wheel"; }
+    virtual void Render( AnimationFrame &frame, uint64_t t ) const;
+};
+
+// All of the pixels ramping down and back up
+class PulseAnimation : public Animation
+{
+    public:
+
+    virtual const char *Name() const { return "pulse"; }
+    virtual void Render( AnimationFrame &frame, uint64_t t ) const;
+    virtual uint32_t DemoColor() const { return Adafruit_NeoPixel::Color( 255, 0, 0, 0 ); }
+};
+
+// All of the pixels alternating between bright and dim
+class StrobeAnimation : public Animation
+{
+    public:
+
+    virtual const char *Name() const { return "strobe"; }
+    virtual void Render( AnimationFrame &frame, uint64_t t ) const;
+    virtual uint32_t DemoColor() const { return Adafruit_NeoPixel::Color( 255, 255, 255, 255 ); }
+};
+
+// One random pixel at a time
+class FlickerAnimation : public Animation
+{
+    public:
+
+    virtual const char *Name() const { return "flicker"; }
+    virtual void Begin( AnimationFrame &frame ) const;
+    virtual void Render( AnimationFrame &frame, uint64_t t ) const;
+    virtual uint32_t DemoColor() const { return Adafruit_NeoPixel::Color( 0, 0, 255, 0 ); }
+};
+
+//----------------------------------------------------------------------
+// Global Constant Definitions
+//----------------------------------------------------------------------
+
+// How long (in microseconds) one full cycle of each animation takes.
+// These were picked to match what the animations used to look like
+// when they were stepped once per ~50ms loop() iteration.
+
+// Full ramp down and back up
+const uint32_t PULSE_PERIOD_US = 2500000UL;
+
+// One bright + one dim flash
+const uint32_t STROBE_PERIOD_US = 100000UL;
+
+// All the way around the 256 position color wheel
+const uint32_t WHEEL_PERIOD_US = 256UL * 50000UL;
+
+// How long a flicker pixel stays lit before we pick another one
+const uint32_t FLICKER_PERIOD_US = 50000UL;
+
+// Flicker::Begin() sets this as the step, so the first Render() always
+// picks a pixel
+const uint32_t FLICKER_NO_STEP = 0xFFFFFFFFUL;
+
+//----------------------------------------------------------------------
+// Global Data Definitions
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Static Variable Definitions 
+//----------------------------------------------------------------------
+
+static const OffAnimation s_off;
+static const OnAnimation s_on;
+static const ColorWheelAnimation s_colorWheel;
+static const PulseAnimation s_pulse;
+static const StrobeAnimation s_strobe;
+static const FlickerAnimation s_flicker;
+
+// Every animation we know about.  The order here is the order the 
+// demo plays them in.  To add an animation, add it here - the web 
+// server and the demo pick it up from this table.
+static const Animation * const s_animations[] =
+{
+    &s_off,
+    &s_on,
+    &s_colorWheel,
+    &s_pulse,
+    &s_strobe,
+    &s_flicker
+};
+
+static const uint32_t s_animationCount = sizeof( s_animations ) / sizeof( s_animations[0] );
+
+//----------------------------------------------------------------------
+// Function Prototypes
+//----------------------------------------------------------------------
+
+static uint32_t cyclePhase( uint64_t t, uint32_t periodUS );
+static uint32_t hash32( uint32_t x );
+
+//----------------------------------------------------------------------
+// Required Libraries
+//----------------------------------------------------------------------
+
+// None. (Where supported these should be in the form
+// of C++ pragmas).
+
+//======================================================================
+// FUNCTION IMPLEMENTATIONS
+//======================================================================
+
+/*======================================================================
+FUNCTION:
+C-tor()
+
+DESCRIPTION:
+Constructs an empty frame.  Attach() a pixel buffer before using it.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+AnimationFrame::AnimationFrame()
+    : _pixels( nullptr ), _pixelCount( 0 ), _generation( 1 ), _color( 0 )
+{
+    _context.seed = 0;
+    _context.step = 0;
+    _context.pixel = 0;
+}
+
+/*======================================================================
+FUNCTION:
+AnimationFrame::Attach()
+
+DESCRIPTION:
+Attaches the pixel buffer the frame renders into.  The buffer is owned
+by the caller and must outlive the frame.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void AnimationFrame::Attach( uint32_t *pixels, uint32_t pixelCount )
+{
+    _pixels = pixels;
+    _pixelCount = pixelCount;
+
+    // Whatever was in there before hasn't been displayed
+    _generation++;
+}
+
+/*======================================================================
+FUNCTION:
+AnimationRegistry::Count()
+
+DESCRIPTION:
+Number of animations in the registry
+
+RETURN VALUE:
+Number of animations
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+uint32_t AnimationRegistry::Count()
+{
+    return s_animationCount;
+}
+
+/*======================================================================
+FUNCTION:
+AnimationRegistry::Get()
+
+DESCRIPTION:
+Gets an animation from the registry by index
+
+RETURN VALUE:
+The animation, or nullptr if the index is out of range
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+const Animation *AnimationRegistry::Get( uint32_t index )
+{
+    if ( index >= s_animationCount )
+    {
+        return nullptr;
+    }
+
+    return s_animations[index];
+}
+
+/*======================================================================
+FUNCTION:
+AnimationRegistry::Find()
+
+DESCRIPTION:
+Looks up an animation by name.  The table is tiny, so a linear search
+is as fast as anything else.
+
+RETURN VALUE:
+Index of the animation, or NOT_FOUND
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+uint32_t AnimationRegistry::Find( const char *name )
+{
+    if ( name == nullptr )
+    {
+        return NOT_FOUND;
+    }
+
+    for ( uint32_t i = 0; i < s_animationCount; i++ )
+    {
+        if ( strcmp( s_animations[i]->Name(), name ) == 0 )
+        {
+            return i;
+        }
+    }
+
+    return NOT_FOUND;
+}
+
+/*======================================================================
+FUNCTION:
+cyclePhase()
+
+DESCRIPTION:
+Converts the time since the animation started into a phase within a
+cycle of periodUS.  One full cycle maps to the full 32 bit range, so
+the animations can do their math in fixed point.
+
+RETURN VALUE:
+Phase within the current cycle, 0..2^32-1
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+static uint32_t cyclePhase( uint64_t t, uint32_t periodUS )
+{
+    uint64_t intoCycle = t % periodUS;
+
+    return (uint32_t) ( ( intoCycle << 32 ) / periodUS );
+}
+
+/*======================================================================
+FUNCTION:
+hash32()
+
+DESCRIPTION:
+Small integer hash (the murmur3 finalizer).  Used instead of a random
+number generator so an animation's output only depends on its seed
+and t - rendering the same time twice gives the same pixels.
+
+RETURN VALUE:
+Hashed value
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+static uint32_t hash32( uint32_t x )
+{
+    x ^= x >> 16;
+    x *= 0x85EBCA6BUL;
+    x ^= x >> 13;
+    x *= 0xC2B2AE35UL;
+    x ^= x >> 16;
+
+    return x;
+}
+
+/*======================================================================
+FUNCTION:
+OffAnimation::Render()
+
+DESCRIPTION:
+Turns all of the pixels off
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void OffAnimation::Render( AnimationFrame &frame, uint64_t t ) const
+{
+    (void) t;
+
+    frame.Fill( 0 );
+}
+
+/*======================================================================
+FUNCTION:
+OnAnimation::Render()
+
+DESCRIPTION:
+Turns all of the pixels on with the frame color
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void OnAnimation::Render( AnimationFrame &frame, uint64_t t ) const
+{
+    (void) t;
+
+    frame.Fill( frame.GetColor() );
+}
+
+/*======================================================================
+FUNCTION:
+ColorWheelAnimation::Render()
+
+DESCRIPTION:
+Renders one frame of the color wheel animation.  The top 8 bits of
+the phase is the wheel position.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void ColorWheelAnimation::Render( AnimationFrame &frame, uint64_t t ) const
+{
+    uint32_t phase = cyclePhase( t, WHEEL_PERIOD_US );
+
+    frame.Fill( ColorEngine::Wheel( phase >> 24 ) );
+}
+
+/*======================================================================
+FUNCTION:
+PulseAnimation::Render()
+
+DESCRIPTION:
+Renders one frame of the pulse animation. The phase is turned into 
+a triangle wave so we ramp down from MAX to MIN, then ramp up from
+MIN to MAX.  This will give a nice pulsing effect.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void PulseAnimation::Render( AnimationFrame &frame, uint64_t t ) const
+{
+    // The min and max brightness levels.  These are perceptual
+    // levels since gamma is applied after them.
+    const uint8_t MIN = 72;
+    const uint8_t MAX = 255;
+
+    // Fold the top 16 bits of phase into a 0..65534 triangle wave
+    uint32_t phase = cyclePhase( t, PULSE_PERIOD_US ) >> 16;
+    uint32_t triangle = ( phase < 0x8000 ) ? ( phase << 1 ) : ( ( 0xFFFF - phase ) << 1 );
+
+    uint8_t level = MAX - ( ( ( MAX - MIN ) * triangle ) >> 16 );
+
+    frame.Fill( ColorEngine::Scale( frame.GetColor(), level ) );
+}
+
+/*======================================================================
+FUNCTION:
+StrobeAnimation::Render()
+
+DESCRIPTION:
+Renders one frame of the strobe animation.  The first half of the 
+cycle is bright, the second half is dim.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void StrobeAnimation::Render( AnimationFrame &frame, uint64_t t ) const
+{
+    // Min is 25% bright, max is 100%.  These are perceptual 
+    // levels since gamma is applied after them.
+    const uint8_t MIN = 150;
+    const uint8_t MAX = 255;
+
+    uint8_t level = ( cyclePhase( t, STROBE_PERIOD_US ) < 0x80000000UL ) ? MAX : MIN;
+
+    frame.Fill( ColorEngine::Scale( frame.GetColor(), level ) );
+}
+
+/*======================================================================
+FUNCTION:
+FlickerAnimation::Begin()
+
+DESCRIPTION:
+Turns all of the pixels off so we start from a known state.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void FlickerAnimation::Begin( AnimationFrame &frame ) const
+{
+    frame.Fill( 0 );
+
+    AnimationContext &context = frame.GetContext();
+
+    context.step = FLICKER_NO_STEP;
+    context.pixel = 0;
+}
+
+/*======================================================================
+FUNCTION:
+FlickerAnimation::Render()
+
+DESCRIPTION:
+Renders one frame of the flicker animation.  Every FLICKER_PERIOD_US
+a new random pixel is lit and the previous one is turned off.  The
+pixel for each step comes from hashing the step with the seed, so it
+only depends on t.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void FlickerAnimation::Render( AnimationFrame &frame, uint64_t t ) const
+{
+    AnimationContext &context = frame.GetContext();
+
+    uint32_t step = (uint32_t) ( t / FLICKER_PERIOD_US );
+
+    if ( step != context.step )
+    {
+        uint32_t previous = context.pixel;
+
+        context.step = step;
+        context.pixel = hash32( context.seed + step ) % frame.GetPixelCount();
+
+        // We may have picked the same pixel as the previous one, 
+        // so don't turn it off if that's the case.
+        if ( previous != context.pixel )
+        {
+            frame.SetPixel( previous, 0 );
+        }
+    }
+
+    // Always set it, so a color change shows up right away
+    frame.SetPixel( context.pixel, frame.GetColor() );
+}
+
+/*=====================================================================
+// IMPLEMENTATION NOTES
+//=====================================================================
+
+None
+
+=====================================================================*/
@@ -0,0 +1,402 @@
+#ifndef _JAROFLIGHT_ANIMATION_H_
+#define _JAROFLIGHT_ANIMATION_H_
+
+/*======================================================================
+FILE:
+animation.h
+
+CREATOR:
+Sean Foley
+
+DESCRIPTION:
+The animation interface, the frame animations render into, and the
+registry of all of the animations.
+
+PUBLIC CLASSES AND FUNCTIONS:
+AnimationContext
+AnimationFrame
+Animation
+AnimationRegistry
+
+Copyright (C) 2017 Sean Foley  All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted.  Enjoy.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+======================================================================*/
+
+//======================================================================
+// INCLUDES AND PUBLIC DATA DECLARATIONS
+//======================================================================
+
+//----------------------------------------------------------------------
+// Defines
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Include Files
+//----------------------------------------------------------------------
+
+#include <stdint.h>
+
+//----------------------------------------------------------------------
+// Type Declarations
+//----------------------------------------------------------------------
+
+// Scratch state an animation can carry from one frame to the next.
+// Each place an animation runs gets its own, so the animation objects
+// themselves stay stateless and can be shared.
+struct AnimationContext
+{
+    // Random seed for this run of the animation
+    uint32_t seed;
+
+    // Last discrete step rendered, for animations that change in steps
+    uint32_t step;
+
+    // Animation defined pixel index
+    uint32_t pixel;
+};
+
+//----------------------------------------------------------------------
+// Global Constant Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Data Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//======================================================================
+// WARNINGS!!!
+//======================================================================
+
+// None.
+
+//======================================================================
+// FUNCTION DECLARATIONS
+//======================================================================
+
+// None.
+
+//=====================================================================
+// EXCEPTION CLASS DEFINITIONS
+//=====================================================================
+
+// None.
+
+//======================================================================
+// CLASS DEFINITIONS
+//======================================================================
+
+/*======================================================================
+CLASS:
+AnimationFrame
+
+DESCRIPTION:
+The pixel buffer an animation renders into, along with the color to
+render with and the animation's scratch context.  Writes that actually
+change a pixel bump the frame's generation, so the owner can tell if
+anything needs to be displayed.
+
+HOW TO USE:
+1. Attach() a pixel buffer
+2. Set the color/context, and pass it to Animation::Render()
+3. Compare GetGeneration() with the last one displayed
+
+======================================================================*/
+class AnimationFrame
+{
+    public:
+
+    //=================================================================
+    // TYPE DECLARATIONS AND CONSTANTS    
+    //=================================================================
+
+    // None.
+
+    //=================================================================
+    // CLIENT INTERFACE
+    //=================================================================
+
+    AnimationFrame();
+
+    void Attach( uint32_t *pixels, uint32_t pixelCount );
+
+    uint32_t GetPixelCount() const { return _pixelCount; }
+
+    uint32_t GetPixel( uint32_t index ) const { return _pixels[index]; }
+    const uint32_t *GetPixels() const { return _pixels; }
+
+    void SetPixel( uint32_t index, uint32_t color );
+    void Fill( uint32_t color );
+
+    uint32_t GetGeneration() const { return _generation; }
+
+    // Forces the owner to treat the frame as changed
+    void Touch() { _generation++; }
+
+    uint32_t GetColor() const { return _color; }
+    void SetColor( uint32_t color ) { _color = color; }
+
+    AnimationContext &GetContext() { return _context; }
+
+    protected:
+
+    //=================================================================
+    // SUBCLASS INTERFACE   
+    //=================================================================
+
+    // None.
+
+    private:
+
+    //=================================================================
+    // CUSTOMIZATION INTERFACE    
+    //=================================================================
+
+    // None.
+
+    //=================================================================
+    // IMPLEMENTATION INTERFACE    
+    //=================================================================
+
+    // No copying - intentionally not defining the implementation
+    // to throw a link error if someone somehow invokes a copy.
+    AnimationFrame( const AnimationFrame &rhs );
+
+    //=================================================================
+    // DATA MEMBERS    
+    //=================================================================
+
+    uint32_t *_pixels;
+    uint32_t _pixelCount;
+
+    uint32_t _generation;
+
+    uint32_t _color;
+
+    AnimationContext _context;
+};
+
+/*======================================================================
+CLASS:
+Animation
+
+DESCRIPTION:
+Base class for all of the animations.  An animation renders a frame as
+a function of the time since it started, so it looks the same no matter
+how often it gets rendered.  Animations don't keep any state of their 
+own - anything they need from frame to frame goes in the frame's 
+AnimationContext - so one object can drive any number of strips.
+
+HOW TO USE:
+Derive from this class, implement Name() and Render(), and add an
+instance to the table in animation.cpp.  That is all it takes for the
+animation to show up in the web server and the demo.
+
+======================================================================*/
+class Animation
+{
+    public:
+
+    //=================================================================
+    // TYPE DECLARATIONS AND CONSTANTS    
+    //=================================================================
+
+    // None.
+
+    //=================================================================
+    // CLIENT INTERFACE
+    //=================================================================
+
+    virtual ~Animation() {}
+
+    // Short name, used for the web server endpoints
+    virtual const char *Name() const = 0;
+
+    // Called once when the animation starts, before the first Render()
+    virtual void Begin( AnimationFrame &frame ) const { (void) frame; }
+
+    // Renders the frame for t microseconds after the animation started
+    virtual void Render( AnimationFrame &frame, uint64_t t ) const = 0;
+
+    // Static animations look the same at any t, so they only need
+    // to be rendered when they start
+    virtual bool IsStatic() const { return false; }
+
+    // What the demo uses for this animation
+    virtual uint32_t DemoColor() const { return 0; }
+    virtual uint32_t DemoDurationMS() const { return 5000; }
+
+    protected:
+
+    //=================================================================
+    // SUBCLASS INTERFACE   
+    //=================================================================
+
+    // None.
+
+    private:
+
+    //=================================================================
+    // CUSTOMIZATION INTERFACE    
+    //=================================================================
+
+    // None.
+
+    //=================================================================
+    // IMPLEMENTATION INTERFACE    
+    //=================================================================
+
+    // None.
+
+    //=================================================================
+    // DATA MEMBERS    
+    //=================================================================
+
+    // None.
+};
+
+/*======================================================================
+CLASS:
+AnimationRegistry
+
+DESCRIPTION:
+The table of all of the animations we know about.  Everything that 
+needs to list the animations (the web server endpoints, the demo 
+playlist) walks this table, so a new animation only needs to be added
+in one place.
+
+HOW TO USE:
+Use Count()/Get() to walk the table, or Find() to look one up by 
+name.
+
+======================================================================*/
+class AnimationRegistry
+{
+    public:
+
+    //=================================================================
+    // TYPE DECLARATIONS AND CONSTANTS    
+    //=================================================================
+
+    // Returned by Find() when there is no such animation
+    static const uint32_t NOT_FOUND = 0xFFFFFFFFUL;
+
+    //=================================================================
+    // CLIENT INTERFACE
+    //=================================================================
+
+    static uint32_t Count();
+
+    static const Animation *Get( uint32_t index );
+
+    // Index of the animation with the given name, or NOT_FOUND
+    static uint32_t Find( const char *name );
+
+    protected:
+
+    //=================================================================
+    // SUBCLASS INTERFACE   
+    //=================================================================
+
+    // None.
+
+    private:
+
+    //=================================================================
+    // CUSTOMIZATION INTERFACE    
+    //=================================================================
+
+    // None.
+
+    //=================================================================
+    // IMPLEMENTATION INTERFACE    
+    //=================================================================
+
+    // No creating these, it is all static
+    AnimationRegistry();
+
+    //=================================================================
+    // DATA MEMBERS    
+    //=================================================================
+
+    // None.
+};
+
+//======================================================================
+// INLINE FUNCTION DEFINITIONS
+//======================================================================
+
+/*======================================================================
+FUNCTION:
+AnimationFrame::SetPixel()
+
+DESCRIPTION:
+Sets a pixel.  If the color actually changed, the generation is bumped.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+inline void AnimationFrame::SetPixel( uint32_t index, uint32_t color )
+{
+    if ( _pixels[index] != color )
+    {
+        _pixels[index] = color;
+        _generation++;
+    }
+}
+
+/*======================================================================
+FUNCTION:
+AnimationFrame::Fill()
+
+DESCRIPTION:
+Sets every pixel to the same color.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+inline void AnimationFrame::Fill( uint32_t color )
+{
+    for ( uint32_t i = 0; i < _pixelCount; i++ )
+    {
+        SetPixel( i, color );
+    }
+}
+
+
+/*======================================================================
+// DOCUMENTATION
+========================================================================
+
+None.
+
+======================================================================*/
+
+#endif	// #ifendif _JAROFLIGHT_ANIMATION_H_
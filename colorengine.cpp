@@ -0,0 +1,406 @@
+/*======================================================================
+FILE:
+colorengine.cpp
+
+CREATOR:
+Sean Foley
+
+GENERAL DESCRIPTION:
+Integer color math (color wheel, HSV, white extraction, scaling)
+for the neopixel animations.
+
+PUBLIC CLASSES AND FUNCTIONS:
+ColorEngine
+
+INITIALIZATION AND SEQUENCING REQUIREMENTS:
+None.
+
+Copyright (C) 2017 Sean Foley  All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted.  Enjoy.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+======================================================================*/
+
+//======================================================================
+// INCLUDES AND VARIABLE DEFINITIONS
+//======================================================================
+
+//----------------------------------------------------------------------
+// Defines
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Include Files
+//----------------------------------------------------------------------
+
+#include "colorengine.h"
+
+#include <Arduino.h>
+
+//----------------------------------------------------------------------
+// Type Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Constant Definitions
+//----------------------------------------------------------------------
+
+// The color wheel, precomputed from the Wheel algorithm by Bill Earl
+// https://learn.adafruit.com/multi-tasking-the-arduino-part-3?view=all
+// Packed as 0x00RRGGBB and kept in flash.
+static constexpr uint32_t WHEEL_TABLE[256] PROGMEM =
+{
+    0x00FF0000, 0x00FC0300, 0x00F90600, 0x00F60900, 0x00F30C00, 0x00F00F00, 0x00ED1200, 0x00EA1500,
+    0x00E71800, 0x00E41B00, 0x00E11E00, 0x00DE2100, 0x00DB2400, 0x00D82700, 0x00D52A00, 0x00D22D00,
+    0x00CF3000, 0x00CC3300, 0x00C93600, 0x00C63900, 0x00C33C00, 0x00C03F00, 0x00BD4200, 0x00BA4500,
+    0x00B74800, 0x00B44B00, 0x00B14E00, 0x00AE5100, 0x00AB5400, 0x00A85700, 0x00A55A00, 0x00A25D00,
+    0x009F6000, 0x009C6300, 0x00996600, 0x00966900, 0x00936C00, 0x00906F00, 0x008D7200, 0x008A7500,
+    0x00877800, 0x00847B00, 0x00817E00, 0x007E8100, 0x007B8400, 0x00788700, 0x00758A00, 0x00728D00,
+    0x006F9000, 0x006C9300, 0x00699600, 0x00669900, 0x00639C00, 0x00609F00, 0x005DA200, 0x005AA500,
+    0x0057A800, 0x0054AB00, 0x0051AE00, 0x004EB100, 0x004BB400, 0x0048B700, 0x0045BA00, 0x0042BD00,
+    0x003FC000, 0x003CC300, 0x0039C600, 0x0036C900, 0x0033CC00, 0x0030CF00, 0x002DD200, 0x002AD500,
+    0x0027D800, 0x0024DB00, 0x0021DE00, 0x001EE100, 0x001BE400, 0x0018E700, 0x0015EA00, 0x0012ED00,
+    0x000FF000, 0x000CF300, 0x0009F600, 0x0006F900, 0x0003FC00, 0x0000FF00, 0x0000FC03, 0x0000F906,
+    0x0000F609, 0x0000F30C, 0x0000F00F, 0x0000ED12, 0x0000EA15, 0x0000E718, 0x0000E41B, 0x0000E11E,
+    0x0000DE21, 0x0000DB24, 0x0000D827, 0x0000D52A, 0x0000D22D, 0x0000CF30, 0x0000CC33, 0x0000C936,
+    0x0000C639, 0x0000C33C, 0x0000C03F, 0x0000BD42, 0x0000BA45, 0x0000B748, 0x0000B44B, 0x0000B14E,
+    0x0000AE51, 0x0000AB54, 0x0000A857, 0x0000A55A, 0x0000A25D, 0x00009F60, 0x00009C63, 0x00009966,
+    0x00009669, 0x0000936C, 0x0000906F, 0x00008D72, 0x00008A75, 0x00008778, 0x0000847B, 0x0000817E,
+    0x00007E81, 0x00007B84, 0x00007887, 0x0000758A, 0x0000728D, 0x00006F90, 0x00006C93, 0x00006996,
+    0x00006699, 0x0000639C, 0x0000609F, 0x00005DA2, 0x00005AA5, 0x000057A8, 0x000054AB, 0x000051AE,
+    0x00004EB1, 0x00004BB4, 0x000048B7, 0x000045BA, 0x000042BD, 0x00003FC0, 0x00003CC3, 0x000039C6,
+    0x000036C9, 0x000033CC, 0x000030CF, 0x00002DD2, 0x00002AD5, 0x000027D8, 0x000024DB, 0x000021DE,
+    0x00001EE1, 0x00001BE4, 0x000018E7, 0x000015EA, 0x000012ED, 0x00000FF0, 0x00000CF3, 0x000009F6,
+    0x000006F9, 0x000003FC, 0x000000FF, 0x000300FC, 0x000600F9, 0x000900F6, 0x000C00F3, 0x000F00F0,
+    0x001200ED, 0x001500EA, 0x001800E7, 0x001B00E4, 0x001E00E1, 0x002100DE, 0x002400DB, 0x002700D8,
+    0x002A00D5, 0x002D00D2, 0x003000CF, 0x003300CC, 0x003600C9, 0x003900C6, 0x003C00C3, 0x003F00C0,
+    0x004200BD, 0x004500BA, 0x004800B7, 0x004B00B4, 0x004E00B1, 0x005100AE, 0x005400AB, 0x005700A8,
+    0x005A00A5, 0x005D00A2, 0x0060009F, 0x0063009C, 0x00660099, 0x00690096, 0x006C0093, 0x006F0090,
+    0x0072008D, 0x0075008A, 0x00780087, 0x007B0084, 0x007E0081, 0x0081007E, 0x0084007B, 0x00870078,
+    0x008A0075, 0x008D0072, 0x0090006F, 0x0093006C, 0x00960069, 0x00990066, 0x009C0063, 0x009F0060,
+    0x00A2005D, 0x00A5005A, 0x00A80057, 0x00AB0054, 0x00AE0051, 0x00B1004E, 0x00B4004B, 0x00B70048,
+    0x00BA0045, 0x00BD0042, 0x00C0003F, 0x00C3003C, 0x00C60039, 0x00C90036, 0x00CC0033, 0x00CF0030,
+    0x00D2002D, 0x00D5002A, 0x00D80027, 0x00DB0024, 0x00DE0021, 0x00E1001E, 0x00E4001B, 0x00E70018,
+    0x00EA0015, 0x00ED0012, 0x00F0000F, 0x00F3000C, 0x00F60009, 0x00F90006, 0x00FC0003, 0x00FF0000
+};
+
+//----------------------------------------------------------------------
+// Global Data Definitions
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Static Variable Definitions 
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Function Prototypes
+//----------------------------------------------------------------------
+
+// a * b / 255 in 8 bit fixed point, with scale8( a, 255 ) == a
+static inline uint8_t scale8( uint8_t a, uint8_t b )
+{
+    return ( (uint16_t) a * ( (uint16_t) b + 1 ) ) >> 8;
+}
+
+//----------------------------------------------------------------------
+// Required Libraries
+//----------------------------------------------------------------------
+
+// None. (Where supported these should be in the form
+// of C++ pragmas).
+
+//======================================================================
+// FUNCTION IMPLEMENTATIONS
+//======================================================================
+
+/*======================================================================
+FUNCTION:
+Wheel()
+
+DESCRIPTION:
+Returns the color wheel color for the given position.  This is a table
+lookup of the Bill Earl Wheel algorithm, so there are no branches or
+multiplies.
+
+RETURN VALUE:
+Color value of the wheel based on the wheel position
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+uint32_t ColorEngine::Wheel( uint8_t position )
+{
+    return pgm_read_dword( &WHEEL_TABLE[position] );
+}
+
+/*======================================================================
+FUNCTION:
+HsvToRgbw()
+
+DESCRIPTION:
+Converts a hue/saturation/value color to a packed color using only
+8 bit fixed point math.  The hue circle is split into 6 sectors of 
+256 steps each, so there are no divides.
+
+RETURN VALUE:
+packed color
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+uint32_t ColorEngine::HsvToRgbw( uint8_t hue, uint8_t saturation, uint8_t value,
+                                 bool extractWhite )
+{
+    // Position on the 6 sector hue circle (0..1530) - the top
+    // byte is the sector, the bottom byte is how far into it we are
+    uint16_t h = (uint16_t) hue * 6;
+    uint8_t sector = h >> 8;
+    uint8_t fraction = h & 0xFF;
+
+    uint8_t p = value - scale8( value, saturation );
+    uint8_t q = value - scale8( value, scale8( saturation, fraction ) );
+    uint8_t t = value - scale8( value, scale8( saturation, 255 - fraction ) );
+    
+    uint8_t r, g, b;
+
+    switch ( sector )
+    {
+        case 0:  r = value; g = t;     b = p;     break;
+        case 1:  r = q;     g = value; b = p;     break;
+        case 2:  r = p;     g = value; b = t;     break;
+        case 3:  r = p;     g = q;     b = value; break;
+        case 4:  r = t;     g = p;     b = value; break;
+        default: r = value; g = p;     b = q;     break;
+    }
+
+    uint32_t color = ( (uint32_t) r << 16 ) | ( (uint32_t) g << 8 ) | b;
+
+    if ( extractWhite == true )
+    {
+        color = ExtractWhite( color );
+    }
+
+    return color;
+}
+
+/*======================================================================
+FUNCTION:
+ExtractWhite()
+
+DESCRIPTION:
+Moves the grey part of a color (the amount all of r/g/b have in common)
+over to the white LED.  The Jewel's white LED is brighter and a nicer
+white than r+g+b, and it only burns one LED instead of three.  Any white
+already in the color is kept, saturating at 255.
+
+RETURN VALUE:
+color with the white pulled out
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+uint32_t ColorEngine::ExtractWhite( uint32_t color )
+{
+    uint8_t w = color >> 24;
+    uint8_t r = color >> 16;
+    uint8_t g = color >> 8;
+    uint8_t b = color;
+
+    uint8_t grey = r < g ? r : g;
+    grey = grey < b ? grey : b;
+
+    if ( grey == 0 )
+    {
+        return color;
+    }
+
+    uint16_t white = (uint16_t) w + grey;
+    w = white > 255 ? 255 : white;
+
+    r -= grey;
+    g -= grey;
+    b -= grey;
+
+    return ( (uint32_t) w << 24 ) | ( (uint32_t) r << 16 ) | ( (uint32_t) g << 8 ) | b;
+}
+
+/*======================================================================
+FUNCTION:
+Scale()
+
+DESCRIPTION:
+Scales all four channels of a packed color by level/255.  The channels
+are processed two at a time (r/b and w/g) using the 0x00FF00FF mask
+trick, so it is just two multiplies per color.
+
+RETURN VALUE:
+scaled color
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+uint32_t ColorEngine::Scale( uint32_t color, uint8_t level )
+{
+    const uint32_t scale = (uint32_t) level + 1;
+
+    uint32_t rb = ( ( ( color & 0x00FF00FFUL ) * scale ) >> 8 ) & 0x00FF00FFUL;
+    uint32_t wg = ( ( ( color >> 8 ) & 0x00FF00FFUL ) * scale ) & 0xFF00FF00UL;
+
+    return wg | rb;
+}
+
+/*======================================================================
+FUNCTION:
+Blend()
+
+DESCRIPTION:
+Blends two packed colors, from*(256-alpha) + to*alpha.  Same trick as
+Scale(), two channels at a time, so all four channels take four
+multiplies.  Each 16 bit lane tops out at 255*256, so the lanes never
+carry into each other.
+
+RETURN VALUE:
+blended color
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+uint32_t ColorEngine::Blend( uint32_t from, uint32_t to, uint16_t alpha )
+{
+    if ( alpha >= 256 )
+    {
+        return to;
+    }
+
+    const uint32_t inverse = 256 - alpha;
+
+    uint32_t rb = ( ( from & 0x00FF00FFUL ) * inverse + ( to & 0x00FF00FFUL ) * alpha ) >> 8;
+    uint32_t wg = ( ( from >> 8 ) & 0x00FF00FFUL ) * inverse + ( ( to >> 8 ) & 0x00FF00FFUL ) * alpha;
+
+    return ( wg & 0xFF00FF00UL ) | ( rb & 0x00FF00FFUL );
+}
+
+/*======================================================================
+FUNCTION:
+Add()
+
+DESCRIPTION:
+Adds two packed colors, saturating each channel at 255.  All four
+channels are added at once: the low 7 bits of each channel are added
+without being able to carry into the next channel, then the top bit
+and the carry out of it are worked out with logic ops.  Any channel
+that carried out is forced to 255.
+
+RETURN VALUE:
+sum of the colors
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+uint32_t ColorEngine::Add( uint32_t a, uint32_t b )
+{
+    const uint32_t HIGH_BITS = 0x80808080UL;
+
+    uint32_t sum = ( a & ~HIGH_BITS ) + ( b & ~HIGH_BITS );
+    uint32_t carry = ( ( a & b ) | ( ( a | b ) & sum ) ) & HIGH_BITS;
+
+    sum ^= ( a ^ b ) & HIGH_BITS;
+
+    // 0x80 -> 0xFF in each channel that overflowed
+    return sum | ( ( carry >> 7 ) * 0xFF );
+}
+
+/*======================================================================
+FUNCTION:
+Multiply()
+
+DESCRIPTION:
+Multiplies two packed colors channel by channel, a*b/255.  Black 
+stays black and white leaves the other color alone.
+
+RETURN VALUE:
+product of the colors
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+uint32_t ColorEngine::Multiply( uint32_t a, uint32_t b )
+{
+    uint32_t result = 0;
+
+    for ( uint8_t shift = 0; shift < 32; shift += 8 )
+    {
+        uint32_t product = ( ( a >> shift ) & 0xFF ) * ( ( b >> shift ) & 0xFF );
+
+        // Fast /255, 255*255 still comes out as 255
+        product = ( product + 1 + ( product >> 8 ) ) >> 8;
+
+        result |= product << shift;
+    }
+
+    return result;
+}
+
+/*======================================================================
+FUNCTION:
+Max()
+
+DESCRIPTION:
+Takes the brighter of the two colors, channel by channel.
+
+RETURN VALUE:
+per channel max of the colors
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+uint32_t ColorEngine::Max( uint32_t a, uint32_t b )
+{
+    uint32_t result = 0;
+
+    for ( uint8_t shift = 0; shift < 32; shift += 8 )
+    {
+        uint32_t channelA = a & ( 0xFFUL << shift );
+        uint32_t channelB = b & ( 0xFFUL << shift );
+
+        result |= ( channelA > channelB ) ? channelA : channelB;
+    }
+
+    return result;
+}
+
+/*=====================================================================
+// IMPLEMENTATION NOTES
+//=====================================================================
+
+None
+
+=====================================================================*/
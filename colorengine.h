@@ -0,0 +1,194 @@
+#ifndef _JAROFLIGHT_COLORENGINE_H_
+#define _JAROFLIGHT_COLORENGINE_H_
+
+/*======================================================================
+FILE:
+colorengine.h
+
+CREATOR:
+Sean Foley
+
+DESCRIPTION:
+Integer color math (color wheel, HSV, white extraction, scaling)
+for the neopixel animations.
+
+PUBLIC CLASSES AND FUNCTIONS:
+ColorEngine
+
+Copyright (C) 2017 Sean Foley  All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted.  Enjoy.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+======================================================================*/
+
+//======================================================================
+// INCLUDES AND PUBLIC DATA DECLARATIONS
+//======================================================================
+
+//----------------------------------------------------------------------
+// Defines
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Include Files
+//----------------------------------------------------------------------
+
+#include <stdint.h>
+
+//----------------------------------------------------------------------
+// Type Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Constant Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Data Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//======================================================================
+// WARNINGS!!!
+//======================================================================
+
+// None.
+
+//======================================================================
+// FUNCTION DECLARATIONS
+//======================================================================
+
+// None.
+
+//=====================================================================
+// EXCEPTION CLASS DEFINITIONS
+//=====================================================================
+
+// None.
+
+//======================================================================
+// CLASS DEFINITIONS
+//======================================================================
+
+/*======================================================================
+CLASS:
+ColorEngine
+
+DESCRIPTION:
+Fast color math for the animations.  Everything works on the packed
+0xWWRRGGBB colors that Adafruit_NeoPixel::Color() produces, and sticks 
+to integer math and lookup tables so it is cheap enough to run for 
+every pixel of every frame.
+
+HOW TO USE:
+All methods are static, just call them:
+
+    uint32_t c = ColorEngine::Wheel( position );
+    uint32_t c = ColorEngine::HsvToRgbw( hue, saturation, value );
+
+======================================================================*/
+class ColorEngine
+{
+    public:
+
+    //=================================================================
+    // TYPE DECLARATIONS AND CONSTANTS    
+    //=================================================================
+
+    // None.
+
+    //=================================================================
+    // CLIENT INTERFACE
+    //=================================================================
+
+    // Color wheel position 0..255 -> color, from a table in flash
+    static uint32_t Wheel( uint8_t position );
+
+    // Fixed point HSV to RGBW.  Hue, saturation and value are all 
+    // 0..255.  When extractWhite is true, the common (grey) part of
+    // r/g/b is moved over to the white LED.
+    static uint32_t HsvToRgbw( uint8_t hue, uint8_t saturation, uint8_t value,
+                               bool extractWhite = true );
+
+    // Moves the common part of r/g/b over to the white channel so 
+    // whites are rendered with the W LED instead of all three colors
+    static uint32_t ExtractWhite( uint32_t color );
+
+    // Scales all channels of a packed color by level/255
+    static uint32_t Scale( uint32_t color, uint8_t level );
+
+    // Blends two packed colors.  alpha is 0..256, 0 is all from, 
+    // 256 is all to.
+    static uint32_t Blend( uint32_t from, uint32_t to, uint16_t alpha );
+
+    // Per channel a+b (saturating at 255), a*b/255 and max(a,b).
+    // Used for the compositor's blend modes.
+    static uint32_t Add( uint32_t a, uint32_t b );
+    static uint32_t Multiply( uint32_t a, uint32_t b );
+    static uint32_t Max( uint32_t a, uint32_t b );
+
+    protected:
+
+    //=================================================================
+    // SUBCLASS INTERFACE   
+    //=================================================================
+
+    // None.
+
+    private:
+
+    //=================================================================
+    // CUSTOMIZATION INTERFACE    
+    //=================================================================
+
+    // None.
+
+    //=================================================================
+    // IMPLEMENTATION INTERFACE    
+    //=================================================================
+
+    // No creating these, it is all static
+    ColorEngine();
+
+    //=================================================================
+    // DATA MEMBERS    
+    //=================================================================
+
+    // None.
+};
+
+//======================================================================
+// INLINE FUNCTION DEFINITIONS
+//======================================================================
+
+// None.
+
+
+/*======================================================================
+// DOCUMENTATION
+========================================================================
+
+None.
+
+======================================================================*/
+
+#endif	// #ifendif _JAROFLIGHT_COLORENGINE_H_
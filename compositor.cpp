@@ -0,0 +1,424 @@
+/*======================================================================
+FILE:
+compositor.cpp
+
+CREATOR:
+Sean Foley
+
+GENERAL DESCRIPTION:
+Composites animation layers on top of each other.
+
+PUBLIC CLASSES AND FUNCTIONS:
+Compositor
+
+INITIALIZATION AND SEQUENCING REQUIREMENTS:
+None.
+
+Copyright (C) 2017 Sean Foley  All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted.  Enjoy.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+======================================================================*/
+
+//======================================================================
+// INCLUDES AND VARIABLE DEFINITIONS
+//======================================================================
+
+//----------------------------------------------------------------------
+// Defines
+//----------------------------------------------------------------------
+
+// How many pixels worth of layer buffers there are, shared between all
+// of the compositors.  Override it on the compiler command line if you
+// have more (or longer) strips.
+#ifndef COMPOSITOR_ARENA_PIXELS
+#define COMPOSITOR_ARENA_PIXELS 256
+#endif
+
+//----------------------------------------------------------------------
+// Include Files
+//----------------------------------------------------------------------
+
+#include <string.h>
+
+#include "compositor.h"
+#include "colorengine.h"
+
+//----------------------------------------------------------------------
+// Type Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Constant Definitions
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Data Definitions
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Static Variable Definitions 
+//----------------------------------------------------------------------
+
+// Layer buffers are bump allocated out of here.  Nothing is ever freed,
+// compositors are expected to live for as long as the program does.
+static uint32_t s_arena[COMPOSITOR_ARENA_PIXELS];
+static uint32_t s_arenaUsed = 0;
+
+static const char * const BLEND_MODE_NAMES[] =
+{
+    "normal",
+    "add",
+    "multiply",
+    "max"
+};
+
+//----------------------------------------------------------------------
+// Function Prototypes
+//----------------------------------------------------------------------
+
+static uint32_t *arenaAllocate( uint32_t pixelCount );
+
+//----------------------------------------------------------------------
+// Required Libraries
+//----------------------------------------------------------------------
+
+// None. (Where supported these should be in the form
+// of C++ pragmas).
+
+//======================================================================
+// FUNCTION IMPLEMENTATIONS
+//======================================================================
+
+/*======================================================================
+FUNCTION:
+C-tor()
+
+DESCRIPTION:
+Constructs a compositor with no layers.  Call Attach() to get some.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+Compositor::Compositor()
+    : _layerCount( 0 ), _activeLayers( 0 ), _generation( 1 )
+{
+    for ( uint8_t i = 0; i < MAX_LAYERS; i++ )
+    {
+        _layers[i].animation = nullptr;
+        _layers[i].timeUS = 0;
+        _layers[i].alpha = 256;
+        _layers[i].mode = BLEND_NORMAL;
+    }
+}
+
+/*======================================================================
+FUNCTION:
+Attach()
+
+DESCRIPTION:
+Carves a pixel buffer for each layer out of the arena.  We take as
+many layers as fit, up to MAX_LAYERS.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void Compositor::Attach( uint32_t pixelCount )
+{
+    while ( _layerCount < MAX_LAYERS )
+    {
+        uint32_t *pixels = arenaAllocate( pixelCount );
+
+        if ( pixels == nullptr )
+        {
+            break;
+        }
+
+        _layers[_layerCount].frame.Attach( pixels, pixelCount );
+        _layerCount++;
+    }
+}
+
+/*======================================================================
+FUNCTION:
+arenaAllocate()
+
+DESCRIPTION:
+Bump allocates a zeroed buffer from the arena.
+
+RETURN VALUE:
+The buffer, or nullptr if the arena is out of room
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+static uint32_t *arenaAllocate( uint32_t pixelCount )
+{
+    if ( pixelCount == 0 || pixelCount > COMPOSITOR_ARENA_PIXELS - s_arenaUsed )
+    {
+        return nullptr;
+    }
+
+    uint32_t *pixels = &s_arena[s_arenaUsed];
+    s_arenaUsed += pixelCount;
+
+    return pixels;
+}
+
+/*======================================================================
+FUNCTION:
+SetLayer()
+
+DESCRIPTION:
+Starts an animation on a layer.  The layer's animation starts from
+t = 0 and renders its first frame right away.  Nothing is displayed
+until the owner composites and commits the frame.
+
+RETURN VALUE:
+true if the layer was set
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+bool Compositor::SetLayer( uint8_t layer, const Animation *animation, uint32_t color,
+                          uint8_t opacity, BlendMode mode, uint32_t seed )
+{
+    if ( layer >= _layerCount || animation == nullptr )
+    {
+        return false;
+    }
+
+    Layer &l = _layers[layer];
+
+    l.animation = animation;
+    l.timeUS = 0;
+
+    // Map 0..255 onto 0..256 so full opacity is a straight copy
+    l.alpha = (uint16_t) opacity + ( opacity >> 7 );
+    l.mode = mode;
+
+    l.frame.SetColor( color );
+    l.frame.GetContext().seed = seed;
+
+    l.animation->Begin( l.frame );
+    l.animation->Render( l.frame, 0 );
+
+    _activeLayers |= ( 1 << layer );
+    _generation++;
+
+    return true;
+}
+
+/*======================================================================
+FUNCTION:
+ClearLayer()
+
+DESCRIPTION:
+Stops the animation on a layer.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void Compositor::ClearLayer( uint8_t layer )
+{
+    if ( layer >= _layerCount || _layers[layer].animation == nullptr )
+    {
+        return;
+    }
+
+    _layers[layer].animation = nullptr;
+
+    _activeLayers &= ~( 1 << layer );
+    _generation++;
+}
+
+/*======================================================================
+FUNCTION:
+Render()
+
+DESCRIPTION:
+Renders the next frame of every active layer.  If any of them changed,
+the generation is bumped.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void Compositor::Render( uint32_t elapsedUS )
+{
+    for ( uint8_t i = 0; i < _layerCount; i++ )
+    {
+        Layer &l = _layers[i];
+
+        if ( l.animation == nullptr )
+        {
+            continue;
+        }
+
+        l.timeUS += elapsedUS;
+
+        if ( l.animation->IsStatic() == true )
+        {
+            continue;
+        }
+
+        uint32_t before = l.frame.GetGeneration();
+
+        l.animation->Render( l.frame, l.timeUS );
+
+        if ( l.frame.GetGeneration() != before )
+        {
+            _generation++;
+        }
+    }
+}
+
+/*======================================================================
+FUNCTION:
+Composite()
+
+DESCRIPTION:
+Composites all of the active layers, bottom to top, on top of a base
+pixel.  The blend mode combines the layer with what is underneath, 
+then the result is mixed in according to the layer's opacity.
+
+RETURN VALUE:
+The composited pixel
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+uint32_t Compositor::Composite( uint32_t index, uint32_t base ) const
+{
+    uint32_t c = base;
+
+    for ( uint8_t i = 0; i < _layerCount; i++ )
+    {
+        const Layer &l = _layers[i];
+
+        if ( l.animation == nullptr )
+        {
+            continue;
+        }
+
+        uint32_t top = l.frame.GetPixel( index );
+
+        switch ( l.mode )
+        {
+            case BLEND_ADD:
+                top = ColorEngine::Add( c, top );
+                break;
+
+            case BLEND_MULTIPLY:
+                top = ColorEngine::Multiply( c, top );
+                break;
+
+            case BLEND_MAX:
+                top = ColorEngine::Max( c, top );
+                break;
+
+            case BLEND_NORMAL:
+                break;
+        }
+
+        c = ColorEngine::Blend( c, top, l.alpha );
+    }
+
+    return c;
+}
+
+/*======================================================================
+FUNCTION:
+BlendModeName()
+
+DESCRIPTION:
+Gets the name of a blend mode
+
+RETURN VALUE:
+Name of the blend mode
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+const char *Compositor::BlendModeName( BlendMode mode )
+{
+    return BLEND_MODE_NAMES[mode];
+}
+
+/*======================================================================
+FUNCTION:
+FindBlendMode()
+
+DESCRIPTION:
+Looks up a blend mode by name
+
+RETURN VALUE:
+true if the name was found, mode is set
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+bool Compositor::FindBlendMode( const char *name, BlendMode &mode )
+{
+    if ( name == nullptr )
+    {
+        return false;
+    }
+
+    for ( uint8_t i = 0; i <= BLEND_MAX; i++ )
+    {
+        if ( strcmp( BLEND_MODE_NAMES[i], name ) == 0 )
+        {
+            mode = (BlendMode) i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*=====================================================================
+// IMPLEMENTATION NOTES
+//=====================================================================
+
+None
+
+=====================================================================*/
@@ -0,0 +1,231 @@
+#ifndef _JAROFLIGHT_COMPOSITOR_H_
+#define _JAROFLIGHT_COMPOSITOR_H_
+
+/*======================================================================
+FILE:
+compositor.h
+
+CREATOR:
+Sean Foley
+
+DESCRIPTION:
+Composites animation layers on top of each other.
+
+PUBLIC CLASSES AND FUNCTIONS:
+Compositor
+
+Copyright (C) 2017 Sean Foley  All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted.  Enjoy.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+======================================================================*/
+
+//======================================================================
+// INCLUDES AND PUBLIC DATA DECLARATIONS
+//======================================================================
+
+//----------------------------------------------------------------------
+// Defines
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Include Files
+//----------------------------------------------------------------------
+
+#include <stdint.h>
+
+#include "animation.h"
+
+//----------------------------------------------------------------------
+// Type Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Constant Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Data Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//======================================================================
+// WARNINGS!!!
+//======================================================================
+
+// None.
+
+//======================================================================
+// FUNCTION DECLARATIONS
+//======================================================================
+
+// None.
+
+//=====================================================================
+// EXCEPTION CLASS DEFINITIONS
+//=====================================================================
+
+// None.
+
+//======================================================================
+// CLASS DEFINITIONS
+//======================================================================
+
+/*======================================================================
+CLASS:
+Compositor
+
+DESCRIPTION:
+Composites a small, fixed number of animation layers on top of a base
+frame.  Each layer runs its own animation with its own color, opacity
+and blend mode.  For example, a slow color wheel as the base with a
+flicker sparkle added on top.
+
+The layer pixel buffers are carved out of a static arena when the 
+compositor is attached, so nothing is allocated from the heap while
+we are running.
+
+HOW TO USE:
+1. Attach() with the number of pixels in the frame
+2. SetLayer() / ClearLayer() to change what is on top
+3. Once per frame, Render() the layers, then run each pixel of the
+base frame thru Composite()
+
+======================================================================*/
+class Compositor
+{
+    public:
+
+    //=================================================================
+    // TYPE DECLARATIONS AND CONSTANTS    
+    //=================================================================
+
+    // Layers per compositor.  Each one costs 4 bytes per pixel of
+    // arena (see COMPOSITOR_ARENA_PIXELS).
+    static const uint8_t MAX_LAYERS = 3;
+
+    // How a layer is combined with what is underneath it
+    enum BlendMode
+    {
+        BLEND_NORMAL = 0,
+        BLEND_ADD,
+        BLEND_MULTIPLY,
+        BLEND_MAX
+    };
+
+    //=================================================================
+    // CLIENT INTERFACE
+    //=================================================================
+
+    Compositor();
+
+    // Carves the layer buffers out of the arena.  If the arena is
+    // short on room we get fewer layers (maybe none).
+    void Attach( uint32_t pixelCount );
+
+    // Number of layers we actually got from the arena
+    uint8_t GetLayerCount() const { return _layerCount; }
+
+    // Starts an animation on a layer.  opacity is 0..255.  Returns
+    // false if there is no such layer or animation.
+    bool SetLayer( uint8_t layer, const Animation *animation, uint32_t color,
+                   uint8_t opacity, BlendMode mode, uint32_t seed );
+    void ClearLayer( uint8_t layer );
+
+    bool HasActiveLayers() const { return _activeLayers != 0; }
+
+    // Bumped whenever the composited output would change
+    uint32_t GetGeneration() const { return _generation; }
+
+    // Renders the next frame of every active layer
+    void Render( uint32_t elapsedUS );
+
+    // Composites all of the active layers on top of a base pixel
+    uint32_t Composite( uint32_t index, uint32_t base ) const;
+
+    // Name <-> blend mode, for the web server
+    static const char *BlendModeName( BlendMode mode );
+    static bool FindBlendMode( const char *name, BlendMode &mode );
+
+    protected:
+
+    //=================================================================
+    // SUBCLASS INTERFACE   
+    //=================================================================
+
+    // None.
+
+    private:
+
+    //=================================================================
+    // CUSTOMIZATION INTERFACE    
+    //=================================================================
+
+    // None.
+
+    //=================================================================
+    // IMPLEMENTATION INTERFACE    
+    //=================================================================
+
+    // No copying - intentionally not defining the implementation
+    // to throw a link error if someone somehow invokes a copy.
+    Compositor( const Compositor &rhs );
+
+    struct Layer
+    {
+        const Animation *animation;
+        AnimationFrame frame;
+        uint64_t timeUS;
+        uint16_t alpha;
+        BlendMode mode;
+    };
+
+    //=================================================================
+    // DATA MEMBERS    
+    //=================================================================
+
+    Layer _layers[MAX_LAYERS];
+
+    uint8_t _layerCount;
+
+    // Bit per layer that has an animation on it
+    uint8_t _activeLayers;
+
+    uint32_t _generation;
+};
+
+//======================================================================
+// INLINE FUNCTION DEFINITIONS
+//======================================================================
+
+// None.
+
+
+/*======================================================================
+// DOCUMENTATION
+========================================================================
+
+None.
+
+======================================================================*/
+
+#endif	// #ifendif _JAROFLIGHT_COMPOSITOR_H_
@@ -147,6 +147,27 @@ void DiscoveryProxy::AddService( const String &service, const String &protocol,
     MDNS.addService( service, protocol, port );
 }
 
+/*======================================================================
+FUNCTION:
+Process()
+
+DESCRIPTION:
+Wrapper for MDNS.update().  The mDNS responder only answers queries
+(and announces our services) when this is called, so call it 
+periodically.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void DiscoveryProxy::Process()
+{
+    MDNS.update();
+}
+
 /*=====================================================================
 // IMPLEMENTATION NOTES
 //=====================================================================
@@ -127,6 +127,9 @@ class DiscoveryProxy
 
     void AddService( const String &service, const String &protocol, int port );
 
+    // Call this periodically so mDNS can answer queries
+    void Process();
+
     protected:
 
     //=================================================================
@@ -141,6 +141,9 @@ void FirmwareUpdater::Begin()
     // Set the callbacks
     ArduinoOTA.onStart( std::bind( &FirmwareUpdater::handleUpdateStart, this ) );
     ArduinoOTA.onEnd(   std::bind( &FirmwareUpdater::handleUpdateComplete, this ) );
+    ArduinoOTA.onProgress( std::bind( &FirmwareUpdater::handleUpdateProgress, this,
+                                      std::placeholders::_1, std::placeholders::_2 ) );
+    ArduinoOTA.onError( std::bind( &FirmwareUpdater::handleUpdateError, this, std::placeholders::_1 ) );
 
     Serial.printf("FirmwareUpdater: starting OTA update support on port %d\n", _port);
 
@@ -183,6 +186,8 @@ none
 ======================================================================*/
 void FirmwareUpdater::handleUpdateStart()
 {
+    _updating = true;
+
     Serial.println( "FirmwareUpdater: firmware OTA update starting" );
 }
 
@@ -203,12 +208,60 @@ none
 void FirmwareUpdater::handleUpdateComplete()
 {
     Serial.println( "FirmwareUpdater: update complete, restarting device" );
+
+    _updating = false;
     
     // Sometimes the device doesn't seem to automagically restart
     // so maybe we need to help it along???
     //ESP.reset();
 }
 
+/*======================================================================
+FUNCTION:
+handleUpdateProgress()
+
+DESCRIPTION:
+Callback that is called as each chunk of the update is received
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void FirmwareUpdater::handleUpdateProgress( unsigned int progress, unsigned int total )
+{
+    (void) progress;
+    (void) total;
+
+    if ( _progressHandler )
+    {
+        _progressHandler();
+    }
+}
+
+/*======================================================================
+FUNCTION:
+handleUpdateError()
+
+DESCRIPTION:
+Callback that is called if the update fails
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void FirmwareUpdater::handleUpdateError( ota_error_t error )
+{
+    Serial.printf( "FirmwareUpdater: update failed, error %d\n", (int) error );
+
+    _updating = false;
+}
+
 /*=====================================================================
 // IMPLEMENTATION NOTES
 //=====================================================================
@@ -47,6 +47,10 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 // Include Files
 //----------------------------------------------------------------------
 
+#include <functional>
+
+#include <ArduinoOTA.h>
+
 #include "WString.h"
 
 //----------------------------------------------------------------------
@@ -122,6 +126,14 @@ class FirmwareUpdater
 
     void Process();
 
+    // True while an update is being received
+    bool IsUpdating() const { return _updating; }
+
+    // Called over and over while an update is being received.  The
+    // update runs inside of Process() until it is done, so nothing 
+    // else gets a turn - this is the place to keep status LEDs going.
+    void SetProgressHandler( std::function< void( void ) > handler ) { _progressHandler = handler; }
+
     protected:
 
     //=================================================================
@@ -131,6 +143,8 @@ class FirmwareUpdater
     // Callbacks
     void handleUpdateStart();
     void handleUpdateComplete();
+    void handleUpdateProgress( unsigned int progress, unsigned int total );
+    void handleUpdateError( ota_error_t error );
 
     private:
 
@@ -156,6 +170,10 @@ class FirmwareUpdater
     String _password;
     int _port;
 
+    bool _updating = false;
+
+    std::function< void( void ) > _progressHandler;
+
 };
 
 //======================================================================
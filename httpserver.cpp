@@ -0,0 +1,1626 @@
+/*======================================================================
+FILE:
+httpserver.cpp
+
+CREATOR:
+Sean Foley
+
+GENERAL DESCRIPTION:
+A small HTTP server built on the asynchronous (callback based) TCP
+library, so no client can hold up the main loop.
+
+PUBLIC CLASSES AND FUNCTIONS:
+HttpServer
+
+INITIALIZATION AND SEQUENCING REQUIREMENTS:
+The device must be on the network before Begin() is called.
+
+Copyright (C) 2017 Sean Foley  All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted.  Enjoy.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+======================================================================*/
+
+//======================================================================
+// INCLUDES AND VARIABLE DEFINITIONS
+//======================================================================
+
+//----------------------------------------------------------------------
+// Defines
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Include Files
+//----------------------------------------------------------------------
+
+#include "httpserver.h"
+
+#include <Arduino.h>
+
+#include <string.h>
+#include <strings.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+//----------------------------------------------------------------------
+// Type Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Constant Definitions
+//----------------------------------------------------------------------
+
+// The headers that tell the client whether we are keeping the
+// connection open (the timeout is KEEP_ALIVE_TIMEOUT_MS)
+static const char KEEP_ALIVE_HEADERS[] = "Connection: keep-alive\r\nKeep-Alive: timeout=10\r\n";
+static const char CLOSE_HEADERS[] = "Connection: close\r\n";
+
+//----------------------------------------------------------------------
+// Global Data Definitions
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Static Variable Definitions 
+//----------------------------------------------------------------------
+
+// None
+
+//----------------------------------------------------------------------
+// Function Prototypes
+//----------------------------------------------------------------------
+
+static char *nextLine( char *&cursor );
+static int hexValue( char c );
+
+//----------------------------------------------------------------------
+// Required Libraries
+//----------------------------------------------------------------------
+
+// None. (Where supported these should be in the form
+// of C++ pragmas).
+
+//======================================================================
+// FUNCTION IMPLEMENTATIONS
+//======================================================================
+
+/*======================================================================
+FUNCTION:
+HttpServer()
+
+DESCRIPTION:
+C-tor
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+HttpServer::HttpServer( uint16_t port )
+    : _server( port ),
+      _nextConnection( 0 ),
+      _routeCount( 0 ),
+      _nodeCount( 0 ),
+      _current( nullptr ),
+      _responded( false ),
+      _argCount( 0 ),
+      _body( nullptr ),
+      _pathArgCount( 0 ),
+      _extraHeadersLength( 0 ),
+      _requests( 0 ),
+      _badRequests( 0 ),
+      _rejected( 0 ),
+      _timeouts( 0 ),
+      _keptAlive( 0 ),
+      _idleClosed( 0 )
+{
+    for ( size_t i = 0; i < MAX_CONNECTIONS; i++ )
+    {
+        _connections[i].client = nullptr;
+        reset( _connections[i] );
+    }
+
+    // The root, which matches nothing by itself
+    addNode( "", 0 );
+}
+
+/*======================================================================
+FUNCTION:
+Begin()
+
+DESCRIPTION:
+Starts listening for connections.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void HttpServer::Begin()
+{
+    _server.onClient( [this]( void *, AsyncClient *client ) { onConnect( client ); }, nullptr );
+    _server.setNoDelay( true );
+    _server.begin();
+}
+
+/*======================================================================
+FUNCTION:
+On()
+
+DESCRIPTION:
+Adds a handler for the paths that match pattern.  The pattern is 
+added to the route trie a run of literal text or a {name} parameter
+at a time.
+
+RETURN VALUE:
+false if the pattern doesn't parse, it is already taken, or the
+route table or trie is full.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+bool HttpServer::On( const char *pattern, Handler handler )
+{
+    if ( _routeCount >= MAX_ROUTES || pattern[0] != '/' )
+    {
+        return false;
+    }
+
+    // Check the parameters first, so a bad pattern doesn't leave 
+    // half of itself in the trie.  A parameter has a name, and takes
+    // up a whole segment.
+    for ( const char *open = strchr( pattern, '{' ); open != nullptr; open = strchr( open + 1, '{' ) )
+    {
+        const char *close = strchr( open, '}' );
+
+        if ( close == nullptr || close == open + 1 || open[-1] != '/' || 
+             ( close[1] != '\0' && close[1] != '/' ) || memchr( open + 1, '/', close - open ) != nullptr )
+        {
+            return false;
+        }
+    }
+
+    uint8_t node = 0;
+    const char *text = pattern;
+
+    while ( *text != '\0' && node != NONE )
+    {
+        if ( *text == '{' )
+        {
+            const char *end = strchr( text, '}' );
+            const char *name = text + 1;
+            size_t length = end - name;
+
+            if ( _nodes[node].param == NONE )
+            {
+                uint8_t param = addNode( name, length );
+
+                _nodes[node].param = param;
+                node = param;
+            }
+            else
+            {
+                node = _nodes[node].param;
+
+                // Two names for the same parameter
+                if ( _nodes[node].length != length || strncmp( _nodes[node].label, name, length ) != 0 )
+                {
+                    return false;
+                }
+            }
+
+            text = end + 1;
+        }
+        else
+        {
+            size_t length = strcspn( text, "{" );
+
+            node = addLiteral( node, text, length );
+            text += length;
+        }
+    }
+
+    if ( node == NONE || _nodes[node].route != NONE )
+    {
+        return false;
+    }
+
+    _nodes[node].route = (uint8_t) _routeCount;
+    _routes[_routeCount] = handler;
+    _routeCount++;
+
+    return true;
+}
+
+/*======================================================================
+FUNCTION:
+Process()
+
+DESCRIPTION:
+Closes the connections that are finished, or that have gone quiet for
+too long, and handles the next waiting request.  Only one request is
+handled per call; the connections take turns.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void HttpServer::Process()
+{
+    uint32_t now = millis();
+
+    for ( size_t i = 0; i < MAX_CONNECTIONS; i++ )
+    {
+        Connection &connection = _connections[i];
+
+        bool idle = ( connection.state == STATE_READING && connection.received == 0 && connection.requests > 0 );
+        bool close = ( connection.state == STATE_DONE );
+
+        if ( idle == true )
+        {
+            if ( now - connection.lastActivityMS > KEEP_ALIVE_TIMEOUT_MS )
+            {
+                _idleClosed++;
+                close = true;
+            }
+        }
+        else if ( connection.state == STATE_READING || connection.state == STATE_SENDING )
+        {
+            if ( now - connection.lastActivityMS > REQUEST_TIMEOUT_MS )
+            {
+                _timeouts++;
+                close = true;
+            }
+        }
+
+        // This calls back into onDisconnect(), which frees the slot
+        if ( close == true )
+        {
+            connection.client->close( true );
+        }
+    }
+
+    for ( size_t i = 0; i < MAX_CONNECTIONS; i++ )
+    {
+        Connection &connection = _connections[_nextConnection];
+
+        _nextConnection = ( _nextConnection + 1 ) % MAX_CONNECTIONS;
+
+        if ( connection.state == STATE_READY )
+        {
+            dispatch( connection );
+            break;
+        }
+    }
+}
+
+/*======================================================================
+FUNCTION:
+onConnect()
+
+DESCRIPTION:
+Network callback for a new client.  It gets a free connection.  If
+there isn't one, the connection that has been sitting idle between
+requests the longest is closed to make room, and if none are idle 
+the new client is closed.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void HttpServer::onConnect( AsyncClient *client )
+{
+    Connection *connection = nullptr;
+
+    Connection *idlest = nullptr;
+
+    for ( size_t i = 0; i < MAX_CONNECTIONS && connection == nullptr; i++ )
+    {
+        Connection &candidate = _connections[i];
+
+        if ( candidate.state == STATE_FREE )
+        {
+            connection = &candidate;
+        }
+        else if ( candidate.state == STATE_READING && candidate.received == 0 && candidate.requests > 0 &&
+                  ( idlest == nullptr || (int32_t) ( candidate.lastActivityMS - idlest->lastActivityMS ) < 0 ) )
+        {
+            idlest = &candidate;
+        }
+    }
+
+    if ( connection == nullptr && idlest != nullptr )
+    {
+        _idleClosed++;
+
+        // Frees the slot, through onDisconnect()
+        idlest->client->close( true );
+        connection = idlest;
+    }
+
+    if ( connection == nullptr )
+    {
+        _rejected++;
+
+        client->close( true );
+        client->free();
+        delete client;
+        return;
+    }
+
+    reset( *connection );
+
+    connection->client = client;
+    connection->state = STATE_READING;
+    connection->lastActivityMS = millis();
+
+    client->setNoDelay( true );
+
+    client->onData( [this, connection]( void *, AsyncClient *, void *data, size_t length )
+    {
+        onData( *connection, (const char *) data, length );
+    } );
+
+    client->onAck( [this, connection]( void *, AsyncClient *, size_t length, uint32_t )
+    {
+        onAck( *connection, length );
+    } );
+
+    client->onDisconnect( [this, connection]( void *, AsyncClient * )
+    {
+        onDisconnect( *connection );
+    } );
+}
+
+/*======================================================================
+FUNCTION:
+onData()
+
+DESCRIPTION:
+Network callback for bytes from a client.  They are added to the
+connection's buffer - behind the request being answered, if it is
+pipelining - and parsed as they come in.  Nothing is handled here; a
+complete request is left for Process().
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void HttpServer::onData( Connection &connection, const char *data, size_t length )
+{
+    connection.lastActivityMS = millis();
+
+    size_t room = REQUEST_BUFFER_SIZE - connection.received;
+
+    if ( length > room )
+    {
+        length = room;
+        connection.truncated = true;
+    }
+
+    memcpy( connection.request + connection.received, data, length );
+    connection.received += length;
+
+    if ( connection.state == STATE_READING )
+    {
+        parseRequest( connection );
+    }
+}
+
+/*======================================================================
+FUNCTION:
+parseRequest()
+
+DESCRIPTION:
+Checks what has come in for the end of the headers, and then of the
+body.  The connection is READY once a whole request is in (or once it
+is clear the request is one we can't take).
+
+Only the new bytes are looked at (plus the three before them, in case
+the blank line is split across packets), so a request that comes in
+a few bytes at a time isn't scanned over and over.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void HttpServer::parseRequest( Connection &connection )
+{
+    if ( connection.headerLength == 0 )
+    {
+        char *request = connection.request;
+
+        for ( size_t i = connection.scanned; i + 3 < connection.received; i++ )
+        {
+            if ( request[i] == '\r' && request[i + 1] == '\n' && request[i + 2] == '\r' && request[i + 3] == '\n' )
+            {
+                connection.headerLength = i + 4;
+                break;
+            }
+        }
+
+        if ( connection.headerLength == 0 )
+        {
+            connection.scanned = ( connection.received > 3 ) ? connection.received - 3 : 0;
+
+            if ( connection.received == REQUEST_BUFFER_SIZE )
+            {
+                connection.error = 431;
+                connection.state = STATE_READY;
+            }
+
+            return;
+        }
+
+        connection.error = parseHeaders( connection );
+
+        if ( connection.error == 0 && connection.contentLength > REQUEST_BUFFER_SIZE - connection.headerLength )
+        {
+            connection.error = 413;
+        }
+
+        if ( connection.error != 0 )
+        {
+            connection.state = STATE_READY;
+            return;
+        }
+    }
+
+    if ( connection.received >= connection.headerLength + connection.contentLength )
+    {
+        connection.state = STATE_READY;
+    }
+}
+
+/*======================================================================
+FUNCTION:
+onAck()
+
+DESCRIPTION:
+Network callback for the client acknowledging some of the response.
+Sends the next part of it, or moves on once all of it has been taken.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void HttpServer::onAck( Connection &connection, size_t length )
+{
+    if ( connection.state != STATE_SENDING )
+    {
+        return;
+    }
+
+    connection.lastActivityMS = millis();
+    connection.acked += length;
+
+    if ( connection.acked >= connection.total )
+    {
+        nextRequest( connection );
+    }
+    else
+    {
+        sendMore( connection );
+    }
+}
+
+/*======================================================================
+FUNCTION:
+nextRequest()
+
+DESCRIPTION:
+Called once a response has been taken.  If the connection is being
+kept alive, the request is dropped from the front of the buffer and 
+anything pipelined behind it is parsed.  Otherwise the connection is
+left for Process() to close.
+
+If some of what the client pipelined didn't fit in the buffer, the
+requests that did are still answered, but the connection is closed
+at the gap rather than parsing across it.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void HttpServer::nextRequest( Connection &connection )
+{
+    if ( connection.keepAlive == false )
+    {
+        connection.state = STATE_DONE;
+        return;
+    }
+
+    size_t used = connection.headerLength + connection.contentLength;
+    size_t pipelined = connection.received - used;
+
+    memmove( connection.request, connection.request + used, pipelined );
+
+    AsyncClient *client = connection.client;
+    uint32_t requests = connection.requests;
+    bool truncated = connection.truncated;
+
+    reset( connection );
+
+    connection.client = client;
+    connection.requests = requests;
+    connection.truncated = truncated;
+    connection.received = pipelined;
+    connection.state = STATE_READING;
+    connection.lastActivityMS = millis();
+
+    parseRequest( connection );
+
+    if ( connection.state == STATE_READING && connection.truncated == true )
+    {
+        connection.state = STATE_DONE;
+    }
+}
+
+/*======================================================================
+FUNCTION:
+onDisconnect()
+
+DESCRIPTION:
+Network callback for a connection going away, whoever closed it.
+Frees the client and the connection.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void HttpServer::onDisconnect( Connection &connection )
+{
+    AsyncClient *client = connection.client;
+
+    connection.client = nullptr;
+    reset( connection );
+
+    delete client;
+}
+
+/*======================================================================
+FUNCTION:
+reset()
+
+DESCRIPTION:
+Puts a connection back to its unused state.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void HttpServer::reset( Connection &connection )
+{
+    connection.state = STATE_FREE;
+    connection.lastActivityMS = 0;
+
+    connection.received = 0;
+    connection.truncated = false;
+    connection.scanned = 0;
+    connection.headerLength = 0;
+    connection.contentLength = 0;
+
+    connection.method = METHOD_OTHER;
+    connection.uri = nullptr;
+    connection.query = nullptr;
+    connection.form = false;
+    connection.keepAlive = false;
+    connection.requests = 0;
+    connection.error = 0;
+
+    connection.responseLength = 0;
+    connection.body = String();
+    connection.total = 0;
+    connection.sent = 0;
+    connection.acked = 0;
+}
+
+/*======================================================================
+FUNCTION:
+parseHeaders()
+
+DESCRIPTION:
+Splits up the request line and the headers, in place.  Of the
+headers, only the ones that say how to read the body matter to us.
+
+RETURN VALUE:
+0, or the status to answer the request with if it's one we can't take
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+int HttpServer::parseHeaders( Connection &connection )
+{
+    // Lose the blank line so the last header ends the string
+    connection.request[connection.headerLength - 2] = '\0';
+
+    char *cursor = connection.request;
+    char *line = nextLine( cursor );
+
+    // METHOD SP target SP HTTP/1.x.  A request that starts with a nul
+    // has no line at all.
+    char *target = ( line != nullptr ) ? strchr( line, ' ' ) : nullptr;
+
+    if ( target == nullptr )
+    {
+        return 400;
+    }
+
+    *target++ = '\0';
+
+    char *version = strchr( target, ' ' );
+
+    if ( version == nullptr )
+    {
+        return 400;
+    }
+
+    *version++ = '\0';
+
+    if ( strncmp( version, "HTTP/1.", 7 ) != 0 || target[0] != '/' )
+    {
+        return 400;
+    }
+
+    // 1.1 keeps the connection open unless told otherwise, 1.0 closes
+    // it unless asked not to
+    connection.keepAlive = ( strcmp( version + 7, "0" ) != 0 );
+
+    if ( strcmp( line, "GET" ) == 0 )
+    {
+        connection.method = METHOD_GET;
+    }
+    else if ( strcmp( line, "POST" ) == 0 )
+    {
+        connection.method = METHOD_POST;
+    }
+    else if ( strcmp( line, "PUT" ) == 0 )
+    {
+        connection.method = METHOD_PUT;
+    }
+    else if ( strcmp( line, "DELETE" ) == 0 )
+    {
+        connection.method = METHOD_DELETE;
+    }
+
+    connection.uri = target;
+    connection.query = strchr( target, '?' );
+
+    if ( connection.query != nullptr )
+    {
+        *connection.query++ = '\0';
+    }
+
+    while ( ( line = nextLine( cursor ) ) != nullptr )
+    {
+        char *value = strchr( line, ':' );
+
+        if ( value == nullptr )
+        {
+            return 400;
+        }
+
+        *value++ = '\0';
+
+        while ( *value == ' ' || *value == '\t' )
+        {
+            value++;
+        }
+
+        if ( strcasecmp( line, "Content-Length" ) == 0 )
+        {
+            char *end = nullptr;
+
+            if ( *value < '0' || *value > '9' )
+            {
+                return 400;
+            }
+
+            connection.contentLength = strtoul( value, &end, 10 );
+
+            if ( *end != '\0' && *end != ' ' && *end != '\t' )
+            {
+                return 400;
+            }
+        }
+        else if ( strcasecmp( line, "Content-Type" ) == 0 )
+        {
+            connection.form = ( strncasecmp( value, "application/x-www-form-urlencoded", 33 ) == 0 );
+        }
+        else if ( strcasecmp( line, "Connection" ) == 0 )
+        {
+            if ( strncasecmp( value, "close", 5 ) == 0 )
+            {
+                connection.keepAlive = false;
+            }
+            else if ( strncasecmp( value, "keep-alive", 10 ) == 0 )
+            {
+                connection.keepAlive = true;
+            }
+        }
+        else if ( strcasecmp( line, "Transfer-Encoding" ) == 0 )
+        {
+            // No chunked bodies - there is nowhere to put them
+            return 501;
+        }
+    }
+
+    return 0;
+}
+
+/*======================================================================
+FUNCTION:
+dispatch()
+
+DESCRIPTION:
+Runs the handler for a complete request (or answers a bad one), and
+starts sending the response.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void HttpServer::dispatch( Connection &connection )
+{
+    _current = &connection;
+    _responded = false;
+    _argCount = 0;
+    _body = nullptr;
+    _pathArgCount = 0;
+    _extraHeadersLength = 0;
+
+    _requests++;
+    connection.requests++;
+
+    if ( connection.requests > 1 )
+    {
+        _keptAlive++;
+    }
+
+    if ( connection.requests >= MAX_KEEP_ALIVE_REQUESTS )
+    {
+        connection.keepAlive = false;
+    }
+
+    if ( connection.error != 0 )
+    {
+        _badRequests++;
+
+        // We can't tell where the next request would start
+        connection.keepAlive = false;
+
+        Send( connection.error, "text/plain", statusText( connection.error ) );
+    }
+    else
+    {
+        urlDecode( connection.uri );
+
+        parseArgs( connection.query );
+
+        // The byte after the body may be the start of a pipelined
+        // request, so it is put back once we are done
+        char *end = connection.request + connection.headerLength + connection.contentLength;
+        char next = *end;
+
+        if ( connection.contentLength > 0 )
+        {
+            _body = connection.request + connection.headerLength;
+            *end = '\0';
+
+            if ( connection.form == true )
+            {
+                memcpy( _form, _body, connection.contentLength + 1 );
+                parseArgs( _form );
+            }
+        }
+
+        uint8_t route = NONE;
+
+        if ( match( 0, connection.uri, route ) == true && keepPathArgs() == true )
+        {
+            _routes[route]();
+        }
+        else if ( _notFound )
+        {
+            _pathArgCount = 0;
+
+            _notFound();
+        }
+        else
+        {
+            Send( 404, "text/plain", statusText( 404 ) );
+        }
+
+        if ( _responded == false )
+        {
+            Send( 500, "text/plain", statusText( 500 ) );
+        }
+
+        *end = next;
+    }
+
+    _current = nullptr;
+}
+
+/*======================================================================
+FUNCTION:
+addNode()
+
+DESCRIPTION:
+Takes a node for the route trie from the pool.
+
+RETURN VALUE:
+The node, NONE if the pool is used up.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+uint8_t HttpServer::addNode( const char *label, size_t length )
+{
+    if ( _nodeCount >= MAX_ROUTE_NODES || length > 255 )
+    {
+        return NONE;
+    }
+
+    RouteNode &node = _nodes[_nodeCount];
+
+    node.label = label;
+    node.length = (uint8_t) length;
+    node.child = NONE;
+    node.sibling = NONE;
+    node.param = NONE;
+    node.route = NONE;
+
+    return (uint8_t) _nodeCount++;
+}
+
+/*======================================================================
+FUNCTION:
+addLiteral()
+
+DESCRIPTION:
+Adds a run of literal text below node.  It follows the children that
+share a prefix with it, splitting a child's label where the two part
+ways, and adds a child for whatever is left.
+
+RETURN VALUE:
+The node the text ends on, NONE if the pool is used up.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+uint8_t HttpServer::addLiteral( uint8_t node, const char *text, size_t length )
+{
+    while ( length > 0 )
+    {
+        uint8_t child = _nodes[node].child;
+
+        while ( child != NONE && _nodes[child].label[0] != text[0] )
+        {
+            child = _nodes[child].sibling;
+        }
+
+        if ( child == NONE )
+        {
+            child = addNode( text, length );
+
+            if ( child != NONE )
+            {
+                _nodes[child].sibling = _nodes[node].child;
+                _nodes[node].child = child;
+            }
+
+            return child;
+        }
+
+        size_t common = 1;
+
+        while ( common < length && common < _nodes[child].length && _nodes[child].label[common] == text[common] )
+        {
+            common++;
+        }
+
+        // Split the child: its tail (and everything below it) moves
+        // down to a new node
+        if ( common < _nodes[child].length )
+        {
+            uint8_t tail = addNode( _nodes[child].label + common, _nodes[child].length - common );
+
+            if ( tail == NONE )
+            {
+                return NONE;
+            }
+
+            _nodes[tail].child = _nodes[child].child;
+            _nodes[tail].param = _nodes[child].param;
+            _nodes[tail].route = _nodes[child].route;
+
+            _nodes[child].length = (uint8_t) common;
+            _nodes[child].child = tail;
+            _nodes[child].param = NONE;
+            _nodes[child].route = NONE;
+        }
+
+        node = child;
+        text += common;
+        length -= common;
+    }
+
+    return node;
+}
+
+/*======================================================================
+FUNCTION:
+match()
+
+DESCRIPTION:
+Matches the rest of path below node (whose own label has been 
+matched).  The literal child is picked by the path's next character -
+there is at most one - and the parameter child is only tried if that
+doesn't lead anywhere.  Parameter values are noted in _pathArgs as we 
+go.
+
+RETURN VALUE:
+true, with the route, if the path matches one.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+bool HttpServer::match( uint8_t node, const char *path, uint8_t &route )
+{
+    if ( *path == '\0' )
+    {
+        route = _nodes[node].route;
+        return ( route != NONE );
+    }
+
+    for ( uint8_t child = _nodes[node].child; child != NONE; child = _nodes[child].sibling )
+    {
+        if ( _nodes[child].label[0] == *path )
+        {
+            if ( strncmp( path, _nodes[child].label, _nodes[child].length ) == 0 &&
+                 match( child, path + _nodes[child].length, route ) == true )
+            {
+                return true;
+            }
+
+            break;
+        }
+    }
+
+    uint8_t param = _nodes[node].param;
+    size_t length = strcspn( path, "/" );
+
+    if ( param == NONE || length == 0 || _pathArgCount >= MAX_PATH_ARGS )
+    {
+        return false;
+    }
+
+    PathArg &arg = _pathArgs[_pathArgCount++];
+
+    arg.name = _nodes[param].label;
+    arg.nameLength = _nodes[param].length;
+    arg.value = path;
+    arg.valueLength = length;
+
+    if ( match( param, path + length, route ) == true )
+    {
+        return true;
+    }
+
+    _pathArgCount--;
+
+    return false;
+}
+
+/*======================================================================
+FUNCTION:
+keepPathArgs()
+
+DESCRIPTION:
+Copies the matched parameters' values out of the path, so they can be
+nul terminated without cutting the path up.
+
+RETURN VALUE:
+false if they don't fit in PATH_ARGS_SIZE.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+bool HttpServer::keepPathArgs()
+{
+    size_t used = 0;
+
+    for ( size_t i = 0; i < _pathArgCount; i++ )
+    {
+        PathArg &arg = _pathArgs[i];
+
+        if ( used + arg.valueLength + 1 > PATH_ARGS_SIZE )
+        {
+            return false;
+        }
+
+        memcpy( _pathArgValues + used, arg.value, arg.valueLength );
+        _pathArgValues[used + arg.valueLength] = '\0';
+
+        arg.value = _pathArgValues + used;
+        used += arg.valueLength + 1;
+    }
+
+    return true;
+}
+
+/*======================================================================
+FUNCTION:
+parseArgs()
+
+DESCRIPTION:
+Splits name=value&name=value... into the argument list, decoding
+each in place.  An argument without a value gets an empty one, and
+any past MAX_ARGS are dropped.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void HttpServer::parseArgs( char *text )
+{
+    while ( text != nullptr && *text != '\0' && _argCount < MAX_ARGS )
+    {
+        char *name = text;
+
+        text = strchr( text, '&' );
+
+        if ( text != nullptr )
+        {
+            *text++ = '\0';
+        }
+
+        if ( *name == '\0' )
+        {
+            continue;
+        }
+
+        char *value = strchr( name, '=' );
+
+        if ( value != nullptr )
+        {
+            *value++ = '\0';
+        }
+        else
+        {
+            value = name + strlen( name );
+        }
+
+        urlDecode( name );
+        urlDecode( value );
+
+        _argNames[_argCount] = name;
+        _argValues[_argCount] = value;
+        _argCount++;
+    }
+}
+
+/*======================================================================
+FUNCTION:
+GetMethod()
+
+DESCRIPTION:
+The method of the request being handled.
+
+RETURN VALUE:
+The method, METHOD_OTHER outside of a handler.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+HttpServer::Method HttpServer::GetMethod() const
+{
+    return ( _current == nullptr ) ? METHOD_OTHER : _current->method;
+}
+
+/*======================================================================
+FUNCTION:
+GetUri()
+
+DESCRIPTION:
+The path of the request being handled, without the query string.
+
+RETURN VALUE:
+The path, "" outside of a handler.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+const char *HttpServer::GetUri() const
+{
+    return ( _current == nullptr ) ? "" : _current->uri;
+}
+
+/*======================================================================
+FUNCTION:
+GetArg()
+
+DESCRIPTION:
+Finds an argument of the request being handled by name.
+
+RETURN VALUE:
+The argument's value, nullptr if it wasn't given.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+const char *HttpServer::GetArg( const char *name ) const
+{
+    for ( size_t i = 0; i < _argCount; i++ )
+    {
+        if ( strcmp( _argNames[i], name ) == 0 )
+        {
+            return _argValues[i];
+        }
+    }
+
+    return nullptr;
+}
+
+/*======================================================================
+FUNCTION:
+GetPathArg()
+
+DESCRIPTION:
+Finds a {name} parameter of the matched route by name.
+
+RETURN VALUE:
+The parameter's value, nullptr if the route doesn't have it.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+const char *HttpServer::GetPathArg( const char *name ) const
+{
+    for ( size_t i = 0; i < _pathArgCount; i++ )
+    {
+        const PathArg &arg = _pathArgs[i];
+
+        if ( strncmp( arg.name, name, arg.nameLength ) == 0 && name[arg.nameLength] == '\0' )
+        {
+            return arg.value;
+        }
+    }
+
+    return nullptr;
+}
+
+/*======================================================================
+FUNCTION:
+SendHeader()
+
+DESCRIPTION:
+Adds a header to the response to the request being handled.  It has
+to be called before Send(), and headers that don't fit in
+EXTRA_HEADERS_SIZE are dropped.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void HttpServer::SendHeader( const char *name, const char *value )
+{
+    size_t room = EXTRA_HEADERS_SIZE - _extraHeadersLength;
+    int length = snprintf( _extraHeaders + _extraHeadersLength, room, "%s: %s\r\n", name, value );
+
+    if ( length > 0 && (size_t) length < room )
+    {
+        _extraHeadersLength += length;
+    }
+    else
+    {
+        _extraHeaders[_extraHeadersLength] = '\0';
+    }
+}
+
+/*======================================================================
+FUNCTION:
+Send()
+
+DESCRIPTION:
+Answers the request being handled.  Only the first call counts.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void HttpServer::Send( int code, const char *contentType, const char *body )
+{
+    send( code, contentType, body, strlen( body ), nullptr );
+}
+
+void HttpServer::Send( int code, const char *contentType, const String &body )
+{
+    send( code, contentType, body.c_str(), body.length(), &body );
+}
+
+/*======================================================================
+FUNCTION:
+send()
+
+DESCRIPTION:
+Builds the response in the connection's buffer - the body too, if it
+fits.  If it doesn't it is kept in the connection's String (taken
+from owner, when the caller has one).  Then starts sending.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void HttpServer::send( int code, const char *contentType, const char *body, size_t length, const String *owner )
+{
+    if ( _current == nullptr || _responded == true )
+    {
+        return;
+    }
+
+    _responded = true;
+
+    Connection &connection = *_current;
+
+    int headerLength = snprintf( connection.response, RESPONSE_BUFFER_SIZE,
+                                 "HTTP/1.1 %d %s\r\n"
+                                 "Content-Type: %s\r\n"
+                                 "Content-Length: %u\r\n"
+                                 "%s"
+                                 "%.*s\r\n",
+                                 code, statusText( code ), contentType, (unsigned) length,
+                                 ( connection.keepAlive == true ) ? KEEP_ALIVE_HEADERS : CLOSE_HEADERS,
+                                 (int) _extraHeadersLength, _extraHeaders );
+
+    // Can't happen with the headers we have room for, but don't
+    // send half of them if it does
+    if ( headerLength < 0 || (size_t) headerLength >= RESPONSE_BUFFER_SIZE )
+    {
+        headerLength = snprintf( connection.response, RESPONSE_BUFFER_SIZE,
+                                 "HTTP/1.1 500 %s\r\nContent-Length: 0\r\n%s\r\n",
+                                 statusText( 500 ), CLOSE_HEADERS );
+        length = 0;
+        connection.keepAlive = false;
+    }
+
+    connection.responseLength = headerLength;
+
+    if ( connection.responseLength + length <= RESPONSE_BUFFER_SIZE )
+    {
+        memcpy( connection.response + connection.responseLength, body, length );
+        connection.responseLength += length;
+    }
+    else if ( owner != nullptr )
+    {
+        connection.body = *owner;
+    }
+    else
+    {
+        connection.body = body;
+    }
+
+    connection.total = connection.responseLength + connection.body.length();
+    connection.sent = 0;
+    connection.acked = 0;
+    connection.state = STATE_SENDING;
+    connection.lastActivityMS = millis();
+
+    sendMore( connection );
+}
+
+/*======================================================================
+FUNCTION:
+sendMore()
+
+DESCRIPTION:
+Hands the network stack as much of the response as it has room for.
+The data isn't copied - it stays put in the connection until the
+client has acknowledged it.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void HttpServer::sendMore( Connection &connection )
+{
+    while ( connection.sent < connection.total )
+    {
+        const char *data;
+        size_t available;
+
+        if ( connection.sent < connection.responseLength )
+        {
+            data = connection.response + connection.sent;
+            available = connection.responseLength - connection.sent;
+        }
+        else
+        {
+            size_t offset = connection.sent - connection.responseLength;
+
+            data = connection.body.c_str() + offset;
+            available = connection.body.length() - offset;
+        }
+
+        size_t space = connection.client->space();
+
+        if ( space == 0 )
+        {
+            break;
+        }
+
+        size_t added = connection.client->add( data, ( available < space ) ? available : space, 0 );
+
+        if ( added == 0 )
+        {
+            break;
+        }
+
+        connection.sent += added;
+    }
+
+    connection.client->send();
+}
+
+/*======================================================================
+FUNCTION:
+Report()
+
+DESCRIPTION:
+Formats the connection and request counts for a status page.
+
+RETURN VALUE:
+The report.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+String HttpServer::Report() const
+{
+    size_t open = 0;
+
+    for ( size_t i = 0; i < MAX_CONNECTIONS; i++ )
+    {
+        if ( _connections[i].state != STATE_FREE )
+        {
+            open++;
+        }
+    }
+
+    char report[224];
+
+    snprintf( report, sizeof( report ),
+              "connections: %u of %u\n"
+              "requests: %u\n"
+              "bad requests: %u\n"
+              "on kept alive connections: %u\n"
+              "turned away: %u\n"
+              "timed out: %u\n"
+              "idle closed: %u\n",
+              (unsigned) open, (unsigned) MAX_CONNECTIONS, (unsigned) _requests,
+              (unsigned) _badRequests, (unsigned) _keptAlive, (unsigned) _rejected,
+              (unsigned) _timeouts, (unsigned) _idleClosed );
+
+    return String( report );
+}
+
+/*======================================================================
+FUNCTION:
+urlDecode()
+
+DESCRIPTION:
+Decodes %xx escapes, and + as a space, in place.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void HttpServer::urlDecode( char *text )
+{
+    char *out = text;
+
+    for ( const char *in = text; *in != '\0'; in++ )
+    {
+        if ( *in == '+' )
+        {
+            *out++ = ' ';
+        }
+        else if ( in[0] == '%' && hexValue( in[1] ) >= 0 && hexValue( in[2] ) >= 0 )
+        {
+            *out++ = (char) ( hexValue( in[1] ) * 16 + hexValue( in[2] ) );
+            in += 2;
+        }
+        else
+        {
+            *out++ = *in;
+        }
+    }
+
+    *out = '\0';
+}
+
+/*======================================================================
+FUNCTION:
+statusText()
+
+DESCRIPTION:
+The reason phrase for the status codes we send.
+
+RETURN VALUE:
+The phrase.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+const char *HttpServer::statusText( int code )
+{
+    switch ( code )
+    {
+        case 200: return "OK";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 413: return "Payload Too Large";
+        case 431: return "Request Header Fields Too Large";
+        case 500: return "Internal Server Error";
+        case 501: return "Not Implemented";
+        default: return "Unknown";
+    }
+}
+
+/*======================================================================
+FUNCTION:
+nextLine()
+
+DESCRIPTION:
+Cuts the next CRLF terminated line off of cursor.
+
+RETURN VALUE:
+The line, nullptr when there are none left.
+
+SIDE EFFECTS:
+cursor moves past the line.
+
+======================================================================*/
+static char *nextLine( char *&cursor )
+{
+    if ( cursor == nullptr || *cursor == '\0' )
+    {
+        return nullptr;
+    }
+
+    char *line = cursor;
+    char *end = strstr( cursor, "\r\n" );
+
+    if ( end != nullptr )
+    {
+        *end = '\0';
+        cursor = end + 2;
+    }
+    else
+    {
+        cursor = nullptr;
+    }
+
+    return line;
+}
+
+/*======================================================================
+FUNCTION:
+hexValue()
+
+DESCRIPTION:
+The value of a hex digit.
+
+RETURN VALUE:
+0..15, or -1 if c isn't one.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+static int hexValue( char c )
+{
+    if ( c >= '0' && c <= '9' )
+    {
+        return c - '0';
+    }
+
+    if ( c >= 'a' && c <= 'f' )
+    {
+        return c - 'a' + 10;
+    }
+
+    if ( c >= 'A' && c <= 'F' )
+    {
+        return c - 'A' + 10;
+    }
+
+    return -1;
+}
+
+/*=====================================================================
+// IMPLEMENTATION NOTES
+//=====================================================================
+
+None
+
+=====================================================================*/
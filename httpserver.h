@@ -0,0 +1,452 @@
+#ifndef _JAROFLIGHT_HTTPSERVER_H_
+#define _JAROFLIGHT_HTTPSERVER_H_
+
+/*======================================================================
+FILE:
+httpserver.h
+
+CREATOR:
+Sean Foley
+
+DESCRIPTION:
+A small HTTP server built on the asynchronous (callback based) TCP
+library, so no client can hold up the main loop.
+
+PUBLIC CLASSES AND FUNCTIONS:
+HttpServer
+
+Copyright (C) 2017 Sean Foley  All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted.  Enjoy.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+======================================================================*/
+
+//======================================================================
+// INCLUDES AND PUBLIC DATA DECLARATIONS
+//======================================================================
+
+//----------------------------------------------------------------------
+// Defines
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Include Files
+//----------------------------------------------------------------------
+
+#include <functional>
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <ESPAsyncTCP.h>
+#include "WString.h"
+
+//----------------------------------------------------------------------
+// Type Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Constant Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Data Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//======================================================================
+// WARNINGS!!!
+//======================================================================
+
+// None.
+
+//======================================================================
+// FUNCTION DECLARATIONS
+//======================================================================
+
+// None.
+
+//=====================================================================
+// EXCEPTION CLASS DEFINITIONS
+//=====================================================================
+
+// None.
+
+//======================================================================
+// CLASS DEFINITIONS
+//======================================================================
+
+/*======================================================================
+CLASS:
+HttpServer
+
+DESCRIPTION:
+An HTTP/1.1 server for a handful of clients at once, built on
+ESPAsyncTCP.  The network stack hands us bytes as they arrive, and
+each connection's request is parsed a packet at a time into a buffer
+of its own - a client that trickles its request in, or stops halfway,
+only ties up its own connection.
+
+The handlers are not run from the network callbacks.  A complete
+request waits for Process(), which runs one handler per call from the
+main loop, so handlers can safely touch the animator and the file
+system, and a burst of requests is spread out over several passes of
+the loop instead of holding up a frame.
+
+Each connection's response (status line, headers and any body that
+fits) is built in a buffer that is allocated with the connection, and
+handed to the network stack without being copied.  The rest goes out
+as the client acknowledges what it has, again from callbacks, so a
+slow reader doesn't block anything either.  Only bodies too big for
+the buffer are kept in a String.
+
+Connections are kept open between requests (HTTP/1.1's default, or
+when an HTTP/1.0 client asks), so a script that polls or sends a 
+burst of commands only pays for the handshake once.  An idle
+connection is closed after KEEP_ALIVE_TIMEOUT_MS, or sooner if a new
+client needs its slot.  Requests can be pipelined: whatever comes in
+behind the request being answered waits in the buffer, and is picked
+up once the response has been taken, so the answers go back in order.
+
+Requests are routed with a compact trie of the handlers' paths, built
+as they are added (from a fixed pool of nodes - nothing is allocated).
+A path can have {name} parameters that match one segment, e.g. 
+/led/command/{name}, which the handler gets with GetPathArg().  The
+lookup walks the request's path once, picking each branch by its first
+character, so it doesn't get slower as routes are added.  Literal 
+segments win over parameters.  Paths that match nothing go to the
+OnNotFound() handler.
+
+The request being handled is available from the Get*() calls, and the
+handler answers it with Send().  The arguments are the query string's
+and, for a form encoded POST, the body's.  The body itself is there as
+is from GetBody().
+
+HOW TO USE:
+1. Construct with the port to listen on
+2. Add the handlers with On() (and OnNotFound())
+3. Call Begin() once the network is up
+4. Call Process() often - the handlers are run from there
+
+======================================================================*/
+class HttpServer
+{
+    public:
+
+    //=================================================================
+    // TYPE DECLARATIONS AND CONSTANTS    
+    //=================================================================
+
+    enum Method
+    {
+        METHOD_GET = 0,
+        METHOD_POST,
+        METHOD_PUT,
+        METHOD_DELETE,
+        METHOD_OTHER
+    };
+
+    typedef std::function< void( void ) > Handler;
+
+    // Clients we serve at once.  Any more are turned away.
+    static const size_t MAX_CONNECTIONS = 4;
+
+    // A whole request (request line, headers and body) has to fit in
+    // this, or it gets a 431 (or 413 for the body)
+    static const size_t REQUEST_BUFFER_SIZE = 1024;
+
+    // The status line and headers, and the body when it fits
+    static const size_t RESPONSE_BUFFER_SIZE = 768;
+
+    // Room for headers added with SendHeader()
+    static const size_t EXTRA_HEADERS_SIZE = 192;
+
+    static const size_t MAX_ARGS = 16;
+    static const size_t MAX_ROUTES = 32;
+
+    // Nodes in the route trie, about two per route
+    static const size_t MAX_ROUTE_NODES = 64;
+
+    // {name} parameters in a path, and room for their values
+    static const size_t MAX_PATH_ARGS = 4;
+    static const size_t PATH_ARGS_SIZE = 64;
+
+    // A client has this long to send its request, or to take each
+    // part of the response
+    static const uint32_t REQUEST_TIMEOUT_MS = 5000;
+
+    // How long a kept alive connection can sit idle, and how many
+    // requests it can make before we close it
+    static const uint32_t KEEP_ALIVE_TIMEOUT_MS = 10000;
+    static const uint32_t MAX_KEEP_ALIVE_REQUESTS = 100;
+
+    //=================================================================
+    // CLIENT INTERFACE
+    //=================================================================
+
+    HttpServer( uint16_t port = 80 );
+
+    void Begin();
+
+    // Runs a waiting request's handler and closes connections that
+    // are done or timed out.  Never blocks.
+    void Process();
+
+    // Calls handler for requests whose path matches pattern, whatever
+    // the method.  A {name} part of the pattern matches any one path
+    // segment.  The pattern isn't copied, so it has to stay around 
+    // (a string literal is fine).  Returns false if the pattern 
+    // doesn't parse, is already taken, or there is no room for it.
+    bool On( const char *pattern, Handler handler );
+
+    // Calls handler for requests no other handler takes
+    void OnNotFound( Handler handler ) { _notFound = handler; }
+
+    //
+    // The request being handled.  Only good inside a handler.
+    //
+    Method GetMethod() const;
+    const char *GetUri() const;
+
+    size_t GetArgCount() const { return _argCount; }
+    const char *GetArgName( size_t index ) const { return _argNames[index]; }
+    const char *GetArg( size_t index ) const { return _argValues[index]; }
+
+    // The named argument's value, nullptr if it wasn't given
+    const char *GetArg( const char *name ) const;
+
+    // The value of the path's {name} parameter, nullptr if the route
+    // doesn't have one by that name
+    const char *GetPathArg( const char *name ) const;
+
+    // The body, nul terminated, or nullptr if there isn't one.  The
+    // handler is free to change it in place.
+    char *GetBody() const { return _body; }
+
+    // True if the body is a form, whose fields are in the arguments
+    bool IsForm() const { return _current != nullptr && _current->form; }
+
+    //
+    // Answering the request.  Headers go first, then one Send().
+    //
+    void SendHeader( const char *name, const char *value );
+    void Send( int code, const char *contentType, const char *body );
+    void Send( int code, const char *contentType, const String &body );
+
+    // Connection and request counts, formatted for a status page
+    String Report() const;
+
+    protected:
+
+    //=================================================================
+    // SUBCLASS INTERFACE   
+    //=================================================================
+
+    // None.
+
+    private:
+
+    //=================================================================
+    // CUSTOMIZATION INTERFACE    
+    //=================================================================
+
+    // None.
+
+    //=================================================================
+    // IMPLEMENTATION INTERFACE    
+    //=================================================================
+
+    enum State
+    {
+        STATE_FREE = 0,
+        STATE_READING,      // waiting on the rest of the request
+        STATE_READY,        // waiting for Process() to handle it
+        STATE_SENDING,      // waiting on the client to take the response
+        STATE_DONE          // waiting for Process() to close it
+    };
+
+    struct Connection
+    {
+        AsyncClient *client;
+        State state;
+        uint32_t lastActivityMS;
+
+        // The request as it comes in, and any pipelined behind it.
+        // headerLength is 0 until the blank line after the headers is
+        // in, and scanned is how far we have looked for it.  truncated
+        // is set if some of what came in didn't fit.
+        char request[REQUEST_BUFFER_SIZE + 1];
+        size_t received;
+        bool truncated;
+        size_t scanned;
+        size_t headerLength;
+        size_t contentLength;
+
+        // Set by parseHeaders()
+        Method method;
+        char *uri;
+        char *query;
+        bool form;
+        bool keepAlive;
+
+        // Requests answered on this connection
+        uint32_t requests;
+
+        // If not 0, the status to answer with instead of a handler
+        int error;
+
+        // What we send, and how far the client has got with it
+        char response[RESPONSE_BUFFER_SIZE];
+        size_t responseLength;
+        String body;
+        size_t total;
+        size_t sent;
+        size_t acked;
+    };
+
+    // A node of the route trie.  Each node matches its label, or for
+    // a parameter node one path segment (the label is then the 
+    // parameter's name).  Children are a list through sibling, with 
+    // the parameter child kept apart so literals are tried first.
+    struct RouteNode
+    {
+        const char *label;
+        uint8_t length;
+        uint8_t child;
+        uint8_t sibling;
+        uint8_t param;
+        uint8_t route;
+    };
+
+    struct PathArg
+    {
+        const char *name;
+        uint8_t nameLength;
+        const char *value;
+        size_t valueLength;
+    };
+
+    // No node, or no route
+    static const uint8_t NONE = 0xFF;
+
+    // No copying - intentionally not defining the implementation
+    // to throw a link error if someone somehow invokes a copy.
+    HttpServer( const HttpServer &rhs );
+
+    // Network callbacks
+    void onConnect( AsyncClient *client );
+    void onData( Connection &connection, const char *data, size_t length );
+    void onAck( Connection &connection, size_t length );
+    void onDisconnect( Connection &connection );
+
+    // Looks for a complete request in what has come in so far
+    void parseRequest( Connection &connection );
+
+    // Once a response has been taken, moves on to the next request
+    // (or closes the connection)
+    void nextRequest( Connection &connection );
+
+    // Picks apart the request line and headers.  Returns 0, or the
+    // status to answer a bad request with.
+    int parseHeaders( Connection &connection );
+
+    void dispatch( Connection &connection );
+
+    // Route trie
+    uint8_t addNode( const char *label, size_t length );
+    uint8_t addLiteral( uint8_t node, const char *text, size_t length );
+    bool match( uint8_t node, const char *path, uint8_t &route );
+    bool keepPathArgs();
+    void parseArgs( char *text );
+
+    void send( int code, const char *contentType, const char *body, size_t length, const String *owner );
+    void sendMore( Connection &connection );
+
+    void reset( Connection &connection );
+
+    static void urlDecode( char *text );
+    static const char *statusText( int code );
+
+    //=================================================================
+    // DATA MEMBERS    
+    //=================================================================
+
+    AsyncServer _server;
+
+    Connection _connections[MAX_CONNECTIONS];
+
+    // Where Process() looks for a waiting request first, so every
+    // connection gets its turn
+    size_t _nextConnection;
+
+    Handler _routes[MAX_ROUTES];
+    size_t _routeCount;
+    Handler _notFound;
+
+    // The trie; node 0 is the root
+    RouteNode _nodes[MAX_ROUTE_NODES];
+    size_t _nodeCount;
+
+    // The request being handled, and whether it has been answered
+    Connection *_current;
+    bool _responded;
+
+    const char *_argNames[MAX_ARGS];
+    const char *_argValues[MAX_ARGS];
+    size_t _argCount;
+    char *_body;
+
+    // The matched route's {name} parameters
+    PathArg _pathArgs[MAX_PATH_ARGS];
+    size_t _pathArgCount;
+    char _pathArgValues[PATH_ARGS_SIZE];
+
+    // A form body is decoded into here, leaving the original alone
+    char _form[REQUEST_BUFFER_SIZE + 1];
+
+    char _extraHeaders[EXTRA_HEADERS_SIZE];
+    size_t _extraHeadersLength;
+
+    uint32_t _requests;
+    uint32_t _badRequests;
+    uint32_t _rejected;
+    uint32_t _timeouts;
+    uint32_t _keptAlive;
+    uint32_t _idleClosed;
+};
+
+//======================================================================
+// INLINE FUNCTION DEFINITIONS
+//======================================================================
+
+// None.
+
+
+/*======================================================================
+// DOCUMENTATION
+========================================================================
+
+None.
+
+======================================================================*/
+
+#endif	// #ifendif _JAROFLIGHT_HTTPSERVER_H_
@@ -62,17 +62,42 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 // For the board-level leds
 #include "ledhelper.h"
 
+// Runs everything loop() does
+#include "taskscheduler.h"
+
 // Other feature support
 #include "webserverproxy.h"
 #include "firmwareupdater.h"
 #include "timeproxy.h"
 #include "discoveryproxy.h"
+#include "wifiproxy.h"
+#include "syncproxy.h"
+#include "websocketproxy.h"
+#include "realtimeproxy.h"
+
+// So we come back up the way we went down
+#include "settingsstore.h"
+
+// Timed animation changes
+#include "schedulestore.h"
 
 //----------------------------------------------------------------------
 // Type Declarations
 //----------------------------------------------------------------------
 
-// None.
+// Describes one neopixel strip hooked up to the controller
+struct StripConfig
+{
+    uint8_t gpioDataPin;
+    uint32_t pixelCount;
+};
+
+// When (micros() since reset) we got to some point in the boot
+struct BootPhase
+{
+    const char *name;
+    uint32_t timeUS;
+};
 
 //----------------------------------------------------------------------
 // Global Constant Definitions
@@ -90,17 +115,59 @@ const int STATE_WIFI_AP_CONFIG_MODE   = 3;
 const int STATE_WIFI_STA_DISCONNECTED = 4;
 const int STATE_WIFI_STA_CONNECTED    = 5;
 const int STATE_READY                 = 6;
+const int STATE_WIFI_STA_CONNECTING   = 7;
+
+// How often (in microseconds) each of our tasks runs.  The animators
+// and the web server run on every pass, they have their own clocks.
+// NTP does too: the sooner we see a reply, the better the timestamp.
+const uint32_t TASK_PERIOD_NETWORK_US    = 20000UL;
+const uint32_t TASK_PERIOD_OTA_US        = 20000UL;
+const uint32_t TASK_PERIOD_MDNS_US       = 50000UL;
+const uint32_t TASK_PERIOD_NTP_US        = 0;
+const uint32_t TASK_PERIOD_STATUS_LED_US = 10000UL;
+const uint32_t TASK_PERIOD_SETTINGS_US   = 1000000UL;
+const uint32_t TASK_PERIOD_SYNC_US       = 20000UL;
+const uint32_t TASK_PERIOD_SCHEDULE_US   = 1000000UL;
+
+// Schedule rules are in local time.  This is a POSIX TZ rule, so DST
+// is handled, e.g. "EST5EDT,M3.2.0,M11.1.0" for US Eastern or 
+// "CET-1CEST,M3.5.0,M10.5.0/3" for Central Europe.  See TimeZone.
+const char *TIMEZONE = "UTC0";
+
+// When true, every jar on the network shows the same animation, in
+// step (see SyncProxy)
+const bool FLEET_SYNC = true;
+
+// When true, lighting software can drive the pixels over DDP or 
+// E1.31 (see RealtimeProxy).  For E1.31, the strip starts at this 
+// universe and address.
+const bool REALTIME_PIXELS = true;
+const uint16_t REALTIME_UNIVERSE = 1;
+const uint16_t REALTIME_ADDRESS = 1;
+
+// How many boot phases we keep timestamps for
+const size_t MAX_BOOT_PHASES = 8;
 
 // This will make it easier to pass around colors.
-// Values are grbw respectively.
-const uint32_t COLOR_GREEN  = LedAnimator::Color( 255, 0, 0, 0 );
-const uint32_t COLOR_YELLOW = LedAnimator::Color( 140, 255, 0, 0 );
-const uint32_t COLOR_RED    = LedAnimator::Color( 0, 255, 0, 0 );
+// Values are rgbw respectively.
+const uint32_t COLOR_GREEN  = LedAnimator::Color( 0, 255, 0, 0 );
+const uint32_t COLOR_YELLOW = LedAnimator::Color( 255, 140, 0, 0 );
+const uint32_t COLOR_RED    = LedAnimator::Color( 255, 0, 0, 0 );
 const uint32_t COLOR_BLUE   = LedAnimator::Color( 0, 0, 255, 0 );
 const uint32_t COLOR_WHITE  = LedAnimator::Color( 0, 0, 0, 255 );
 const uint32_t COLOR_BLACK  = LedAnimator::Color( 0, 0, 0, 0 );
 const uint32_t COLOR_ALL    = LedAnimator::Color( 255, 255, 255, 255 );
 
+// All of the strips we drive. Each one gets its own LedAnimator (and
+// its own animation timeline).  The first strip is the one the web
+// server controls. Add more entries here to drive more strips.
+const StripConfig STRIPS[] =
+{
+    { GPIO_PIXEL_DATA_PIN, NEOPIXEL_COUNT }
+};
+
+const size_t STRIP_COUNT = sizeof( STRIPS ) / sizeof( STRIPS[0] );
+
 //----------------------------------------------------------------------
 // Global Data Definitions
 //----------------------------------------------------------------------
@@ -108,14 +175,31 @@ const uint32_t COLOR_ALL    = LedAnimator::Color( 255, 255, 255, 255 );
 LedHelper activityLed( PIN_ACTIVITY_LED );
 LedHelper networkLed( PIN_NETWORK_LED );
 
+// One animator per strip
+std::shared_ptr<LedAnimator> ledAnimators[STRIP_COUNT];
+
 // This object is shared (aggregated) between
 // this code in our main loop and the WebserverProxy
 std::shared_ptr<LedAnimator> ledAnimator;
 
+WifiProxy wifiProxy( WLAN_SSID, WLAN_PASS );
+
 std::unique_ptr<WebserverProxy> webserverProxy;
 std::unique_ptr<FirmwareUpdater> firmwareUpdater;
 std::unique_ptr<TimeProxy> timeProxy;
 std::unique_ptr<DiscoveryProxy> discoveryProxy;
+std::unique_ptr<SyncProxy> syncProxy;
+std::unique_ptr<WebSocketProxy> webSocketProxy;
+std::unique_ptr<RealtimeProxy> realtimeProxy;
+
+TaskScheduler scheduler;
+
+SettingsStore settingsStore;
+
+std::shared_ptr<ScheduleStore> schedule;
+
+BootPhase bootPhases[MAX_BOOT_PHASES];
+size_t bootPhaseCount = 0;
 
 volatile int activeState = STATE_INITIALIZING;
 
@@ -129,7 +213,16 @@ volatile int activeState = STATE_INITIALIZING;
 // Function Prototypes
 //----------------------------------------------------------------------
 
-// None.
+static void processAnimators();
+static void processNetwork();
+static void stepNetwork();
+static void processStatusLeds();
+static void processSettings();
+static void restoreAnimation( const SettingsStore::Settings &settings );
+static void markBootPhase( const char *name );
+static void addTask( const char *name, uint32_t periodUS, TaskScheduler::TaskFunction function );
+static uint64_t sharedClock();
+static String bootReport();
 
 //----------------------------------------------------------------------
 // Required Libraries
@@ -144,104 +237,214 @@ volatile int activeState = STATE_INITIALIZING;
 
 /*======================================================================
 FUNCTION:
-onWiFiEvent()
+setup()
 
 DESCRIPTION:
-Callback handler for various wifi events
+Put your one-time initialization/setup code here
 
 RETURN VALUE:
 none.
 
 SIDE EFFECTS:
-Changes the value of the activeState varaible
+none
 
 ======================================================================*/
-static void onWiFiEvent( WiFiEvent_t event )
+void setup()
 {
-    Serial.printf( "**Wifi event %d\n", event );
+    markBootPhase( "setup" );
+
+    // Read the saved settings before anything else, so we can pick
+    // up where we left off rather than starting from scratch
+    bool restored = settingsStore.Begin();
 
-    switch ( event )
+    markBootPhase( "settings" );
+
+    for ( size_t i = 0; i < STRIP_COUNT; i++ )
     {
-        case WIFI_EVENT_STAMODE_CONNECTED:
+        if ( ledAnimators[i] == false )
+        {
+            ledAnimators[i].reset(
+                new LedAnimator( STRIPS[i].gpioDataPin, STRIPS[i].pixelCount )
+            );
+        }
 
-            break;
-           
-        case WIFI_EVENT_STAMODE_DISCONNECTED:
-            
-            activeState = STATE_WIFI_STA_DISCONNECTED;
-            break;
+        ledAnimators[i]->TurnAllOff();
 
-        
-        case WIFI_EVENT_STAMODE_AUTHMODE_CHANGE:
+        if ( FLEET_SYNC == true )
+        {
+            ledAnimators[i]->SetClock( sharedClock );
+        }
 
-            break;
-            
-        case WIFI_EVENT_STAMODE_GOT_IP:
-            // When we have this event, we should be fully 
-            // good-to-go on the network.
-            break;
+        // Start animating.  The first strip is the one the web server
+        // controls, so it is the one with saved settings.
+        if ( i == 0 && restored == true )
+        {
+            restoreAnimation( settingsStore.Get() );
+        }
+        else
+        {
+            ledAnimators[i]->Demo();
+        }
+    }
 
-        case WIFI_EVENT_STAMODE_DHCP_TIMEOUT:
-        case WIFI_EVENT_SOFTAPMODE_STACONNECTED:
-        case WIFI_EVENT_SOFTAPMODE_STADISCONNECTED:
-        case WIFI_EVENT_SOFTAPMODE_PROBEREQRECVED:
-        case WIFI_EVENT_MAX:
-        case WIFI_EVENT_MODE_CHANGE:
-            break;
+    ledAnimator = ledAnimators[0];
+
+    // Skip the scan and DHCP if we can
+    if ( restored == true )
+    {
+        wifiProxy.SetFastConnect( settingsStore.Get().network );
     }
+
+    // The schedule drives the first strip, like the web server
+    schedule.reset( new ScheduleStore( ledAnimator ) );
+    schedule->Begin();
+
+    markBootPhase( "animators" );
+
+    // Everything loop() does is a task.  Nothing here is allowed to
+    // block - see TaskScheduler.
+    addTask( "animator", 0, processAnimators );
+
+    addTask( "network", TASK_PERIOD_NETWORK_US, processNetwork );
+
+    addTask( "web", 0, []()
+    {
+        if ( webserverProxy != nullptr ) { webserverProxy->Process(); }
+    } );
+
+    // Every pass, how often we read the sockets is the latency
+    addTask( "websocket", 0, []()
+    {
+        if ( webSocketProxy != nullptr ) { webSocketProxy->Process(); }
+    } );
+
+    // Every pass too, so packets don't back up in the stack
+    addTask( "realtime", 0, []()
+    {
+        if ( realtimeProxy != nullptr ) { realtimeProxy->Process(); }
+    } );
+
+    addTask( "ota", TASK_PERIOD_OTA_US, []()
+    {
+        if ( firmwareUpdater != nullptr ) { firmwareUpdater->Process(); }
+    } );
+
+    addTask( "mdns", TASK_PERIOD_MDNS_US, []()
+    {
+        if ( discoveryProxy != nullptr ) { discoveryProxy->Process(); }
+    } );
+
+    addTask( "ntp", TASK_PERIOD_NTP_US, []()
+    {
+        if ( timeProxy != nullptr ) { timeProxy->Process(); }
+    } );
+
+    // The activity led shows a heartbeat, or blinks fast while
+    // a firmware update is coming in
+    activityLed.Play( LedHelper::HEARTBEAT );
+
+    addTask( "status-led", TASK_PERIOD_STATUS_LED_US, processStatusLeds );
+
+    addTask( "settings", TASK_PERIOD_SETTINGS_US, processSettings );
+
+    addTask( "sync", TASK_PERIOD_SYNC_US, []()
+    {
+        if ( syncProxy != nullptr ) { syncProxy->Process(); }
+    } );
+
+    // Rules can only fire once we know what time it is
+    addTask( "schedule", TASK_PERIOD_SCHEDULE_US, []()
+    {
+        if ( timeProxy != nullptr && timeProxy->IsSynced() == true ) 
+        { 
+            schedule->Process( *timeProxy ); 
+        }
+    } );
 }
 
 /*======================================================================
 FUNCTION:
-connectWifi()
+sharedClock()
 
 DESCRIPTION:
-Attempts to connect to the wireless AP
+The clock the animators keep in step with: NTP time, once we have it.
 
 RETURN VALUE:
-True if connected
+Microseconds since the unix epoch, or 0 if we aren't synced yet.
 
 SIDE EFFECTS:
-none.
+none
 
 ======================================================================*/
-bool connectWifi()
+static uint64_t sharedClock()
 {
-    bool connected = false;
+    if ( timeProxy == nullptr || timeProxy->IsSynced() == false )
+    {
+        return 0;
+    }
 
-    // Set our callback handler
-    WiFi.onEvent( onWiFiEvent, WIFI_EVENT_ANY );
+    return timeProxy->GetTimeMicros();
+}
 
-    WiFi.begin( WLAN_SSID, WLAN_PASS );
+/*======================================================================
+FUNCTION:
+restoreAnimation()
 
-    WiFi.persistent( false );
-    WiFi.mode( WIFI_OFF );
-    WiFi.mode( WIFI_STA );
+DESCRIPTION:
+Puts the first strip back the way it was before we rebooted.  Falls 
+back to the demo if the saved animation doesn't exist anymore.
 
-    WiFi.begin( WLAN_SSID, WLAN_PASS );
+RETURN VALUE:
+none.
 
-    while ( WiFi.status() != WL_CONNECTED )
+SIDE EFFECTS:
+none
+
+======================================================================*/
+static void restoreAnimation( const SettingsStore::Settings &settings )
+{
+    ledAnimators[0]->SetPixelBrightness( settings.brightness );
+
+    // No transition, we want to be showing this right away
+    if ( strcmp( settings.animation, "demo" ) == 0 ||
+         ledAnimators[0]->Start( settings.animation, settings.color, 0 ) == false )
     {
-        // TODO... break out of  loop after some N amount of time
-        delay( 500 );
-        Serial.print( "." );
+        ledAnimators[0]->Demo();
     }
+}
 
-    connected = true;
+/*======================================================================
+FUNCTION:
+markBootPhase()
 
-    Serial.printf( "\nConnected to SSID %s, ip address %s\n",
-                   WLAN_SSID,
-                   WiFi.localIP().toString().c_str() );
+DESCRIPTION:
+Records when we reached some point in the boot.  See bootReport().
 
-    return connected;
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+static void markBootPhase( const char *name )
+{
+    if ( bootPhaseCount < MAX_BOOT_PHASES )
+    {
+        bootPhases[bootPhaseCount].name = name;
+        bootPhases[bootPhaseCount].timeUS = micros();
+        bootPhaseCount++;
+    }
 }
 
 /*======================================================================
 FUNCTION:
-setup()
+addTask()
 
 DESCRIPTION:
-Put your one-time initialization/setup code here
+Adds a task to the scheduler, and says so on the serial port if it 
+didn't fit.  A task that didn't fit never runs, so this is worth 
+knowing about (see TaskScheduler::MAX_TASKS).
 
 RETURN VALUE:
 none.
@@ -250,27 +453,58 @@ SIDE EFFECTS:
 none
 
 ======================================================================*/
-void setup()
+static void addTask( const char *name, uint32_t periodUS, TaskScheduler::TaskFunction function )
+{
+    if ( scheduler.AddTask( name, periodUS, function ) == TaskScheduler::INVALID_TASK )
+    {
+        Serial.printf( "Couldn't add task %s, raise TaskScheduler::MAX_TASKS\n", name );
+    }
+}
+
+/*======================================================================
+FUNCTION:
+bootReport()
+
+DESCRIPTION:
+Formats the boot phase timestamps, one phase per line, with the time
+since reset and the time since the previous phase.
+
+RETURN VALUE:
+The report.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+static String bootReport()
 {
-    if ( ledAnimator == false )
+    String report;
+
+    for ( size_t i = 0; i < bootPhaseCount; i++ )
     {
-        ledAnimator.reset(
-            new LedAnimator( GPIO_PIXEL_DATA_PIN, NEOPIXEL_COUNT )
-        );
+        uint32_t sinceLastUS = ( i == 0 ) ? 0 : bootPhases[i].timeUS - bootPhases[i - 1].timeUS;
+
+        char line[64];
+
+        snprintf( line, sizeof( line ), "%-10s %8lu us  +%8lu us\n",
+                  bootPhases[i].name,
+                  (unsigned long) bootPhases[i].timeUS,
+                  (unsigned long) sinceLastUS );
+
+        report += line;
     }
 
-    ledAnimator->TurnAllOff();
-    
-    // Start animating
-    ledAnimator->Demo();
+    return report;
 }
 
 /*======================================================================
 FUNCTION:
-loop()
+processSettings()
 
 DESCRIPTION:
-Arduino main entry point for a sketch
+Task that hands the current settings to the settings store.  The 
+store only writes to flash when they change, and then only once they
+have settled.
 
 RETURN VALUE:
 none.
@@ -279,13 +513,92 @@ SIDE EFFECTS:
 none
 
 ======================================================================*/
-void loop()
+static void processSettings()
 {
-    activityLed.Flash(50);
-    
-    // No matter what state we're in, we always animate
-    ledAnimator->Process();
+    SettingsStore::Settings settings;
+    SettingsStore::Clear( settings );
 
+    strncpy( settings.animation, 
+             ledAnimator->GetAnimationName(), 
+             SettingsStore::MAX_ANIMATION_NAME - 1 );
+
+    // The demo changes colors on its own, don't save every one
+    settings.color = ( ledAnimator->IsDemo() == true ) ? 0 : ledAnimator->GetColor();
+    settings.brightness = ledAnimator->GetPixelBrightness();
+    settings.network = wifiProxy.GetFastConnect();
+
+    settingsStore.Update( settings );
+    settingsStore.Process();
+}
+
+/*======================================================================
+FUNCTION:
+processAnimators()
+
+DESCRIPTION:
+Task that lets every animator render its next frame, if one is due.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+static void processAnimators()
+{
+    for ( size_t i = 0; i < STRIP_COUNT; i++ )
+    {
+        ledAnimators[i]->Process();
+    }
+}
+
+/*======================================================================
+FUNCTION:
+processStatusLeds()
+
+DESCRIPTION:
+Task that keeps the board-level led patterns going.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+static void processStatusLeds()
+{
+    if ( firmwareUpdater != nullptr && firmwareUpdater->IsUpdating() == true )
+    {
+        activityLed.Play( LedHelper::FAST_BLINK );
+    }
+    else
+    {
+        activityLed.Play( LedHelper::HEARTBEAT );
+    }
+
+    activityLed.Tick();
+    networkLed.Tick();
+}
+
+/*======================================================================
+FUNCTION:
+stepNetwork()
+
+DESCRIPTION:
+Takes one step through the network state machine: gets us connected,
+and then starts all of the network services.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+Changes the value of the activeState variable
+
+======================================================================*/
+static void stepNetwork()
+{
     switch ( activeState )
     {
         case STATE_INITIALIZING:
@@ -300,7 +613,9 @@ void loop()
 
         case STATE_CHECK_STORED_CONFIG:
 
+            // The stored settings were applied in setup()
             activeState = STATE_WIFI_STA_DISCONNECTED;
+            break;
 
         case STATE_WIFI_AP_CONFIG_MODE:
         
@@ -308,21 +623,37 @@ void loop()
             break;
 
         case STATE_WIFI_STA_DISCONNECTED:
-        {
-            networkLed.TurnOff();
-            bool connected = connectWifi();
-            if ( connected == true )
+
+            // WifiProxy takes it from here, including retrying
+            // (with backoff) if the connect doesn't work out
+            wifiProxy.Begin();
+
+            networkLed.Play( LedHelper::SLOW_BLINK );
+            activeState = STATE_WIFI_STA_CONNECTING;
+            break;
+
+        case STATE_WIFI_STA_CONNECTING:
+
+            wifiProxy.Process();
+
+            if ( wifiProxy.IsConnected() == true )
             {
+                markBootPhase( "wifi" );
+
                 Serial.printf( "Setting state to WIFI STA connected\n" );
                 activeState = STATE_WIFI_STA_CONNECTED;
             }
+            else if ( wifiProxy.GetState() == WifiProxy::STATE_BACKOFF )
+            {
+                // Two blinks - we couldn't get on the network and 
+                // are waiting to try again
+                networkLed.PlayErrorCode( 2 );
+            }
             else
             {
-                Serial.printf( "connectWifi() returned false\n" );
+                networkLed.Play( LedHelper::SLOW_BLINK );
             }
-        }
-
-        break;
+            break;
 
         case STATE_WIFI_STA_CONNECTED:
 
@@ -336,6 +667,14 @@ void loop()
                     "") );
 
                 firmwareUpdater->Begin();
+
+                // An update takes over until it is done, so keep
+                // the activity led going from in there
+                firmwareUpdater->SetProgressHandler( []()
+                {
+                    activityLed.Play( LedHelper::FAST_BLINK );
+                    activityLed.Tick();
+                } );
             }
 
             // Do we have a webserver yet?
@@ -346,12 +685,50 @@ void loop()
                 webserverProxy.reset( new WebserverProxy(ledAnimator) );
 
                 webserverProxy->Begin();
+
+                // So we can see where the time goes
+                webserverProxy->AddStatusPage( "/status/tasks", []()
+                {
+                    return scheduler.Report();
+                } );
+
+                webserverProxy->AddStatusPage( "/status/boot", bootReport );
+
+                webserverProxy->SetSchedule( schedule );
+
+                webserverProxy->AddStatusPage( "/status/time", []()
+                {
+                    return ( timeProxy != nullptr ) ? timeProxy->Report() : String( "not started\n" );
+                } );
+            }
+
+            if ( webSocketProxy == false )
+            {
+                webSocketProxy.reset( new WebSocketProxy( ledAnimator ) );
+                webSocketProxy->Begin();
+            }
+
+            if ( REALTIME_PIXELS == true && realtimeProxy == false )
+            {
+                realtimeProxy.reset( new RealtimeProxy( ledAnimator, REALTIME_UNIVERSE, REALTIME_ADDRESS ) );
+                realtimeProxy->Begin();
+
+                webserverProxy->AddStatusPage( "/status/realtime", []()
+                {
+                    return realtimeProxy->Report();
+                } );
             }
 
             if ( timeProxy == false )
             {
                 timeProxy.reset( new TimeProxy( "pool.ntp.org" ) );
 
+                // In case the pool doesn't answer
+                timeProxy->AddServer( "time.nist.gov" );
+                timeProxy->AddServer( "time.google.com" );
+
+                timeProxy->SetTimezone( TIMEZONE );
+
                 timeProxy->Begin();
             }
 
@@ -363,20 +740,83 @@ void loop()
                 // Add our web server
                 discoveryProxy->AddService( "http", "tcp", 80 );
             }
+
+            if ( FLEET_SYNC == true && syncProxy == false )
+            {
+                syncProxy.reset( new SyncProxy( ledAnimator ) );
+                syncProxy->Begin();
+            }
             
             activeState = STATE_READY;
+
+            markBootPhase( "ready" );
+            Serial.print( bootReport() );
             break;
 
         case STATE_READY:
 
-            // Call of the handlers so they can do their thing
-            webserverProxy->Process();
-            firmwareUpdater->Process();
+            // The handlers are all tasks of their own.  We just 
+            // watch the link; if it drops, WifiProxy reconnects
+            // and the services we already started carry on once
+            // it is back.
+            wifiProxy.Process();
 
+            if ( wifiProxy.IsConnected() == false )
+            {
+                networkLed.Play( LedHelper::SLOW_BLINK );
+                activeState = STATE_WIFI_STA_CONNECTING;
+            }
             break;
     }
+}
+
+/*======================================================================
+FUNCTION:
+processNetwork()
+
+DESCRIPTION:
+Task that runs the network state machine.  States that don't have to
+wait on anything are run through in one go, instead of one state per
+task period, so boot gets to STATE_READY as soon as the link is up.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+Changes the value of the activeState variable
+
+======================================================================*/
+static void processNetwork()
+{
+    int previousState;
+
+    do
+    {
+        previousState = activeState;
+
+        stepNetwork();
+    }
+    while ( activeState != previousState );
+}
 
-    yield();
+/*======================================================================
+FUNCTION:
+loop()
+
+DESCRIPTION:
+Arduino main entry point for a sketch.  All of the work is done by the
+tasks set up in setup(), so this just runs whichever ones are due.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void loop()
+{
+    scheduler.Run();
 }
 
 /*=====================================================================
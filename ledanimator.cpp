@@ -47,14 +47,10 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 //----------------------------------------------------------------------
 
 #include "ledanimator.h"
+#include "colorengine.h"
+#include "neopixeldriver.h"
 
-// Hack to deal with a collision between the Arduino.h definitions and
-// what is in the std c++ definitions
-// https://github.com/platformio/platformio-core/issues/646
-#undef min
-#undef max
-
-#include <random>
+#include <string.h>
 
 //----------------------------------------------------------------------
 // Type Declarations
@@ -66,7 +62,74 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 // Global Constant Definitions
 //----------------------------------------------------------------------
 
-// None.
+// Gamma correction lookup tables, applied per channel when a frame is
+// committed.  The LEDs are linear in PWM duty cycle but our eyes are
+// not, so without these fades look like they spend most of their time
+// near full brightness.  They live in flash to save RAM.
+
+// gamma 2.6 - used for the red, green and blue dies
+static constexpr uint8_t GAMMA_RGB[256] PROGMEM =
+{
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   1,   1,   1,   1,   1,   1,   1,   1,
+      1,   1,   1,   1,   2,   2,   2,   2,   2,   2,   2,   2,   3,   3,   3,   3,
+      3,   3,   4,   4,   4,   4,   5,   5,   5,   5,   5,   6,   6,   6,   6,   7,
+      7,   7,   8,   8,   8,   9,   9,   9,  10,  10,  10,  11,  11,  11,  12,  12,
+     13,  13,  13,  14,  14,  15,  15,  16,  16,  17,  17,  18,  18,  19,  19,  20,
+     20,  21,  21,  22,  22,  23,  24,  24,  25,  25,  26,  27,  27,  28,  29,  29,
+     30,  31,  31,  32,  33,  34,  34,  35,  36,  37,  38,  38,  39,  40,  41,  42,
+     42,  43,  44,  45,  46,  47,  48,  49,  50,  51,  52,  53,  54,  55,  56,  57,
+     58,  59,  60,  61,  62,  63,  64,  65,  66,  68,  69,  70,  71,  72,  73,  75,
+     76,  77,  78,  80,  81,  82,  84,  85,  86,  88,  89,  90,  92,  93,  94,  96,
+     97,  99, 100, 102, 103, 105, 106, 108, 109, 111, 112, 114, 115, 117, 119, 120,
+    122, 124, 125, 127, 129, 130, 132, 134, 136, 137, 139, 141, 143, 145, 146, 148,
+    150, 152, 154, 156, 158, 160, 162, 164, 166, 168, 170, 172, 174, 176, 178, 180,
+    182, 184, 186, 188, 191, 193, 195, 197, 199, 202, 204, 206, 209, 211, 213, 215,
+    218, 220, 223, 225, 227, 230, 232, 235, 237, 240, 242, 245, 247, 250, 252, 255
+};
+
+// gamma 2.2 - the white die is a phosphor LED and reads brighter at
+// the low end, so it gets a gentler curve
+static constexpr uint8_t GAMMA_W[256] PROGMEM =
+{
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   1,
+      1,   1,   1,   1,   1,   1,   1,   1,   1,   2,   2,   2,   2,   2,   2,   2,
+      3,   3,   3,   3,   3,   4,   4,   4,   4,   5,   5,   5,   5,   6,   6,   6,
+      6,   7,   7,   7,   8,   8,   8,   9,   9,   9,  10,  10,  11,  11,  11,  12,
+     12,  13,  13,  13,  14,  14,  15,  15,  16,  16,  17,  17,  18,  18,  19,  19,
+     20,  20,  21,  22,  22,  23,  23,  24,  25,  25,  26,  26,  27,  28,  28,  29,
+     30,  30,  31,  32,  33,  33,  34,  35,  35,  36,  37,  38,  39,  39,  40,  41,
+     42,  43,  43,  44,  45,  46,  47,  48,  49,  49,  50,  51,  52,  53,  54,  55,
+     56,  57,  58,  59,  60,  61,  62,  63,  64,  65,  66,  67,  68,  69,  70,  71,
+     73,  74,  75,  76,  77,  78,  79,  81,  82,  83,  84,  85,  87,  88,  89,  90,
+     91,  93,  94,  95,  97,  98,  99, 100, 102, 103, 105, 106, 107, 109, 110, 111,
+    113, 114, 116, 117, 119, 120, 121, 123, 124, 126, 127, 129, 130, 132, 133, 135,
+    137, 138, 140, 141, 143, 145, 146, 148, 149, 151, 153, 154, 156, 158, 159, 161,
+    163, 165, 166, 168, 170, 172, 173, 175, 177, 179, 181, 182, 184, 186, 188, 190,
+    192, 194, 196, 197, 199, 201, 203, 205, 207, 209, 211, 213, 215, 217, 219, 221,
+    223, 225, 227, 229, 231, 234, 236, 238, 240, 242, 244, 246, 248, 251, 253, 255
+};
+
+// No correction, used when gamma correction is turned off
+static constexpr uint8_t GAMMA_LINEAR[256] PROGMEM =
+{
+      0,   1,   2,   3,   4,   5,   6,   7,   8,   9,  10,  11,  12,  13,  14,  15,
+     16,  17,  18,  19,  20,  21,  22,  23,  24,  25,  26,  27,  28,  29,  30,  31,
+     32,  33,  34,  35,  36,  37,  38,  39,  40,  41,  42,  43,  44,  45,  46,  47,
+     48,  49,  50,  51,  52,  53,  54,  55,  56,  57,  58,  59,  60,  61,  62,  63,
+     64,  65,  66,  67,  68,  69,  70,  71,  72,  73,  74,  75,  76,  77,  78,  79,
+     80,  81,  82,  83,  84,  85,  86,  87,  88,  89,  90,  91,  92,  93,  94,  95,
+     96,  97,  98,  99, 100, 101, 102, 103, 104, 105, 106, 107, 108, 109, 110, 111,
+    112, 113, 114, 115, 116, 117, 118, 119, 120, 121, 122, 123, 124, 125, 126, 127,
+    128, 129, 130, 131, 132, 133, 134, 135, 136, 137, 138, 139, 140, 141, 142, 143,
+    144, 145, 146, 147, 148, 149, 150, 151, 152, 153, 154, 155, 156, 157, 158, 159,
+    160, 161, 162, 163, 164, 165, 166, 167, 168, 169, 170, 171, 172, 173, 174, 175,
+    176, 177, 178, 179, 180, 181, 182, 183, 184, 185, 186, 187, 188, 189, 190, 191,
+    192, 193, 194, 195, 196, 197, 198, 199, 200, 201, 202, 203, 204, 205, 206, 207,
+    208, 209, 210, 211, 212, 213, 214, 215, 216, 217, 218, 219, 220, 221, 222, 223,
+    224, 225, 226, 227, 228, 229, 230, 231, 232, 233, 234, 235, 236, 237, 238, 239,
+    240, 241, 242, 243, 244, 245, 246, 247, 248, 249, 250, 251, 252, 253, 254, 255
+};
 
 //----------------------------------------------------------------------
 // Global Data Definitions
@@ -113,7 +176,29 @@ none
 
 ======================================================================*/
 LedAnimator::LedAnimator( uint8_t gpioDataPin, uint32_t pixelCount )
-    : _gpioDataPin( gpioDataPin ), _pixelCount( pixelCount )
+    : _gpioDataPin( gpioDataPin ), _pixelCount( pixelCount ),
+      _driver( new NeoPixelDriver( gpioDataPin, pixelCount ) )
+{
+    init();
+}
+
+/*======================================================================
+FUNCTION:
+C-tor()
+
+DESCRIPTION:
+Constructs the object with the output driver to use and # of pixels
+we are going to animate.  We take ownership of the driver.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+LedAnimator::LedAnimator( std::unique_ptr< PixelDriver > driver, uint32_t pixelCount )
+    : _gpioDataPin( 0 ), _pixelCount( pixelCount ), _driver( std::move( driver ) )
 {
     init();
 }
@@ -135,25 +220,59 @@ none
 ======================================================================*/
 void LedAnimator::init()
 {
-    _lastAnimationState = AnimationState::STATE_UNKNOWN;
+    _lastFrameUS = micros();
+
+    // Seed off of the data pin so strips driven from the same 
+    // controller don't flicker in lock step.  The seed must not be 0.
+    _randomSeed = 0x9E3779B9UL ^ ( (uint32_t) _gpioDataPin << 16 ) ^
+                  (uint32_t) (uintptr_t) this;
 
-    if ( _pixels == false )
+    if ( _randomSeed == 0 )
     {
-        _pixels.reset( 
-            new Adafruit_NeoPixel( _pixelCount, _gpioDataPin, NEO_RGBW + NEO_KHZ800 )
-        );
+        _randomSeed = 0x9E3779B9UL;
     }
 
     // Initalize
-    _pixels->begin();
+    _driver->Begin();
+
+    // This is our unscaled master copy of the frame.  Brightness
+    // and gamma are applied when the frame is committed to the
+    // pixels, so nothing gets lost along the way.
+    if ( _framePixels == nullptr )
+    {
+        _framePixels.reset( new uint32_t[_pixelCount * 2] );
+    }
+
+    // What actually gets handed to the driver, after brightness
+    // and gamma are applied
+    if ( _output == nullptr )
+    {
+        _output.reset( new uint32_t[_pixelCount] );
+    }
+
+    for ( uint32_t i = 0; i < _pixelCount * 2; i++ )
+    {
+        _framePixels[i] = 0;
+    }
+
+    _frames[0].Attach( _framePixels.get(), _pixelCount );
+    _frames[1].Attach( _framePixels.get() + _pixelCount, _pixelCount );
+
+    // Overlay layers come out of the compositor's arena
+    _compositor.Attach( _pixelCount );
+
+    SetGammaCorrection( true );
+
+    startAnimation( AnimationRegistry::Find( "off" ), 0, 0, 0 );
 }
 
 /*======================================================================
 FUNCTION:
-TurnAllOff()
+SetGammaCorrection()
 
 DESCRIPTION:
-Turns all of the pixels off
+Turns gamma correction on/off.  The table for each channel is picked
+here so the commit pass doesn't have to make any decisions.
 
 RETURN VALUE:
 none.
@@ -162,24 +281,28 @@ SIDE EFFECTS:
 none
 
 ======================================================================*/
-void LedAnimator::TurnAllOff()
+void LedAnimator::SetGammaCorrection( bool enabled )
 {
-    _lastAnimationState = AnimationState::STATE_OFF;
+    // Channel order matches the packed color: b, g, r, w
+    _gammaTables[0] = enabled ? GAMMA_RGB : GAMMA_LINEAR;
+    _gammaTables[1] = enabled ? GAMMA_RGB : GAMMA_LINEAR;
+    _gammaTables[2] = enabled ? GAMMA_RGB : GAMMA_LINEAR;
+    _gammaTables[3] = enabled ? GAMMA_W : GAMMA_LINEAR;
 
-    for ( int i = 0; i < _pixelCount; i++ )
-    {
-        _pixels->setPixelColor( i, _pixels->Color( 0, 0, 0, 0 ) );
-    }
+    _gammaEnabled = enabled;
 
-    _pixels->show();
+    // Same pixels, different output
+    _frames[_current].Touch();
+    _liveFrame.Touch();
 }
 
 /*======================================================================
 FUNCTION:
-TurnAllOn()
+SetFrameRate()
 
 DESCRIPTION:
-Turns all of the pixels on with the color provided
+Sets the target frame rate Process() renders at.  A value of 0 is
+treated as 1 frame per second.
 
 RETURN VALUE:
 none.
@@ -188,145 +311,159 @@ SIDE EFFECTS:
 none
 
 ======================================================================*/
-void LedAnimator::TurnAllOn( uint32_t color )
+void LedAnimator::SetFrameRate( uint8_t framesPerSecond )
 {
-    _lastAnimationState = AnimationState::STATE_ON;
-
-    for ( int i = 0; i < _pixelCount; i++ )
+    if ( framesPerSecond == 0 )
     {
-        _pixels->setPixelColor( i, color ); 
+        framesPerSecond = 1;
     }
 
-    _pixels->setBrightness( _brightness );
-
-    _pixels->show();
+    _frameRate = framesPerSecond;
+    _frameIntervalUS = 1000000UL / _frameRate;
 }
 
 /*======================================================================
 FUNCTION:
-SetPixelBrightness()
+frameDue()
 
 DESCRIPTION:
-Helper method to set the brightness.
-Brightness can be 0..255, with 0 = off, 255 = high
+Checks the frame clock to see if it is time to render another frame.
+If so, elapsedUS is set to the time since the last rendered frame. 
+If the caller fell behind by more than one frame, the missed frames are
+counted as dropped and we simply render the latest one - the animations
+are time based so they will land where they should be.
 
 RETURN VALUE:
-none.
+true if a frame should be rendered
 
 SIDE EFFECTS:
-none.
+Advances the frame clock when a frame is due
 
 ======================================================================*/
-void inline LedAnimator::SetPixelBrightness( uint8_t brightness )
+bool LedAnimator::frameDue( uint32_t &elapsedUS )
 {
-    // Setting the brightness causes "bit rot" (loss) which
-    // can skew the colors over time. The library guidance is
-    // to call this once.  However, since we are re-initializing
-    // the pixel buffer, bit rot shouldn't be a concern.
-    // You can also set the brightness by scaling the RGB/W values 
-    // in the setPixelColor() call.  For example, a full red would be r=255, 
-    // 50% would be r=127. So to control brightness, just scale the rbg 
-    // values by the same amount.
-    _brightness = brightness;
-    _pixels->setBrightness( _brightness );
+    uint32_t now = micros();
+
+    // Unsigned math handles the micros() wrap
+    uint32_t elapsed = now - _lastFrameUS;
+
+    if ( elapsed < _frameIntervalUS )
+    {
+        return false;
+    }
+
+    _frameStats.framesRendered++;
+    _frameStats.framesDropped += ( elapsed / _frameIntervalUS ) - 1;
+
+    _lastFrameUS = now;
+    elapsedUS = elapsed;
+
+    return true;
 }
 
 /*======================================================================
 FUNCTION:
-AllPulse()
+commit()
 
 DESCRIPTION:
-This function will pulse all the pixels by the specified color.
-It will flip/flop by ramping the brightness level up/down each
-time it is called.  If we did a loop with a delay internal to this
-method, it would delay the ability of the caller to responsive
-to distance changes.
+Displays the master frame, but only if it changed since we last 
+displayed it.  Shipping a frame out is expensive (the neopixel driver
+bit-bangs the whole strip with interrupts off, ~30us per pixel), so 
+skipping it when nothing changed frees that time up for WiFi and the 
+web server.
+
+Brightness and gamma are applied here in a single pass as the frame is
+copied to the output buffer.  During a transition the outgoing frame
+is blended in, and then any overlay layers are composited on top, as 
+part of the same pass.  The master frame is never scaled, so 
+there is no bit rot no matter how often the brightness changes.
 
-Just call it multiple times with the color you want to pulse.  You
-need about 10-50ms between calls to allow for decent pulse effect.
+While live frames are coming in (see SetLivePixels()), the live frame
+is shown instead of the animation, with the layers still on top.
+
+The output buffer is handed to the driver.  Drivers that send in the
+background take a copy, so this doesn't wait on the hardware.
 
 RETURN VALUE:
-none.
+true if the frame was displayed
 
 SIDE EFFECTS:
-none.
+none
 
 ======================================================================*/
-void LedAnimator::AllPulse( uint32_t color )
+bool LedAnimator::commit()
 {
-    _lastAnimationState = AnimationState::STATE_PULSE;
+    // Live frames take the place of the animation
+    const AnimationFrame &frame = ( _live == true ) ? _liveFrame : _frames[_current];
 
-    // The min and max brightness levels
-    const uint8_t MIN = 10;
-    const uint8_t MAX = 255;
+    // Every frame of a transition is different
+    const bool blending = ( _outgoing != nullptr && _live == false );
 
-    // The larger the step, the more dramatic the changes
-    // in brightness.  Smaller values give more subtle
-    // changes.
-    const uint8_t STEP = 10;
+    const bool layered = _compositor.HasActiveLayers();
 
-    // We need to use something bigger than a byte
-    // We step (up/down) the brightness value, then
-    // bounds check it.  Since we bounds check after-the-fact
-    // it is possible to exceed a byte range (0..255).
-    static uint16_t brightness = MAX;
+    if ( blending == false && 
+         _live == _shownLive &&
+         frame.GetGeneration() == _shownGeneration &&
+         _compositor.GetGeneration() == _shownLayerGeneration )
+    {
+        _frameStats.framesSkipped++;
+        return false;
+    }
 
-    // Note that this is a signed 8 bit int
-    // We need the sign because we are going to
-    // flip flop from +1 to -1
-    static int8_t countdirection = 1;
+    const uint32_t *incoming = frame.GetPixels();
+    const uint32_t *outgoing = _frames[_current ^ 1].GetPixels();
 
-    const int8_t UP = 1;
-    const int8_t DOWN = -1;
+    // +1 so that full brightness is a no-op after the >> 8
+    const uint16_t scale = (uint16_t) _brightness + 1;
 
-    // What we want is to ramp down from MAX to MIN, then
-    // ramp up from MIN to MAX.  This will give a nice
-    // pulsing effect.
-    brightness = brightness + ( STEP * countdirection );
+    const uint8_t *gammaB = _gammaTables[0];
+    const uint8_t *gammaG = _gammaTables[1];
+    const uint8_t *gammaR = _gammaTables[2];
+    const uint8_t *gammaW = _gammaTables[3];
 
-    // Bounds checking
-    if ( brightness <= MIN )
+    for ( uint32_t i = 0; i < _pixelCount; i++ )
     {
-        // count up
-        countdirection = UP;
+        uint32_t c = incoming[i];
 
-        // bounds check to minimum
-        brightness = MIN;
-    }
+        if ( blending == true )
+        {
+            c = ColorEngine::Blend( outgoing[i], c, _blendAlpha );
+        }
 
-    // Bounds checking the other extreme
-    if ( brightness >= MAX )
-    {
-        // count down
-        countdirection = DOWN;
+        if ( layered == true )
+        {
+            c = _compositor.Composite( i, c );
+        }
 
-        brightness = MAX;
-    }
+        uint8_t b = pgm_read_byte( &gammaB[( ( c & 0xFF ) * scale ) >> 8] );
+        uint8_t g = pgm_read_byte( &gammaG[( ( ( c >> 8 ) & 0xFF ) * scale ) >> 8] );
+        uint8_t r = pgm_read_byte( &gammaR[( ( ( c >> 16 ) & 0xFF ) * scale ) >> 8] );
+        uint8_t w = pgm_read_byte( &gammaW[( ( c >> 24 ) * scale ) >> 8] );
 
-    SetPixelBrightness( brightness );
+        _output[i] = ( (uint32_t) w << 24 ) | ( (uint32_t) r << 16 ) | ( (uint32_t) g << 8 ) | b;
+    }
 
-    for ( int i = 0; i < _pixelCount; i++ )
+    if ( _driver->Show( _output.get(), _pixelCount ) == false )
     {
-        _pixels->setPixelColor( i, color );
+        // Driver couldn't take it, we'll try again next frame
+        return false;
     }
 
-    // We've set the entire array (i.e. the buffer), so
-    // now call show to display it (i.e. make it active)
-    _pixels->show();
+    _shownGeneration = frame.GetGeneration();
+    _shownLayerGeneration = _compositor.GetGeneration();
+    _shownLive = _live;
+    _frameStats.framesShown++;
+
+    return true;
 }
 
 /*======================================================================
 FUNCTION:
-pixelsAllStrobe()
+SetPixelBrightness()
 
 DESCRIPTION:
-This function will strobe (alternate) all of the pixels between a minimum
-brightness to a maximum brightness.  If we handled the delay internally
-to this method, it would delay the ability of the caller to responsive
-to distance changes.
-
-Just call it multiple times with the color you want to strobe.  You
-need about 10-50ms between calls to allow for decent strobe effect.
+Helper method to set the brightness.
+Brightness can be 0..255, with 0 = off, 255 = high
 
 RETURN VALUE:
 none.
@@ -335,42 +472,18 @@ SIDE EFFECTS:
 none.
 
 ======================================================================*/
-void LedAnimator::AllStrobe( uint32_t color )
+void LedAnimator::SetPixelBrightness( uint8_t brightness )
 {
-    _lastAnimationState = AnimationState::STATE_STROBE;
-
-    // Min is 25% bright, max is 100%
-    const uint8_t MIN = 64;
-    const uint8_t MAX = 255;
-
-    static uint8_t brightness = MIN;
-
-    // Flip/flop between the extremes
-    switch ( brightness )
-    {
-        case MIN:
-            brightness = MAX;
-            break;
-
-        case MAX:
-            brightness = MIN;
-            break;
-
-        default:
-            brightness = MAX;
-            break;
-    }
-
-    SetPixelBrightness( brightness );
-
-    for ( int i = 0; i < _pixelCount; i++ )
+    // We don't use the library's setBrightness(), it rescales 
+    // (and loses bits from) the whole pixel buffer every time it
+    // is called. Instead the brightness is applied when the 
+    // frame is committed - see commit().
+    if ( _brightness != brightness )
     {
-        _pixels->setPixelColor( i, color );
+        _brightness = brightness;
+        _frames[_current].Touch();
+        _liveFrame.Touch();
     }
-
-    // We've set the entire array (i.e. the buffer), so
-    // now call show to display it (i.e. make it active)
-    _pixels->show();
 }
 
 /*======================================================================
@@ -379,7 +492,8 @@ Wheel()
 
 DESCRIPTION:
 Implements a color wheel and returns a color based on the wheel position.
-This code is by Bill Earl from the Adafruit site.
+This is the algorithm by Bill Earl from the Adafruit site, precomputed
+into a lookup table (see ColorEngine::Wheel()).
 
 https://learn.adafruit.com/multi-tasking-the-arduino-part-3?view=all
 
@@ -392,252 +506,1025 @@ none
 ======================================================================*/
 uint32_t LedAnimator::Wheel( byte WheelPos )
 {
-    _lastAnimationState = STATE_COLOR_WHEEL;
+    return ColorEngine::Wheel( WheelPos );
+}
+
+/*======================================================================
+FUNCTION:
+SetColor()
+
+DESCRIPTION:
+Sets the color used by the animations.  If white extraction is on, 
+the grey part of the color is moved over to the white LED.
+
+RETURN VALUE:
+none.
 
-    WheelPos = 255 - WheelPos;
-    if ( WheelPos < 85 )
+SIDE EFFECTS:
+none.
+
+======================================================================*/
+void LedAnimator::SetColor( uint32_t color )
+{
+    if ( _whiteExtraction == true )
     {
-        return Color( 255 - WheelPos * 3, 0, WheelPos * 3 );
+        color = ColorEngine::ExtractWhite( color );
     }
-    else if ( WheelPos < 170 )
+
+    _color = color;
+}
+
+/*======================================================================
+FUNCTION:
+SetSpeed()
+
+DESCRIPTION:
+Sets how fast the animations play, in percent of normal.  The time
+scale is rebased at the current effect time, so whatever is running
+carries on from where it is rather than jumping to where it would be 
+had it always run at this speed.  Every Start() starts a new scale, 
+so jars that start in step at the same speed stay in step.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void LedAnimator::SetSpeed( uint16_t percent )
+{
+    if ( percent > MAX_SPEED )
     {
-        WheelPos -= 85;
-        return Color( 0, WheelPos * 3, 255 - WheelPos * 3 );
+        percent = MAX_SPEED;
     }
-    else
+
+    if ( percent == _speed )
     {
-        WheelPos -= 170;
-        return Color( WheelPos * 3, 255 - WheelPos * 3, 0 );
+        return;
     }
+
+    _scale = { scaledTime( _scale, _effectTimeUS ), _effectTimeUS };
+    _outgoingScale = { scaledTime( _outgoingScale, _outgoingTimeUS ), _outgoingTimeUS };
+
+    _speed = percent;
 }
 
 /*======================================================================
 FUNCTION:
-CycleThruColorWheel()
+QueuePixelBrightness()
 
 DESCRIPTION:
-This is a helper function that will drive thru a color wheel.  Essentially
-this is a wrapper that makes it easier than the caller having to do all 
-the work.
+Sets the brightness at the start of the next frame, along with 
+anything else queued up for it.
 
 RETURN VALUE:
 none.
 
 SIDE EFFECTS:
-none.
+none
 
 ======================================================================*/
-void LedAnimator::CycleThruColorWheel()
+void LedAnimator::QueuePixelBrightness( uint8_t brightness )
 {
-    TurnAllOn( Wheel( _wheeloffset++ ) );
+    _pendingSettings.brightnessValid = true;
+    _pendingSettings.brightness = brightness;
+}
+
+/*======================================================================
+FUNCTION:
+QueueSpeed()
+
+DESCRIPTION:
+Sets the speed at the start of the next frame, along with anything 
+else queued up for it.
+
+RETURN VALUE:
+none.
 
-    // The call to TurnAllOn will set the last state to all on
-    // so we need to reset it here.
-    _lastAnimationState = AnimationState::STATE_COLOR_WHEEL;
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void LedAnimator::QueueSpeed( uint16_t percent )
+{
+    _pendingSettings.speedValid = true;
+    _pendingSettings.speed = percent;
 }
 
 /*======================================================================
 FUNCTION:
-Flicker()
+QueueColor()
 
 DESCRIPTION:
-This method will randomly select 1 pixel from total pixels and turn it
-on.  Any previous pixel will turned off.  This will give the effect
-of random pixels turning on.
+Changes the color of the running animation at the start of the next
+frame.  Unlike Start() with a new color, the animation carries on 
+where it is.
 
 RETURN VALUE:
 none.
 
 SIDE EFFECTS:
+none
+
+======================================================================*/
+void LedAnimator::QueueColor( uint32_t color )
+{
+    _pendingSettings.colorValid = true;
+    _pendingSettings.color = color;
+
+    // A start waiting on the same frame takes the new color too
+    if ( _pending.valid == true && _pending.demo == false )
+    {
+        _pending.color = color;
+    }
+}
+
+/*======================================================================
+FUNCTION:
+SetLivePixels()
+
+DESCRIPTION:
+Writes pixels into the live frame that is being put together.  The 
+bytes are r,g,b or r,g,b,w per pixel, and pixels past the end of the
+strip are dropped.  Nothing changes on the strip until ShowLive().
+
+RETURN VALUE:
 none.
 
+SIDE EFFECTS:
+none
+
 ======================================================================*/
-void LedAnimator::Flicker( uint32_t color )
+void LedAnimator::SetLivePixels( uint32_t offset, const uint8_t *data, uint32_t count, uint8_t channels )
 {
-    static int offset = 0;
+    if ( channels != 3 && channels != 4 )
+    {
+        return;
+    }
 
-    // If we weren't doing flickering before, we 
-    // need to reset everything to a known state
-    if ( _lastAnimationState != STATE_FLICKER )
+    if ( _livePixels == nullptr )
     {
-        for ( int i = 0; i < _pixelCount; i++ )
+        // The one being put together, then the one being shown
+        _livePixels.reset( new uint32_t[_pixelCount * 2] );
+
+        for ( uint32_t i = 0; i < _pixelCount * 2; i++ )
         {
-            // Turn all the pixels off
-            _pixels->setPixelColor( i, 0, 0, 0, 0 );
+            _livePixels[i] = 0;
         }
-    }
 
-    static std::default_random_engine generator;
-    std::uniform_int_distribution<int> distribution( 0, _pixelCount );
+        _liveFrame.Attach( _livePixels.get() + _pixelCount, _pixelCount );
+    }
 
-    int previous = offset;
+    if ( offset >= _pixelCount )
+    {
+        return;
+    }
 
-    // get a new pixel to use
-    offset = distribution( generator );
+    if ( count > _pixelCount - offset )
+    {
+        count = _pixelCount - offset;
+    }
 
-    // Now turn that one on
-    _pixels->setPixelColor( offset, _color );
-    _pixels->show();
+    uint32_t *pixels = _livePixels.get() + offset;
 
-    // At this point, we may have turned the same pixel on as the 
-    // previous one (i.e. we randomly selected the same pixel)
-    // so don't turn it off if that's the case. 
-    if ( previous != offset )
+    for ( uint32_t i = 0; i < count; i++, data += channels )
     {
-        _pixels->setPixelColor( previous, 0, 0, 0, 0 );
-        _pixels->show();
+        pixels[i] = Color( data[0], data[1], data[2], ( channels == 4 ) ? data[3] : 0 );
     }
-
-    _lastAnimationState = STATE_FLICKER;
 }
 
 /*======================================================================
 FUNCTION:
-Demo()
+ShowLive()
 
 DESCRIPTION:
-This method will cycle thru all of the various animation effects
-that this class implements.  The way it works is it calculates
-an elapsed time, and if that timeframe has expired, then it advances
-to the next animation step.
+Hands the live frame that was put together with SetLivePixels() over
+to be shown at the next frame, and holds off the animation for 
+another LIVE_TIMEOUT_MS.
 
 RETURN VALUE:
 none.
 
 SIDE EFFECTS:
-none.
+none
 
 ======================================================================*/
-void LedAnimator::Demo()
+void LedAnimator::ShowLive()
 {
-    // We are going to do our own internal state machine
-    // in this method. We will use this to cycle thru
-    // the various animation features
-    static int lastDemoState = STATE_OFF;
-
-    static unsigned long start = 0;
-
-    if ( start == 0 )
+    if ( _livePixels == nullptr )
     {
-        start = millis();
+        return;
     }
-    
-    unsigned long stop = millis();
-    unsigned long elapsed = stop - start;
 
-    static unsigned long timeToShow = 1000;
+    memcpy( _livePixels.get() + _pixelCount, _livePixels.get(), _pixelCount * sizeof( uint32_t ) );
 
-    // How long have we been doing this particular state
-    // demo?
-    if ( elapsed >= timeToShow )
-    {
-        // Slide to the next time period
-        start = stop;
+    _liveFrame.Touch();
+    _live = true;
+    _liveLastMS = millis();
+}
+
+/*======================================================================
+FUNCTION:
+scaledTime()
+
+DESCRIPTION:
+Maps an effect time onto the time the animation is rendered at.
+
+RETURN VALUE:
+The time to hand to Render().
 
-        // We want to exclude the demo state, which MUST
-        // be the last enumerated CONST in the list for
-        // this code to work.  If you add more enumerations,
-        // make sure to keep STATE_DEMO at the end of the list
-        const int TOTAL_STATES = 8 - 1;
+SIDE EFFECTS:
+none
 
-        // Advance the state and wrap if we exceed
-        // the bounds
-        lastDemoState = ( lastDemoState + 1 ) % TOTAL_STATES;
+======================================================================*/
+uint64_t LedAnimator::scaledTime( const TimeScale &scale, uint64_t timeUS ) const
+{
+    if ( _speed == SPEED_NORMAL && scale.baseUS == scale.fromUS )
+    {
+        return timeUS;
     }
 
-    switch ( lastDemoState )
+    if ( timeUS <= scale.fromUS )
     {
-        case STATE_UNKNOWN:
-            TurnAllOff();
-            lastDemoState = STATE_OFF;
-            break;
+        return scale.baseUS;
+    }
+
+    return scale.baseUS + ( timeUS - scale.fromUS ) * _speed / SPEED_NORMAL;
+}
+
+/*======================================================================
+FUNCTION:
+Start()
+
+DESCRIPTION:
+Starts the animation at the given index in the registry, using the 
+current color and transition time.  Stops the demo if it is running.
+
+RETURN VALUE:
+true if the animation will be started
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+bool LedAnimator::Start( uint32_t index )
+{
+    return Start( index, _color, _transitionMS );
+}
+
+/*======================================================================
+FUNCTION:
+Start()
+
+DESCRIPTION:
+Starts the animation at the given index in the registry with the
+color provided, using the current transition time.
+
+RETURN VALUE:
+true if the animation will be started
+
+SIDE EFFECTS:
+none
 
-        case STATE_OFF:
-            TurnAllOff();
-            timeToShow = 1000;
-            break;
+======================================================================*/
+bool LedAnimator::Start( uint32_t index, uint32_t color )
+{
+    return Start( index, color, _transitionMS );
+}
 
-        case STATE_ON:
-            timeToShow = 5000;
-            // Let's make it green
-            _color = Color( 0, 255, 0, 0 );
+/*======================================================================
+FUNCTION:
+Start()
 
-            TurnAllOn( _color );
-            break;
+DESCRIPTION:
+Starts the animation at the given index in the registry with the
+color provided, crossfading from the current animation over 
+transitionMS.  Stops the demo if it is running.
 
-        case STATE_COLOR_WHEEL:
-            CycleThruColorWheel();
-            break;
+The request is only recorded here.  It is picked up at the start of 
+the next frame (see applyPending()), so calling this from a web 
+request handler never renders or shows anything.
 
-        case STATE_PULSE:
-            _color = Color( 255, 0, 0, 0 );
-            AllPulse( _color );
-            break;
+RETURN VALUE:
+true if the animation will be started
 
-        case STATE_STROBE:
-            _color = Color( 255, 255, 255, 255 );
-            AllStrobe( _color );
-            break;
+SIDE EFFECTS:
+none
 
-        case STATE_FLICKER:
-            _color = Color( 0, 0, 255, 0 );
-            Flicker( _color );
-            break;
+======================================================================*/
+bool LedAnimator::Start( uint32_t index, uint32_t color, uint32_t transitionMS )
+{
+    if ( AnimationRegistry::Get( index ) == nullptr )
+    {
+        return false;
     }
 
-    // Make sure to keep us in the DEMO mode
-    // so next time Process() is called, we know
-    // where to pick up
-    _lastAnimationState = STATE_DEMO;
+    _pending.valid = true;
+    _pending.demo = false;
+    _pending.index = index;
+    _pending.color = color;
+    _pending.transitionMS = transitionMS;
+    _pending.startTimeUS = 0;
+
+    return true;
 }
 
 /*======================================================================
 FUNCTION:
-Process()
+StartAt()
 
 DESCRIPTION:
-This method will use the last known animation and call it.  This is
-needed for the "active" animations, such as pulsing/strobing/flashing
-etc.
+Starts the animation at the given index as if it had started at 
+startTimeUS on the shared clock, so it is in step with everyone else
+who started it then.  The crossfade is timed from startTimeUS too; a
+start far enough in the past snaps straight to where the animation 
+is now.
+
+Without a shared clock this is the same as Start().
 
 RETURN VALUE:
-none.
+true if the animation will be started
 
 SIDE EFFECTS:
-none.
+none
 
 ======================================================================*/
-void LedAnimator::Process()
+bool LedAnimator::StartAt( uint32_t index, uint32_t color, uint32_t transitionMS, uint64_t startTimeUS )
 {
-    switch ( _lastAnimationState )
+    if ( Start( index, color, transitionMS ) == false )
     {
-        case STATE_COLOR_WHEEL:
-            CycleThruColorWheel();
-            break;
+        return false;
+    }
 
-        case STATE_STROBE:
-            AllStrobe( _color );
-            break;
+    _pending.startTimeUS = startTimeUS;
+
+    return true;
+}
+
+/*======================================================================
+FUNCTION:
+Start()
 
-        case STATE_PULSE:
-            AllPulse( _color );
-            break;
+DESCRIPTION:
+Starts the animation with the given name, using the current color.
 
-        case STATE_FLICKER:
-            Flicker( _color );
-            break;
+RETURN VALUE:
+true if the animation will be started
 
-        case STATE_DEMO:
-            Demo();
-            break;
+SIDE EFFECTS:
+none
 
-        // We don't need to do anything for the following 
-        // states
-        case STATE_UNKNOWN:
-        case STATE_ON:
-        case STATE_OFF:
-            break;
-    }
+======================================================================*/
+bool LedAnimator::Start( const char *name )
+{
+    return Start( AnimationRegistry::Find( name ), _color, _transitionMS );
+}
+
+/*======================================================================
+FUNCTION:
+Start()
+
+DESCRIPTION:
+Starts the animation with the given name and the color provided.
+
+RETURN VALUE:
+true if the animation will be started
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+bool LedAnimator::Start( const char *name, uint32_t color )
+{
+    return Start( AnimationRegistry::Find( name ), color, _transitionMS );
+}
+
+/*======================================================================
+FUNCTION:
+Start()
+
+DESCRIPTION:
+Starts the animation with the given name and the color provided, 
+crossfading from the current animation over transitionMS.
+
+RETURN VALUE:
+true if the animation will be started
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+bool LedAnimator::Start( const char *name, uint32_t color, uint32_t transitionMS )
+{
+    return Start( AnimationRegistry::Find( name ), color, transitionMS );
+}
+
+/*======================================================================
+FUNCTION:
+applyPending()
+
+DESCRIPTION:
+Picks up the queued brightness, speed and color, and the last 
+Start()/Demo() request, if there are any.  Called at
+the start of a frame.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void LedAnimator::applyPending( uint64_t now )
+{
+    if ( _pendingSettings.brightnessValid == true )
+    {
+        _pendingSettings.brightnessValid = false;
+        SetPixelBrightness( _pendingSettings.brightness );
+    }
+
+    if ( _pendingSettings.speedValid == true )
+    {
+        _pendingSettings.speedValid = false;
+        SetSpeed( _pendingSettings.speed );
+    }
+
+    if ( _pending.valid == true )
+    {
+        _pending.valid = false;
+        _startTransitionMS = _pending.transitionMS;
+
+        // Without a start time, now is when it started
+        uint64_t startTimeUS = ( _pending.startTimeUS != 0 ) ? _pending.startTimeUS : now;
+
+        if ( now == 0 )
+        {
+            startTimeUS = 0;
+        }
+
+        if ( _pending.demo == true )
+        {
+            _demo = true;
+            _demoIndex = 0;
+            _demoStartMS = millis();
+            _demoStartTimeUS = startTimeUS;
+
+            // Joining a demo that is already under way
+            uint64_t slotStartUS = startTimeUS;
+
+            if ( startTimeUS != 0 )
+            {
+                _demoIndex = demoSlot( now, slotStartUS );
+            }
+
+            SetColor( AnimationRegistry::Get( _demoIndex )->DemoColor() );
+
+            startAnimation( _demoIndex, _pending.transitionMS, now, slotStartUS );
+        }
+        else
+        {
+            _demo = false;
+
+            SetColor( _pending.color );
+
+            startAnimation( _pending.index, _pending.transitionMS, now, startTimeUS );
+        }
+    }
+
+    // After the start, so it is the start that gets recolored
+    if ( _pendingSettings.colorValid == true )
+    {
+        _pendingSettings.colorValid = false;
+        SetColor( _pendingSettings.color );
+
+        // The animations pick the frame color up as they render, 
+        // the static ones need a nudge
+        _frames[_current].SetColor( _color );
+
+        if ( _animation->IsStatic() == true )
+        {
+            _animation->Render( _frames[_current], scaledTime( _scale, _effectTimeUS ) );
+        }
+
+        _frames[_current].Touch();
+    }
+}
+
+/*======================================================================
+FUNCTION:
+startAnimation()
+
+DESCRIPTION:
+Switches over to the animation at the given index and renders its 
+first frame.  If transitionMS isn't 0, the running animation becomes
+the outgoing one and keeps rendering into the other frame while we
+crossfade.  Nothing is displayed until commit() is called.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void LedAnimator::startAnimation( uint32_t index, uint32_t transitionMS, uint64_t now, uint64_t startTimeUS )
+{
+    if ( transitionMS > 0 && _animation != nullptr )
+    {
+        // If we were already in a transition, the animation that was
+        // fading out is dropped and we fade from the current one
+        _outgoing = _animation;
+        _outgoingTimeUS = _effectTimeUS;
+        _outgoingSynced = _synced;
+        _outgoingStartUS = _startTimeUS;
+        _outgoingScale = _scale;
+
+        _transitionUS = transitionMS * 1000UL;
+        _transitionElapsedUS = 0;
+        _blendAlpha = 0;
+
+        // The outgoing animation keeps its frame (and its context),
+        // the incoming one gets the other frame
+        _current ^= 1;
+    }
+    else
+    {
+        _outgoing = nullptr;
+    }
+
+    _animation = AnimationRegistry::Get( index );
+    _effectTimeUS = 0;
+    _scale = { 0, 0 };
+
+    _synced = ( startTimeUS != 0 );
+    _startTimeUS = startTimeUS;
+
+    if ( _synced == true && now > startTimeUS )
+    {
+        _effectTimeUS = now - startTimeUS;
+
+        // Joining late - pick the transition up where everyone 
+        // else is, or skip it if it is already over
+        if ( _outgoing != nullptr )
+        {
+            if ( _effectTimeUS >= _transitionUS )
+            {
+                _outgoing = nullptr;
+            }
+            else
+            {
+                _transitionElapsedUS = (uint32_t) _effectTimeUS;
+                _blendAlpha = (uint16_t) ( ( (uint64_t) _transitionElapsedUS << 8 ) / _transitionUS );
+            }
+        }
+    }
+
+    AnimationFrame &frame = _frames[_current];
+
+    frame.SetColor( _color );
+
+    // Each run gets a fresh seed, so the random animations
+    // don't repeat themselves.  Synced runs take theirs from the
+    // start time, so everyone in step flickers the same way.
+    if ( _synced == true )
+    {
+        uint32_t seed = (uint32_t) ( startTimeUS ^ ( startTimeUS >> 32 ) ) * 2654435761UL;
+
+        frame.GetContext().seed = ( seed != 0 ) ? seed : 1;
+    }
+    else
+    {
+        frame.GetContext().seed = nextRandom();
+    }
+
+    _animation->Begin( frame );
+    _animation->Render( frame, scaledTime( _scale, _effectTimeUS ) );
+
+    // The frame may have been swapped in, so its generation 
+    // says nothing about what is being displayed
+    frame.Touch();
+}
+
+/*======================================================================
+FUNCTION:
+advanceTransition()
+
+DESCRIPTION:
+Moves the transition along by the elapsed time, rendering the next 
+frame of the outgoing animation and working out the blend for this 
+frame.  Once the transition is done the outgoing animation is 
+dropped.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void LedAnimator::advanceTransition( uint32_t elapsedUS, uint64_t now )
+{
+    if ( _outgoing == nullptr )
+    {
+        return;
+    }
+
+    _transitionElapsedUS += elapsedUS;
+
+    // Synced, the transition started when the incoming animation 
+    // did, so everyone in step blends the same amount
+    if ( _synced == true )
+    {
+        uint64_t sinceStartUS = ( now > _startTimeUS ) ? now - _startTimeUS : 0;
+
+        _transitionElapsedUS = ( sinceStartUS < _transitionUS ) ? (uint32_t) sinceStartUS : _transitionUS;
+    }
+
+    if ( _transitionElapsedUS >= _transitionUS )
+    {
+        _outgoing = nullptr;
+
+        // The last blended frame is still showing
+        _frames[_current].Touch();
+        return;
+    }
+
+    _outgoingTimeUS += elapsedUS;
+
+    if ( _outgoingSynced == true && now > _outgoingStartUS )
+    {
+        _outgoingTimeUS = now - _outgoingStartUS;
+    }
+
+    if ( _outgoing->IsStatic() == false )
+    {
+        _outgoing->Render( _frames[_current ^ 1], scaledTime( _outgoingScale, _outgoingTimeUS ) );
+    }
+
+    _blendAlpha = (uint16_t) ( ( (uint64_t) _transitionElapsedUS << 8 ) / _transitionUS );
+}
+
+/*======================================================================
+FUNCTION:
+SetLayer()
+
+DESCRIPTION:
+Starts an animation on one of the overlay layers.  The layer is 
+composited on top of the running animation with the given opacity 
+(0..255) and blend mode.  White extraction applies to the layer color
+the same as it does in SetColor().
+
+RETURN VALUE:
+true if the layer was set
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+bool LedAnimator::SetLayer( uint8_t layer, const char *name, uint32_t color,
+                            uint8_t opacity, Compositor::BlendMode mode )
+{
+    if ( _whiteExtraction == true )
+    {
+        color = ColorEngine::ExtractWhite( color );
+    }
+
+    return _compositor.SetLayer( layer, 
+                                 AnimationRegistry::Get( AnimationRegistry::Find( name ) ), 
+                                 color, opacity, mode, nextRandom() );
+}
+
+/*======================================================================
+FUNCTION:
+GetAnimationName()
+
+DESCRIPTION:
+Gets the name of what is currently running.
+
+RETURN VALUE:
+Name of the animation, or "demo" if the demo is running
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+const char *LedAnimator::GetAnimationName() const
+{
+    // A request that hasn't been picked up yet wins
+    if ( _pending.valid == true )
+    {
+        return ( _pending.demo == true ) ? "demo" : AnimationRegistry::Get( _pending.index )->Name();
+    }
+
+    if ( _demo == true )
+    {
+        return "demo";
+    }
+
+    return _animation->Name();
+}
+
+/*======================================================================
+FUNCTION:
+nextRandom()
+
+DESCRIPTION:
+Small xorshift32 pseudo random number generator.  The state is just
+a 32 bit seed, which keeps each object's sequence independent and is
+plenty random for seeding the animations.
+
+RETURN VALUE:
+Next pseudo random number in the sequence
+
+SIDE EFFECTS:
+Advances the seed
+
+======================================================================*/
+uint32_t LedAnimator::nextRandom()
+{
+    uint32_t x = _randomSeed;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+
+    _randomSeed = x;
+
+    return x;
+}
+
+/*======================================================================
+FUNCTION:
+Demo()
+
+DESCRIPTION:
+This method will start cycling thru all of the animations in the 
+registry, crossfading from one to the next.  Like Start(), the demo 
+starts with the next frame.  Call Process() periodically to keep the
+demo going.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void LedAnimator::Demo()
+{
+    _pending.valid = true;
+    _pending.demo = true;
+    _pending.transitionMS = _transitionMS;
+    _pending.startTimeUS = 0;
+}
+
+/*======================================================================
+FUNCTION:
+DemoAt()
+
+DESCRIPTION:
+Runs the demo as if it had started at startTimeUS on the shared 
+clock.  A demo that is already under way is joined part way through, 
+with whatever animation would be on right now.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void LedAnimator::DemoAt( uint32_t transitionMS, uint64_t startTimeUS )
+{
+    Demo();
+
+    _pending.transitionMS = transitionMS;
+    _pending.startTimeUS = startTimeUS;
+}
+
+/*======================================================================
+FUNCTION:
+demoSlot()
+
+DESCRIPTION:
+Works out which demo animation is on at now on the shared clock.  The
+demo plays the registry in order, each animation for its 
+DemoDurationMS(), over and over from _demoStartTimeUS.
+
+RETURN VALUE:
+The registry index of the animation, with slotStartUS set to when it
+came on.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+uint32_t LedAnimator::demoSlot( uint64_t now, uint64_t &slotStartUS ) const
+{
+    uint64_t cycleUS = 0;
+
+    for ( uint32_t i = 0; i < AnimationRegistry::Count(); i++ )
+    {
+        cycleUS += AnimationRegistry::Get( i )->DemoDurationMS() * 1000ULL;
+    }
+
+    // Not started yet counts as just started
+    uint64_t position = ( now > _demoStartTimeUS ) ? ( now - _demoStartTimeUS ) % cycleUS : 0;
+
+    slotStartUS = ( now > _demoStartTimeUS ) ? now - position : _demoStartTimeUS;
+
+    for ( uint32_t i = 0; i < AnimationRegistry::Count(); i++ )
+    {
+        uint64_t durationUS = AnimationRegistry::Get( i )->DemoDurationMS() * 1000ULL;
+
+        if ( position < durationUS )
+        {
+            return i;
+        }
+
+        position -= durationUS;
+        slotStartUS += durationUS;
+    }
+
+    return 0;
+}
+
+/*======================================================================
+FUNCTION:
+followClock()
+
+DESCRIPTION:
+Keeps _synced in line with the shared clock.  When the clock shows up
+(say NTP just synced), what is running carries on from where it is, 
+but from then on is timed off of the clock.  Should the clock go 
+away, we carry on off of our own frame clock.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void LedAnimator::followClock( uint64_t now )
+{
+    if ( _synced == true && now == 0 )
+    {
+        _synced = false;
+        _outgoingSynced = false;
+        return;
+    }
+
+    if ( _synced == true || now == 0 || _animation == nullptr )
+    {
+        return;
+    }
+
+    _synced = true;
+    _startTimeUS = now - _effectTimeUS;
+
+    if ( _outgoing != nullptr )
+    {
+        _outgoingSynced = true;
+        _outgoingStartUS = now - _outgoingTimeUS;
+    }
+
+    if ( _demo == true )
+    {
+        // Back the demo's start up by the animations before this one
+        _demoStartTimeUS = _startTimeUS;
+
+        for ( uint32_t i = 0; i < _demoIndex; i++ )
+        {
+            _demoStartTimeUS -= AnimationRegistry::Get( i )->DemoDurationMS() * 1000ULL;
+        }
+    }
+}
+
+/*======================================================================
+FUNCTION:
+advanceDemo()
+
+DESCRIPTION:
+Moves the demo on to the next animation in the registry once the 
+current one has been shown for long enough.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void LedAnimator::advanceDemo( uint64_t now )
+{
+    if ( _synced == true )
+    {
+        uint64_t slotStartUS = 0;
+        uint32_t index = demoSlot( now, slotStartUS );
+
+        if ( index != _demoIndex )
+        {
+            _demoIndex = index;
+
+            SetColor( AnimationRegistry::Get( _demoIndex )->DemoColor() );
+
+            startAnimation( _demoIndex, _transitionMS, now, slotStartUS );
+        }
+        return;
+    }
+
+    unsigned long nowMS = millis();
+
+    if ( nowMS - _demoStartMS < _animation->DemoDurationMS() )
+    {
+        return;
+    }
+
+    // Slide to the next time period
+    _demoStartMS = nowMS;
+
+    _demoIndex = ( _demoIndex + 1 ) % AnimationRegistry::Count();
+
+    SetColor( AnimationRegistry::Get( _demoIndex )->DemoColor() );
+
+    startAnimation( _demoIndex, _transitionMS, 0, 0 );
+}
+
+/*======================================================================
+FUNCTION:
+Process()
+
+DESCRIPTION:
+This method will render the next frame of the running animation, if 
+a frame is due.  This is needed for the "active" animations, such as
+pulsing/strobing/flashing etc.  Static animations only need to be 
+rendered when they start, so they cost nothing here.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void LedAnimator::Process()
+{
+    // Background drivers get a chance to run every call, not
+    // just when we have a frame
+    _driver->Process();
+
+    uint32_t elapsedUS = 0;
+
+    if ( frameDue( elapsedUS ) == false )
+    {
+        return;
+    }
+
+    uint32_t frameStartUS = micros();
+
+    // The shared clock, if we have one.  One reading per frame, so
+    // everything in the frame agrees on the time.
+    uint64_t now = ( _clock ) ? _clock() : 0;
+
+    followClock( now );
+
+    _effectTimeUS += elapsedUS;
+
+    if ( _synced == true && now > _startTimeUS )
+    {
+        _effectTimeUS = now - _startTimeUS;
+    }
+
+    advanceTransition( elapsedUS, now );
+
+    // Commands only take effect on a frame boundary
+    applyPending( now );
+
+    if ( _demo == true )
+    {
+        advanceDemo( now );
+    }
+
+    if ( _live == true && millis() - _liveLastMS >= LIVE_TIMEOUT_MS )
+    {
+        // The stream stopped, back to the animation
+        _live = false;
+    }
+
+    // No point rendering what nobody will see
+    if ( _live == false && _animation->IsStatic() == false )
+    {
+        _animation->Render( _frames[_current], scaledTime( _scale, _effectTimeUS ) );
+    }
+
+    _compositor.Render( elapsedUS );
+
+    // Only one show() per frame, and only if something changed
+    commit();
+
+    _frameStats.lastFrameCostUS = micros() - frameStartUS;
 }
  
 /*======================================================================
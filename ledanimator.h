@@ -49,8 +49,13 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <stdint.h>
 
 #include <memory>
+#include <functional>
 
-#include <Adafruit_NeoPixel.h>
+#include <Arduino.h>
+
+#include "animation.h"
+#include "compositor.h"
+#include "pixeldriver.h"
 
 //----------------------------------------------------------------------
 // Type Declarations
@@ -101,9 +106,19 @@ Provides animation routines for neopixels
 
 HOW TO USE:
 1. Construct the object
-2. Call an explicit animation method
-3. Call Process() which will use the animation method in #2 above and 
-continue that animation
+2. Start() an animation by name or registry index (see 
+AnimationRegistry), or call one of the helper methods
+3. Call Process() which will continue the animation from #2 above
+
+Process() runs off of a frame clock.  It only renders when a frame is
+due (see SetFrameRate()), and the animations are computed from the 
+elapsed time rather than the number of calls, so the visual speed is
+the same no matter how fast or slow the caller's loop happens to spin.
+
+Given a shared clock (see SetClock()), animations are instead timed 
+from a start time on that clock.  Every animator with the same clock
+and the same start time renders the same frame at the same moment, 
+however late it joined - see SyncProxy.
 
 ======================================================================*/
 class LedAnimator
@@ -114,48 +129,176 @@ class LedAnimator
     // TYPE DECLARATIONS AND CONSTANTS    
     //=================================================================
 
-    enum AnimationState 
-    { 
-        STATE_UNKNOWN = 0,
-        STATE_OFF, 
-        STATE_ON, 
-        STATE_COLOR_WHEEL,
-        STATE_PULSE, 
-        STATE_STROBE,
-        STATE_FLICKER,
-        STATE_DEMO
+    // Default frame rate Process() will try to hit
+    static const uint8_t DEFAULT_FRAME_RATE = 50;
+
+    // Default time to crossfade from one animation to the next
+    static const uint32_t DEFAULT_TRANSITION_MS = 500;
+
+    // Animation speed, in percent of normal
+    static const uint16_t SPEED_NORMAL = 100;
+    static const uint16_t MAX_SPEED = 1000;
+
+    // How long live frames hold the pixels after the last one came
+    // in, before the animation takes back over
+    static const uint32_t LIVE_TIMEOUT_MS = 2500;
+
+    // A clock shared between devices, in microseconds.  Returns 0
+    // when it isn't available (not synced yet, for example).
+    typedef std::function< uint64_t( void ) > Clock;
+
+    // Simple counters so we can see if the caller is keeping up
+    // with the frame rate, and what a frame costs us
+    struct FrameStats
+    {
+        uint32_t framesRendered;
+        uint32_t framesDropped;
+        uint32_t framesShown;
+        uint32_t framesSkipped;
+        uint32_t lastFrameCostUS;
     };
 
     //=================================================================
     // CLIENT INTERFACE
     //=================================================================
 
+    // Drives the pixels with the Adafruit neopixel library
     LedAnimator( uint8_t gpioDataPin, uint32_t pixelCount );
 
-    void SetPixelBrightness( uint8_t brightness );
-    void SetColor( uint32_t color ) { _color = color; }
+    // Drives the pixels with the given output driver
+    LedAnimator( std::unique_ptr< PixelDriver > driver, uint32_t pixelCount );
 
-    void TurnAllOff();
+    // Target frames per second for Process().  Frames the caller
+    // can't keep up with are dropped, not queued up.
+    void SetFrameRate( uint8_t framesPerSecond );
+    uint8_t GetFrameRate() const { return _frameRate; }
 
-    void TurnAllOn( uint32_t color );
+    const FrameStats &GetFrameStats() const { return _frameStats; }
+
+    // Master brightness, 0..255.  Applied along with gamma
+    // correction when a frame is committed.
+    void SetPixelBrightness( uint8_t brightness );
+    uint8_t GetPixelBrightness() const { return _brightness; }
+
+    // Gamma correction is on by default
+    void SetGammaCorrection( bool enabled );
+    bool GetGammaCorrection() const { return _gammaEnabled; }
+
+    void SetColor( uint32_t color );
+    uint32_t GetColor() const { return _color; }
+
+    // When on (the default), whites are rendered with the W LED 
+    // instead of burning r+g+b
+    void SetWhiteExtraction( bool enabled ) { _whiteExtraction = enabled; }
+
+    // Starts an animation from the registry, crossfading from the 
+    // current one over transitionMS (0 switches right away).  Returns
+    // false if there is no such animation.  The switch happens at the
+    // start of the next frame, so these are safe to call from a web
+    // request handler - nothing is displayed until Process().
+    bool Start( uint32_t index );
+    bool Start( uint32_t index, uint32_t color );
+    bool Start( uint32_t index, uint32_t color, uint32_t transitionMS );
+    bool Start( const char *name );
+    bool Start( const char *name, uint32_t color );
+    bool Start( const char *name, uint32_t color, uint32_t transitionMS );
+
+    // Plays the animations faster or slower, in percent (0 freezes
+    // them).  They carry on from where they are at the new speed.
+    void SetSpeed( uint16_t percent );
+    uint16_t GetSpeed() const { return _speed; }
+
+    // Like SetPixelBrightness() and SetSpeed(), but held until the
+    // start of the next frame along with any Start() or Demo(), so
+    // a whole set of changes shows up on the same frame
+    void QueuePixelBrightness( uint8_t brightness );
+    void QueueSpeed( uint16_t percent );
+
+    // Changes the color of what is running at the next frame, 
+    // without restarting it (so nothing crossfades or starts over).
+    // For a color picker being dragged around.
+    void QueueColor( uint32_t color );
+
+    // Live frames, streamed in from elsewhere, take the place of the
+    // animation until LIVE_TIMEOUT_MS goes by without one.  Pixels
+    // are packed r,g,b (channels 3) or r,g,b,w (channels 4) bytes, 
+    // starting at pixel offset; anything past the end of the strip
+    // is dropped.  Nothing is shown until ShowLive(), so a frame 
+    // that comes in over several packets goes out whole.
+    void SetLivePixels( uint32_t offset, const uint8_t *data, uint32_t count, uint8_t channels );
+    void ShowLive();
+    bool IsLive() const { return _live; }
+
+    // Hands the pixels back to the animation right away, for a 
+    // stream that says it is done
+    void EndLive() { _live = false; }
+
+    uint32_t GetPixelCount() const { return _pixelCount; }
+
+    // Crossfade time used when one isn't given, and by the demo
+    void SetTransitionTime( uint32_t transitionMS ) { _transitionMS = transitionMS; }
+    uint32_t GetTransitionTime() const { return _transitionMS; }
+
+    // Overlay layers, composited on top of the running animation
+    // (see Compositor).  Returns false if there is no such layer
+    // or animation.
+    bool SetLayer( uint8_t layer, const char *name, uint32_t color,
+                   uint8_t opacity, Compositor::BlendMode mode );
+    void ClearLayer( uint8_t layer ) { _compositor.ClearLayer( layer ); }
+    uint8_t GetLayerCount() const { return _compositor.GetLayerCount(); }
+
+    // Name of what is running, "demo" while the demo is running
+    const char *GetAnimationName() const;
+
+    // Helpers for the built in animations
+    void TurnAllOff() { Start( "off" ); }
+
+    void TurnAllOn( uint32_t color ) { Start( "on", color ); }
     void TurnAllOn() { TurnAllOn( _color ); }
 
-    void AllPulse( uint32_t color );
+    void AllPulse( uint32_t color ) { Start( "pulse", color ); }
     void AllPulse() { AllPulse( _color ); }
 
-    void AllStrobe( uint32_t color );
+    void AllStrobe( uint32_t color ) { Start( "strobe", color ); }
     void AllStrobe() { AllStrobe( _color ); }
 
-    void Flicker( uint32_t color );
+    void Flicker( uint32_t color ) { Start( "flicker", color ); }
     void Flicker() { Flicker( _color ); }
 
-    void CycleThruColorWheel();
+    void CycleThruColorWheel() { Start( "wheel" ); }
 
     // This is the Wheel algorithm by Bill Earl
     //  https://learn.adafruit.com/multi-tasking-the-arduino-part-3?view=all
-    uint32_t Wheel( byte WheelPos );
+    static uint32_t Wheel( byte WheelPos );
 
+    // Plays every animation in the registry, one after the other
     void Demo();
+    bool IsDemo() const { return _demo; }
+
+    // Times the animations off of a shared clock.  Anything already
+    // running carries on where it is, from then on in step with 
+    // the clock.
+    void SetClock( Clock clock ) { _clock = clock; }
+
+    // Like Start() and Demo(), but starting (or having started) at
+    // startTimeUS on the shared clock rather than now.  Anything 
+    // that started at the same time is in step with us.
+    bool StartAt( uint32_t index, uint32_t color, uint32_t transitionMS, uint64_t startTimeUS );
+    void DemoAt( uint32_t transitionMS, uint64_t startTimeUS );
+
+    // The crossfade time of the last Start() or Demo()
+    uint32_t GetStartTransitionTime() const { return _startTransitionMS; }
+
+    // True if what is running is timed off of the shared clock, and 
+    // when it started (when the demo started, for the demo)
+    bool IsSynced() const { return _synced; }
+    uint64_t GetStartTime() const { return _demo ? _demoStartTimeUS : _startTimeUS; }
+
+    // True if there is a Start() or Demo() waiting for the next frame
+    bool IsStartPending() const { return _pending.valid; }
+
+    // True if there is a QueueColor() waiting for the next frame
+    bool IsColorPending() const { return _pendingSettings.colorValid; }
 
     void Process();
 
@@ -188,6 +331,63 @@ class LedAnimator
 
     void init();
 
+    // A Start() or Demo() request, waiting for the next frame
+    struct PendingStart
+    {
+        bool valid;
+        bool demo;
+        uint32_t index;
+        uint32_t color;
+        uint32_t transitionMS;
+
+        // On the shared clock, 0 for now
+        uint64_t startTimeUS;
+    };
+
+    // QueuePixelBrightness() and QueueSpeed() values, waiting for 
+    // the next frame
+    struct PendingSettings
+    {
+        bool brightnessValid;
+        bool speedValid;
+        bool colorValid;
+        uint8_t brightness;
+        uint16_t speed;
+        uint32_t color;
+    };
+
+    void applyPending( uint64_t now );
+
+    // Maps an animation's effect time onto the time it is rendered
+    // at, for the current speed.  Rebased whenever the speed changes
+    // so the animation doesn't jump.
+    struct TimeScale
+    {
+        uint64_t baseUS;
+        uint64_t fromUS;
+    };
+
+    uint64_t scaledTime( const TimeScale &scale, uint64_t timeUS ) const;
+
+    void startAnimation( uint32_t index, uint32_t transitionMS, uint64_t now, uint64_t startTimeUS );
+
+    void advanceTransition( uint32_t elapsedUS, uint64_t now );
+
+    bool commit();
+
+    bool frameDue( uint32_t &elapsedUS );
+
+    void advanceDemo( uint64_t now );
+
+    // Which demo animation is on at now, and when it came on
+    uint32_t demoSlot( uint64_t now, uint64_t &slotStartUS ) const;
+
+    // Picks up the shared clock (or lets go of it) when it comes and
+    // goes, without disturbing what is running
+    void followClock( uint64_t now );
+
+    uint32_t nextRandom();
+
     //=================================================================
     // DATA MEMBERS    
     //=================================================================
@@ -198,13 +398,94 @@ class LedAnimator
 
     uint32_t _color;
 
-    uint8_t _brightness = 255;
-
-    byte _wheeloffset = 0;
+    bool _whiteExtraction = true;
 
-    std::unique_ptr< Adafruit_NeoPixel> _pixels;
+    uint8_t _brightness = 255;
 
-    AnimationState _lastAnimationState;
+    uint8_t _frameRate = DEFAULT_FRAME_RATE;
+
+    uint32_t _frameIntervalUS = 1000000UL / DEFAULT_FRAME_RATE;
+
+    // micros() timestamp of the last rendered frame
+    uint32_t _lastFrameUS = 0;
+
+    FrameStats _frameStats = { 0, 0, 0, 0, 0 };
+
+    // Unscaled master frames the animations render into.  There are
+    // two so the outgoing animation can keep rendering during a 
+    // transition.  _frames[_current] is the incoming/running one.
+    std::unique_ptr< uint32_t[] > _framePixels;
+    AnimationFrame _frames[2];
+    uint8_t _current = 0;
+
+    // Brightness/gamma corrected frame handed to the driver
+    std::unique_ptr< uint32_t[] > _output;
+
+    // The frame's generation is bumped every time the output would
+    // change. If it matches what we last displayed, we can skip the
+    // show() call.
+    uint32_t _shownGeneration = 0;
+    uint32_t _shownLayerGeneration = 0;
+    bool _shownLive = false;
+
+    // Per channel (b, g, r, w) gamma lookup tables
+    const uint8_t *_gammaTables[4];
+    bool _gammaEnabled = true;
+
+    std::unique_ptr< PixelDriver > _driver;
+
+    // What is running, and how long (in microseconds of frame 
+    // clock) it has been running
+    const Animation *_animation = nullptr;
+    uint64_t _effectTimeUS = 0;
+
+    PendingStart _pending = { false, false, 0, 0, 0, 0 };
+    PendingSettings _pendingSettings = { false, false, false, 0, 0, 0 };
+
+    // The shared clock, and whether (and when, on that clock) the 
+    // running animation started.  _effectTimeUS is worked out from
+    // these when _synced is set.
+    Clock _clock;
+    bool _synced = false;
+    uint64_t _startTimeUS = 0;
+    uint32_t _startTransitionMS = 0;
+
+    // The animation we are fading out of, nullptr if we aren't in
+    // a transition.  _blendAlpha is how far along we are, 0..256.
+    const Animation *_outgoing = nullptr;
+    uint64_t _outgoingTimeUS = 0;
+    uint32_t _transitionUS = 0;
+    uint32_t _transitionElapsedUS = 0;
+    uint16_t _blendAlpha = 0;
+    bool _outgoingSynced = false;
+    uint64_t _outgoingStartUS = 0;
+
+    // Live frames.  The pixels are only allocated once the first
+    // one comes in, most jars never see one.  The frame is filled in
+    // _livePixels and copied over to _liveFrame by ShowLive().
+    std::unique_ptr< uint32_t[] > _livePixels;
+    AnimationFrame _liveFrame;
+    bool _live = false;
+    uint32_t _liveLastMS = 0;
+
+    uint16_t _speed = SPEED_NORMAL;
+    TimeScale _scale = { 0, 0 };
+    TimeScale _outgoingScale = { 0, 0 };
+
+    uint32_t _transitionMS = DEFAULT_TRANSITION_MS;
+
+    Compositor _compositor;
+
+    // The demo plays the registry in order
+    bool _demo = false;
+    uint32_t _demoIndex = 0;
+    unsigned long _demoStartMS = 0;
+
+    // When the demo started on the shared clock
+    uint64_t _demoStartTimeUS = 0;
+
+    // Random number generator state, used to seed the animations
+    uint32_t _randomSeed;
 
 };
 
@@ -71,7 +71,10 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 // Static Variable Definitions 
 //----------------------------------------------------------------------
 
-// None.
+// Play() takes these by reference, so they need a home (pre C++17)
+constexpr LedHelper::BlinkPattern LedHelper::HEARTBEAT;
+constexpr LedHelper::BlinkPattern LedHelper::FAST_BLINK;
+constexpr LedHelper::BlinkPattern LedHelper::SLOW_BLINK;
 
 //----------------------------------------------------------------------
 // Function Prototypes
@@ -95,7 +98,7 @@ FUNCTION:
 TurnOn()
 
 DESCRIPTION:
-Turns the LED on
+Turns the LED on, stopping any pattern that is playing
 
 RETURN VALUE:
 none.
@@ -106,14 +109,9 @@ none
 ======================================================================*/
 void LedHelper::TurnOn() 
 {
-    uint8_t value = HIGH;
-
-    if ( true == _invertLogicLevel )
-    {
-        value = !value;
-    }
+    Stop();
 
-    digitalWrite( _gpio, value );
+    setLed( true );
 }
 
 /*======================================================================
@@ -121,7 +119,7 @@ FUNCTION:
 TurnOff()
 
 DESCRIPTION:
-Turns the LED off.
+Turns the LED off, stopping any pattern that is playing
 
 RETURN VALUE:
 none.
@@ -132,7 +130,28 @@ none
 ======================================================================*/
 void LedHelper::TurnOff() 
 {
-    uint8_t value = LOW;
+    Stop();
+
+    setLed( false );
+}
+
+/*======================================================================
+FUNCTION:
+setLed()
+
+DESCRIPTION:
+Drives the GPIO, taking care of the logic level.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void LedHelper::setLed( bool on ) 
+{
+    uint8_t value = on ? HIGH : LOW;
 
     if ( true == _invertLogicLevel )
     {
@@ -171,8 +190,9 @@ FUNCTION:
 Flash()
 
 DESCRIPTION:
-Flashes the LED. The LED will be ON for durationMS/2, and off 
-for the other half of the duration.
+Flashes the LED once. The LED will be ON for durationMS/2, and off 
+for the other half of the duration.  This is played as a pattern, so
+it returns right away - Tick() does the rest.
 
 RETURN VALUE:
 none.
@@ -183,25 +203,166 @@ none
 ======================================================================*/
 void LedHelper::Flash( const int durationMS ) 
 {
-    unsigned int waitcycle = durationMS / 2;
+    BlinkPattern flash = { 0b01, 2, (uint16_t) ( durationMS / 2 ) };
+
+    Play( flash, 1 );
+}
+
+/*======================================================================
+FUNCTION:
+Play()
+
+DESCRIPTION:
+Starts playing a blink pattern.  If the same pattern is already 
+playing, it carries on from where it is, so callers can keep asking
+for the pattern they want without restarting it.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void LedHelper::Play( const BlinkPattern &pattern, uint8_t repeat ) 
+{
+    if ( pattern.length == 0 || pattern.length > 32 )
+    {
+        return;
+    }
 
-    // Flip/flop for 2 cycles
-    for( int i = 0; i < 2; i++ )
+    if ( _playing == true &&
+         _pattern.bits == pattern.bits &&
+         _pattern.length == pattern.length &&
+         _pattern.stepMS == pattern.stepMS )
     {
-        unsigned long start = millis();
-        Toggle();
+        return;
+    }
 
-        while ( true )
-        {
-            unsigned long stop = millis();
+    _pattern = pattern;
+    _playing = true;
+    _step = 0;
+    _repeatsLeft = repeat;
+    _stepStartMS = millis();
 
-            unsigned long elapsed = stop - start;
+    setLed( ( _pattern.bits & 1 ) != 0 );
+}
 
-            if ( elapsed >= waitcycle ) { break; }
+/*======================================================================
+FUNCTION:
+PlayErrorCode()
+
+DESCRIPTION:
+Blinks count times, pauses, and does it again, forever.  The pattern
+is built on the fly: an on and an off step per blink, then four off 
+steps for the pause.
+
+RETURN VALUE:
+none.
 
-            yield();
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void LedHelper::PlayErrorCode( uint8_t count ) 
+{
+    const uint8_t PAUSE_STEPS = 4;
+    const uint8_t MAX_COUNT = ( 32 - PAUSE_STEPS ) / 2;
+
+    if ( count == 0 )
+    {
+        return;
+    }
+
+    if ( count > MAX_COUNT )
+    {
+        count = MAX_COUNT;
+    }
+
+    BlinkPattern code = { 0, (uint8_t) ( count * 2 + PAUSE_STEPS ), ERROR_CODE_STEP_MS };
+
+    for ( uint8_t i = 0; i < count; i++ )
+    {
+        code.bits |= 1UL << ( i * 2 );
+    }
+
+    Play( code );
+}
+
+/*======================================================================
+FUNCTION:
+Stop()
+
+DESCRIPTION:
+Stops any pattern that is playing and leaves the LED off.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void LedHelper::Stop() 
+{
+    if ( _playing == true )
+    {
+        _playing = false;
+        setLed( false );
+    }
+}
+
+/*======================================================================
+FUNCTION:
+Tick()
+
+DESCRIPTION:
+Advances the pattern if the current step is over.  If we fell more 
+than a step behind we don't try to catch up, we just carry on from
+now.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void LedHelper::Tick() 
+{
+    if ( _playing == false )
+    {
+        return;
+    }
+
+    unsigned long now = millis();
+
+    if ( now - _stepStartMS < _pattern.stepMS )
+    {
+        return;
+    }
+
+    _stepStartMS += _pattern.stepMS;
+
+    if ( now - _stepStartMS >= _pattern.stepMS )
+    {
+        _stepStartMS = now;
+    }
+
+    _step++;
+
+    if ( _step >= _pattern.length )
+    {
+        _step = 0;
+
+        if ( _repeatsLeft != REPEAT_FOREVER && --_repeatsLeft == 0 )
+        {
+            Stop();
+            return;
         }
     }
+
+    setLed( ( ( _pattern.bits >> _step ) & 1 ) != 0 );
 }
 
 /*=====================================================================
@@ -102,7 +102,10 @@ up to a micro GPIO pin.
 HOW TO USE:
 Construct the object with the GPIO pin and logic level.   
 
-Then call the various methods to control the Led.
+Then call the various methods to control the Led.  Blink patterns 
+(see Play()) are played in the background - call Tick() often (every
+10ms or so) to keep them going.  Tick() is just a millis() compare 
+unless it is time for the next step, so it is cheap to call.
 
 ======================================================================*/
 class LedHelper
@@ -113,7 +116,29 @@ class LedHelper
     // TYPE DECLARATIONS AND CONSTANTS    
     //=================================================================
 
-    // None.
+    // A blink pattern.  Bit n of bits is the LED state (1 = on) for
+    // step n, played from bit 0 up.  Each step lasts stepMS.
+    struct BlinkPattern
+    {
+        uint32_t bits;
+        uint8_t length;
+        uint16_t stepMS;
+    };
+
+    // Two quick blips, once a second
+    static constexpr BlinkPattern HEARTBEAT = { 0b0000000101, 10, 100 };
+
+    // Fast blink, i.e. during an OTA update
+    static constexpr BlinkPattern FAST_BLINK = { 0b01, 2, 50 };
+
+    // Slow blink, i.e. while trying to connect
+    static constexpr BlinkPattern SLOW_BLINK = { 0b01, 2, 250 };
+
+    // Step time for PlayErrorCode() blinks
+    static const uint16_t ERROR_CODE_STEP_MS = 200;
+
+    // Pass to Play() to repeat the pattern until told otherwise
+    static const uint8_t REPEAT_FOREVER = 0;
 
     //=================================================================
     // CLIENT INTERFACE
@@ -121,6 +146,7 @@ class LedHelper
 
     LedHelper( const uint8_t gpio, bool invertLogicLevel = true );
 
+    // These stop any pattern that is playing
     void TurnOn();
     void TurnOff();
 
@@ -128,9 +154,24 @@ class LedHelper
     // and if it is on, it turns off.
     int Toggle();
 
-    // This will flash the LED for the given duration in milliseconds
+    // This will flash the LED once over the given duration in 
+    // milliseconds.  It doesn't wait for the flash to finish.
     void Flash( const int durationMS = 500 );
 
+    // Plays a blink pattern, repeat times (or forever).  If the 
+    // pattern is already playing it carries on where it is.
+    void Play( const BlinkPattern &pattern, uint8_t repeat = REPEAT_FOREVER );
+
+    // Blinks count times, then pauses, over and over.  count is 
+    // 1..14 - the whole sequence has to fit in a pattern.
+    void PlayErrorCode( uint8_t count );
+
+    void Stop();
+    bool IsPlaying() const { return _playing; }
+
+    // Advances the pattern.  Call this often.
+    void Tick();
+
     protected:
 
     //=================================================================
@@ -151,7 +192,7 @@ class LedHelper
     // IMPLEMENTATION INTERFACE    
     //=================================================================
 
-    // None.
+    void setLed( bool on );
 
     //=================================================================
     // DATA MEMBERS    
@@ -160,6 +201,13 @@ class LedHelper
     uint8_t _gpio;
     bool _invertLogicLevel;
 
+    // What is playing and where we are in it
+    BlinkPattern _pattern = { 0, 0, 0 };
+    bool _playing = false;
+    uint8_t _step = 0;
+    uint8_t _repeatsLeft = 0;
+    unsigned long _stepStartMS = 0;
+
 };
 
 //======================================================================
@@ -0,0 +1,163 @@
+/*======================================================================
+FILE:
+neopixeldriver.cpp
+
+CREATOR:
+Sean Foley
+
+GENERAL DESCRIPTION:
+Pixel output driver built on the Adafruit neopixel library.
+
+PUBLIC CLASSES AND FUNCTIONS:
+NeoPixelDriver
+
+INITIALIZATION AND SEQUENCING REQUIREMENTS:
+None.
+
+Copyright (C) 2017 Sean Foley  All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted.  Enjoy.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+======================================================================*/
+
+//======================================================================
+// INCLUDES AND VARIABLE DEFINITIONS
+//======================================================================
+
+//----------------------------------------------------------------------
+// Defines
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Include Files
+//----------------------------------------------------------------------
+
+#include "neopixeldriver.h"
+
+//----------------------------------------------------------------------
+// Type Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Constant Definitions
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Data Definitions
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Static Variable Definitions 
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Function Prototypes
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Required Libraries
+//----------------------------------------------------------------------
+
+// None. (Where supported these should be in the form
+// of C++ pragmas).
+
+//======================================================================
+// FUNCTION IMPLEMENTATIONS
+//======================================================================
+
+/*======================================================================
+FUNCTION:
+NeoPixelDriver()
+
+DESCRIPTION:
+C-tor
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+NeoPixelDriver::NeoPixelDriver( uint8_t gpioDataPin, uint32_t pixelCount, neoPixelType type )
+    : _pixels( pixelCount, gpioDataPin, type )
+{
+}
+
+/*======================================================================
+FUNCTION:
+Begin()
+
+DESCRIPTION:
+Initializes the neopixel library
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void NeoPixelDriver::Begin()
+{
+    _pixels.begin();
+}
+
+/*======================================================================
+FUNCTION:
+Show()
+
+DESCRIPTION:
+Copies the frame into the library's buffer and displays it.  This
+blocks until the whole frame has been bit-banged out.
+
+RETURN VALUE:
+true, the frame is always taken
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+bool NeoPixelDriver::Show( const uint32_t *pixels, uint32_t count )
+{
+    for ( uint32_t i = 0; i < count; i++ )
+    {
+        _pixels.setPixelColor( i, pixels[i] );
+    }
+
+    _pixels.show();
+
+    return true;
+}
+
+/*=====================================================================
+// IMPLEMENTATION NOTES
+//=====================================================================
+
+None
+
+=====================================================================*/
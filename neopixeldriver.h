@@ -0,0 +1,177 @@
+#ifndef _JAROFLIGHT_NEOPIXELDRIVER_H_
+#define _JAROFLIGHT_NEOPIXELDRIVER_H_
+
+/*======================================================================
+FILE:
+neopixeldriver.h
+
+CREATOR:
+Sean Foley
+
+DESCRIPTION:
+Pixel output driver built on the Adafruit neopixel library.
+
+PUBLIC CLASSES AND FUNCTIONS:
+NeoPixelDriver
+
+Copyright (C) 2017 Sean Foley  All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted.  Enjoy.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+======================================================================*/
+
+//======================================================================
+// INCLUDES AND PUBLIC DATA DECLARATIONS
+//======================================================================
+
+//----------------------------------------------------------------------
+// Defines
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Include Files
+//----------------------------------------------------------------------
+
+#include <stdint.h>
+
+#include <Adafruit_NeoPixel.h>
+
+#include "pixeldriver.h"
+
+//----------------------------------------------------------------------
+// Type Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Constant Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Data Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//======================================================================
+// WARNINGS!!!
+//======================================================================
+
+// None.
+
+//======================================================================
+// FUNCTION DECLARATIONS
+//======================================================================
+
+// None.
+
+//=====================================================================
+// EXCEPTION CLASS DEFINITIONS
+//=====================================================================
+
+// None.
+
+//======================================================================
+// CLASS DEFINITIONS
+//======================================================================
+
+/*======================================================================
+CLASS:
+NeoPixelDriver
+
+DESCRIPTION:
+PixelDriver that uses the Adafruit neopixel library.  The library
+bit-bangs the data out with interrupts disabled, so Show() blocks for
+about 30us per pixel.
+
+HOW TO USE:
+1. Construct with the GPIO pin, # of pixels, and the neopixel type 
+(the jar's strip, and the default, is GRBW)
+2. Hand it to a LedAnimator
+
+======================================================================*/
+class NeoPixelDriver : public PixelDriver
+{
+    public:
+
+    //=================================================================
+    // TYPE DECLARATIONS AND CONSTANTS    
+    //=================================================================
+
+    // None.
+
+    //=================================================================
+    // CLIENT INTERFACE
+    //=================================================================
+
+    NeoPixelDriver( uint8_t gpioDataPin, uint32_t pixelCount,
+                    neoPixelType type = NEO_GRBW + NEO_KHZ800 );
+
+    virtual void Begin();
+
+    virtual bool Show( const uint32_t *pixels, uint32_t count );
+
+    protected:
+
+    //=================================================================
+    // SUBCLASS INTERFACE   
+    //=================================================================
+
+    // None.
+
+    private:
+
+    //=================================================================
+    // CUSTOMIZATION INTERFACE    
+    //=================================================================
+
+    // None.
+
+    //=================================================================
+    // IMPLEMENTATION INTERFACE    
+    //=================================================================
+
+    // No copying - intentionally not defining the implementation
+    // to throw a link error if someone somehow invokes a copy.
+    NeoPixelDriver( const NeoPixelDriver &rhs );
+
+    //=================================================================
+    // DATA MEMBERS    
+    //=================================================================
+
+    Adafruit_NeoPixel _pixels;
+};
+
+//======================================================================
+// INLINE FUNCTION DEFINITIONS
+//======================================================================
+
+// None.
+
+
+/*======================================================================
+// DOCUMENTATION
+========================================================================
+
+None.
+
+======================================================================*/
+
+#endif	// #ifendif _JAROFLIGHT_NEOPIXELDRIVER_H_
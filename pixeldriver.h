@@ -0,0 +1,178 @@
+#ifndef _JAROFLIGHT_PIXELDRIVER_H_
+#define _JAROFLIGHT_PIXELDRIVER_H_
+
+/*======================================================================
+FILE:
+pixeldriver.h
+
+CREATOR:
+Sean Foley
+
+DESCRIPTION:
+Interface for the pixel output drivers used by LedAnimator.
+
+PUBLIC CLASSES AND FUNCTIONS:
+PixelDriver
+
+Copyright (C) 2017 Sean Foley  All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted.  Enjoy.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+======================================================================*/
+
+//======================================================================
+// INCLUDES AND PUBLIC DATA DECLARATIONS
+//======================================================================
+
+//----------------------------------------------------------------------
+// Defines
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Include Files
+//----------------------------------------------------------------------
+
+#include <stdint.h>
+
+//----------------------------------------------------------------------
+// Type Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Constant Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Data Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//======================================================================
+// WARNINGS!!!
+//======================================================================
+
+// None.
+
+//======================================================================
+// FUNCTION DECLARATIONS
+//======================================================================
+
+// None.
+
+//=====================================================================
+// EXCEPTION CLASS DEFINITIONS
+//=====================================================================
+
+// None.
+
+//======================================================================
+// CLASS DEFINITIONS
+//======================================================================
+
+/*======================================================================
+CLASS:
+PixelDriver
+
+DESCRIPTION:
+Abstract interface for whatever actually ships a frame of pixels out
+to the LEDs.  LedAnimator renders and gamma corrects a frame, then
+hands it off to one of these.
+
+HOW TO USE:
+Derive from this class and implement Begin() and Show().  Drivers
+that do their work in the background can use Process() to keep 
+things moving - it is called every time LedAnimator::Process() is.
+
+======================================================================*/
+class PixelDriver
+{
+    public:
+
+    //=================================================================
+    // TYPE DECLARATIONS AND CONSTANTS    
+    //=================================================================
+
+    // None.
+
+    //=================================================================
+    // CLIENT INTERFACE
+    //=================================================================
+
+    virtual ~PixelDriver() {}
+
+    virtual void Begin() = 0;
+
+    // Queue up a frame for display.  Pixels are packed 0xWWRRGGBB.
+    // Drivers are free to return before the frame is actually on the
+    // wire - the caller can reuse the pixel buffer as soon as this
+    // returns.  Returns false if the frame could not be taken, in 
+    // which case the caller should try again on a later frame.
+    virtual bool Show( const uint32_t *pixels, uint32_t count ) = 0;
+
+    // Give background drivers some time
+    virtual void Process() {}
+
+    protected:
+
+    //=================================================================
+    // SUBCLASS INTERFACE   
+    //=================================================================
+
+    // None.
+
+    private:
+
+    //=================================================================
+    // CUSTOMIZATION INTERFACE    
+    //=================================================================
+
+    // None.
+
+    //=================================================================
+    // IMPLEMENTATION INTERFACE    
+    //=================================================================
+
+    // None.
+
+    //=================================================================
+    // DATA MEMBERS    
+    //=================================================================
+
+    // None.
+};
+
+//======================================================================
+// INLINE FUNCTION DEFINITIONS
+//======================================================================
+
+// None.
+
+
+/*======================================================================
+// DOCUMENTATION
+========================================================================
+
+None.
+
+======================================================================*/
+
+#endif	// #ifendif _JAROFLIGHT_PIXELDRIVER_H_
@@ -0,0 +1,599 @@
+/*======================================================================
+FILE:
+realtimeproxy.cpp
+
+CREATOR:
+Sean Foley
+
+GENERAL DESCRIPTION:
+DDP and E1.31 (sACN) real time pixel receiver.
+
+PUBLIC CLASSES AND FUNCTIONS:
+RealtimeProxy
+
+INITIALIZATION AND SEQUENCING REQUIREMENTS:
+A valid network connection must exist
+
+Copyright (C) 2017 Sean Foley  All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted.  Enjoy.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+======================================================================*/
+
+//======================================================================
+// INCLUDES AND VARIABLE DEFINITIONS
+//======================================================================
+
+//----------------------------------------------------------------------
+// Defines
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Include Files
+//----------------------------------------------------------------------
+
+#include "realtimeproxy.h"
+
+#include <string.h>
+
+#include <ESP8266WiFi.h>
+#include <lwip/igmp.h>
+
+//----------------------------------------------------------------------
+// Type Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Constant Definitions
+//----------------------------------------------------------------------
+
+// E1.31 packet layout
+const size_t E131_ACN_ID = 4;
+const size_t E131_ROOT_VECTOR = 18;
+const size_t E131_FRAMING_VECTOR = 40;
+const size_t E131_SEQUENCE = 111;
+const size_t E131_OPTIONS = 112;
+const size_t E131_UNIVERSE = 113;
+const size_t E131_DMP_VECTOR = 117;
+const size_t E131_ADDRESS_TYPE = 118;
+const size_t E131_VALUE_COUNT = 123;
+const size_t E131_START_CODE = 125;
+const size_t E131_DATA = 126;
+
+const uint8_t E131_OPTION_PREVIEW = 0x80;
+const uint8_t E131_OPTION_TERMINATED = 0x40;
+
+const size_t DMX_SLOTS = 512;
+
+const uint8_t ACN_PACKET_ID[12] = { 'A', 'S', 'C', '-', 'E', '1', '.', '1', '7', 0, 0, 0 };
+
+// DDP header
+const size_t DDP_HEADER_SIZE = 10;
+const size_t DDP_TIMECODE_SIZE = 4;
+
+const uint8_t DDP_VERSION_MASK = 0xC0;
+const uint8_t DDP_VERSION_1 = 0x40;
+const uint8_t DDP_FLAG_TIMECODE = 0x10;
+const uint8_t DDP_FLAG_REPLY = 0x04;
+const uint8_t DDP_FLAG_QUERY = 0x02;
+const uint8_t DDP_FLAG_PUSH = 0x01;
+
+const uint8_t DDP_TYPE_RGBW = 0x1B;
+
+const uint8_t DDP_ID_DISPLAY = 1;
+
+// E1.31 says to drop a packet whose sequence number is up to this 
+// far behind the last one
+const int8_t E131_SEQUENCE_WINDOW = -20;
+
+//----------------------------------------------------------------------
+// Global Data Definitions
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Static Variable Definitions 
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Function Prototypes
+//----------------------------------------------------------------------
+
+static uint16_t read16( const uint8_t *p );
+static uint32_t read32( const uint8_t *p );
+
+//----------------------------------------------------------------------
+// Required Libraries
+//----------------------------------------------------------------------
+
+// None. (Where supported these should be in the form
+// of C++ pragmas).
+
+//======================================================================
+// FUNCTION IMPLEMENTATIONS
+//======================================================================
+
+/*======================================================================
+FUNCTION:
+RealtimeProxy()
+
+DESCRIPTION:
+C-tor.  Works out how many universes the strip covers, starting 
+at startAddress (1 based) in startUniverse.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+RealtimeProxy::RealtimeProxy( std::shared_ptr<LedAnimator> ledAnimator, uint16_t startUniverse, uint16_t startAddress )
+    : _ledAnimator( ledAnimator ),
+      _started( false ),
+      _startUniverse( startUniverse ),
+      _startAddress( ( startAddress >= 1 && startAddress <= DMX_SLOTS ) ? startAddress : 1 ),
+      _ddpSequence( 0 ),
+      _lastPacketMS( 0 ),
+      _packetsReceived( 0 ),
+      _packetsDropped( 0 ),
+      _framesShown( 0 )
+{
+    // The first universe holds what fits after the start address, 
+    // the rest 170 pixels each
+    uint32_t pixels = _ledAnimator->GetPixelCount();
+    uint32_t first = ( DMX_SLOTS - ( _startAddress - 1 ) ) / 3;
+
+    _universeCount = 1;
+
+    if ( pixels > first )
+    {
+        _universeCount += ( pixels - first + ( DMX_SLOTS / 3 ) - 1 ) / ( DMX_SLOTS / 3 );
+    }
+
+    if ( _universeCount > MAX_UNIVERSES )
+    {
+        _universeCount = MAX_UNIVERSES;
+    }
+
+    memset( _e131SequenceValid, 0, sizeof( _e131SequenceValid ) );
+}
+
+/*======================================================================
+FUNCTION:
+Begin()
+
+DESCRIPTION:
+Opens the DDP and E1.31 ports, and joins the multicast group of each
+of our universes (239.255.<universe high>.<universe low>).
+
+RETURN VALUE:
+true if the ports opened.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+bool RealtimeProxy::Begin()
+{
+    ip4_addr_t local;
+    local.addr = (uint32_t) WiFi.localIP();
+
+    for ( size_t i = 0; i < _universeCount; i++ )
+    {
+        uint16_t universe = _startUniverse + i;
+
+        ip4_addr_t group;
+        IP4_ADDR( &group, 239, 255, universe >> 8, universe & 0xFF );
+
+        if ( igmp_joingroup( &local, &group ) != ERR_OK )
+        {
+            Serial.printf( "RealtimeProxy: joining the group for universe %u failed\n", universe );
+        }
+    }
+
+    _started = ( _ddp.begin( DDP_PORT ) != 0 ) && ( _e131.begin( E131_PORT ) != 0 );
+
+    if ( _started == false )
+    {
+        Serial.println( "RealtimeProxy: opening the ports failed" );
+    }
+
+    return _started;
+}
+
+/*======================================================================
+FUNCTION:
+Process()
+
+DESCRIPTION:
+Reads every packet waiting on both ports.  Each one is read into 
+_packet and parsed in place.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void RealtimeProxy::Process()
+{
+    if ( _started == false )
+    {
+        return;
+    }
+
+    // A sender that went quiet may come back with any sequence
+    // number
+    if ( millis() - _lastPacketMS >= LedAnimator::LIVE_TIMEOUT_MS )
+    {
+        _ddpSequence = 0;
+        memset( _e131SequenceValid, 0, sizeof( _e131SequenceValid ) );
+    }
+
+    int size;
+
+    while ( ( size = _ddp.parsePacket() ) > 0 )
+    {
+        int read = _ddp.read( _packet, sizeof( _packet ) );
+
+        _ddp.flush();
+        _packetsReceived++;
+
+        if ( read != size || handleDDP( (size_t) size ) == false )
+        {
+            _packetsDropped++;
+        }
+    }
+
+    while ( ( size = _e131.parsePacket() ) > 0 )
+    {
+        int read = _e131.read( _packet, sizeof( _packet ) );
+
+        _e131.flush();
+        _packetsReceived++;
+
+        if ( read != size || handleE131( (size_t) size ) == false )
+        {
+            _packetsDropped++;
+        }
+    }
+}
+
+/*======================================================================
+FUNCTION:
+handleDDP()
+
+DESCRIPTION:
+Parses a DDP packet in _packet and writes its pixels into the live frame.
+
+RETURN VALUE:
+false if the packet isn't one we take.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+bool RealtimeProxy::handleDDP( size_t size )
+{
+    if ( size < DDP_HEADER_SIZE )
+    {
+        return false;
+    }
+
+    uint8_t flags = _packet[0];
+    uint8_t destination = _packet[3];
+
+    // Queries and replies (status, config) aren't supported
+    if ( ( flags & DDP_VERSION_MASK ) != DDP_VERSION_1 ||
+         ( flags & ( DDP_FLAG_QUERY | DDP_FLAG_REPLY ) ) != 0 ||
+         ( destination != DDP_ID_DISPLAY && destination != 0 ) )
+    {
+        return false;
+    }
+
+    size_t header = DDP_HEADER_SIZE + ( ( ( flags & DDP_FLAG_TIMECODE ) != 0 ) ? DDP_TIMECODE_SIZE : 0 );
+    uint8_t channels = ( _packet[2] == DDP_TYPE_RGBW ) ? 4 : 3;
+    uint32_t offset = read32( _packet + 4 );
+    uint16_t length = read16( _packet + 8 );
+
+    if ( header + length > size || offset % channels != 0 || length % channels != 0 )
+    {
+        return false;
+    }
+
+    if ( ddpSequence( _packet[1] & 0x0F ) == false )
+    {
+        return false;
+    }
+
+    _lastPacketMS = millis();
+
+    _ledAnimator->SetLivePixels( offset / channels, _packet + header, length / channels, channels );
+
+    if ( ( flags & DDP_FLAG_PUSH ) != 0 )
+    {
+        show();
+    }
+
+    return true;
+}
+
+/*======================================================================
+FUNCTION:
+handleE131()
+
+DESCRIPTION:
+Parses an E1.31 data packet in _packet and writes its pixels into 
+the live frame.
+
+RETURN VALUE:
+false if the packet isn't one we take.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+bool RealtimeProxy::handleE131( size_t size )
+{
+    if ( size < E131_DATA ||
+         memcmp( _packet + E131_ACN_ID, ACN_PACKET_ID, sizeof( ACN_PACKET_ID ) ) != 0 ||
+         read32( _packet + E131_ROOT_VECTOR ) != 0x00000004UL ||
+         read32( _packet + E131_FRAMING_VECTOR ) != 0x00000002UL ||
+         _packet[E131_DMP_VECTOR] != 0x02 ||
+         _packet[E131_ADDRESS_TYPE] != 0xA1 ||
+         _packet[E131_START_CODE] != 0 )
+    {
+        return false;
+    }
+
+    uint16_t universe = read16( _packet + E131_UNIVERSE );
+    uint8_t options = _packet[E131_OPTIONS];
+
+    // Value count includes the start code
+    size_t slots = read16( _packet + E131_VALUE_COUNT );
+    slots = ( slots > 0 ) ? slots - 1 : 0;
+
+    if ( universe < _startUniverse || 
+         universe >= _startUniverse + _universeCount ||
+         slots > DMX_SLOTS ||
+         E131_DATA + slots > size )
+    {
+        return false;
+    }
+
+    // Meant for a console's preview, not for the pixels
+    if ( ( options & E131_OPTION_PREVIEW ) != 0 )
+    {
+        return true;
+    }
+
+    size_t index = universe - _startUniverse;
+
+    if ( e131Sequence( index, _packet[E131_SEQUENCE] ) == false )
+    {
+        return false;
+    }
+
+    _lastPacketMS = millis();
+
+    if ( ( options & E131_OPTION_TERMINATED ) != 0 )
+    {
+        _ledAnimator->EndLive();
+        return true;
+    }
+
+    // Where this universe's pixels start, in the universe and on 
+    // the strip
+    size_t firstSlot = ( index == 0 ) ? _startAddress - 1 : 0;
+    uint32_t pixel = 0;
+
+    if ( index > 0 )
+    {
+        pixel = ( DMX_SLOTS - ( _startAddress - 1 ) ) / 3 + ( index - 1 ) * ( DMX_SLOTS / 3 );
+    }
+
+    if ( slots > firstSlot )
+    {
+        _ledAnimator->SetLivePixels( pixel, _packet + E131_DATA + firstSlot, ( slots - firstSlot ) / 3, 3 );
+    }
+
+    // The last universe finishes the frame
+    if ( index == _universeCount - 1 )
+    {
+        show();
+    }
+
+    return true;
+}
+
+/*======================================================================
+FUNCTION:
+ddpSequence()
+
+DESCRIPTION:
+Checks a DDP sequence number (1..15, wrapping, 0 if the sender 
+doesn't use them).  A repeat, or one up to half way round behind, is
+stale.
+
+RETURN VALUE:
+true if the packet should be used.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+bool RealtimeProxy::ddpSequence( uint8_t sequence )
+{
+    if ( sequence == 0 || _ddpSequence == 0 )
+    {
+        _ddpSequence = sequence;
+        return true;
+    }
+
+    // Distance forward from the last one, on the 1..15 circle
+    uint8_t ahead = ( sequence + 15 - _ddpSequence ) % 15;
+
+    if ( ahead == 0 || ahead > 7 )
+    {
+        return false;
+    }
+
+    _ddpSequence = sequence;
+    return true;
+}
+
+/*======================================================================
+FUNCTION:
+e131Sequence()
+
+DESCRIPTION:
+Checks an E1.31 sequence number.  Per the standard, one that is 
+behind the last one (by less than 20, further back is taken as the 
+sender starting over) or the same is stale.
+
+RETURN VALUE:
+true if the packet should be used.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+bool RealtimeProxy::e131Sequence( size_t universe, uint8_t sequence )
+{
+    if ( _e131SequenceValid[universe] == true )
+    {
+        int8_t difference = (int8_t) ( sequence - _e131Sequences[universe] );
+
+        if ( difference <= 0 && difference > E131_SEQUENCE_WINDOW )
+        {
+            return false;
+        }
+    }
+
+    _e131Sequences[universe] = sequence;
+    _e131SequenceValid[universe] = true;
+
+    return true;
+}
+
+/*======================================================================
+FUNCTION:
+show()
+
+DESCRIPTION:
+Hands the finished frame to the animator.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void RealtimeProxy::show()
+{
+    _ledAnimator->ShowLive();
+    _framesShown++;
+}
+
+/*======================================================================
+FUNCTION:
+Report()
+
+DESCRIPTION:
+Formats the packet counts for a status page.
+
+RETURN VALUE:
+The report.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+String RealtimeProxy::Report() const
+{
+    char buffer[160];
+
+    snprintf( buffer, sizeof( buffer ),
+              "live:      %s\n"
+              "universes: %u..%u (from address %u)\n"
+              "packets:   %lu\n"
+              "dropped:   %lu\n"
+              "frames:    %lu\n",
+              _ledAnimator->IsLive() ? "yes" : "no",
+              (unsigned) _startUniverse,
+              (unsigned) ( _startUniverse + _universeCount - 1 ),
+              (unsigned) _startAddress,
+              (unsigned long) _packetsReceived,
+              (unsigned long) _packetsDropped,
+              (unsigned long) _framesShown );
+
+    return buffer;
+}
+
+/*======================================================================
+FUNCTION:
+read16()
+
+DESCRIPTION:
+Reads a big endian 16 bit value.
+
+RETURN VALUE:
+The value.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+static uint16_t read16( const uint8_t *p )
+{
+    return (uint16_t) ( ( p[0] << 8 ) | p[1] );
+}
+
+/*======================================================================
+FUNCTION:
+read32()
+
+DESCRIPTION:
+Reads a big endian 32 bit value.
+
+RETURN VALUE:
+The value.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+static uint32_t read32( const uint8_t *p )
+{
+    return ( (uint32_t) p[0] << 24 ) | ( (uint32_t) p[1] << 16 ) | ( (uint32_t) p[2] << 8 ) | p[3];
+}
+
+/*=====================================================================
+// IMPLEMENTATION NOTES
+//=====================================================================
+
+None
+
+=====================================================================*/
@@ -0,0 +1,265 @@
+#ifndef _JAROFLIGHT_REALTIMEPROXY_H_
+#define _JAROFLIGHT_REALTIMEPROXY_H_
+
+/*======================================================================
+FILE:
+realtimeproxy.h
+
+CREATOR:
+Sean Foley
+
+DESCRIPTION:
+DDP and E1.31 (sACN) real time pixel receiver.
+
+PUBLIC CLASSES AND FUNCTIONS:
+RealtimeProxy
+
+Copyright (C) 2017 Sean Foley  All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted.  Enjoy.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+======================================================================*/
+
+//======================================================================
+// INCLUDES AND PUBLIC DATA DECLARATIONS
+//======================================================================
+
+//----------------------------------------------------------------------
+// Defines
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Include Files
+//----------------------------------------------------------------------
+
+#include <stdint.h>
+
+#include <memory>
+
+#include <WiFiUdp.h>
+
+#include "ledanimator.h"
+
+//----------------------------------------------------------------------
+// Type Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Constant Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Data Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//======================================================================
+// WARNINGS!!!
+//======================================================================
+
+// None.
+
+//======================================================================
+// FUNCTION DECLARATIONS
+//======================================================================
+
+// None.
+
+//=====================================================================
+// EXCEPTION CLASS DEFINITIONS
+//=====================================================================
+
+// None.
+
+//======================================================================
+// CLASS DEFINITIONS
+//======================================================================
+
+/*======================================================================
+CLASS:
+RealtimeProxy
+
+DESCRIPTION:
+Receives pixels from lighting software on the LAN (xLights, 
+Vixen, LedFx, Resolume, etc.) over DDP and E1.31 (sACN), and 
+shows them in place of the running animation.  When the packets stop
+the animation takes back over (see LedAnimator::LIVE_TIMEOUT_MS) - it
+kept its place on the timeline the whole time.
+
+Each packet is read once out of the network stack and its pixels are
+written straight from there into the animator's live frame, so there
+is no copy in between.  A frame is shown on DDP's push flag, or once
+the last E1.31 universe of the strip comes in.
+
+E1.31 universes are laid out like most controllers do: pixels start 
+at the start address of the start universe, fill it (170 RGB pixels 
+to a universe), then carry on from channel 1 of each universe after 
+it.  Stale or repeated packets are dropped by sequence number, per
+universe.
+
+HOW TO USE:
+1. Construct with the animator to drive and the universe (and 
+address in it) the strip starts at
+2. Call Begin() once the network is up
+3. Call Process() often - packets are read there
+
+======================================================================*/
+class RealtimeProxy
+{
+    public:
+
+    //=================================================================
+    // TYPE DECLARATIONS AND CONSTANTS    
+    //=================================================================
+
+    static const uint16_t DDP_PORT = 4048;
+    static const uint16_t E131_PORT = 5568;
+
+    static const uint16_t DEFAULT_UNIVERSE = 1;
+
+    // Most universes we listen on, and biggest packet we take
+    static const size_t MAX_UNIVERSES = 8;
+    static const size_t MAX_PACKET_SIZE = 1460;
+
+    //=================================================================
+    // CLIENT INTERFACE
+    //=================================================================
+
+    RealtimeProxy( std::shared_ptr<LedAnimator> ledAnimator, 
+                   uint16_t startUniverse = DEFAULT_UNIVERSE, 
+                   uint16_t startAddress = 1 );
+
+    // Opens the ports and joins the E1.31 multicast groups
+    bool Begin();
+
+    // Reads every packet that is waiting.  Never blocks.
+    void Process();
+
+    uint32_t GetPacketsReceived() const { return _packetsReceived; }
+    uint32_t GetPacketsDropped() const { return _packetsDropped; }
+    uint32_t GetFramesShown() const { return _framesShown; }
+
+    // The above, formatted for a status page
+    String Report() const;
+
+    protected:
+
+    //=================================================================
+    // SUBCLASS INTERFACE   
+    //=================================================================
+
+    // None.
+
+    private:
+
+    //=================================================================
+    // CUSTOMIZATION INTERFACE    
+    //=================================================================
+
+    // None.
+
+    //=================================================================
+    // IMPLEMENTATION INTERFACE    
+    //=================================================================
+
+    // No copying - intentionally not defining the implementation
+    // to throw a link error if someone somehow invokes a copy.
+    RealtimeProxy( const RealtimeProxy &rhs );
+
+    // Parse one packet, returning false if it isn't one we take
+    bool handleDDP( size_t size );
+    bool handleE131( size_t size );
+
+    // Sequence checks, false if the packet is stale or repeated
+    bool ddpSequence( uint8_t sequence );
+    bool e131Sequence( size_t universe, uint8_t sequence );
+
+    // Called when a frame is complete
+    void show();
+
+    //=================================================================
+    // DATA MEMBERS    
+    //=================================================================
+
+    std::shared_ptr<LedAnimator> _ledAnimator;
+
+    WiFiUDP _ddp;
+    WiFiUDP _e131;
+    bool _started;
+
+    // Where the strip starts, and how many universes it covers
+    uint16_t _startUniverse;
+    uint16_t _startAddress;
+    size_t _universeCount;
+
+    // The packet being parsed
+    uint8_t _packet[MAX_PACKET_SIZE];
+
+    // Last sequence number seen, per source.  Forgotten once the 
+    // stream goes quiet, so a sender that restarted isn't ignored.
+    uint8_t _ddpSequence;
+    uint8_t _e131Sequences[MAX_UNIVERSES];
+    bool _e131SequenceValid[MAX_UNIVERSES];
+    uint32_t _lastPacketMS;
+
+    uint32_t _packetsReceived;
+    uint32_t _packetsDropped;
+    uint32_t _framesShown;
+};
+
+//======================================================================
+// INLINE FUNCTION DEFINITIONS
+//======================================================================
+
+// None.
+
+
+/*======================================================================
+// DOCUMENTATION
+========================================================================
+
+DDP (http://www.3waylabs.com/ddp/) - 10 byte header, big endian:
+
+    0   flags       0x40 version 1, 0x10 timecode follows the header,
+                    0x02 query, 0x01 push (show the frame)
+    1   sequence    1..15, 0 if not used
+    2   data type   0x1B is RGBW, anything else RGB
+    3   destination 1 (or 0) for the display
+    4   offset      byte offset into the frame (4 bytes)
+    8   length      bytes of pixel data (2 bytes)
+
+E1.31 (ANSI E1.31-2016) - the parts we look at:
+
+    4   ACN packet identifier, "ASC-E1.17"
+    18  root vector, 4 for data
+    40  framing vector, 2 for data
+    111 sequence number
+    112 options, 0x80 preview (ignored), 0x40 stream terminated
+    113 universe
+    117 DMP vector (2), 118 address/data type (0xA1)
+    123 property value count, start code + slots
+    125 start code, 0 for dimmer (pixel) data
+    126 up to 512 slots
+
+======================================================================*/
+
+#endif	// #ifendif _JAROFLIGHT_REALTIMEPROXY_H_
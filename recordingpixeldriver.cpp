@@ -0,0 +1,152 @@
+/*======================================================================
+FILE:
+recordingpixeldriver.cpp
+
+CREATOR:
+Sean Foley
+
+GENERAL DESCRIPTION:
+Pixel output driver that records frames instead of displaying them.
+
+PUBLIC CLASSES AND FUNCTIONS:
+RecordingPixelDriver
+
+INITIALIZATION AND SEQUENCING REQUIREMENTS:
+None.
+
+Copyright (C) 2017 Sean Foley  All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted.  Enjoy.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+======================================================================*/
+
+//======================================================================
+// INCLUDES AND VARIABLE DEFINITIONS
+//======================================================================
+
+//----------------------------------------------------------------------
+// Defines
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Include Files
+//----------------------------------------------------------------------
+
+#include "recordingpixeldriver.h"
+
+//----------------------------------------------------------------------
+// Type Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Constant Definitions
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Data Definitions
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Static Variable Definitions 
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Function Prototypes
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Required Libraries
+//----------------------------------------------------------------------
+
+// None. (Where supported these should be in the form
+// of C++ pragmas).
+
+//======================================================================
+// FUNCTION IMPLEMENTATIONS
+//======================================================================
+
+/*======================================================================
+FUNCTION:
+RecordingPixelDriver()
+
+DESCRIPTION:
+C-tor
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+RecordingPixelDriver::RecordingPixelDriver( uint32_t pixelCount )
+    : _pixelCount( pixelCount ), _lastFrame( new uint32_t[pixelCount] )
+{
+    for ( uint32_t i = 0; i < _pixelCount; i++ )
+    {
+        _lastFrame[i] = 0;
+    }
+}
+
+/*======================================================================
+FUNCTION:
+Show()
+
+DESCRIPTION:
+Records the frame
+
+RETURN VALUE:
+true, the frame is always taken
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+bool RecordingPixelDriver::Show( const uint32_t *pixels, uint32_t count )
+{
+    if ( count > _pixelCount )
+    {
+        count = _pixelCount;
+    }
+
+    for ( uint32_t i = 0; i < count; i++ )
+    {
+        _lastFrame[i] = pixels[i];
+    }
+
+    _frameCount++;
+
+    return true;
+}
+
+/*=====================================================================
+// IMPLEMENTATION NOTES
+//=====================================================================
+
+None
+
+=====================================================================*/
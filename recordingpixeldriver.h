@@ -0,0 +1,188 @@
+#ifndef _JAROFLIGHT_RECORDINGPIXELDRIVER_H_
+#define _JAROFLIGHT_RECORDINGPIXELDRIVER_H_
+
+/*======================================================================
+FILE:
+recordingpixeldriver.h
+
+CREATOR:
+Sean Foley
+
+DESCRIPTION:
+Pixel output driver that records frames instead of displaying them.
+
+PUBLIC CLASSES AND FUNCTIONS:
+RecordingPixelDriver
+
+Copyright (C) 2017 Sean Foley  All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted.  Enjoy.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+======================================================================*/
+
+//======================================================================
+// INCLUDES AND PUBLIC DATA DECLARATIONS
+//======================================================================
+
+//----------------------------------------------------------------------
+// Defines
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Include Files
+//----------------------------------------------------------------------
+
+#include <stdint.h>
+
+#include <memory>
+
+#include "pixeldriver.h"
+
+//----------------------------------------------------------------------
+// Type Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Constant Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Data Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//======================================================================
+// WARNINGS!!!
+//======================================================================
+
+// None.
+
+//======================================================================
+// FUNCTION DECLARATIONS
+//======================================================================
+
+// None.
+
+//=====================================================================
+// EXCEPTION CLASS DEFINITIONS
+//=====================================================================
+
+// None.
+
+//======================================================================
+// CLASS DEFINITIONS
+//======================================================================
+
+/*======================================================================
+CLASS:
+RecordingPixelDriver
+
+DESCRIPTION:
+PixelDriver that doesn't drive anything.  It keeps a copy of the last
+frame it was given and counts frames, which makes it handy for running 
+the animations on a host machine and checking what they would have
+displayed.
+
+HOW TO USE:
+1. Construct with the # of pixels
+2. Hand it to a LedAnimator
+3. Look at GetFrameCount() / GetPixel() after driving the animator
+
+======================================================================*/
+class RecordingPixelDriver : public PixelDriver
+{
+    public:
+
+    //=================================================================
+    // TYPE DECLARATIONS AND CONSTANTS    
+    //=================================================================
+
+    // None.
+
+    //=================================================================
+    // CLIENT INTERFACE
+    //=================================================================
+
+    explicit RecordingPixelDriver( uint32_t pixelCount );
+
+    virtual void Begin() {}
+
+    virtual bool Show( const uint32_t *pixels, uint32_t count );
+
+    uint32_t GetFrameCount() const { return _frameCount; }
+
+    uint32_t GetPixelCount() const { return _pixelCount; }
+
+    // Pixel from the last frame shown, packed 0xWWRRGGBB
+    uint32_t GetPixel( uint32_t index ) const { return _lastFrame[index]; }
+
+    protected:
+
+    //=================================================================
+    // SUBCLASS INTERFACE   
+    //=================================================================
+
+    // None.
+
+    private:
+
+    //=================================================================
+    // CUSTOMIZATION INTERFACE    
+    //=================================================================
+
+    // None.
+
+    //=================================================================
+    // IMPLEMENTATION INTERFACE    
+    //=================================================================
+
+    // No copying - intentionally not defining the implementation
+    // to throw a link error if someone somehow invokes a copy.
+    RecordingPixelDriver( const RecordingPixelDriver &rhs );
+
+    //=================================================================
+    // DATA MEMBERS    
+    //=================================================================
+
+    uint32_t _pixelCount;
+
+    uint32_t _frameCount = 0;
+
+    std::unique_ptr< uint32_t[] > _lastFrame;
+};
+
+//======================================================================
+// INLINE FUNCTION DEFINITIONS
+//======================================================================
+
+// None.
+
+
+/*======================================================================
+// DOCUMENTATION
+========================================================================
+
+None.
+
+======================================================================*/
+
+#endif	// #ifendif _JAROFLIGHT_RECORDINGPIXELDRIVER_H_
@@ -0,0 +1,544 @@
+/*======================================================================
+FILE:
+requestparams.cpp
+
+CREATOR:
+Sean Foley
+
+GENERAL DESCRIPTION:
+Parsing and checking of the LED request parameters.
+
+PUBLIC CLASSES AND FUNCTIONS:
+RequestParams
+
+INITIALIZATION AND SEQUENCING REQUIREMENTS:
+None.
+
+Copyright (C) 2017 Sean Foley  All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted.  Enjoy.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+======================================================================*/
+
+//======================================================================
+// INCLUDES AND VARIABLE DEFINITIONS
+//======================================================================
+
+//----------------------------------------------------------------------
+// Defines
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Include Files
+//----------------------------------------------------------------------
+
+#include "requestparams.h"
+
+#include <string.h>
+
+//----------------------------------------------------------------------
+// Type Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Constant Definitions
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Data Definitions
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Static Variable Definitions 
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Function Prototypes
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Required Libraries
+//----------------------------------------------------------------------
+
+// None. (Where supported these should be in the form
+// of C++ pragmas).
+
+//======================================================================
+// FUNCTION IMPLEMENTATIONS
+//======================================================================
+
+/*======================================================================
+FUNCTION:
+Clear()
+
+DESCRIPTION:
+Empties a Look, so nothing in it is given.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void RequestParams::Clear( Look &look )
+{
+    look.fields = 0;
+    look.animation = AnimationRegistry::NOT_FOUND;
+    look.color = 0;
+    look.brightness = 0;
+    look.speed = LedAnimator::SPEED_NORMAL;
+    look.transitionMS = 0;
+}
+
+/*======================================================================
+FUNCTION:
+Parse()
+
+DESCRIPTION:
+Parses one name/value pair into look.
+
+RETURN VALUE:
+false if the name is unknown or the value is bad.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+bool RequestParams::Parse( const char *name, const char *value, Look &look )
+{
+    uint32_t number = 0;
+
+    if ( strcmp( name, "animation" ) == 0 )
+    {
+        if ( ParseAnimation( value, look.animation ) == false )
+        {
+            return false;
+        }
+
+        look.fields |= FIELD_ANIMATION;
+    }
+    else if ( strcmp( name, "color" ) == 0 )
+    {
+        if ( ParseColor( value, look.color ) == false )
+        {
+            return false;
+        }
+
+        look.fields |= FIELD_COLOR;
+    }
+    else if ( strcmp( name, "brightness" ) == 0 )
+    {
+        if ( ParseUnsigned( value, 255, number ) == false )
+        {
+            return false;
+        }
+
+        look.brightness = (uint8_t) number;
+        look.fields |= FIELD_BRIGHTNESS;
+    }
+    else if ( strcmp( name, "speed" ) == 0 )
+    {
+        if ( ParseUnsigned( value, LedAnimator::MAX_SPEED, number ) == false )
+        {
+            return false;
+        }
+
+        look.speed = (uint16_t) number;
+        look.fields |= FIELD_SPEED;
+    }
+    else if ( strcmp( name, "transition" ) == 0 )
+    {
+        if ( ParseUnsigned( value, MAX_TRANSITION_MS, look.transitionMS ) == false )
+        {
+            return false;
+        }
+
+        look.fields |= FIELD_TRANSITION;
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
+}
+
+/*======================================================================
+FUNCTION:
+ParseList()
+
+DESCRIPTION:
+Parses a batch of name=value pairs into one look.  Pairs are 
+separated by newlines, & or ;, blank ones are skipped, and spaces 
+around the names and values are ignored, so both of these work:
+
+    animation=pulse             animation=pulse&color=ff0000
+    color=ff0000
+    brightness=128
+
+The separators and = signs are overwritten with terminators as we go,
+so nothing is copied.
+
+RETURN VALUE:
+true if every pair parsed, otherwise false with badItem set.
+
+SIDE EFFECTS:
+text is modified.
+
+======================================================================*/
+bool RequestParams::ParseList( char *text, Look &look, size_t &badItem )
+{
+    size_t item = 0;
+    char *p = text;
+
+    badItem = 0;
+
+    while ( p != nullptr && *p != 0 )
+    {
+        char *end = strpbrk( p, "\r\n&;" );
+
+        if ( end != nullptr )
+        {
+            *end++ = 0;
+        }
+
+        // Trim the pair
+        while ( *p == ' ' || *p == '\t' )
+        {
+            p++;
+        }
+
+        size_t length = strlen( p );
+
+        while ( length > 0 && ( p[length - 1] == ' ' || p[length - 1] == '\t' ) )
+        {
+            p[--length] = 0;
+        }
+
+        if ( length > 0 )
+        {
+            item++;
+
+            char *value = strchr( p, '=' );
+
+            if ( value == nullptr )
+            {
+                badItem = item;
+                return false;
+            }
+
+            // Spaces either side of the =
+            for ( char *c = value; c > p && ( c[-1] == ' ' || c[-1] == '\t' ); c-- )
+            {
+                c[-1] = 0;
+            }
+
+            *value++ = 0;
+
+            while ( *value == ' ' || *value == '\t' )
+            {
+                value++;
+            }
+
+            if ( Parse( p, value, look ) == false )
+            {
+                badItem = item;
+                return false;
+            }
+        }
+
+        p = end;
+    }
+
+    return true;
+}
+
+/*======================================================================
+FUNCTION:
+Apply()
+
+DESCRIPTION:
+Applies a Look to an animator.  Everything is queued up for the 
+animator's next frame, so the changes all show up together - there 
+is never a frame with the new brightness but the old animation.
+
+A color on its own recolors what is running in place, so it carries
+on where it is.  The demo picks its own colors, so it can't be 
+started with one.  A transition is the crossfade to a new animation,
+so there has to be one to fade to.
+
+RETURN VALUE:
+false, with nothing changed, if the look doesn't go together.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+bool RequestParams::Apply( const Look &look, LedAnimator &animator )
+{
+    if ( ( look.fields & FIELD_ANIMATION ) != 0 && 
+         look.animation == DEMO &&
+         ( look.fields & FIELD_COLOR ) != 0 )
+    {
+        return false;
+    }
+
+    if ( ( look.fields & FIELD_TRANSITION ) != 0 && 
+         ( look.fields & FIELD_ANIMATION ) == 0 )
+    {
+        return false;
+    }
+
+    if ( ( look.fields & FIELD_BRIGHTNESS ) != 0 )
+    {
+        animator.QueuePixelBrightness( look.brightness );
+    }
+
+    if ( ( look.fields & FIELD_SPEED ) != 0 )
+    {
+        animator.QueueSpeed( look.speed );
+    }
+
+    if ( ( look.fields & FIELD_ANIMATION ) == 0 )
+    {
+        if ( ( look.fields & FIELD_COLOR ) != 0 )
+        {
+            animator.QueueColor( look.color );
+        }
+        return true;
+    }
+
+    uint32_t transitionMS = ( ( look.fields & FIELD_TRANSITION ) != 0 ) ? look.transitionMS : animator.GetTransitionTime();
+
+    if ( look.animation == DEMO )
+    {
+        animator.DemoAt( transitionMS, 0 );
+    }
+    else
+    {
+        uint32_t color = ( ( look.fields & FIELD_COLOR ) != 0 ) ? look.color : animator.GetColor();
+
+        animator.Start( look.animation, color, transitionMS );
+    }
+    return true;
+}
+
+/*======================================================================
+FUNCTION:
+ParseColor()
+
+DESCRIPTION:
+Parses a color: rrggbb or wwrrggbb in hex, with or without a leading
+#, or r,g,b or r,g,b,w with each 0..255 in decimal.
+
+RETURN VALUE:
+true if it is a color.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+bool RequestParams::ParseColor( const char *text, uint32_t &color )
+{
+    if ( text == nullptr )
+    {
+        return false;
+    }
+
+    if ( strchr( text, ',' ) != nullptr )
+    {
+        uint32_t channels[4] = { 0, 0, 0, 0 };
+        int count = 0;
+        const char *p = text;
+
+        while ( count < 4 )
+        {
+            uint32_t value = 0;
+            int digits = 0;
+
+            while ( *p >= '0' && *p <= '9' && digits < 3 )
+            {
+                value = value * 10 + ( *p++ - '0' );
+                digits++;
+            }
+
+            if ( digits == 0 || value > 255 )
+            {
+                return false;
+            }
+
+            channels[count++] = value;
+
+            if ( *p != ',' )
+            {
+                break;
+            }
+
+            p++;
+        }
+
+        if ( *p != 0 || count < 3 )
+        {
+            return false;
+        }
+
+        color = LedAnimator::Color( (uint8_t) channels[0], (uint8_t) channels[1], 
+                                    (uint8_t) channels[2], (uint8_t) channels[3] );
+        return true;
+    }
+
+    if ( *text == '#' )
+    {
+        text++;
+    }
+
+    uint32_t value = 0;
+    size_t length = 0;
+
+    for ( ; text[length] != 0; length++ )
+    {
+        char c = text[length];
+        uint32_t nibble;
+
+        if ( c >= '0' && c <= '9' ) nibble = c - '0';
+        else if ( c >= 'a' && c <= 'f' ) nibble = c - 'a' + 10;
+        else if ( c >= 'A' && c <= 'F' ) nibble = c - 'A' + 10;
+        else return false;
+
+        if ( length >= 8 )
+        {
+            return false;
+        }
+
+        value = ( value << 4 ) | nibble;
+    }
+
+    if ( length != 6 && length != 8 )
+    {
+        return false;
+    }
+
+    color = value;
+    return true;
+}
+
+/*======================================================================
+FUNCTION:
+ParseUnsigned()
+
+DESCRIPTION:
+Parses a decimal number, digits only, no bigger than max.
+
+RETURN VALUE:
+true if it is one.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+bool RequestParams::ParseUnsigned( const char *text, uint32_t max, uint32_t &value )
+{
+    if ( text == nullptr || *text == 0 )
+    {
+        return false;
+    }
+
+    uint32_t result = 0;
+
+    for ( const char *p = text; *p != 0; p++ )
+    {
+        if ( *p < '0' || *p > '9' )
+        {
+            return false;
+        }
+
+        uint32_t digit = *p - '0';
+
+        // Stop before it can overflow
+        if ( result > ( UINT32_MAX - digit ) / 10 )
+        {
+            return false;
+        }
+
+        result = result * 10 + digit;
+
+        if ( result > max )
+        {
+            return false;
+        }
+    }
+
+    value = result;
+    return true;
+}
+
+/*======================================================================
+FUNCTION:
+ParseAnimation()
+
+DESCRIPTION:
+Looks up an animation by name.  "demo" is the demo.
+
+RETURN VALUE:
+true if there is such an animation.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+bool RequestParams::ParseAnimation( const char *text, uint32_t &index )
+{
+    if ( text == nullptr )
+    {
+        return false;
+    }
+
+    if ( strcmp( text, "demo" ) == 0 )
+    {
+        index = DEMO;
+        return true;
+    }
+
+    uint32_t found = AnimationRegistry::Find( text );
+
+    if ( found == AnimationRegistry::NOT_FOUND )
+    {
+        return false;
+    }
+
+    index = found;
+    return true;
+}
+
+/*=====================================================================
+// IMPLEMENTATION NOTES
+//=====================================================================
+
+None
+
+=====================================================================*/
@@ -0,0 +1,225 @@
+#ifndef _JAROFLIGHT_REQUESTPARAMS_H_
+#define _JAROFLIGHT_REQUESTPARAMS_H_
+
+/*======================================================================
+FILE:
+requestparams.h
+
+CREATOR:
+Sean Foley
+
+DESCRIPTION:
+Parsing and checking of the LED request parameters.
+
+PUBLIC CLASSES AND FUNCTIONS:
+RequestParams
+
+Copyright (C) 2017 Sean Foley  All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted.  Enjoy.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+======================================================================*/
+
+//======================================================================
+// INCLUDES AND PUBLIC DATA DECLARATIONS
+//======================================================================
+
+//----------------------------------------------------------------------
+// Defines
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Include Files
+//----------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "ledanimator.h"
+
+//----------------------------------------------------------------------
+// Type Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Constant Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Data Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//======================================================================
+// WARNINGS!!!
+//======================================================================
+
+// None.
+
+//======================================================================
+// FUNCTION DECLARATIONS
+//======================================================================
+
+// None.
+
+//=====================================================================
+// EXCEPTION CLASS DEFINITIONS
+//=====================================================================
+
+// None.
+
+//======================================================================
+// CLASS DEFINITIONS
+//======================================================================
+
+/*======================================================================
+CLASS:
+RequestParams
+
+DESCRIPTION:
+Parses and checks the parameters a request can set the LEDs with,
+and applies them.  A full look is:
+
+    animation=<name>    from the registry, or demo
+    color=<color>       rrggbb or wwrrggbb in hex (a leading # is 
+                        fine), or r,g,b or r,g,b,w in decimal
+    brightness=<0..255>
+    speed=<0..1000>     percent of normal
+    transition=<ms>     crossfade time, up to MAX_TRANSITION_MS
+
+Everything is parsed straight out of the strings it is given - no
+String or other temporaries are built.
+
+HOW TO USE:
+1. Clear() a Look
+2. Parse() each name/value pair into it (or ParseList() a batch of 
+them), a false return is a bad request
+3. Apply() it to an animator
+
+======================================================================*/
+class RequestParams
+{
+    public:
+
+    //=================================================================
+    // TYPE DECLARATIONS AND CONSTANTS    
+    //=================================================================
+
+    // Which parts of a Look were given
+    enum Field
+    {
+        FIELD_ANIMATION = 0x01,
+        FIELD_COLOR = 0x02,
+        FIELD_BRIGHTNESS = 0x04,
+        FIELD_SPEED = 0x08,
+        FIELD_TRANSITION = 0x10
+    };
+
+    // Look::animation for the demo
+    static const uint32_t DEMO = 0xFFFFFFFEUL;
+
+    static const uint32_t MAX_TRANSITION_MS = 60000;
+
+    struct Look
+    {
+        uint8_t fields;
+        uint32_t animation;
+        uint32_t color;
+        uint8_t brightness;
+        uint16_t speed;
+        uint32_t transitionMS;
+    };
+
+    //=================================================================
+    // CLIENT INTERFACE
+    //=================================================================
+
+    static void Clear( Look &look );
+
+    // Parses one parameter into look.  Returns false if the name 
+    // isn't one of ours or the value doesn't check out.
+    static bool Parse( const char *name, const char *value, Look &look );
+
+    // Parses a list of name=value pairs, one per line (or separated
+    // by & or ;), into look.  Later values win.  The text is split 
+    // up in place.  On failure badItem is the (1 based) number of 
+    // the pair that didn't parse.
+    static bool ParseList( char *text, Look &look, size_t &badItem );
+
+    // Applies whatever was given, all of it at the animator's next 
+    // frame.  A color on its own recolors what is running without
+    // restarting it.  Returns false, changing nothing, for the demo
+    // with a color (it picks its own).
+    static bool Apply( const Look &look, LedAnimator &animator );
+
+    // The parsers Parse() uses, for anyone taking these values 
+    // another way
+    static bool ParseColor( const char *text, uint32_t &color );
+    static bool ParseUnsigned( const char *text, uint32_t max, uint32_t &value );
+    static bool ParseAnimation( const char *text, uint32_t &index );
+
+    protected:
+
+    //=================================================================
+    // SUBCLASS INTERFACE   
+    //=================================================================
+
+    // None.
+
+    private:
+
+    //=================================================================
+    // CUSTOMIZATION INTERFACE    
+    //=================================================================
+
+    // None.
+
+    //=================================================================
+    // IMPLEMENTATION INTERFACE    
+    //=================================================================
+
+    // Everything is static
+    RequestParams();
+
+    //=================================================================
+    // DATA MEMBERS    
+    //=================================================================
+
+    // None.
+};
+
+//======================================================================
+// INLINE FUNCTION DEFINITIONS
+//======================================================================
+
+// None.
+
+
+/*======================================================================
+// DOCUMENTATION
+========================================================================
+
+None.
+
+======================================================================*/
+
+#endif	// #ifendif _JAROFLIGHT_REQUESTPARAMS_H_
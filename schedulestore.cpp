@@ -0,0 +1,812 @@
+/*======================================================================
+FILE:
+schedulestore.cpp
+
+CREATOR:
+Sean Foley
+
+GENERAL DESCRIPTION:
+Changes the animation at set times of the day.
+
+PUBLIC CLASSES AND FUNCTIONS:
+ScheduleStore
+
+INITIALIZATION AND SEQUENCING REQUIREMENTS:
+None.
+
+Copyright (C) 2017 Sean Foley  All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted.  Enjoy.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+======================================================================*/
+
+//======================================================================
+// INCLUDES AND VARIABLE DEFINITIONS
+//======================================================================
+
+//----------------------------------------------------------------------
+// Defines
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Include Files
+//----------------------------------------------------------------------
+
+#include <string.h>
+#include <stdlib.h>
+#include <stddef.h>
+
+#include <Arduino.h>
+#include <LittleFS.h>
+
+#include "schedulestore.h"
+#include "settingsstore.h"
+
+//----------------------------------------------------------------------
+// Type Declarations
+//----------------------------------------------------------------------
+
+// What goes on flash, see SettingsStore for the idea
+struct ScheduleRecord
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count;
+    ScheduleStore::Rule rules[ScheduleStore::MAX_RULES];
+    uint32_t crc;
+};
+
+//----------------------------------------------------------------------
+// Global Constant Definitions
+//----------------------------------------------------------------------
+
+// "JOLR"
+const uint32_t SCHEDULE_MAGIC = 0x4A4F4C52;
+
+// Bump this whenever Rule changes shape
+const uint16_t SCHEDULE_VERSION = 1;
+
+const time_t SECONDS_PER_DAY = 86400;
+
+// How far back we look for a rule to catch up on
+const int CATCH_UP_DAYS = 7;
+
+const char *const DAY_NAMES[] = { "sun", "mon", "tue", "wed", "thu", "fri", "sat" };
+
+//----------------------------------------------------------------------
+// Global Data Definitions
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Static Variable Definitions 
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Function Prototypes
+//----------------------------------------------------------------------
+
+static int weekday( time_t local );
+
+//----------------------------------------------------------------------
+// Required Libraries
+//----------------------------------------------------------------------
+
+// None. (Where supported these should be in the form
+// of C++ pragmas).
+
+//======================================================================
+// FUNCTION IMPLEMENTATIONS
+//======================================================================
+
+/*======================================================================
+FUNCTION:
+C-tor()
+
+DESCRIPTION:
+Constructs the store.  Nothing is read until Begin() is called.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+ScheduleStore::ScheduleStore( std::shared_ptr<LedAnimator> ledAnimator, const char *path )
+    : _ledAnimator( ledAnimator ), _path( path ), _count( 0 ), _changed( true ), _started( false ),
+      _nextFireUTC( 0 ), _lastCheckUTC( 0 )
+{
+    memset( _rules, 0, sizeof( _rules ) );
+}
+
+/*======================================================================
+FUNCTION:
+Begin()
+
+DESCRIPTION:
+Reads the saved rules.
+
+RETURN VALUE:
+true if there were saved rules.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+bool ScheduleStore::Begin()
+{
+    // Already mounted if SettingsStore got there first
+    if ( LittleFS.begin() == false )
+    {
+        return false;
+    }
+
+    return load() && _count > 0;
+}
+
+/*======================================================================
+FUNCTION:
+Process()
+
+DESCRIPTION:
+Fires the rules that are due.  Almost always this is just the one 
+compare against the precomputed next fire time.
+
+The first time through we catch up on the latest rule we missed.  If
+the clock went backwards (an NTP step) or the rules changed, the next
+fire time is worked out again.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void ScheduleStore::Process( TimeProxy &timeProxy )
+{
+    time_t now = timeProxy.GetCurrentTimeUTC();
+
+    if ( _started == false )
+    {
+        _started = true;
+
+        applyLatest( timeProxy, now );
+        computeNext( timeProxy, now );
+    }
+    else if ( _changed == true || now < _lastCheckUTC )
+    {
+        computeNext( timeProxy, now );
+    }
+    else if ( _nextFireUTC != 0 && now >= _nextFireUTC )
+    {
+        // If we were held up long enough to miss a few, the latest 
+        // one is the one that counts
+        applyLatest( timeProxy, now );
+        computeNext( timeProxy, now );
+    }
+
+    _lastCheckUTC = now;
+}
+
+/*======================================================================
+FUNCTION:
+Add()
+
+DESCRIPTION:
+Adds a rule and saves the schedule.
+
+RETURN VALUE:
+true if the rule was added.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+bool ScheduleStore::Add( const Rule &rule )
+{
+    if ( _count >= MAX_RULES || 
+         rule.days == 0 || ( rule.days & ~DAYS_ALL ) != 0 ||
+         rule.hour > 23 || rule.minute > 59 )
+    {
+        return false;
+    }
+
+    Rule &added = _rules[_count];
+
+    memset( &added, 0, sizeof( added ) );
+
+    added.days = rule.days;
+    added.hour = rule.hour;
+    added.minute = rule.minute;
+    added.color = rule.color;
+    memcpy( added.animation, rule.animation, sizeof( added.animation ) );
+    added.animation[sizeof( added.animation ) - 1] = 0;
+
+    _count++;
+    _changed = true;
+
+    save();
+
+    return true;
+}
+
+/*======================================================================
+FUNCTION:
+Remove()
+
+DESCRIPTION:
+Removes a rule and saves the schedule.
+
+RETURN VALUE:
+true if the rule was removed.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+bool ScheduleStore::Remove( size_t index )
+{
+    if ( index >= _count )
+    {
+        return false;
+    }
+
+    for ( size_t i = index; i + 1 < _count; i++ )
+    {
+        _rules[i] = _rules[i + 1];
+    }
+
+    _count--;
+    memset( &_rules[_count], 0, sizeof( Rule ) );
+
+    _changed = true;
+
+    save();
+
+    return true;
+}
+
+/*======================================================================
+FUNCTION:
+Clear()
+
+DESCRIPTION:
+Removes all of the rules and saves the (empty) schedule.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void ScheduleStore::Clear()
+{
+    memset( _rules, 0, sizeof( _rules ) );
+    _count = 0;
+    _changed = true;
+
+    save();
+}
+
+/*======================================================================
+FUNCTION:
+computeNext()
+
+DESCRIPTION:
+Works out when the next rule fires.  The rules are in local time, so
+each one is found in local time and then turned back into UTC.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void ScheduleStore::computeNext( TimeProxy &timeProxy, time_t now )
+{
+    time_t local = timeProxy.ToLocal( now );
+
+    _nextFireUTC = 0;
+
+    for ( size_t i = 0; i < _count; i++ )
+    {
+        time_t fire = nextFire( _rules[i], local );
+
+        if ( fire == 0 )
+        {
+            continue;
+        }
+
+        fire = timeProxy.ToUTC( fire );
+
+        if ( _nextFireUTC == 0 || fire < _nextFireUTC )
+        {
+            _nextFireUTC = fire;
+        }
+    }
+
+    _changed = false;
+}
+
+/*======================================================================
+FUNCTION:
+applyLatest()
+
+DESCRIPTION:
+Applies the rule that fired most recently (at or before now).  Ties go
+to the rule added last.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void ScheduleStore::applyLatest( TimeProxy &timeProxy, time_t now )
+{
+    time_t local = timeProxy.ToLocal( now );
+
+    const Rule *latest = nullptr;
+    time_t latestFire = 0;
+
+    for ( size_t i = 0; i < _count; i++ )
+    {
+        time_t fire = lastFire( _rules[i], local );
+
+        if ( fire != 0 && fire >= latestFire )
+        {
+            latest = &_rules[i];
+            latestFire = fire;
+        }
+    }
+
+    if ( latest != nullptr )
+    {
+        apply( *latest );
+    }
+}
+
+/*======================================================================
+FUNCTION:
+apply()
+
+DESCRIPTION:
+Starts the rule's animation.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void ScheduleStore::apply( const Rule &rule )
+{
+    Serial.printf( "Schedule: %02d:%02d %s\n", rule.hour, rule.minute, rule.animation );
+
+    if ( strcmp( rule.animation, "demo" ) == 0 )
+    {
+        _ledAnimator->Demo();
+    }
+    else
+    {
+        _ledAnimator->Start( rule.animation, rule.color );
+    }
+}
+
+/*======================================================================
+FUNCTION:
+lastFire()
+
+DESCRIPTION:
+Finds the last time the rule fired at or before local, looking back 
+as far as CATCH_UP_DAYS.  Plain arithmetic on the time_t, no calendar
+calls.
+
+RETURN VALUE:
+Local time it fired, 0 if it didn't.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+time_t ScheduleStore::lastFire( const Rule &rule, time_t local )
+{
+    time_t midnight = local - local % SECONDS_PER_DAY;
+    time_t timeOfDay = rule.hour * 3600L + rule.minute * 60L;
+
+    for ( int day = 0; day <= CATCH_UP_DAYS; day++ )
+    {
+        time_t fire = midnight - day * SECONDS_PER_DAY + timeOfDay;
+
+        if ( fire <= local && ( rule.days & ( 1 << weekday( fire ) ) ) != 0 )
+        {
+            return fire;
+        }
+    }
+
+    return 0;
+}
+
+/*======================================================================
+FUNCTION:
+nextFire()
+
+DESCRIPTION:
+Finds the next time the rule fires after local.
+
+RETURN VALUE:
+Local time it fires, 0 if it never does.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+time_t ScheduleStore::nextFire( const Rule &rule, time_t local )
+{
+    time_t midnight = local - local % SECONDS_PER_DAY;
+    time_t timeOfDay = rule.hour * 3600L + rule.minute * 60L;
+
+    // Eight days, so today's time having passed still finds the
+    // same day next week
+    for ( int day = 0; day <= 7; day++ )
+    {
+        time_t fire = midnight + day * SECONDS_PER_DAY + timeOfDay;
+
+        if ( fire > local && ( rule.days & ( 1 << weekday( fire ) ) ) != 0 )
+        {
+            return fire;
+        }
+    }
+
+    return 0;
+}
+
+/*======================================================================
+FUNCTION:
+Report()
+
+DESCRIPTION:
+Lists the rules, one per line, and when the next one fires.
+
+RETURN VALUE:
+The report.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+String ScheduleStore::Report() const
+{
+    String report;
+
+    for ( size_t i = 0; i < _count; i++ )
+    {
+        char days[32];
+        char line[80];
+
+        FormatDays( _rules[i].days, days, sizeof( days ) );
+
+        snprintf( line, sizeof( line ), "%u %02d:%02d %s %s %06lx\n",
+                  (unsigned) i,
+                  _rules[i].hour,
+                  _rules[i].minute,
+                  days,
+                  _rules[i].animation,
+                  (unsigned long) _rules[i].color );
+
+        report += line;
+    }
+
+    char line[48];
+
+    snprintf( line, sizeof( line ), "next: %lu\n", (unsigned long) _nextFireUTC );
+
+    report += line;
+
+    return report;
+}
+
+/*======================================================================
+FUNCTION:
+ParseDays()
+
+DESCRIPTION:
+Parses "all", "weekdays", "weekends", or a comma separated list of 
+day names (sun, mon, tue, wed, thu, fri, sat) into a day mask.
+
+RETURN VALUE:
+true if it parsed.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+bool ScheduleStore::ParseDays( const char *text, uint8_t &days )
+{
+    if ( strcmp( text, "all" ) == 0 )
+    {
+        days = DAYS_ALL;
+        return true;
+    }
+
+    if ( strcmp( text, "weekdays" ) == 0 )
+    {
+        days = DAYS_WEEKDAYS;
+        return true;
+    }
+
+    if ( strcmp( text, "weekends" ) == 0 )
+    {
+        days = DAYS_WEEKENDS;
+        return true;
+    }
+
+    days = 0;
+
+    while ( *text != 0 )
+    {
+        int found = -1;
+
+        for ( int i = 0; i < 7; i++ )
+        {
+            if ( strncmp( text, DAY_NAMES[i], 3 ) == 0 && ( text[3] == ',' || text[3] == 0 ) )
+            {
+                found = i;
+                break;
+            }
+        }
+
+        if ( found < 0 )
+        {
+            return false;
+        }
+
+        days |= 1 << found;
+
+        // A comma has to have another day after it
+        if ( text[3] == ',' && text[4] == 0 )
+        {
+            return false;
+        }
+
+        text += ( text[3] == ',' ) ? 4 : 3;
+    }
+
+    return days != 0;
+}
+
+/*======================================================================
+FUNCTION:
+FormatDays()
+
+DESCRIPTION:
+Writes a day mask out as a comma separated list of day names.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void ScheduleStore::FormatDays( uint8_t days, char *buffer, size_t size )
+{
+    size_t length = 0;
+
+    if ( size == 0 )
+    {
+        return;
+    }
+
+    buffer[0] = 0;
+
+    for ( int i = 0; i < 7; i++ )
+    {
+        if ( ( days & ( 1 << i ) ) == 0 )
+        {
+            continue;
+        }
+
+        int written = snprintf( buffer + length, size - length, "%s%s", 
+                                ( length > 0 ) ? "," : "", DAY_NAMES[i] );
+
+        if ( written < 0 || (size_t) written >= size - length )
+        {
+            break;
+        }
+
+        length += written;
+    }
+}
+
+/*======================================================================
+FUNCTION:
+ParseTime()
+
+DESCRIPTION:
+Parses a 24 hour hh:mm time.
+
+RETURN VALUE:
+true if it parsed.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+bool ScheduleStore::ParseTime( const char *text, uint8_t &hour, uint8_t &minute )
+{
+    char *end = nullptr;
+
+    long hours = strtol( text, &end, 10 );
+
+    if ( end == text || *end != ':' )
+    {
+        return false;
+    }
+
+    const char *minutesText = end + 1;
+
+    long minutes = strtol( minutesText, &end, 10 );
+
+    if ( end == minutesText || *end != 0 || 
+         hours < 0 || hours > 23 || minutes < 0 || minutes > 59 )
+    {
+        return false;
+    }
+
+    hour = (uint8_t) hours;
+    minute = (uint8_t) minutes;
+
+    return true;
+}
+
+/*======================================================================
+FUNCTION:
+load()
+
+DESCRIPTION:
+Reads the rules from flash, if they are intact.
+
+RETURN VALUE:
+true if rules were read.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+bool ScheduleStore::load()
+{
+    File file = LittleFS.open( _path, "r" );
+
+    if ( !file )
+    {
+        return false;
+    }
+
+    // Too big for the stack
+    std::unique_ptr< ScheduleRecord > record( new ScheduleRecord );
+
+    size_t length = file.read( (uint8_t *) record.get(), sizeof( ScheduleRecord ) );
+
+    file.close();
+
+    if ( length != sizeof( ScheduleRecord ) ||
+         record->magic != SCHEDULE_MAGIC ||
+         record->version != SCHEDULE_VERSION ||
+         record->count > MAX_RULES ||
+         record->crc != SettingsStore::Crc32( (const uint8_t *) record.get(), offsetof( ScheduleRecord, crc ) ) )
+    {
+        Serial.println( "ScheduleStore: ignoring invalid schedule" );
+        return false;
+    }
+
+    memcpy( _rules, record->rules, sizeof( _rules ) );
+    _count = record->count;
+    _changed = true;
+
+    for ( size_t i = 0; i < _count; i++ )
+    {
+        _rules[i].animation[MAX_ANIMATION_NAME - 1] = 0;
+    }
+
+    return true;
+}
+
+/*======================================================================
+FUNCTION:
+save()
+
+DESCRIPTION:
+Writes the rules to flash, through a temporary file like SettingsStore.
+
+RETURN VALUE:
+true if written.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+bool ScheduleStore::save()
+{
+    std::unique_ptr< ScheduleRecord > record( new ScheduleRecord );
+
+    memset( record.get(), 0, sizeof( ScheduleRecord ) );
+
+    record->magic = SCHEDULE_MAGIC;
+    record->version = SCHEDULE_VERSION;
+    record->count = (uint16_t) _count;
+    memcpy( record->rules, _rules, sizeof( record->rules ) );
+    record->crc = SettingsStore::Crc32( (const uint8_t *) record.get(), offsetof( ScheduleRecord, crc ) );
+
+    String temporary = String( _path ) + ".tmp";
+
+    File file = LittleFS.open( temporary.c_str(), "w" );
+
+    if ( !file )
+    {
+        return false;
+    }
+
+    size_t length = file.write( (const uint8_t *) record.get(), sizeof( ScheduleRecord ) );
+
+    file.close();
+
+    if ( length != sizeof( ScheduleRecord ) )
+    {
+        LittleFS.remove( temporary.c_str() );
+        return false;
+    }
+
+    // Straight over the old one, which LittleFS does in one step
+    return LittleFS.rename( temporary.c_str(), _path );
+}
+
+/*======================================================================
+FUNCTION:
+weekday()
+
+DESCRIPTION:
+Day of the week of a local time_t.  1 Jan 1970 was a Thursday.
+
+RETURN VALUE:
+0 for Sunday through 6 for Saturday.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+static int weekday( time_t local )
+{
+    return (int) ( ( local / SECONDS_PER_DAY + 4 ) % 7 );
+}
+
+/*=====================================================================
+// IMPLEMENTATION NOTES
+//=====================================================================
+
+None
+
+=====================================================================*/
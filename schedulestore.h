@@ -0,0 +1,272 @@
+#ifndef _JAROFLIGHT_SCHEDULESTORE_H_
+#define _JAROFLIGHT_SCHEDULESTORE_H_
+
+/*======================================================================
+FILE:
+schedulestore.h
+
+CREATOR:
+Sean Foley
+
+DESCRIPTION:
+Changes the animation at set times of the day.
+
+PUBLIC CLASSES AND FUNCTIONS:
+ScheduleStore
+
+Copyright (C) 2017 Sean Foley  All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted.  Enjoy.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+======================================================================*/
+
+//======================================================================
+// INCLUDES AND PUBLIC DATA DECLARATIONS
+//======================================================================
+
+//----------------------------------------------------------------------
+// Defines
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Include Files
+//----------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+
+#include <memory>
+
+#include <WString.h>
+
+#include "ledanimator.h"
+#include "timeproxy.h"
+
+//----------------------------------------------------------------------
+// Type Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Constant Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Data Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//======================================================================
+// WARNINGS!!!
+//======================================================================
+
+// None.
+
+//======================================================================
+// FUNCTION DECLARATIONS
+//======================================================================
+
+// None.
+
+//=====================================================================
+// EXCEPTION CLASS DEFINITIONS
+//=====================================================================
+
+// None.
+
+//======================================================================
+// CLASS DEFINITIONS
+//======================================================================
+
+/*======================================================================
+CLASS:
+ScheduleStore
+
+DESCRIPTION:
+Changes the animation at set times of the day, on the device itself,
+so the lights don't depend on something else being up to poke the 
+REST endpoints.
+
+Rules are cron-like: at hh:mm (local time) on some days of the week,
+start an animation.  A window like "pulse red 17:00-23:00, off 
+otherwise" is two rules, one at 17:00 and one at 23:00.
+
+When the rules are checked, the next time any of them fires is worked
+out once and kept.  Until then Process() is a single compare.  It is
+only when a rule fires (or the rules or the clock change) that the 
+rules are looked at again.
+
+The first time the clock is available, the most recent rule that 
+should have fired (within the last week) is applied, so a jar that 
+was off at 17:00 and comes back at 18:00 still pulses red.
+
+Rules are kept on LittleFS, with a CRC, and survive a reboot.
+
+HOW TO USE:
+1. Construct with the animator the rules drive
+2. Call Begin() to read the saved rules (LittleFS must be mounted, 
+see SettingsStore)
+3. Add()/Remove() rules as needed
+4. Call Process() periodically once the time is synced
+
+======================================================================*/
+class ScheduleStore
+{
+    public:
+
+    //=================================================================
+    // TYPE DECLARATIONS AND CONSTANTS    
+    //=================================================================
+
+    static const size_t MAX_RULES = 16;
+    static const size_t MAX_ANIMATION_NAME = 16;
+
+    // Day masks.  Bit 0 is Sunday, bit 6 is Saturday.
+    static const uint8_t DAYS_ALL = 0x7F;
+    static const uint8_t DAYS_WEEKDAYS = 0x3E;
+    static const uint8_t DAYS_WEEKENDS = 0x41;
+
+    struct Rule
+    {
+        uint8_t days;
+        uint8_t hour;
+        uint8_t minute;
+        uint32_t color;
+        char animation[MAX_ANIMATION_NAME];
+    };
+
+    static constexpr const char *DEFAULT_PATH = "/schedule.bin";
+
+    //=================================================================
+    // CLIENT INTERFACE
+    //=================================================================
+
+    ScheduleStore( std::shared_ptr<LedAnimator> ledAnimator, const char *path = DEFAULT_PATH );
+
+    // Reads the saved rules.  Returns true if there were any.
+    bool Begin();
+
+    // Fires whatever rules are due.  Cheap when nothing is.
+    void Process( TimeProxy &timeProxy );
+
+    // Adds a rule, returning false if the schedule is full or the 
+    // rule makes no sense
+    bool Add( const Rule &rule );
+
+    // Removes the rule at index, returning false if there isn't one
+    bool Remove( size_t index );
+
+    void Clear();
+
+    size_t GetCount() const { return _count; }
+    const Rule &Get( size_t index ) const { return _rules[index]; }
+
+    // When (UTC) the next rule fires, 0 if nothing is scheduled or we
+    // haven't had the time yet
+    time_t GetNextFireTime() const { return _nextFireUTC; }
+
+    // The rules and the next fire time, for a status page
+    String Report() const;
+
+    // "all", "weekdays", "weekends", or a comma separated list of 
+    // sun, mon, tue... into a day mask, and back
+    static bool ParseDays( const char *text, uint8_t &days );
+    static void FormatDays( uint8_t days, char *buffer, size_t size );
+
+    // "hh:mm", 24 hour clock
+    static bool ParseTime( const char *text, uint8_t &hour, uint8_t &minute );
+
+    protected:
+
+    //=================================================================
+    // SUBCLASS INTERFACE   
+    //=================================================================
+
+    // None.
+
+    private:
+
+    //=================================================================
+    // CUSTOMIZATION INTERFACE    
+    //=================================================================
+
+    // None.
+
+    //=================================================================
+    // IMPLEMENTATION INTERFACE    
+    //=================================================================
+
+    // No copying - intentionally not defining the implementation
+    // to throw a link error if someone somehow invokes a copy.
+    ScheduleStore( const ScheduleStore &rhs );
+
+    // When the rule last fired at or before local, and when it next
+    // fires after local.  0 if it never does.
+    static time_t lastFire( const Rule &rule, time_t local );
+    static time_t nextFire( const Rule &rule, time_t local );
+
+    void computeNext( TimeProxy &timeProxy, time_t now );
+    void applyLatest( TimeProxy &timeProxy, time_t now );
+    void apply( const Rule &rule );
+
+    bool load();
+    bool save();
+
+    //=================================================================
+    // DATA MEMBERS    
+    //=================================================================
+
+    std::shared_ptr<LedAnimator> _ledAnimator;
+
+    const char *_path;
+
+    Rule _rules[MAX_RULES];
+    size_t _count;
+
+    // Set when the rules change, so the next fire time is worked 
+    // out again
+    bool _changed;
+
+    // We have had the time at least once (and caught up)
+    bool _started;
+
+    // The next fire time, and the time we last looked (UTC)
+    time_t _nextFireUTC;
+    time_t _lastCheckUTC;
+};
+
+//======================================================================
+// INLINE FUNCTION DEFINITIONS
+//======================================================================
+
+// None.
+
+
+/*======================================================================
+// DOCUMENTATION
+========================================================================
+
+None.
+
+======================================================================*/
+
+#endif	// #ifendif _JAROFLIGHT_SCHEDULESTORE_H_
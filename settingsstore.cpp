@@ -0,0 +1,397 @@
+/*======================================================================
+FILE:
+settingsstore.cpp
+
+CREATOR:
+Sean Foley
+
+GENERAL DESCRIPTION:
+Saves settings to flash so they survive a reboot.
+
+PUBLIC CLASSES AND FUNCTIONS:
+SettingsStore
+
+INITIALIZATION AND SEQUENCING REQUIREMENTS:
+None.
+
+Copyright (C) 2017 Sean Foley  All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted.  Enjoy.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+======================================================================*/
+
+//======================================================================
+// INCLUDES AND VARIABLE DEFINITIONS
+//======================================================================
+
+//----------------------------------------------------------------------
+// Defines
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Include Files
+//----------------------------------------------------------------------
+
+#include <string.h>
+#include <stddef.h>
+
+#include <Arduino.h>
+#include <LittleFS.h>
+
+#include "settingsstore.h"
+
+//----------------------------------------------------------------------
+// Type Declarations
+//----------------------------------------------------------------------
+
+// What actually goes on flash: the settings, wrapped in enough to 
+// tell whether they are ours, the right version, and intact
+struct SettingsRecord
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t length;
+    SettingsStore::Settings settings;
+    uint32_t crc;
+};
+
+//----------------------------------------------------------------------
+// Global Constant Definitions
+//----------------------------------------------------------------------
+
+// "JOLS"
+const uint32_t SETTINGS_MAGIC = 0x4A4F4C53;
+
+// Bump this whenever Settings changes shape
+const uint16_t SETTINGS_VERSION = 1;
+
+//----------------------------------------------------------------------
+// Global Data Definitions
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Static Variable Definitions 
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Function Prototypes
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Required Libraries
+//----------------------------------------------------------------------
+
+// None. (Where supported these should be in the form
+// of C++ pragmas).
+
+//======================================================================
+// FUNCTION IMPLEMENTATIONS
+//======================================================================
+
+/*======================================================================
+FUNCTION:
+C-tor()
+
+DESCRIPTION:
+Constructs the store.  Nothing is read until Begin() is called.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+SettingsStore::SettingsStore( const char *path )
+    : _path( path ), _mounted( false ), _dirty( false ), _dirtySinceMS( 0 ), _writeCount( 0 )
+{
+    Clear( _saved );
+    Clear( _pending );
+}
+
+/*======================================================================
+FUNCTION:
+Begin()
+
+DESCRIPTION:
+Mounts LittleFS and reads the saved settings.  A file system that 
+won't mount is formatted.  The schedule (see ScheduleStore) lives on
+it too and goes with it, but nothing on a file system that won't 
+mount could have been read back anyway.
+
+RETURN VALUE:
+true if valid settings were read.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+bool SettingsStore::Begin()
+{
+    _mounted = LittleFS.begin();
+
+    if ( _mounted == false )
+    {
+        Serial.println( "SettingsStore: file system won't mount, formatting (settings and schedule lost)" );
+
+        _mounted = LittleFS.format() && LittleFS.begin();
+    }
+
+    if ( _mounted == false )
+    {
+        return false;
+    }
+
+    bool loaded = load();
+
+    _pending = _saved;
+
+    return loaded;
+}
+
+/*======================================================================
+FUNCTION:
+Update()
+
+DESCRIPTION:
+Takes the current settings.  If they differ from what is on flash 
+the save timer is (re)started; Process() writes them out once they
+have stopped changing for SAVE_DELAY_MS.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void SettingsStore::Update( const Settings &settings )
+{
+    if ( memcmp( &settings, &_pending, sizeof( settings ) ) == 0 )
+    {
+        return;
+    }
+
+    _pending = settings;
+
+    _dirty = ( memcmp( &_pending, &_saved, sizeof( _pending ) ) != 0 );
+    _dirtySinceMS = millis();
+}
+
+/*======================================================================
+FUNCTION:
+Process()
+
+DESCRIPTION:
+Writes the settings out, once they have settled.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void SettingsStore::Process()
+{
+    if ( _dirty == false || millis() - _dirtySinceMS < SAVE_DELAY_MS )
+    {
+        return;
+    }
+
+    // Either way we are done with this change.  If the write failed,
+    // there is no point in hammering the flash.
+    _dirty = false;
+
+    if ( save() == true )
+    {
+        _saved = _pending;
+        _writeCount++;
+    }
+}
+
+/*======================================================================
+FUNCTION:
+Clear()
+
+DESCRIPTION:
+Sets settings to the defaults.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void SettingsStore::Clear( Settings &settings )
+{
+    memset( &settings, 0, sizeof( settings ) );
+
+    settings.brightness = 255;
+}
+
+/*======================================================================
+FUNCTION:
+load()
+
+DESCRIPTION:
+Reads the record from flash, and keeps the settings if the record is
+intact and the right version.
+
+RETURN VALUE:
+true if valid settings were read.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+bool SettingsStore::load()
+{
+    File file = LittleFS.open( _path, "r" );
+
+    if ( !file )
+    {
+        return false;
+    }
+
+    SettingsRecord record;
+
+    size_t length = file.read( (uint8_t *) &record, sizeof( record ) );
+
+    file.close();
+
+    if ( length != sizeof( record ) ||
+         record.magic != SETTINGS_MAGIC ||
+         record.version != SETTINGS_VERSION ||
+         record.length != sizeof( record.settings ) ||
+         record.crc != Crc32( (const uint8_t *) &record, offsetof( SettingsRecord, crc ) ) )
+    {
+        Serial.println( "SettingsStore: ignoring invalid settings" );
+        return false;
+    }
+
+    _saved = record.settings;
+
+    // Make sure the name is terminated, whatever was on flash
+    _saved.animation[MAX_ANIMATION_NAME - 1] = 0;
+
+    return true;
+}
+
+/*======================================================================
+FUNCTION:
+save()
+
+DESCRIPTION:
+Writes the pending settings to flash.  They go to a temporary file 
+first, and are renamed into place, so a reset part way through leaves
+the old settings alone.
+
+RETURN VALUE:
+true if written.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+bool SettingsStore::save()
+{
+    if ( _mounted == false )
+    {
+        return false;
+    }
+
+    SettingsRecord record;
+    memset( &record, 0, sizeof( record ) );
+
+    record.magic = SETTINGS_MAGIC;
+    record.version = SETTINGS_VERSION;
+    record.length = sizeof( record.settings );
+    record.settings = _pending;
+    record.crc = Crc32( (const uint8_t *) &record, offsetof( SettingsRecord, crc ) );
+
+    String temporary = String( _path ) + ".tmp";
+
+    File file = LittleFS.open( temporary.c_str(), "w" );
+
+    if ( !file )
+    {
+        return false;
+    }
+
+    size_t length = file.write( (const uint8_t *) &record, sizeof( record ) );
+
+    file.close();
+
+    if ( length != sizeof( record ) )
+    {
+        LittleFS.remove( temporary.c_str() );
+        return false;
+    }
+
+    // Rename replaces the old file in one step - removing it first
+    // would leave nothing there if we reset in between
+    return LittleFS.rename( temporary.c_str(), _path );
+}
+
+/*======================================================================
+FUNCTION:
+Crc32()
+
+DESCRIPTION:
+Plain (reflected, 0xEDB88320) CRC-32.  Bitwise rather than table
+driven - it runs over a few dozen bytes once in a while, so the 1K 
+table isn't worth the RAM.
+
+RETURN VALUE:
+The CRC of data.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+uint32_t SettingsStore::Crc32( const uint8_t *data, size_t length )
+{
+    uint32_t crc = 0xFFFFFFFF;
+
+    for ( size_t i = 0; i < length; i++ )
+    {
+        crc ^= data[i];
+
+        for ( int bit = 0; bit < 8; bit++ )
+        {
+            crc = ( crc >> 1 ) ^ ( 0xEDB88320 & ( 0 - ( crc & 1 ) ) );
+        }
+    }
+
+    return ~crc;
+}
+
+/*=====================================================================
+// IMPLEMENTATION NOTES
+//=====================================================================
+
+None
+
+=====================================================================*/
@@ -0,0 +1,229 @@
+#ifndef _JAROFLIGHT_SETTINGSSTORE_H_
+#define _JAROFLIGHT_SETTINGSSTORE_H_
+
+/*======================================================================
+FILE:
+settingsstore.h
+
+CREATOR:
+Sean Foley
+
+DESCRIPTION:
+Saves settings to flash so they survive a reboot.
+
+PUBLIC CLASSES AND FUNCTIONS:
+SettingsStore
+
+Copyright (C) 2017 Sean Foley  All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted.  Enjoy.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+======================================================================*/
+
+//======================================================================
+// INCLUDES AND PUBLIC DATA DECLARATIONS
+//======================================================================
+
+//----------------------------------------------------------------------
+// Defines
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Include Files
+//----------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "wifiproxy.h"
+
+//----------------------------------------------------------------------
+// Type Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Constant Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Data Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//======================================================================
+// WARNINGS!!!
+//======================================================================
+
+// None.
+
+//======================================================================
+// FUNCTION DECLARATIONS
+//======================================================================
+
+// None.
+
+//=====================================================================
+// EXCEPTION CLASS DEFINITIONS
+//=====================================================================
+
+// None.
+
+//======================================================================
+// CLASS DEFINITIONS
+//======================================================================
+
+/*======================================================================
+CLASS:
+SettingsStore
+
+DESCRIPTION:
+Keeps the settings we want back after a power cycle: what the jar 
+was showing, and what we need to get back on the network quickly.
+
+The settings are saved to LittleFS as one small record with a CRC, 
+so a torn or stale write is simply ignored.  Nothing is written 
+unless the settings actually changed, and changes are held back 
+until they settle so a burst of REST calls costs one flash write,
+not one per call.
+
+HOW TO USE:
+1. Call Begin() early in setup().  If it returns true, Get() holds
+the saved settings.
+2. Periodically hand the current settings to Update()
+3. Periodically call Process(), which does the actual writing
+
+======================================================================*/
+class SettingsStore
+{
+    public:
+
+    //=================================================================
+    // TYPE DECLARATIONS AND CONSTANTS    
+    //=================================================================
+
+    static const size_t MAX_ANIMATION_NAME = 16;
+
+    static constexpr const char *DEFAULT_PATH = "/settings.bin";
+
+    struct Settings
+    {
+        char animation[MAX_ANIMATION_NAME];
+        uint32_t color;
+        uint8_t brightness;
+        WifiProxy::FastConnect network;
+    };
+
+    // How long the settings have to sit unchanged before we write
+    // them out
+    static const uint32_t SAVE_DELAY_MS = 5000;
+
+    //=================================================================
+    // CLIENT INTERFACE
+    //=================================================================
+
+    SettingsStore( const char *path = DEFAULT_PATH );
+
+    // Mounts the file system and reads the saved settings.  Returns
+    // true if there were valid settings to read.
+    bool Begin();
+
+    // The saved settings, or the defaults if there weren't any
+    const Settings &Get() const { return _saved; }
+
+    // Hands over the current settings.  Cheap when nothing changed.
+    void Update( const Settings &settings );
+
+    // Writes the settings out once they have settled
+    void Process();
+
+    // Number of times the settings were written since boot
+    uint32_t GetWriteCount() const { return _writeCount; }
+
+    // Sets everything to the defaults (including the padding, so
+    // records can be compared with memcmp)
+    static void Clear( Settings &settings );
+
+    // The CRC the records are checked with, for anything else that
+    // keeps records on flash
+    static uint32_t Crc32( const uint8_t *data, size_t length );
+
+    protected:
+
+    //=================================================================
+    // SUBCLASS INTERFACE   
+    //=================================================================
+
+    // None.
+
+    private:
+
+    //=================================================================
+    // CUSTOMIZATION INTERFACE    
+    //=================================================================
+
+    // None.
+
+    //=================================================================
+    // IMPLEMENTATION INTERFACE    
+    //=================================================================
+
+    // No copying - intentionally not defining the implementation
+    // to throw a link error if someone somehow invokes a copy.
+    SettingsStore( const SettingsStore &rhs );
+
+    bool load();
+    bool save();
+
+    //=================================================================
+    // DATA MEMBERS    
+    //=================================================================
+
+    const char *_path;
+
+    bool _mounted;
+
+    // What is on flash, and what we were last handed
+    Settings _saved;
+    Settings _pending;
+
+    bool _dirty;
+    unsigned long _dirtySinceMS;
+
+    uint32_t _writeCount;
+};
+
+//======================================================================
+// INLINE FUNCTION DEFINITIONS
+//======================================================================
+
+// None.
+
+
+/*======================================================================
+// DOCUMENTATION
+========================================================================
+
+None.
+
+======================================================================*/
+
+#endif	// #ifendif _JAROFLIGHT_SETTINGSSTORE_H_
@@ -0,0 +1,458 @@
+/*======================================================================
+FILE:
+syncproxy.cpp
+
+CREATOR:
+Sean Foley
+
+GENERAL DESCRIPTION:
+Keeps the animations on a group of jars in step.
+
+PUBLIC CLASSES AND FUNCTIONS:
+SyncProxy
+
+INITIALIZATION AND SEQUENCING REQUIREMENTS:
+None.
+
+Copyright (C) 2017 Sean Foley  All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted.  Enjoy.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+======================================================================*/
+
+//======================================================================
+// INCLUDES AND VARIABLE DEFINITIONS
+//======================================================================
+
+//----------------------------------------------------------------------
+// Defines
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Include Files
+//----------------------------------------------------------------------
+
+#include <string.h>
+
+#include <ESP8266WiFi.h>
+
+#include "syncproxy.h"
+
+//----------------------------------------------------------------------
+// Type Declarations
+//----------------------------------------------------------------------
+
+// What goes on the wire.  Every jar is the same little endian ESP8266,
+// so the struct is sent as is.
+struct SyncPacket
+{
+    uint64_t startTimeUS;
+    uint32_t magic;
+    uint32_t color;
+    uint32_t transitionMS;
+    uint8_t version;
+    uint8_t flags;
+    uint16_t recolors;
+    char animation[16];
+};
+
+//----------------------------------------------------------------------
+// Global Constant Definitions
+//----------------------------------------------------------------------
+
+// "JOLY"
+const uint32_t SYNC_MAGIC = 0x4A4F4C59;
+
+// Bump this whenever SyncPacket changes shape
+const uint8_t SYNC_VERSION = 1;
+
+const uint8_t SYNC_FLAG_DEMO = 0x01;
+
+// The group all of the jars listen on
+const IPAddress SYNC_GROUP( 239, 255, 74, 79 );
+
+//----------------------------------------------------------------------
+// Global Data Definitions
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Static Variable Definitions 
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Function Prototypes
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Required Libraries
+//----------------------------------------------------------------------
+
+// None. (Where supported these should be in the form
+// of C++ pragmas).
+
+//======================================================================
+// FUNCTION IMPLEMENTATIONS
+//======================================================================
+
+/*======================================================================
+FUNCTION:
+C-tor()
+
+DESCRIPTION:
+Constructs the proxy.  Nothing is sent until Begin() is called.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+SyncProxy::SyncProxy( std::shared_ptr<LedAnimator> ledAnimator, uint16_t port )
+    : _ledAnimator( ledAnimator ), _port( port ), _started( false ), _joinedMS( 0 ), _sharedValid( false ),
+      _lastSendMS( 0 ), _answerDue( false ), _packetsSent( 0 ), _packetsReceived( 0 )
+{
+    memset( &_shared, 0, sizeof( _shared ) );
+}
+
+/*======================================================================
+FUNCTION:
+Begin()
+
+DESCRIPTION:
+Joins the multicast group.
+
+RETURN VALUE:
+true if we joined.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+bool SyncProxy::Begin()
+{
+    _started = ( _udp.beginMulticast( WiFi.localIP(), SYNC_GROUP, _port ) != 0 );
+    _joinedMS = millis();
+
+    if ( _started == false )
+    {
+        Serial.printf( "SyncProxy: joining the multicast group on port %d failed\n", _port );
+    }
+
+    return _started;
+}
+
+/*======================================================================
+FUNCTION:
+Process()
+
+DESCRIPTION:
+Takes in what the other jars are showing, and lets them know what we
+are showing when it changes (and every BEACON_INTERVAL_MS regardless).
+Only animations timed off of the shared clock are sent; until the 
+clock is synced we have nothing useful to say.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void SyncProxy::Process()
+{
+    if ( _started == false )
+    {
+        return;
+    }
+
+    receive();
+
+    // Wait for a start to be picked up, until then the animator
+    // doesn't know when it started
+    if ( listening() == true ||
+         _ledAnimator->IsSynced() == false || 
+         _ledAnimator->IsStartPending() == true ||
+         _ledAnimator->IsColorPending() == true )
+    {
+        return;
+    }
+
+    SyncState state;
+    readState( state );
+
+    // The same run in another color is a recolor of our own
+    if ( _sharedValid == true && state.startTimeUS == _shared.startTimeUS )
+    {
+        state.recolors = _shared.recolors + ( ( state.color != _shared.color ) ? 1 : 0 );
+    }
+
+    unsigned long sinceSendMS = millis() - _lastSendMS;
+
+    bool changed = ( _sharedValid == false || sameState( state, _shared ) == false );
+
+    if ( changed == true || 
+         sinceSendMS >= BEACON_INTERVAL_MS ||
+         ( _answerDue == true && sinceSendMS >= MIN_SEND_INTERVAL_MS ) )
+    {
+        send( state );
+
+        _shared = state;
+        _sharedValid = true;
+        _answerDue = false;
+    }
+}
+
+/*======================================================================
+FUNCTION:
+readState()
+
+DESCRIPTION:
+Gets what our animator is showing.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void SyncProxy::readState( SyncState &state ) const
+{
+    memset( &state, 0, sizeof( state ) );
+
+    state.demo = _ledAnimator->IsDemo();
+    state.transitionMS = _ledAnimator->GetStartTransitionTime();
+    state.startTimeUS = _ledAnimator->GetStartTime();
+
+    strncpy( state.animation, _ledAnimator->GetAnimationName(), sizeof( state.animation ) - 1 );
+
+    // The demo picks its own colors
+    state.color = ( state.demo == true ) ? 0 : _ledAnimator->GetColor();
+}
+
+/*======================================================================
+FUNCTION:
+sameState()
+
+DESCRIPTION:
+Compares two states.
+
+RETURN VALUE:
+true if they are the same.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+bool SyncProxy::sameState( const SyncState &a, const SyncState &b ) const
+{
+    return a.demo == b.demo &&
+           a.color == b.color &&
+           a.transitionMS == b.transitionMS &&
+           a.startTimeUS == b.startTimeUS &&
+           a.recolors == b.recolors &&
+           strcmp( a.animation, b.animation ) == 0;
+}
+
+/*======================================================================
+FUNCTION:
+isNewerColor()
+
+DESCRIPTION:
+Looks at a state for the run we are on, to see if it was recolored 
+since the last state we sent or took.  The one recolored the most 
+times is the latest.  If two jars were recolored at the same time, 
+the higher address wins, so everyone ends up on the same one.
+
+RETURN VALUE:
+true if we should change to its color.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+bool SyncProxy::isNewerColor( const SyncState &state )
+{
+    if ( state.demo == true || state.color == _ledAnimator->GetColor() )
+    {
+        return false;
+    }
+
+    if ( _sharedValid == false || _shared.startTimeUS != state.startTimeUS )
+    {
+        return true;
+    }
+
+    // Signed, so it is right across the wrap
+    int16_t ahead = (int16_t) ( state.recolors - _shared.recolors );
+
+    if ( ahead != 0 )
+    {
+        return ahead > 0;
+    }
+
+    return state.color != _shared.color && 
+           (uint32_t) _udp.remoteIP() > (uint32_t) WiFi.localIP();
+}
+
+/*======================================================================
+FUNCTION:
+receive()
+
+DESCRIPTION:
+Reads whatever the other jars sent.  A state that started after ours
+is newer, and we switch over to it.  One that started before ours 
+means that jar hasn't heard about our change, so we answer soon.  The
+same start in a different color is a recolor (see isNewerColor()).
+While we are still listening, whatever the group is showing wins.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void SyncProxy::receive()
+{
+    int size;
+
+    while ( ( size = _udp.parsePacket() ) > 0 )
+    {
+        SyncPacket packet;
+
+        bool valid = ( size == sizeof( packet ) ) &&
+                     ( _udp.read( (uint8_t *) &packet, sizeof( packet ) ) == (int) sizeof( packet ) );
+
+        _udp.flush();
+
+        // Not ours, or our own coming back around
+        if ( valid == false || 
+             packet.magic != SYNC_MAGIC || 
+             packet.version != SYNC_VERSION ||
+             _udp.remoteIP() == WiFi.localIP() )
+        {
+            continue;
+        }
+
+        _packetsReceived++;
+
+        packet.animation[sizeof( packet.animation ) - 1] = 0;
+
+        SyncState state;
+        memset( &state, 0, sizeof( state ) );
+
+        state.demo = ( packet.flags & SYNC_FLAG_DEMO ) != 0;
+        state.color = packet.color;
+        state.transitionMS = packet.transitionMS;
+        state.startTimeUS = packet.startTimeUS;
+        state.recolors = packet.recolors;
+        memcpy( state.animation, packet.animation, sizeof( state.animation ) );
+
+        uint64_t ourStartUS = _ledAnimator->GetStartTime();
+        bool synced = _ledAnimator->IsSynced();
+
+        if ( synced == true && packet.startTimeUS == ourStartUS )
+        {
+            // Same run, but a color on its own recolors it without
+            // a restart, so the color can still be news
+            if ( isNewerColor( state ) == true )
+            {
+                _ledAnimator->QueueColor( state.color );
+
+                _shared = state;
+                _sharedValid = true;
+            }
+            continue;
+        }
+
+        if ( synced == true && packet.startTimeUS < ourStartUS && listening() == false )
+        {
+            _answerDue = true;
+            continue;
+        }
+
+        if ( state.demo == true )
+        {
+            _ledAnimator->DemoAt( state.transitionMS, state.startTimeUS );
+        }
+        else if ( _ledAnimator->StartAt( AnimationRegistry::Find( state.animation ), 
+                                         state.color, 
+                                         state.transitionMS, 
+                                         state.startTimeUS ) == false )
+        {
+            // An animation we don't have (older firmware?)
+            continue;
+        }
+
+        // So we don't turn around and send it back out
+        _shared = state;
+        _sharedValid = true;
+        _answerDue = false;
+    }
+}
+
+/*======================================================================
+FUNCTION:
+send()
+
+DESCRIPTION:
+Sends our state to the group.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void SyncProxy::send( const SyncState &state )
+{
+    SyncPacket packet;
+    memset( &packet, 0, sizeof( packet ) );
+
+    packet.magic = SYNC_MAGIC;
+    packet.version = SYNC_VERSION;
+    packet.flags = ( state.demo == true ) ? SYNC_FLAG_DEMO : 0;
+    packet.color = state.color;
+    packet.transitionMS = state.transitionMS;
+    packet.startTimeUS = state.startTimeUS;
+    packet.recolors = state.recolors;
+    memcpy( packet.animation, state.animation, sizeof( packet.animation ) );
+
+    _udp.beginPacketMulticast( SYNC_GROUP, _port, WiFi.localIP() );
+    _udp.write( (const uint8_t *) &packet, sizeof( packet ) );
+    _udp.endPacket();
+
+    _lastSendMS = millis();
+    _packetsSent++;
+}
+
+/*=====================================================================
+// IMPLEMENTATION NOTES
+//=====================================================================
+
+None
+
+=====================================================================*/
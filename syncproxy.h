@@ -0,0 +1,247 @@
+#ifndef _JAROFLIGHT_SYNCPROXY_H_
+#define _JAROFLIGHT_SYNCPROXY_H_
+
+/*======================================================================
+FILE:
+syncproxy.h
+
+CREATOR:
+Sean Foley
+
+DESCRIPTION:
+Keeps the animations on a group of jars in step.
+
+PUBLIC CLASSES AND FUNCTIONS:
+SyncProxy
+
+Copyright (C) 2017 Sean Foley  All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted.  Enjoy.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+======================================================================*/
+
+//======================================================================
+// INCLUDES AND PUBLIC DATA DECLARATIONS
+//======================================================================
+
+//----------------------------------------------------------------------
+// Defines
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Include Files
+//----------------------------------------------------------------------
+
+#include <stdint.h>
+
+#include <memory>
+
+#include <WiFiUdp.h>
+
+#include "ledanimator.h"
+
+//----------------------------------------------------------------------
+// Type Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Constant Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Data Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//======================================================================
+// WARNINGS!!!
+//======================================================================
+
+// None.
+
+//======================================================================
+// FUNCTION DECLARATIONS
+//======================================================================
+
+// None.
+
+//=====================================================================
+// EXCEPTION CLASS DEFINITIONS
+//=====================================================================
+
+// None.
+
+//======================================================================
+// CLASS DEFINITIONS
+//======================================================================
+
+/*======================================================================
+CLASS:
+SyncProxy
+
+DESCRIPTION:
+Keeps a group of jars showing the same thing, in step.
+
+Every jar times its animations off of the same clock (NTP, see 
+TimeProxy and LedAnimator::SetClock()), so all a jar needs to know to
+show exactly what the others are showing is the animation, the color,
+and when it started.  A color on its own doesn't restart anything, so
+recolors are counted to tell the latest one.  Those go out over UDP
+multicast whenever they change, and again every few seconds as a 
+beacon so a jar that joins late snaps into step.  Nothing is sent per
+frame.
+
+If two jars disagree, the one that started more recently wins: that
+is whoever last got a command.  A jar that just joined listens for a
+while before it says anything, so it picks up what the group is 
+showing rather than imposing whatever it booted up with.
+
+HOW TO USE:
+1. Construct with the animator to keep in sync
+2. Call Begin() once the network is up
+3. Call Process() periodically
+
+======================================================================*/
+class SyncProxy
+{
+    public:
+
+    //=================================================================
+    // TYPE DECLARATIONS AND CONSTANTS    
+    //=================================================================
+
+    static const uint16_t DEFAULT_PORT = 7479;
+
+    // How often we repeat what we are showing
+    static const uint32_t BEACON_INTERVAL_MS = 2000;
+
+    // How soon we answer a jar that is behind
+    static const uint32_t MIN_SEND_INTERVAL_MS = 250;
+
+    // How long a jar that just joined listens before it sends
+    static const uint32_t LISTEN_MS = 2 * BEACON_INTERVAL_MS;
+
+    //=================================================================
+    // CLIENT INTERFACE
+    //=================================================================
+
+    SyncProxy( std::shared_ptr<LedAnimator> ledAnimator, uint16_t port = DEFAULT_PORT );
+
+    // Joins the multicast group
+    bool Begin();
+
+    // Sends and receives.  Never blocks.
+    void Process();
+
+    uint32_t GetPacketsSent() const { return _packetsSent; }
+    uint32_t GetPacketsReceived() const { return _packetsReceived; }
+
+    protected:
+
+    //=================================================================
+    // SUBCLASS INTERFACE   
+    //=================================================================
+
+    // None.
+
+    private:
+
+    //=================================================================
+    // CUSTOMIZATION INTERFACE    
+    //=================================================================
+
+    // None.
+
+    //=================================================================
+    // IMPLEMENTATION INTERFACE    
+    //=================================================================
+
+    // No copying - intentionally not defining the implementation
+    // to throw a link error if someone somehow invokes a copy.
+    SyncProxy( const SyncProxy &rhs );
+
+    // What a jar is showing
+    struct SyncState
+    {
+        bool demo;
+        char animation[16];
+        uint32_t color;
+        uint32_t transitionMS;
+        uint64_t startTimeUS;
+
+        // How many times this run has been recolored, so the 
+        // latest color wins
+        uint16_t recolors;
+    };
+
+    void readState( SyncState &state ) const;
+    bool sameState( const SyncState &a, const SyncState &b ) const;
+
+    // True if state is the run we are on, in a color we should take
+    bool isNewerColor( const SyncState &state );
+
+    bool listening() const { return millis() - _joinedMS < LISTEN_MS; }
+
+    void receive();
+    void send( const SyncState &state );
+
+    //=================================================================
+    // DATA MEMBERS    
+    //=================================================================
+
+    std::shared_ptr<LedAnimator> _ledAnimator;
+
+    uint16_t _port;
+
+    WiFiUDP _udp;
+    bool _started;
+    unsigned long _joinedMS;
+
+    // The last state we sent or took from someone else
+    SyncState _shared;
+    bool _sharedValid;
+
+    unsigned long _lastSendMS;
+
+    // Someone is behind, let them know sooner rather than later
+    bool _answerDue;
+
+    uint32_t _packetsSent;
+    uint32_t _packetsReceived;
+};
+
+//======================================================================
+// INLINE FUNCTION DEFINITIONS
+//======================================================================
+
+// None.
+
+
+/*======================================================================
+// DOCUMENTATION
+========================================================================
+
+None.
+
+======================================================================*/
+
+#endif	// #ifendif _JAROFLIGHT_SYNCPROXY_H_
@@ -0,0 +1,326 @@
+/*======================================================================
+FILE:
+taskscheduler.cpp
+
+CREATOR:
+Sean Foley
+
+GENERAL DESCRIPTION:
+A cooperative task scheduler for loop().
+
+PUBLIC CLASSES AND FUNCTIONS:
+TaskScheduler
+
+INITIALIZATION AND SEQUENCING REQUIREMENTS:
+None.
+
+Copyright (C) 2017 Sean Foley  All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted.  Enjoy.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+======================================================================*/
+
+//======================================================================
+// INCLUDES AND VARIABLE DEFINITIONS
+//======================================================================
+
+//----------------------------------------------------------------------
+// Defines
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Include Files
+//----------------------------------------------------------------------
+
+#include <stdio.h>
+
+#include "taskscheduler.h"
+
+//----------------------------------------------------------------------
+// Type Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Constant Definitions
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Data Definitions
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Static Variable Definitions 
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Function Prototypes
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Required Libraries
+//----------------------------------------------------------------------
+
+// None. (Where supported these should be in the form
+// of C++ pragmas).
+
+//======================================================================
+// FUNCTION IMPLEMENTATIONS
+//======================================================================
+
+/*======================================================================
+FUNCTION:
+C-tor()
+
+DESCRIPTION:
+Constructs the scheduler with no tasks.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+TaskScheduler::TaskScheduler()
+    : _taskCount( 0 )
+{
+}
+
+/*======================================================================
+FUNCTION:
+AddTask()
+
+DESCRIPTION:
+Adds a task.  The task is due right away, and after that every 
+periodUS.
+
+RETURN VALUE:
+Task id, or INVALID_TASK if there is no room
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+int TaskScheduler::AddTask( const char *name, uint32_t periodUS, TaskFunction function )
+{
+    if ( _taskCount >= MAX_TASKS || !function )
+    {
+        return INVALID_TASK;
+    }
+
+    Task &task = _tasks[_taskCount];
+
+    task.function = function;
+    task.enabled = true;
+    task.dueUS = micros();
+
+    task.stats.name = name;
+    task.stats.periodUS = periodUS;
+    task.stats.runs = 0;
+    task.stats.lateRuns = 0;
+    task.stats.totalUS = 0;
+    task.stats.maxUS = 0;
+
+    return _taskCount++;
+}
+
+/*======================================================================
+FUNCTION:
+SetEnabled()
+
+DESCRIPTION:
+Enables/disables a task.  A task that is enabled again is due right
+away.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void TaskScheduler::SetEnabled( int task, bool enabled )
+{
+    if ( task < 0 || task >= _taskCount )
+    {
+        return;
+    }
+
+    if ( enabled == true && _tasks[task].enabled == false )
+    {
+        _tasks[task].dueUS = micros();
+    }
+
+    _tasks[task].enabled = enabled;
+}
+
+/*======================================================================
+FUNCTION:
+Run()
+
+DESCRIPTION:
+Runs every task that is due, in the order they were added.  A task's
+next due time is its last due time plus its period, so tasks don't 
+drift.  If a task fell more than a full period behind, it is counted 
+as late and rescheduled from now - we don't try to catch up with a 
+burst of runs.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void TaskScheduler::Run()
+{
+    for ( uint8_t i = 0; i < _taskCount; i++ )
+    {
+        Task &task = _tasks[i];
+
+        if ( task.enabled == false )
+        {
+            continue;
+        }
+
+        uint32_t now = micros();
+
+        // Signed difference handles the micros() wrap
+        int32_t lateUS = (int32_t) ( now - task.dueUS );
+
+        if ( lateUS < 0 )
+        {
+            continue;
+        }
+
+        if ( task.stats.periodUS > 0 && (uint32_t) lateUS >= task.stats.periodUS )
+        {
+            task.stats.lateRuns++;
+            task.dueUS = now + task.stats.periodUS;
+        }
+        else
+        {
+            task.dueUS += task.stats.periodUS;
+        }
+
+        task.function();
+
+        uint32_t costUS = micros() - now;
+
+        task.stats.runs++;
+        task.stats.totalUS += costUS;
+
+        if ( costUS > task.stats.maxUS )
+        {
+            task.stats.maxUS = costUS;
+        }
+
+        // Let the WiFi stack have a turn between tasks
+        yield();
+    }
+}
+
+/*======================================================================
+FUNCTION:
+ResetStats()
+
+DESCRIPTION:
+Zeroes the run time statistics for every task.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void TaskScheduler::ResetStats()
+{
+    for ( uint8_t i = 0; i < _taskCount; i++ )
+    {
+        _tasks[i].stats.runs = 0;
+        _tasks[i].stats.lateRuns = 0;
+        _tasks[i].stats.totalUS = 0;
+        _tasks[i].stats.maxUS = 0;
+    }
+}
+
+/*======================================================================
+FUNCTION:
+Report()
+
+DESCRIPTION:
+Formats the run time statistics, one task per line.
+
+RETURN VALUE:
+The report
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+String TaskScheduler::Report() const
+{
+    uint64_t allUS = 0;
+
+    for ( uint8_t i = 0; i < _taskCount; i++ )
+    {
+        allUS += _tasks[i].stats.totalUS;
+    }
+
+    String report;
+    char line[96];
+
+    for ( uint8_t i = 0; i < _taskCount; i++ )
+    {
+        const TaskStats &stats = _tasks[i].stats;
+
+        uint32_t averageUS = ( stats.runs > 0 ) ? (uint32_t) ( stats.totalUS / stats.runs ) : 0;
+        uint32_t percent = ( allUS > 0 ) ? (uint32_t) ( ( stats.totalUS * 100 ) / allUS ) : 0;
+
+        snprintf( line, sizeof( line ), "%-12s period=%luus runs=%lu late=%lu avg=%luus max=%luus share=%lu%%\n",
+                  stats.name,
+                  (unsigned long) stats.periodUS,
+                  (unsigned long) stats.runs,
+                  (unsigned long) stats.lateRuns,
+                  (unsigned long) averageUS,
+                  (unsigned long) stats.maxUS,
+                  (unsigned long) percent );
+
+        report += line;
+    }
+
+    return report;
+}
+
+/*=====================================================================
+// IMPLEMENTATION NOTES
+//=====================================================================
+
+None
+
+=====================================================================*/
@@ -0,0 +1,234 @@
+#ifndef _JAROFLIGHT_TASKSCHEDULER_H_
+#define _JAROFLIGHT_TASKSCHEDULER_H_
+
+/*======================================================================
+FILE:
+taskscheduler.h
+
+CREATOR:
+Sean Foley
+
+DESCRIPTION:
+A cooperative task scheduler for loop().
+
+PUBLIC CLASSES AND FUNCTIONS:
+TaskScheduler
+
+Copyright (C) 2017 Sean Foley  All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted.  Enjoy.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+======================================================================*/
+
+//======================================================================
+// INCLUDES AND PUBLIC DATA DECLARATIONS
+//======================================================================
+
+//----------------------------------------------------------------------
+// Defines
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Include Files
+//----------------------------------------------------------------------
+
+#include <stdint.h>
+
+#include <functional>
+
+#include <Arduino.h>
+#include <WString.h>
+
+//----------------------------------------------------------------------
+// Type Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Constant Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Data Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//======================================================================
+// WARNINGS!!!
+//======================================================================
+
+// None.
+
+//======================================================================
+// FUNCTION DECLARATIONS
+//======================================================================
+
+// None.
+
+//=====================================================================
+// EXCEPTION CLASS DEFINITIONS
+//=====================================================================
+
+// None.
+
+//======================================================================
+// CLASS DEFINITIONS
+//======================================================================
+
+/*======================================================================
+CLASS:
+TaskScheduler
+
+DESCRIPTION:
+A small cooperative scheduler.  Each subsystem registers as a task 
+with a period, and Run() calls whatever is due.  Tasks are expected to
+do a little bit of work and return - nothing here can preempt a task,
+so a task that blocks holds up everything else.
+
+Every task keeps run time statistics, so we can see which subsystem
+is eating the frame budget.
+
+HOW TO USE:
+1. AddTask() for each subsystem, usually in setup()
+2. Call Run() from loop()
+3. GetStats() / Report() to see where the time is going
+
+======================================================================*/
+class TaskScheduler
+{
+    public:
+
+    //=================================================================
+    // TYPE DECLARATIONS AND CONSTANTS    
+    //=================================================================
+
+    // Most tasks we can hold.  Tasks are registered once and never
+    // removed, so these are all allocated up front.  The sketch uses
+    // 12, this leaves room for a few more.
+    static const uint8_t MAX_TASKS = 16;
+
+    // Returned by AddTask() if there is no room
+    static const int INVALID_TASK = -1;
+
+    typedef std::function< void( void ) > TaskFunction;
+
+    struct TaskStats
+    {
+        const char *name;
+
+        uint32_t periodUS;
+
+        // How many times the task has run, and how many of those
+        // started more than a full period late
+        uint32_t runs;
+        uint32_t lateRuns;
+
+        // Time spent in the task
+        uint64_t totalUS;
+        uint32_t maxUS;
+    };
+
+    //=================================================================
+    // CLIENT INTERFACE
+    //=================================================================
+
+    TaskScheduler();
+
+    // Adds a task that runs every periodUS.  A period of 0 runs the
+    // task on every call to Run().  Returns the task id, or 
+    // INVALID_TASK if there is no room.
+    int AddTask( const char *name, uint32_t periodUS, TaskFunction function );
+
+    void SetEnabled( int task, bool enabled );
+
+    // Runs every task that is due, then returns
+    void Run();
+
+    uint8_t GetTaskCount() const { return _taskCount; }
+
+    const TaskStats &GetStats( int task ) const { return _tasks[task].stats; }
+
+    void ResetStats();
+
+    // One line per task: name, period, runs, late runs, average 
+    // and max run time (us), and share of the total run time
+    String Report() const;
+
+    protected:
+
+    //=================================================================
+    // SUBCLASS INTERFACE   
+    //=================================================================
+
+    // None.
+
+    private:
+
+    //=================================================================
+    // CUSTOMIZATION INTERFACE    
+    //=================================================================
+
+    // None.
+
+    //=================================================================
+    // IMPLEMENTATION INTERFACE    
+    //=================================================================
+
+    // No copying - intentionally not defining the implementation
+    // to throw a link error if someone somehow invokes a copy.
+    TaskScheduler( const TaskScheduler &rhs );
+
+    struct Task
+    {
+        TaskFunction function;
+        bool enabled;
+
+        // micros() when the task is next due
+        uint32_t dueUS;
+
+        TaskStats stats;
+    };
+
+    //=================================================================
+    // DATA MEMBERS    
+    //=================================================================
+
+    Task _tasks[MAX_TASKS];
+
+    uint8_t _taskCount;
+};
+
+//======================================================================
+// INLINE FUNCTION DEFINITIONS
+//======================================================================
+
+// None.
+
+
+/*======================================================================
+// DOCUMENTATION
+========================================================================
+
+None.
+
+======================================================================*/
+
+#endif	// #ifendif _JAROFLIGHT_TASKSCHEDULER_H_
@@ -0,0 +1,117 @@
+/*======================================================================
+FILE:
+bench_animators.cpp
+
+DESCRIPTION:
+Benchmark: what a frame costs with 1, 2, 4 and 8 strips, each on its 
+own LedAnimator.  Every animator keeps its own state, so the cost per
+strip should stay flat as strips are added - the total grows linearly.
+
+Every strip plays the same animation, each started at a different 
+time so they are all at different points in it.  Frames go to 
+RecordingPixelDriver, so this is the cost of rendering, compositing 
+and committing a frame, without the time the wire takes.
+
+USAGE:
+bench_animators [pixels per strip] [frames] [animation]
+
+======================================================================*/
+
+#include "ledanimator.h"
+#include "recordingpixeldriver.h"
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+// Strip counts to try
+static const uint32_t STRIP_COUNTS[] = { 1, 2, 4, 8 };
+
+/*======================================================================
+FUNCTION:
+runFrames()
+
+DESCRIPTION:
+Runs frames on every animator, one frame interval of simulated time 
+apart, and times the Process() calls.
+
+RETURN VALUE:
+Wall clock nanoseconds spent in Process().
+
+======================================================================*/
+static double runFrames( std::vector< std::shared_ptr<LedAnimator> > &animators, uint32_t frames )
+{
+    const uint64_t frameUS = 1000000ULL / LedAnimator::DEFAULT_FRAME_RATE;
+
+    double totalNS = 0;
+
+    for ( uint32_t frame = 0; frame < frames; frame++ )
+    {
+        HostAdvanceMicros( frameUS );
+
+        auto start = std::chrono::steady_clock::now();
+
+        for ( size_t i = 0; i < animators.size(); i++ )
+        {
+            animators[i]->Process();
+        }
+
+        totalNS += std::chrono::duration<double, std::nano>( std::chrono::steady_clock::now() - start ).count();
+    }
+
+    return totalNS;
+}
+
+int main( int argc, char **argv )
+{
+    uint32_t pixels = ( argc > 1 ) ? (uint32_t) atoi( argv[1] ) : 150;
+    uint32_t frames = ( argc > 2 ) ? (uint32_t) atoi( argv[2] ) : 20000;
+    const char *animation = ( argc > 3 ) ? argv[3] : "flicker";
+
+    HostQuiet( true );
+
+    printf( "%s, %u pixels per strip, %u frames\n\n", animation, pixels, frames );
+    printf( "strips  us/frame  us/frame/strip  vs 1 strip\n" );
+
+    double singleStripUS = 0;
+
+    for ( size_t run = 0; run < sizeof( STRIP_COUNTS ) / sizeof( STRIP_COUNTS[0] ); run++ )
+    {
+        uint32_t strips = STRIP_COUNTS[run];
+
+        std::vector< std::shared_ptr<LedAnimator> > animators;
+
+        for ( uint32_t i = 0; i < strips; i++ )
+        {
+            std::unique_ptr<PixelDriver> driver( new RecordingPixelDriver( pixels ) );
+
+            std::shared_ptr<LedAnimator> animator = std::make_shared<LedAnimator>( std::move( driver ), pixels );
+
+            if ( animator->Start( animation, LedAnimator::Color( 255, 120, 0, 0 ), 0 ) == false )
+            {
+                printf( "no such animation: %s\n", animation );
+                return 1;
+            }
+
+            animators.push_back( animator );
+
+            // Out of step with the ones before it
+            runFrames( animators, 7 );
+        }
+
+        // Let the starts land, then time the steady state
+        runFrames( animators, 10 );
+
+        double frameUS = runFrames( animators, frames ) / frames / 1000.0;
+        double stripUS = frameUS / strips;
+
+        if ( strips == 1 )
+        {
+            singleStripUS = stripUS;
+        }
+
+        printf( "%6u  %8.2f  %14.2f  %9.2fx\n", strips, frameUS, stripUS, stripUS / singleStripUS );
+    }
+
+    return 0;
+}
@@ -0,0 +1,149 @@
+#!/usr/bin/env python3
+"""
+FILE:
+bench_batch.py
+
+DESCRIPTION:
+Benchmark, run against a jar on the network: a change of look sent as
+one /led/set request per setting, the way a script did it before
+/led/batch, against the same change sent as one /led/batch request.
+
+Each look is an animation, a color and a brightness.  The single
+command way is three GETs, each on a connection of its own; the batch
+is one POST.  Looks alternate between two animations and colors, so
+every one is a real change.  It reports looks and requests per second,
+and the latency of a whole look (first byte out to last answer in),
+as percentiles.  --keep-alive sends everything over one connection
+instead, to see what is left once the connects are taken out.
+
+Needs nothing outside the Python standard library.
+
+USAGE:
+bench_batch.py [--port 80] [--looks 100] [--keep-alive] host
+"""
+
+import argparse
+import http.client
+import socket
+import sys
+import time
+
+LOOKS = [
+    ( "pulse", "ff0000", 128 ),
+    ( "wheel", "0000ff", 200 ),
+]
+
+
+def percentile( values, fraction ):
+    """The value fraction of the way through values (sorted)."""
+    index = min( len( values ) - 1, int( fraction * len( values ) ) )
+    return values[index]
+
+
+class Client:
+    """Sends requests, on one connection or a new one each time."""
+
+    def __init__( self, host, port, keep_alive ):
+        self.host = host
+        self.port = port
+        self.keep_alive = keep_alive
+        self.connection = None
+        self.requests = 0
+        self.failures = 0
+
+    def request( self, method, path, body = None, headers = None ):
+        headers = dict( headers or {} )
+
+        if self.keep_alive == False:
+            headers["Connection"] = "close"
+
+        try:
+            if self.connection is None:
+                self.connection = http.client.HTTPConnection( self.host, self.port, timeout = 5 )
+                self.connection.connect()
+
+                # Otherwise our side holds small writes back, waiting
+                # on an ACK, and that is what gets measured
+                self.connection.sock.setsockopt( socket.IPPROTO_TCP, socket.TCP_NODELAY, 1 )
+
+            self.connection.request( method, path, body = body, headers = headers )
+            response = self.connection.getresponse()
+            response.read()
+            ok = ( response.status == 200 )
+        except ( OSError, http.client.HTTPException ):
+            ok = False
+
+        if ( ok == False or self.keep_alive == False ) and self.connection is not None:
+            self.connection.close()
+            self.connection = None
+
+        self.requests += 1
+        self.failures += 0 if ok else 1
+
+    def close( self ):
+        if self.connection is not None:
+            self.connection.close()
+            self.connection = None
+
+
+def single( client, look ):
+    animation, color, brightness = look
+
+    client.request( "GET", "/led/set?animation=%s" % animation )
+    client.request( "GET", "/led/set?color=%s" % color )
+    client.request( "GET", "/led/set?brightness=%d" % brightness )
+
+
+def batch( client, look ):
+    animation, color, brightness = look
+
+    body = "animation=%s\ncolor=%s\nbrightness=%d" % ( animation, color, brightness )
+
+    client.request( "POST", "/led/batch", body = body,
+                    headers = { "Content-Type": "text/plain" } )
+
+
+def run( name, send, args ):
+    client = Client( args.host, args.port, args.keep_alive )
+    latencies = []
+
+    started = time.perf_counter()
+
+    for i in range( args.looks ):
+        before = time.perf_counter()
+        send( client, LOOKS[i % len( LOOKS )] )
+        latencies.append( ( time.perf_counter() - before ) * 1000.0 )
+
+    elapsed = time.perf_counter() - started
+    client.close()
+
+    latencies.sort()
+
+    print( "%-8s %7.1f looks/s %7.1f requests/s   ms p50 %6.1f  p90 %6.1f  p99 %6.1f  max %6.1f   %d failed"
+           % ( name, args.looks / elapsed, client.requests / elapsed,
+               percentile( latencies, 0.50 ), percentile( latencies, 0.90 ),
+               percentile( latencies, 0.99 ), latencies[-1], client.failures ) )
+
+    return client.failures
+
+
+def main():
+    parser = argparse.ArgumentParser( description = "/led/set against /led/batch" )
+    parser.add_argument( "host" )
+    parser.add_argument( "--port", type = int, default = 80 )
+    parser.add_argument( "--looks", type = int, default = 100 )
+    parser.add_argument( "--keep-alive", action = "store_true",
+                         help = "one connection for everything" )
+    args = parser.parse_args()
+
+    print( "%d looks of 3 settings each, %s"
+           % ( args.looks, "one connection" if args.keep_alive else "a connection per request" ) )
+
+    failures = run( "single", single, args )
+    failures += run( "batch", batch, args )
+
+    return 1 if failures > 0 else 0
+
+
+if __name__ == "__main__":
+    sys.exit( main() )
@@ -0,0 +1,220 @@
+/*======================================================================
+FILE:
+bench_color.cpp
+
+DESCRIPTION:
+Benchmark: ColorEngine against what it replaced.
+
+    Wheel       the old branchy LedAnimator::Wheel() against the 
+                table in ColorEngine::Wheel()
+    HSV         ColorEngine::HsvToRgbw() against the usual floating
+                point HSV to RGB (the ESP8266 has no FPU, so floats
+                cost far more there than here)
+    rainbow     a per-pixel rainbow over a strip, both ways
+
+It also checks the table gives exactly the old wheel's colors, and 
+how far the fixed point HSV is from the floating point one.
+
+USAGE:
+bench_color [iterations]
+
+======================================================================*/
+
+#include "colorengine.h"
+
+#include <Adafruit_NeoPixel.h>
+
+#include <chrono>
+#include <math.h>
+
+// Something for the results to go into, so they aren't optimized away
+static volatile uint32_t s_sink;
+
+// Pixels in the rainbow strip
+static const uint32_t RAINBOW_PIXELS = 300;
+
+/*======================================================================
+FUNCTION:
+oldWheel()
+
+DESCRIPTION:
+LedAnimator::Wheel() as it was before ColorEngine, minus the state it
+used to change as a side effect.
+
+RETURN VALUE:
+The color at WheelPos.
+
+======================================================================*/
+static uint32_t __attribute__(( noinline )) oldWheel( byte WheelPos )
+{
+    WheelPos = 255 - WheelPos;
+    if ( WheelPos < 85 )
+    {
+        return Adafruit_NeoPixel::Color( 255 - WheelPos * 3, 0, WheelPos * 3 );
+    }
+    else if ( WheelPos < 170 )
+    {
+        WheelPos -= 85;
+        return Adafruit_NeoPixel::Color( 0, WheelPos * 3, 255 - WheelPos * 3 );
+    }
+    else
+    {
+        WheelPos -= 170;
+        return Adafruit_NeoPixel::Color( WheelPos * 3, 255 - WheelPos * 3, 0 );
+    }
+}
+
+/*======================================================================
+FUNCTION:
+floatHsv()
+
+DESCRIPTION:
+Textbook floating point HSV to RGB, hue/saturation/value 0..255 like 
+HsvToRgbw(), with no white extraction.
+
+RETURN VALUE:
+The packed color.
+
+======================================================================*/
+static uint32_t __attribute__(( noinline )) floatHsv( uint8_t hue, uint8_t saturation, uint8_t value )
+{
+    float h = hue * 6.0f / 256.0f;
+    float s = saturation / 255.0f;
+    float v = value / 255.0f;
+
+    int sector = (int) h;
+    float f = h - sector;
+    float p = v * ( 1.0f - s );
+    float q = v * ( 1.0f - s * f );
+    float t = v * ( 1.0f - s * ( 1.0f - f ) );
+
+    float r, g, b;
+
+    switch ( sector )
+    {
+        case 0: r = v; g = t; b = p; break;
+        case 1: r = q; g = v; b = p; break;
+        case 2: r = p; g = v; b = t; break;
+        case 3: r = p; g = q; b = v; break;
+        case 4: r = t; g = p; b = v; break;
+        default: r = v; g = p; b = q; break;
+    }
+
+    return Adafruit_NeoPixel::Color( (uint8_t) lroundf( r * 255 ), 
+                                     (uint8_t) lroundf( g * 255 ), 
+                                     (uint8_t) lroundf( b * 255 ) );
+}
+
+/*======================================================================
+FUNCTION:
+timeNS()
+
+DESCRIPTION:
+Times iterations calls of call, which is handed the iteration number.
+
+RETURN VALUE:
+Nanoseconds per call.
+
+======================================================================*/
+template < typename Call >
+static double timeNS( uint32_t iterations, Call call )
+{
+    auto start = std::chrono::steady_clock::now();
+
+    for ( uint32_t i = 0; i < iterations; i++ )
+    {
+        call( i );
+    }
+
+    return std::chrono::duration<double, std::nano>( std::chrono::steady_clock::now() - start ).count() / iterations;
+}
+
+/*======================================================================
+FUNCTION:
+channelError()
+
+DESCRIPTION:
+Largest difference between the r/g/b channels of two colors.
+
+RETURN VALUE:
+0..255
+
+======================================================================*/
+static int channelError( uint32_t a, uint32_t b )
+{
+    int worst = 0;
+
+    for ( int shift = 0; shift <= 16; shift += 8 )
+    {
+        int difference = abs( (int) ( ( a >> shift ) & 0xFF ) - (int) ( ( b >> shift ) & 0xFF ) );
+        worst = ( difference > worst ) ? difference : worst;
+    }
+
+    return worst;
+}
+
+int main( int argc, char **argv )
+{
+    uint32_t iterations = ( argc > 1 ) ? (uint32_t) atoi( argv[1] ) : 20000000;
+
+    // Same colors as before?
+    int wheelMismatches = 0;
+
+    for ( int i = 0; i < 256; i++ )
+    {
+        wheelMismatches += ( oldWheel( (byte) i ) != ColorEngine::Wheel( (uint8_t) i ) ) ? 1 : 0;
+    }
+
+    int hsvError = 0;
+
+    for ( int h = 0; h < 256; h++ )
+    {
+        for ( int s = 0; s < 256; s += 15 )
+        {
+            for ( int v = 0; v < 256; v += 15 )
+            {
+                int error = channelError( floatHsv( h, s, v ), ColorEngine::HsvToRgbw( h, s, v, false ) );
+                hsvError = ( error > hsvError ) ? error : hsvError;
+            }
+        }
+    }
+
+    printf( "wheel table matches the old wheel: %s (%d of 256 differ)\n", 
+            ( wheelMismatches == 0 ) ? "yes" : "NO", wheelMismatches );
+    printf( "fixed point HSV, worst channel error against float: %d\n\n", hsvError );
+
+    double oldWheelNS = timeNS( iterations, []( uint32_t i ) { s_sink = s_sink + oldWheel( (byte) i ); } );
+    double newWheelNS = timeNS( iterations, []( uint32_t i ) { s_sink = s_sink + ColorEngine::Wheel( (uint8_t) i ); } );
+
+    double floatHsvNS = timeNS( iterations, []( uint32_t i ) { s_sink = s_sink + floatHsv( (uint8_t) i, 255, (uint8_t) ( i >> 8 ) ); } );
+    double fixedHsvNS = timeNS( iterations, []( uint32_t i ) { s_sink = s_sink + ColorEngine::HsvToRgbw( (uint8_t) i, 255, (uint8_t) ( i >> 8 ) ); } );
+
+    uint32_t frames = iterations / RAINBOW_PIXELS;
+    uint32_t pixels[RAINBOW_PIXELS];
+
+    double oldRainbowNS = timeNS( frames, [&]( uint32_t frame ) 
+    {
+        for ( uint32_t p = 0; p < RAINBOW_PIXELS; p++ )
+        {
+            pixels[p] = oldWheel( (byte) ( p * 256 / RAINBOW_PIXELS + frame ) );
+        }
+        s_sink = s_sink + pixels[frame % RAINBOW_PIXELS];
+    } );
+
+    double newRainbowNS = timeNS( frames, [&]( uint32_t frame ) 
+    {
+        for ( uint32_t p = 0; p < RAINBOW_PIXELS; p++ )
+        {
+            pixels[p] = ColorEngine::Wheel( (uint8_t) ( p * 256 / RAINBOW_PIXELS + frame ) );
+        }
+        s_sink = s_sink + pixels[frame % RAINBOW_PIXELS];
+    } );
+
+    printf( "                   before      after    speedup\n" );
+    printf( "Wheel             %6.2fns   %6.2fns   %6.2fx\n", oldWheelNS, newWheelNS, oldWheelNS / newWheelNS );
+    printf( "HSV               %6.2fns   %6.2fns   %6.2fx\n", floatHsvNS, fixedHsvNS, floatHsvNS / fixedHsvNS );
+    printf( "rainbow, %u px   %6.2fus   %6.2fus   %6.2fx\n", RAINBOW_PIXELS, 
+            oldRainbowNS / 1000, newRainbowNS / 1000, oldRainbowNS / newRainbowNS );
+
+    return ( wheelMismatches == 0 ) ? 0 : 1;
+}
@@ -0,0 +1,195 @@
+#!/usr/bin/env python3
+"""
+FILE:
+bench_keepalive.py
+
+DESCRIPTION:
+Benchmark, run against a jar on the network: request throughput and
+latency over HTTP, three ways.
+
+    close        a new connection for every request (Connection:
+                 close), which is what every request cost before
+                 keep-alive
+    keep-alive   one connection, a request at a time
+    pipelined    one connection, --depth requests written back to
+                 back before any answer is read
+
+Each is run for --requests requests of --path (something that doesn't
+change anything, /led/animations by default).  It reports requests per
+second and latency percentiles - for pipelined requests, the time from
+a batch going out to each answer coming back.  Answers are checked for
+a 200 and that the connection stayed open when it should have.
+
+Needs nothing outside the Python standard library.
+
+USAGE:
+bench_keepalive.py [--port 80] [--requests 200] [--depth 4]
+                   [--path /led/animations] host
+"""
+
+import argparse
+import socket
+import sys
+import time
+
+
+class Connection:
+    """Just enough of an HTTP/1.1 client to pipeline requests."""
+
+    def __init__( self, host, port ):
+        self.host = host
+        self.sock = socket.create_connection( ( host, port ), timeout = 5 )
+        self.sock.setsockopt( socket.IPPROTO_TCP, socket.TCP_NODELAY, 1 )
+        self.buffer = b""
+
+    def send( self, paths, close = False ):
+        requests = b""
+
+        for path in paths:
+            requests += ( "GET %s HTTP/1.1\r\nHost: %s\r\n%s\r\n"
+                          % ( path, self.host, "Connection: close\r\n" if close else "" ) ).encode()
+
+        self.sock.sendall( requests )
+
+    def read( self ):
+        """The next answer's status, and whether the jar will close
+        the connection after it."""
+        while b"\r\n\r\n" not in self.buffer:
+            self.fill()
+
+        head, self.buffer = self.buffer.split( b"\r\n\r\n", 1 )
+        lines = head.decode( errors = "replace" ).split( "\r\n" )
+
+        status = int( lines[0].split()[1] )
+        headers = {}
+
+        for line in lines[1:]:
+            name, _, value = line.partition( ":" )
+            headers[name.strip().lower()] = value.strip().lower()
+
+        length = int( headers.get( "content-length", "0" ) )
+
+        while len( self.buffer ) < length:
+            self.fill()
+
+        self.buffer = self.buffer[length:]
+
+        return status, headers.get( "connection" ) == "close"
+
+    def fill( self ):
+        data = self.sock.recv( 65536 )
+
+        if not data:
+            raise OSError( "connection closed by the jar" )
+
+        self.buffer += data
+
+    def close( self ):
+        self.sock.close()
+
+
+def report( name, count, elapsed, latencies, failures ):
+    latencies.sort()
+
+    def at( fraction ):
+        return latencies[min( len( latencies ) - 1, int( fraction * len( latencies ) ) )] if latencies else 0.0
+
+    print( "%-11s %8.1f requests/s   ms p50 %6.1f  p90 %6.1f  p99 %6.1f  max %6.1f   %d failed"
+           % ( name, count / elapsed, at( 0.50 ), at( 0.90 ), at( 0.99 ),
+               latencies[-1] if latencies else 0.0, failures ) )
+
+
+def close_each( args ):
+    latencies = []
+    failures = 0
+
+    started = time.perf_counter()
+
+    for _ in range( args.requests ):
+        before = time.perf_counter()
+
+        try:
+            connection = Connection( args.host, args.port )
+            connection.send( [args.path], close = True )
+            status, closing = connection.read()
+            connection.close()
+            failures += 0 if status == 200 and closing else 1
+        except OSError:
+            failures += 1
+
+        latencies.append( ( time.perf_counter() - before ) * 1000.0 )
+
+    report( "close", args.requests, time.perf_counter() - started, latencies, failures )
+
+    return failures
+
+
+def keep_alive( args, depth ):
+    latencies = []
+    failures = 0
+    connection = None
+
+    started = time.perf_counter()
+    remaining = args.requests
+
+    while remaining > 0:
+        count = min( depth, remaining )
+        remaining -= count
+
+        try:
+            if connection is None:
+                connection = Connection( args.host, args.port )
+
+            before = time.perf_counter()
+            connection.send( [args.path] * count )
+
+            for i in range( count ):
+                status, closing = connection.read()
+                latencies.append( ( time.perf_counter() - before ) * 1000.0 )
+
+                failures += 0 if status == 200 and closing == False else 1
+
+                # Closing on us is a failure, and so is anything still
+                # in flight.  Start again on a new connection.
+                if closing:
+                    failures += count - i - 1
+                    connection.close()
+                    connection = None
+                    break
+        except OSError:
+            failures += count
+            if connection is not None:
+                connection.close()
+            connection = None
+
+    if connection is not None:
+        connection.close()
+
+    report( "keep-alive" if depth == 1 else "pipelined", args.requests,
+            time.perf_counter() - started, latencies, failures )
+
+    return failures
+
+
+def main():
+    parser = argparse.ArgumentParser( description = "HTTP throughput with and without keep-alive" )
+    parser.add_argument( "host" )
+    parser.add_argument( "--port", type = int, default = 80 )
+    parser.add_argument( "--requests", type = int, default = 200 )
+    parser.add_argument( "--depth", type = int, default = 4, help = "requests in flight when pipelining" )
+    parser.add_argument( "--path", default = "/led/animations" )
+    args = parser.parse_args()
+
+    print( "%d requests of %s" % ( args.requests, args.path ) )
+
+    failures = close_each( args )
+    failures += keep_alive( args, 1 )
+
+    if args.depth > 1:
+        failures += keep_alive( args, args.depth )
+
+    return 1 if failures > 0 else 0
+
+
+if __name__ == "__main__":
+    sys.exit( main() )
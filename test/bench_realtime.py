@@ -0,0 +1,260 @@
+#!/usr/bin/env python3
+"""
+FILE:
+bench_realtime.py
+
+DESCRIPTION:
+Packet generator and benchmark for the real time pixel receiver (see
+realtimeproxy.h), run against a jar on the network in place of the
+lighting software.
+
+Sends a moving rainbow over DDP or E1.31 at --fps for --seconds, and
+reports the rate it actually managed.  A frame is split up the way the
+jar expects: DDP packets of up to 480 RGB pixels, the last one pushed,
+or one E1.31 universe per 170 pixels starting at --universe and
+--address.  E1.31 goes unicast to the jar, or to the universes'
+multicast groups with --multicast, and ends with stream terminated
+packets so the animation comes straight back.
+
+The jar's own packet counts are read from /status/realtime before and
+after, so the report has what it received, dropped and showed per
+second alongside what was sent.  --repeat N sends every Nth packet
+twice and --skip N leaves every Nth out, to see the sequence checks
+drop the repeats and ride over the gaps.
+
+Needs nothing outside the Python standard library.
+
+USAGE:
+bench_realtime.py [--protocol ddp|e131] [--pixels 150] [--fps 40]
+                  [--seconds 10] [--universe 1] [--address 1]
+                  [--multicast] [--repeat 0] [--skip 0] [--http-port 80]
+                  host
+"""
+
+import argparse
+import colorsys
+import http.client
+import os
+import re
+import socket
+import struct
+import sys
+import time
+
+DDP_PORT = 4048
+E131_PORT = 5568
+
+DDP_VERSION_1 = 0x40
+DDP_FLAG_PUSH = 0x01
+DDP_TYPE_RGB = 0x0B
+DDP_ID_DISPLAY = 1
+DDP_PIXELS_PER_PACKET = 480
+
+E131_PIXELS_PER_UNIVERSE = 170
+E131_OPTION_TERMINATED = 0x40
+E131_PRIORITY = 100
+
+ACN_PACKET_ID = b"ASC-E1.17\x00\x00\x00"
+
+
+def rainbow( frame, pixels ):
+    """One frame of a rainbow that moves along a pixel each frame."""
+    data = bytearray()
+
+    for i in range( pixels ):
+        r, g, b = colorsys.hsv_to_rgb( ( ( i + frame ) % 256 ) / 256.0, 1.0, 1.0 )
+        data += bytes( [int( r * 255 ), int( g * 255 ), int( b * 255 )] )
+
+    return bytes( data )
+
+
+class DDP:
+    """DDP version 1, RGB, to the jar's display."""
+
+    def __init__( self, host, args ):
+        self.address = ( host, DDP_PORT )
+        self.sequence = 0
+
+    def frame( self, data ):
+        packets = []
+        step = DDP_PIXELS_PER_PACKET * 3
+
+        for offset in range( 0, len( data ), step ):
+            chunk = data[offset:offset + step]
+            last = ( offset + step >= len( data ) )
+
+            # 1..15, 0 means "not using sequence numbers"
+            self.sequence = self.sequence % 15 + 1
+
+            header = struct.pack( "!BBBBIH",
+                                  DDP_VERSION_1 | ( DDP_FLAG_PUSH if last else 0 ),
+                                  self.sequence, DDP_TYPE_RGB, DDP_ID_DISPLAY,
+                                  offset, len( chunk ) )
+
+            packets.append( ( header + chunk, self.address ) )
+
+        return packets
+
+    def end( self ):
+        return []
+
+
+class E131:
+    """E1.31 data packets, a universe per 170 pixels."""
+
+    def __init__( self, host, args ):
+        self.host = host
+        self.universe = args.universe
+        self.address = args.address
+        self.multicast = args.multicast
+        self.cid = os.urandom( 16 )
+        self.sequences = {}
+
+    def destination( self, universe ):
+        if self.multicast:
+            return ( "239.255.%d.%d" % ( universe >> 8, universe & 0xFF ), E131_PORT )
+        return ( self.host, E131_PORT )
+
+    def packet( self, universe, slots, options = 0 ):
+        sequence = ( self.sequences.get( universe, -1 ) + 1 ) & 0xFF
+        self.sequences[universe] = sequence
+
+        length = 126 + len( slots )
+
+        root = struct.pack( "!HH12sHI16s", 0x0010, 0x0000, ACN_PACKET_ID,
+                            0x7000 | ( length - 16 ), 0x00000004, self.cid )
+        framing = struct.pack( "!HI64sBHBBH", 0x7000 | ( length - 38 ), 0x00000002,
+                               b"jar of light bench", E131_PRIORITY, 0, sequence, options, universe )
+        dmp = struct.pack( "!HBBHHHB", 0x7000 | ( length - 115 ), 0x02, 0xA1, 0, 1,
+                           len( slots ) + 1, 0 )
+
+        return ( root + framing + dmp + slots, self.destination( universe ) )
+
+    def universes( self, data ):
+        """The slots for each universe the frame covers."""
+        # The first universe's pixels start at the start address
+        pad = bytes( self.address - 1 )
+        first = ( 512 - ( self.address - 1 ) ) // 3 * 3
+
+        chunks = [pad + data[:first]]
+
+        for offset in range( first, len( data ), E131_PIXELS_PER_UNIVERSE * 3 ):
+            chunks.append( data[offset:offset + E131_PIXELS_PER_UNIVERSE * 3] )
+
+        return chunks
+
+    def frame( self, data ):
+        return [self.packet( self.universe + i, slots )
+                for i, slots in enumerate( self.universes( data ) )]
+
+    def end( self ):
+        # Three of them, as the standard asks
+        count = len( self.sequences )
+        return [self.packet( self.universe + i, b"", E131_OPTION_TERMINATED )
+                for _ in range( 3 ) for i in range( count )]
+
+
+def counters( host, port ):
+    """The jar's packet counts from /status/realtime, None if it
+    doesn't answer."""
+    try:
+        connection = http.client.HTTPConnection( host, port, timeout = 3 )
+        connection.request( "GET", "/status/realtime" )
+        text = connection.getresponse().read().decode( errors = "replace" )
+        connection.close()
+    except ( OSError, http.client.HTTPException ):
+        return None
+
+    values = dict( re.findall( r"^(packets|dropped|frames):\s*(\d+)", text, re.MULTILINE ) )
+
+    if len( values ) != 3:
+        return None
+
+    return { name: int( value ) for name, value in values.items() }
+
+
+def main():
+    parser = argparse.ArgumentParser( description = "DDP / E1.31 packet generator" )
+    parser.add_argument( "host" )
+    parser.add_argument( "--protocol", choices = ["ddp", "e131"], default = "ddp" )
+    parser.add_argument( "--pixels", type = int, default = 150 )
+    parser.add_argument( "--fps", type = float, default = 40 )
+    parser.add_argument( "--seconds", type = float, default = 10 )
+    parser.add_argument( "--universe", type = int, default = 1 )
+    parser.add_argument( "--address", type = int, default = 1, help = "E1.31 start address, 1..510" )
+    parser.add_argument( "--multicast", action = "store_true", help = "E1.31 to the multicast groups" )
+    parser.add_argument( "--repeat", type = int, default = 0, help = "send every Nth packet twice" )
+    parser.add_argument( "--skip", type = int, default = 0, help = "leave every Nth packet out" )
+    parser.add_argument( "--http-port", type = int, default = 80 )
+    args = parser.parse_args()
+
+    sender = ( DDP if args.protocol == "ddp" else E131 )( args.host, args )
+
+    sock = socket.socket( socket.AF_INET, socket.SOCK_DGRAM )
+    sock.setsockopt( socket.IPPROTO_IP, socket.IP_MULTICAST_TTL, 1 )
+
+    before = counters( args.host, args.http_port )
+
+    frames = 0
+    packets = 0
+    sent = 0
+    late = 0
+
+    interval = 1.0 / args.fps
+    started = time.perf_counter()
+    next_frame = started
+
+    while time.perf_counter() - started < args.seconds:
+        for packet, destination in sender.frame( rainbow( frames, args.pixels ) ):
+            packets += 1
+
+            if args.skip > 0 and packets % args.skip == 0:
+                continue
+
+            copies = 2 if args.repeat > 0 and packets % args.repeat == 0 else 1
+
+            for _ in range( copies ):
+                sock.sendto( packet, destination )
+                sent += 1
+
+        frames += 1
+        next_frame += interval
+        delay = next_frame - time.perf_counter()
+
+        if delay > 0:
+            time.sleep( delay )
+        else:
+            late += 1
+
+    elapsed = time.perf_counter() - started
+
+    ending = sender.end()
+
+    for packet, destination in ending:
+        sock.sendto( packet, destination )
+
+    print( "%s, %d pixels: %d frames in %.2fs (%.1f fps, %d late), %d packets sent (%.1f/s)"
+           % ( args.protocol, args.pixels, frames, elapsed, frames / elapsed, late, sent, sent / elapsed ) )
+
+    # Give the jar a moment with the last of them
+    time.sleep( 0.5 )
+
+    after = counters( args.host, args.http_port )
+
+    if before is None or after is None:
+        print( "no /status/realtime from the jar, so no received counts" )
+        return 0
+
+    received = after["packets"] - before["packets"]
+    dropped = after["dropped"] - before["dropped"]
+    shown = after["frames"] - before["frames"]
+
+    print( "jar: %d packets received (%.1f/s), %d dropped, %d frames shown (%.1f/s), %d lost on the way"
+           % ( received, received / elapsed, dropped, shown, shown / elapsed,
+               max( 0, sent + len( ending ) - received ) ) )
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit( main() )
@@ -0,0 +1,351 @@
+#!/usr/bin/env python3
+"""
+FILE:
+bench_websocket.py
+
+DESCRIPTION:
+Load test, run against a jar on the network: how fast the WebSocket
+channel (port 81, see websocketproxy.h for the protocol) takes updates,
+and how long they take.
+
+Three parts:
+
+    round trip   a state request (10) and its answer, with nothing
+                 else going on - the channel's own latency
+    applied      a color (01) until a state comes back showing it.
+                 This is what a color picker sees: the next frame
+                 boundary, plus up to NOTIFY_INTERVAL_MS before the
+                 jar says so.
+    load         colors (or, with --pixels, whole frames) sent at
+                 --rate for --seconds without waiting on anything,
+                 then a state request.  Updates per second is what
+                 was sent over the time to that answer, so anything
+                 the jar had backed up is counted.  Rejections (81)
+                 are counted along the way.
+
+Latencies are reported as percentiles, in milliseconds.  It speaks
+just enough WebSocket itself to need nothing outside the Python
+standard library.
+
+USAGE:
+bench_websocket.py [--port 81] [--samples 200] [--rate 100]
+                   [--seconds 10] [--pixels 0] host
+"""
+
+import argparse
+import base64
+import hashlib
+import os
+import select
+import socket
+import struct
+import sys
+import time
+
+GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC11B27"
+
+OP_COLOR = 0x01
+OP_FRAME = 0x05
+OP_GET_STATE = 0x10
+OP_STATE = 0x80
+OP_ERROR = 0x81
+
+# WebSocket frame opcodes
+WS_BINARY = 0x2
+WS_CLOSE = 0x8
+WS_PING = 0x9
+WS_PONG = 0xA
+
+# The most of a frame sent in one message, the jar takes it in pieces
+FRAME_PIXELS_PER_MESSAGE = 300
+
+
+class WebSocket:
+    """A client WebSocket, binary messages only."""
+
+    def __init__( self, host, port ):
+        self.sock = socket.create_connection( ( host, port ), timeout = 5 )
+        self.sock.setsockopt( socket.IPPROTO_TCP, socket.TCP_NODELAY, 1 )
+        self.buffer = b""
+
+        key = base64.b64encode( os.urandom( 16 ) ).decode()
+
+        self.sock.sendall( ( "GET / HTTP/1.1\r\n"
+                             "Host: %s:%d\r\n"
+                             "Upgrade: websocket\r\n"
+                             "Connection: Upgrade\r\n"
+                             "Sec-WebSocket-Key: %s\r\n"
+                             "Sec-WebSocket-Version: 13\r\n\r\n" % ( host, port, key ) ).encode() )
+
+        while b"\r\n\r\n" not in self.buffer:
+            data = self.sock.recv( 4096 )
+            if not data:
+                raise OSError( "closed during the handshake" )
+            self.buffer += data
+
+        headers, self.buffer = self.buffer.split( b"\r\n\r\n", 1 )
+        expected = base64.b64encode( hashlib.sha1( ( key + GUID ).encode() ).digest() )
+
+        if b" 101 " not in headers.split( b"\r\n" )[0] or expected not in headers:
+            raise OSError( "handshake refused: %r" % headers.split( b"\r\n" )[0] )
+
+    def send( self, payload, opcode = WS_BINARY ):
+        # Clients always mask
+        mask = os.urandom( 4 )
+        length = len( payload )
+
+        if length < 126:
+            header = struct.pack( "!BB", 0x80 | opcode, 0x80 | length )
+        elif length < 65536:
+            header = struct.pack( "!BBH", 0x80 | opcode, 0x80 | 126, length )
+        else:
+            header = struct.pack( "!BBQ", 0x80 | opcode, 0x80 | 127, length )
+
+        masked = bytes( b ^ mask[i % 4] for i, b in enumerate( payload ) )
+        self.sock.sendall( header + mask + masked )
+
+    def receive( self, timeout ):
+        """The next binary message, or None if there isn't one in time."""
+        deadline = time.perf_counter() + timeout
+
+        while True:
+            message = self.parse()
+
+            if message is not None:
+                return message
+
+            remaining = deadline - time.perf_counter()
+
+            if remaining <= 0 or not select.select( [self.sock], [], [], remaining )[0]:
+                return None
+
+            data = self.sock.recv( 65536 )
+
+            if not data:
+                raise OSError( "closed by the jar" )
+
+            self.buffer += data
+
+    def parse( self ):
+        while len( self.buffer ) >= 2:
+            opcode = self.buffer[0] & 0x0F
+            length = self.buffer[1] & 0x7F
+            offset = 2
+
+            if length == 126:
+                if len( self.buffer ) < 4:
+                    return None
+                length = struct.unpack( "!H", self.buffer[2:4] )[0]
+                offset = 4
+            elif length == 127:
+                if len( self.buffer ) < 10:
+                    return None
+                length = struct.unpack( "!Q", self.buffer[2:10] )[0]
+                offset = 10
+
+            if len( self.buffer ) < offset + length:
+                return None
+
+            payload = self.buffer[offset:offset + length]
+            self.buffer = self.buffer[offset + length:]
+
+            if opcode == WS_PING:
+                self.send( payload, WS_PONG )
+            elif opcode == WS_CLOSE:
+                raise OSError( "closed by the jar" )
+            elif opcode == WS_BINARY:
+                return payload
+
+        return None
+
+    def close( self ):
+        try:
+            self.send( b"", WS_CLOSE )
+        except OSError:
+            pass
+        self.sock.close()
+
+
+def percentiles( name, values ):
+    if not values:
+        print( "%-12s no samples" % name )
+        return
+
+    values = sorted( values )
+
+    def at( fraction ):
+        return values[min( len( values ) - 1, int( fraction * len( values ) ) )]
+
+    print( "%-12s ms p50 %6.1f  p90 %6.1f  p99 %6.1f  max %6.1f   (%d samples)"
+           % ( name, at( 0.50 ), at( 0.90 ), at( 0.99 ), values[-1], len( values ) ) )
+
+
+def color_of( state ):
+    """wwrrggbb from a state message."""
+    return struct.unpack( "<I", state[2:6] )[0]
+
+
+def color_message( i ):
+    """A color that differs from the one before, and what the jar
+    reports for it."""
+    r, g, b = ( i * 37 ) & 0xFF, ( i * 91 ) & 0xFF, 0x40 | ( i & 0x3F )
+    return bytes( [OP_COLOR, r, g, b] ), ( r << 16 ) | ( g << 8 ) | b
+
+
+def wait_for_state( ws, timeout, wanted = None ):
+    """Waits for a state message (showing wanted, if given).  Counts
+    any rejections seen on the way."""
+    deadline = time.perf_counter() + timeout
+    rejected = 0
+
+    while True:
+        message = ws.receive( max( 0.0, deadline - time.perf_counter() ) )
+
+        if message is None:
+            return None, rejected
+
+        if message[0] == OP_ERROR:
+            rejected += 1
+        elif message[0] == OP_STATE and len( message ) >= 6:
+            if wanted is None or color_of( message ) == wanted:
+                return message, rejected
+
+
+def drain( ws ):
+    """Anything the jar had queued up (state on connect, and so on)."""
+    while ws.receive( 0.2 ) is not None:
+        pass
+
+
+def round_trips( ws, samples ):
+    drain( ws )
+
+    latencies = []
+
+    for _ in range( samples ):
+        before = time.perf_counter()
+        ws.send( bytes( [OP_GET_STATE] ) )
+
+        if wait_for_state( ws, 1.0 )[0] is not None:
+            latencies.append( ( time.perf_counter() - before ) * 1000.0 )
+
+    percentiles( "round trip", latencies )
+
+
+def applied( ws, samples ):
+    drain( ws )
+
+    latencies = []
+    missing = 0
+
+    for i in range( samples ):
+        message, color = color_message( i )
+
+        before = time.perf_counter()
+        ws.send( message )
+
+        if wait_for_state( ws, 1.0, color )[0] is not None:
+            latencies.append( ( time.perf_counter() - before ) * 1000.0 )
+        else:
+            missing += 1
+
+    percentiles( "applied", latencies )
+
+    if missing > 0:
+        print( "             %d colors never showed up in a state" % missing )
+
+    return missing
+
+
+def frame_messages( i, pixels ):
+    """A whole frame of one (changing) color, in pieces small enough
+    for the jar."""
+    r, g, b = ( i * 5 ) & 0xFF, ( i * 11 ) & 0xFF, ( i * 17 ) & 0xFF
+    messages = []
+
+    for start in range( 0, pixels, FRAME_PIXELS_PER_MESSAGE ):
+        count = min( FRAME_PIXELS_PER_MESSAGE, pixels - start )
+        flags = 0x02 if start + count < pixels else 0x00
+        messages.append( bytes( [OP_FRAME, flags, start & 0xFF, start >> 8] ) + bytes( [r, g, b] ) * count )
+
+    return messages
+
+
+def load( ws, rate, seconds, pixels ):
+    drain( ws )
+
+    interval = 1.0 / rate if rate > 0 else 0.0
+    sent = 0
+    messages = 0
+    rejected = 0
+
+    started = time.perf_counter()
+    next_send = started
+
+    while time.perf_counter() - started < seconds:
+        if pixels > 0:
+            for message in frame_messages( sent, pixels ):
+                ws.send( message )
+                messages += 1
+        else:
+            ws.send( color_message( sent )[0] )
+            messages += 1
+
+        sent += 1
+
+        # Whatever has come back, without waiting on it
+        while True:
+            message = ws.receive( 0.0 )
+            if message is None:
+                break
+            rejected += 1 if message[0] == OP_ERROR else 0
+
+        if interval > 0:
+            next_send += interval
+            delay = next_send - time.perf_counter()
+            if delay > 0:
+                time.sleep( delay )
+
+    # Everything before this has been dealt with once it is answered
+    ws.send( bytes( [OP_GET_STATE] ) )
+
+    state, more = wait_for_state( ws, 5.0 )
+    rejected += more
+
+    elapsed = time.perf_counter() - started
+
+    print( "load         %d %s in %.2fs: %.1f updates/s, %.1f messages/s, %d rejected%s"
+           % ( sent, "frames of %d pixels" % pixels if pixels > 0 else "colors", elapsed,
+               sent / elapsed, messages / elapsed, rejected,
+               "" if state is not None else ", and no answer at the end" ) )
+
+    return rejected + ( 0 if state is not None else 1 )
+
+
+def main():
+    parser = argparse.ArgumentParser( description = "WebSocket channel load test" )
+    parser.add_argument( "host" )
+    parser.add_argument( "--port", type = int, default = 81 )
+    parser.add_argument( "--samples", type = int, default = 200,
+                         help = "round trips and applied colors to time" )
+    parser.add_argument( "--rate", type = float, default = 100,
+                         help = "updates per second under load, 0 for flat out" )
+    parser.add_argument( "--seconds", type = float, default = 10 )
+    parser.add_argument( "--pixels", type = int, default = 0,
+                         help = "send frames of this many pixels, not colors" )
+    args = parser.parse_args()
+
+    ws = WebSocket( args.host, args.port )
+
+    try:
+        round_trips( ws, args.samples )
+        failures = applied( ws, args.samples )
+        failures += load( ws, args.rate, args.seconds, args.pixels )
+    finally:
+        ws.close()
+
+    return 1 if failures > 0 else 0
+
+
+if __name__ == "__main__":
+    sys.exit( main() )
@@ -0,0 +1,56 @@
+#ifndef _JAROFLIGHT_TEST_ADAFRUIT_NEOPIXEL_H_
+#define _JAROFLIGHT_TEST_ADAFRUIT_NEOPIXEL_H_
+
+/*======================================================================
+FILE:
+Adafruit_NeoPixel.h
+
+DESCRIPTION:
+Stand in for the Adafruit neopixel library.  Pixels are kept, but 
+show() sends them nowhere.
+
+======================================================================*/
+
+#include <Arduino.h>
+
+#include <vector>
+
+typedef uint16_t neoPixelType;
+
+#define NEO_GRB 0x52
+#define NEO_GRBW 0xD2
+#define NEO_RGBW 0xC6
+#define NEO_KHZ800 0x0000
+
+class Adafruit_NeoPixel
+{
+    public:
+
+    Adafruit_NeoPixel( uint16_t count, int16_t pin, neoPixelType type ) 
+        : _pixels( count, 0 ) { (void) pin; (void) type; }
+
+    void begin() {}
+    void show() {}
+    bool canShow() const { return true; }
+
+    void setPixelColor( uint16_t n, uint32_t c ) { if ( n < _pixels.size() ) _pixels[n] = c; }
+    uint32_t getPixelColor( uint16_t n ) const { return ( n < _pixels.size() ) ? _pixels[n] : 0; }
+    uint16_t numPixels() const { return (uint16_t) _pixels.size(); }
+    void setBrightness( uint8_t brightness ) { (void) brightness; }
+
+    static uint32_t Color( uint8_t r, uint8_t g, uint8_t b ) 
+    {
+        return ( (uint32_t) r << 16 ) | ( (uint32_t) g << 8 ) | b;
+    }
+
+    static uint32_t Color( uint8_t r, uint8_t g, uint8_t b, uint8_t w ) 
+    {
+        return ( (uint32_t) w << 24 ) | ( (uint32_t) r << 16 ) | ( (uint32_t) g << 8 ) | b;
+    }
+
+    private:
+
+    std::vector< uint32_t > _pixels;
+};
+
+#endif  // _JAROFLIGHT_TEST_ADAFRUIT_NEOPIXEL_H_
@@ -0,0 +1,85 @@
+#ifndef _JAROFLIGHT_TEST_ARDUINO_H_
+#define _JAROFLIGHT_TEST_ARDUINO_H_
+
+/*======================================================================
+FILE:
+Arduino.h
+
+DESCRIPTION:
+Just enough of the ESP8266 Arduino core to build the sketch's 
+hardware independent parts on a PC (see test/Makefile).  Time is
+simulated - it only moves when HostAdvanceMicros() is called - so 
+runs are repeatable and as fast as the PC can go.
+
+======================================================================*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "WString.h"
+
+typedef uint8_t byte;
+
+#define PROGMEM
+#define IRAM_ATTR
+#define ICACHE_RAM_ATTR
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+
+using std::min;
+using std::max;
+
+inline uint8_t pgm_read_byte( const void *p ) { return *(const uint8_t *) p; }
+inline uint16_t pgm_read_word( const void *p ) { return *(const uint16_t *) p; }
+inline uint32_t pgm_read_dword( const void *p ) { return *(const uint32_t *) p; }
+
+unsigned long millis();
+unsigned long micros();
+uint64_t micros64();
+
+void delay( unsigned long ms );
+void yield();
+
+void pinMode( uint8_t pin, uint8_t mode );
+void digitalWrite( uint8_t pin, uint8_t value );
+int digitalRead( uint8_t pin );
+
+void noInterrupts();
+void interrupts();
+
+// Output goes to stdout, unless HostQuiet() says otherwise
+class HardwareSerial
+{
+    public:
+
+    void begin( unsigned long baud ) { (void) baud; }
+    size_t printf( const char *format, ... );
+    size_t print( const char *text );
+    size_t print( const String &text ) { return print( text.c_str() ); }
+    size_t println( const char *text = "" );
+    size_t println( const String &text ) { return println( text.c_str() ); }
+    int available() { return 0; }
+    int read() { return -1; }
+};
+
+extern HardwareSerial Serial;
+
+//
+// Host only - drives the simulation
+//
+
+// Moves the clocks on.  Time starts at 1ms after boot.
+void HostAdvanceMicros( uint64_t us );
+
+// Throws away Serial output (benchmarks don't want it)
+void HostQuiet( bool quiet );
+
+#endif  // _JAROFLIGHT_TEST_ARDUINO_H_
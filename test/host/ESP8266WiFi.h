@@ -0,0 +1,66 @@
+#ifndef _JAROFLIGHT_TEST_ESP8266WIFI_H_
+#define _JAROFLIGHT_TEST_ESP8266WIFI_H_
+
+/*======================================================================
+FILE:
+ESP8266WiFi.h
+
+DESCRIPTION:
+The WiFi object, as far as the sketch's network code needs it.  A 
+simulation with several jars in one process says which one is running
+with HostSetLocalIP() before calling into it.
+
+======================================================================*/
+
+#include <Arduino.h>
+
+#include "IPAddress.h"
+
+#include <memory>
+
+// The event types WifiProxy declares its handlers with (a header the
+// stores include), with a few of the SDK's disconnect reasons
+enum WiFiDisconnectReason
+{
+    WIFI_DISCONNECT_REASON_UNSPECIFIED = 1,
+    WIFI_DISCONNECT_REASON_ASSOC_LEAVE = 8,
+    WIFI_DISCONNECT_REASON_BEACON_TIMEOUT = 200,
+    WIFI_DISCONNECT_REASON_NO_AP_FOUND = 201,
+    WIFI_DISCONNECT_REASON_AUTH_FAIL = 202,
+    WIFI_DISCONNECT_REASON_ASSOC_FAIL = 203
+};
+
+struct WiFiEventStationModeGotIP
+{
+    IPAddress ip;
+    IPAddress mask;
+    IPAddress gw;
+};
+
+struct WiFiEventStationModeDisconnected
+{
+    String ssid;
+    uint8_t bssid[6];
+    WiFiDisconnectReason reason;
+};
+
+struct WiFiEventHandlerOpaque {};
+typedef std::shared_ptr< WiFiEventHandlerOpaque > WiFiEventHandler;
+
+class ESP8266WiFiClass
+{
+    public:
+
+    IPAddress localIP() const { return _localIP; }
+
+    // Host only
+    void HostSetLocalIP( IPAddress address ) { _localIP = address; }
+
+    private:
+
+    IPAddress _localIP = IPAddress( 192, 168, 1, 2 );
+};
+
+extern ESP8266WiFiClass WiFi;
+
+#endif  // _JAROFLIGHT_TEST_ESP8266WIFI_H_
@@ -0,0 +1,104 @@
+#ifndef _JAROFLIGHT_TEST_ESPASYNCTCP_H_
+#define _JAROFLIGHT_TEST_ESPASYNCTCP_H_
+
+/*======================================================================
+FILE:
+ESPAsyncTCP.h
+
+DESCRIPTION:
+AsyncServer and AsyncClient on the simulated network, as far as
+HttpServer needs them.  Nothing listens on a real socket: a test
+connects with AsyncServer::HostConnect() and plays the far end of the
+connection by its id - sending bytes in, reading back what was sent,
+and acknowledging it.  The callbacks are run right away, from inside
+those calls, the way the network stack would run them.
+
+A client has HOST_SEND_BUFFER bytes of room for data that hasn't been
+acknowledged yet, so a big response has to wait on acks.
+
+======================================================================*/
+
+#include <Arduino.h>
+
+#include <functional>
+#include <string>
+
+class AsyncClient;
+
+typedef std::function< void( void *, AsyncClient * ) > AcConnectHandler;
+typedef std::function< void( void *, AsyncClient *, size_t length, uint32_t time ) > AcAckHandler;
+typedef std::function< void( void *, AsyncClient *, void *data, size_t length ) > AcDataHandler;
+
+class AsyncClient
+{
+    public:
+
+    // Room for unacknowledged data, about two segments
+    static const size_t HOST_SEND_BUFFER = 2920;
+
+    AsyncClient();
+    ~AsyncClient();
+
+    void onData( AcDataHandler handler, void *arg = nullptr ) { (void) arg; _onData = handler; }
+    void onAck( AcAckHandler handler, void *arg = nullptr ) { (void) arg; _onAck = handler; }
+    void onDisconnect( AcConnectHandler handler, void *arg = nullptr ) { (void) arg; _onDisconnect = handler; }
+
+    void setNoDelay( bool noDelay ) { (void) noDelay; }
+    bool connected() const { return _open; }
+
+    size_t space() const { return ( _open == true ) ? HOST_SEND_BUFFER - _unacked : 0; }
+    size_t add( const char *data, size_t length, uint8_t flags = 0 );
+    bool send() { return _open; }
+
+    // Calls the disconnect handler, which may well delete us
+    void close( bool now = false );
+    bool free() { return true; }
+
+    // Host only - the far end of connection id (from HostConnect()).
+    // Once the connection is closed HostReceive() and HostAck() do
+    // nothing, and HostSent() still has everything that was sent.
+    static void HostReceive( int id, const std::string &data );
+    static void HostAck( int id );
+    static std::string HostSent( int id );
+    static bool HostIsOpen( int id );
+
+    private:
+
+    AsyncClient( const AsyncClient &rhs );
+
+    int _id;
+    bool _open;
+    size_t _unacked;
+
+    AcDataHandler _onData;
+    AcAckHandler _onAck;
+    AcConnectHandler _onDisconnect;
+
+    friend class AsyncServer;
+};
+
+class AsyncServer
+{
+    public:
+
+    explicit AsyncServer( uint16_t port );
+    ~AsyncServer();
+
+    void onClient( AcConnectHandler handler, void *arg ) { (void) arg; _onClient = handler; }
+    void setNoDelay( bool noDelay ) { (void) noDelay; }
+    void begin() { _listening = true; }
+
+    // Host only - a new client for whatever has begun listening on
+    // port.  Returns the connection's id, -1 if nothing is listening.
+    static int HostConnect( uint16_t port );
+
+    private:
+
+    AsyncServer( const AsyncServer &rhs );
+
+    uint16_t _port;
+    bool _listening;
+    AcConnectHandler _onClient;
+};
+
+#endif  // _JAROFLIGHT_TEST_ESPASYNCTCP_H_
@@ -0,0 +1,44 @@
+#ifndef _JAROFLIGHT_TEST_IPADDRESS_H_
+#define _JAROFLIGHT_TEST_IPADDRESS_H_
+
+/*======================================================================
+FILE:
+IPAddress.h
+
+DESCRIPTION:
+IPv4 address, stored the way the ESP8266 core does (first octet in 
+the low byte).
+
+======================================================================*/
+
+#include <Arduino.h>
+
+class IPAddress
+{
+    public:
+
+    IPAddress() : _address( 0 ) {}
+    IPAddress( uint32_t address ) : _address( address ) {}
+    IPAddress( uint8_t a, uint8_t b, uint8_t c, uint8_t d ) 
+        : _address( a | ( b << 8 ) | ( c << 16 ) | ( (uint32_t) d << 24 ) ) {}
+
+    operator uint32_t() const { return _address; }
+
+    bool operator==( const IPAddress &rhs ) const { return _address == rhs._address; }
+    bool operator!=( const IPAddress &rhs ) const { return _address != rhs._address; }
+
+    uint8_t operator[]( int index ) const { return (uint8_t) ( _address >> ( index * 8 ) ); }
+
+    String toString() const
+    {
+        char text[16];
+        snprintf( text, sizeof( text ), "%u.%u.%u.%u", (*this)[0], (*this)[1], (*this)[2], (*this)[3] );
+        return String( text );
+    }
+
+    private:
+
+    uint32_t _address;
+};
+
+#endif  // _JAROFLIGHT_TEST_IPADDRESS_H_
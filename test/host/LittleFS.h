@@ -0,0 +1,62 @@
+#ifndef _JAROFLIGHT_TEST_LITTLEFS_H_
+#define _JAROFLIGHT_TEST_LITTLEFS_H_
+
+/*======================================================================
+FILE:
+LittleFS.h
+
+DESCRIPTION:
+A file system in memory, with the calls the settings and schedule 
+stores make.  It lasts as long as the process, so a store constructed
+again reads back what the last one saved.
+
+======================================================================*/
+
+#include <Arduino.h>
+
+#include <map>
+#include <string>
+
+class File
+{
+    public:
+
+    File() : _file( nullptr ), _offset( 0 ) {}
+    explicit File( std::string *file ) : _file( file ), _offset( 0 ) {}
+
+    explicit operator bool() const { return _file != nullptr; }
+
+    size_t read( uint8_t *buffer, size_t length );
+    size_t write( const uint8_t *buffer, size_t length );
+    size_t size() const { return ( _file != nullptr ) ? _file->size() : 0; }
+    void close() { _file = nullptr; }
+
+    private:
+
+    std::string *_file;
+    size_t _offset;
+};
+
+class FS
+{
+    public:
+
+    bool begin() { return true; }
+    bool format() { _files.clear(); return true; }
+
+    // "r" or "w"
+    File open( const char *path, const char *mode );
+    bool exists( const char *path ) const { return _files.count( path ) > 0; }
+    bool remove( const char *path ) { return _files.erase( path ) > 0; }
+
+    // Over the top of to, if it is there
+    bool rename( const char *from, const char *to );
+
+    private:
+
+    std::map< std::string, std::string > _files;
+};
+
+extern FS LittleFS;
+
+#endif  // _JAROFLIGHT_TEST_LITTLEFS_H_
@@ -0,0 +1,24 @@
+#ifndef _JAROFLIGHT_TEST_TIMELIB_H_
+#define _JAROFLIGHT_TEST_TIMELIB_H_
+
+/*======================================================================
+FILE:
+TimeLib.h
+
+DESCRIPTION:
+The TimeLib calls the sketch makes.  Like the real one, the time
+set with setTime() runs on from millis().
+
+======================================================================*/
+
+#include <time.h>
+
+typedef time_t ( *getExternalTime )();
+
+time_t now();
+void setTime( time_t t );
+
+// Nothing here calls the provider, it is only ever set to null
+void setSyncProvider( getExternalTime getTimeFunction );
+
+#endif  // _JAROFLIGHT_TEST_TIMELIB_H_
@@ -0,0 +1,77 @@
+#ifndef _JAROFLIGHT_TEST_WSTRING_H_
+#define _JAROFLIGHT_TEST_WSTRING_H_
+
+/*======================================================================
+FILE:
+WString.h
+
+DESCRIPTION:
+The parts of the Arduino String class the sketch uses, on top of 
+std::string.
+
+======================================================================*/
+
+#include <stdlib.h>
+
+#include <string>
+
+class String
+{
+    public:
+
+    String() {}
+    String( const char *text ) : _s( text != nullptr ? text : "" ) {}
+    String( const std::string &text ) : _s( text ) {}
+    String( char c ) : _s( 1, c ) {}
+    String( int value ) : _s( std::to_string( value ) ) {}
+    String( unsigned int value ) : _s( std::to_string( value ) ) {}
+    String( long value ) : _s( std::to_string( value ) ) {}
+    String( unsigned long value ) : _s( std::to_string( value ) ) {}
+
+    const char *c_str() const { return _s.c_str(); }
+    unsigned int length() const { return (unsigned int) _s.size(); }
+    bool isEmpty() const { return _s.empty(); }
+    void reserve( unsigned int size ) { _s.reserve( size ); }
+
+    char operator[]( unsigned int index ) const { return _s[index]; }
+    char charAt( unsigned int index ) const { return _s[index]; }
+
+    bool operator==( const String &rhs ) const { return _s == rhs._s; }
+    bool operator==( const char *rhs ) const { return _s == rhs; }
+    bool operator!=( const String &rhs ) const { return _s != rhs._s; }
+    bool equals( const String &rhs ) const { return _s == rhs._s; }
+
+    String &operator+=( const String &rhs ) { _s += rhs._s; return *this; }
+    String &operator+=( const char *rhs ) { _s += rhs; return *this; }
+    String &operator+=( char rhs ) { _s += rhs; return *this; }
+    String &operator+=( int rhs ) { _s += std::to_string( rhs ); return *this; }
+    String &operator+=( unsigned int rhs ) { _s += std::to_string( rhs ); return *this; }
+    String &operator+=( long rhs ) { _s += std::to_string( rhs ); return *this; }
+    String &operator+=( unsigned long rhs ) { _s += std::to_string( rhs ); return *this; }
+
+    bool concat( const String &rhs ) { _s += rhs._s; return true; }
+    bool concat( const char *rhs ) { _s += rhs; return true; }
+    bool concat( char rhs ) { _s += rhs; return true; }
+
+    friend String operator+( const String &lhs, const String &rhs ) { return String( lhs._s + rhs._s ); }
+    friend String operator+( const String &lhs, const char *rhs ) { return String( lhs._s + rhs ); }
+    friend String operator+( const char *lhs, const String &rhs ) { return String( lhs + rhs._s ); }
+
+    int indexOf( char c, unsigned int from = 0 ) const 
+    {
+        size_t at = _s.find( c, from );
+        return ( at == std::string::npos ) ? -1 : (int) at;
+    }
+
+    String substring( unsigned int from ) const { return String( _s.substr( from ) ); }
+    String substring( unsigned int from, unsigned int to ) const { return String( _s.substr( from, to - from ) ); }
+
+    bool startsWith( const char *prefix ) const { return _s.compare( 0, strlen( prefix ), prefix ) == 0; }
+    long toInt() const { return atol( _s.c_str() ); }
+
+    private:
+
+    std::string _s;
+};
+
+#endif  // _JAROFLIGHT_TEST_WSTRING_H_
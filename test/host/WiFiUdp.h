@@ -0,0 +1,77 @@
+#ifndef _JAROFLIGHT_TEST_WIFIUDP_H_
+#define _JAROFLIGHT_TEST_WIFIUDP_H_
+
+/*======================================================================
+FILE:
+WiFiUdp.h
+
+DESCRIPTION:
+WiFiUDP on a simulated network inside the process.  A packet sent to 
+a port (unicast or multicast, it makes no difference here) is queued
+for every WiFiUDP listening on that port, the sender included, so 
+the code has to cope with hearing itself.  It comes from whatever 
+WiFi.localIP() was when it was sent.
+
+======================================================================*/
+
+#include <Arduino.h>
+
+#include <deque>
+#include <vector>
+
+#include "IPAddress.h"
+
+class WiFiUDP
+{
+    public:
+
+    WiFiUDP();
+    ~WiFiUDP();
+
+    uint8_t begin( uint16_t port );
+    uint8_t beginMulticast( IPAddress interfaceAddress, IPAddress group, uint16_t port );
+    void stop();
+
+    // Receiving
+    int parsePacket();
+    int available() const { return (int) ( _current.data.size() - _readOffset ); }
+    int read();
+    int read( uint8_t *buffer, size_t length );
+    int read( char *buffer, size_t length ) { return read( (uint8_t *) buffer, length ); }
+    void flush();
+    IPAddress remoteIP() const { return _current.from; }
+    uint16_t remotePort() const { return _current.fromPort; }
+
+    // Sending
+    int beginPacket( IPAddress address, uint16_t port );
+    int beginPacketMulticast( IPAddress group, uint16_t port, IPAddress interfaceAddress, int ttl = 1 );
+    size_t write( const uint8_t *buffer, size_t length );
+    size_t write( uint8_t value ) { return write( &value, 1 ); }
+    int endPacket();
+
+    // Host only - packets sent on the simulated network, and dropped
+    // on the way (every nth, 0 for none)
+    static uint32_t HostPacketsSent();
+    static void HostDropEvery( uint32_t n );
+
+    private:
+
+    struct Packet
+    {
+        IPAddress from;
+        uint16_t fromPort;
+        std::vector< uint8_t > data;
+    };
+
+    WiFiUDP( const WiFiUDP &rhs );
+
+    uint16_t _port;
+    std::deque< Packet > _queue;
+    Packet _current;
+    size_t _readOffset;
+
+    uint16_t _sendPort;
+    std::vector< uint8_t > _sending;
+};
+
+#endif  // _JAROFLIGHT_TEST_WIFIUDP_H_
@@ -0,0 +1,71 @@
+/*======================================================================
+FILE:
+filesystem.cpp
+
+DESCRIPTION:
+The in memory file system behind the LittleFS stub.
+
+======================================================================*/
+
+#include <LittleFS.h>
+
+#include <string.h>
+
+FS LittleFS;
+
+size_t File::read( uint8_t *buffer, size_t length )
+{
+    if ( _file == nullptr || _offset >= _file->size() )
+    {
+        return 0;
+    }
+
+    length = std::min( length, _file->size() - _offset );
+    memcpy( buffer, _file->data() + _offset, length );
+    _offset += length;
+
+    return length;
+}
+
+size_t File::write( const uint8_t *buffer, size_t length )
+{
+    if ( _file == nullptr )
+    {
+        return 0;
+    }
+
+    _file->append( (const char *) buffer, length );
+
+    return length;
+}
+
+File FS::open( const char *path, const char *mode )
+{
+    if ( mode[0] == 'w' )
+    {
+        std::string &file = _files[path];
+        file.clear();
+        return File( &file );
+    }
+
+    std::map< std::string, std::string >::iterator found = _files.find( path );
+
+    return ( found != _files.end() ) ? File( &found->second ) : File();
+}
+
+bool FS::rename( const char *from, const char *to )
+{
+    std::map< std::string, std::string >::iterator found = _files.find( from );
+
+    if ( found == _files.end() )
+    {
+        return false;
+    }
+
+    std::string contents = found->second;
+
+    _files.erase( found );
+    _files[to] = contents;
+
+    return true;
+}
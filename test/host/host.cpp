@@ -0,0 +1,75 @@
+/*======================================================================
+FILE:
+host.cpp
+
+DESCRIPTION:
+The bits of the Arduino core the stubs in this directory declare: a
+simulated clock, and Serial on stdout.  TimeLib's clock is here too,
+running off the simulated one.
+
+======================================================================*/
+
+#include <Arduino.h>
+#include <TimeLib.h>
+
+#include <stdarg.h>
+
+// Simulated time since boot
+static uint64_t s_nowUS = 1000;
+
+static bool s_quiet = false;
+
+// TimeLib: the time last set, and when (simulated) it was set
+static time_t s_setTime = 0;
+static uint64_t s_setAtUS = 0;
+
+static uint8_t s_pins[32];
+
+HardwareSerial Serial;
+
+void HostAdvanceMicros( uint64_t us ) { s_nowUS += us; }
+void HostQuiet( bool quiet ) { s_quiet = quiet; }
+
+unsigned long millis() { return (unsigned long) ( s_nowUS / 1000 ); }
+unsigned long micros() { return (unsigned long) s_nowUS; }
+uint64_t micros64() { return s_nowUS; }
+
+void delay( unsigned long ms ) { s_nowUS += ms * 1000ULL; }
+void yield() {}
+
+void pinMode( uint8_t pin, uint8_t mode ) { (void) pin; (void) mode; }
+void digitalWrite( uint8_t pin, uint8_t value ) { s_pins[pin % 32] = value; }
+int digitalRead( uint8_t pin ) { return s_pins[pin % 32]; }
+
+time_t now() { return s_setTime + (time_t) ( ( s_nowUS - s_setAtUS ) / 1000000ULL ); }
+void setTime( time_t t ) { s_setTime = t; s_setAtUS = s_nowUS; }
+void setSyncProvider( getExternalTime getTimeFunction ) { (void) getTimeFunction; }
+
+void noInterrupts() {}
+void interrupts() {}
+
+size_t HardwareSerial::printf( const char *format, ... )
+{
+    if ( s_quiet == true )
+    {
+        return 0;
+    }
+
+    va_list args;
+    va_start( args, format );
+    int length = vprintf( format, args );
+    va_end( args );
+
+    return ( length > 0 ) ? (size_t) length : 0;
+}
+
+size_t HardwareSerial::print( const char *text )
+{
+    return ( s_quiet == true ) ? 0 : (size_t) fputs( text, stdout );
+}
+
+size_t HardwareSerial::println( const char *text )
+{
+    // Our printf(), which checks s_quiet
+    return printf( "%s\n", text );
+}
@@ -0,0 +1,29 @@
+#ifndef _JAROFLIGHT_TEST_LWIP_DNS_H_
+#define _JAROFLIGHT_TEST_LWIP_DNS_H_
+
+/*======================================================================
+FILE:
+lwip/dns.h
+
+DESCRIPTION:
+lwIP's asynchronous lookup.  There is no DNS on the simulated network
+(see network.cpp): a dotted quad comes straight back, and anything 
+else fails.
+
+======================================================================*/
+
+#include <stdint.h>
+
+#include "ip_addr.h"
+
+typedef int8_t err_t;
+
+#define ERR_OK          0
+#define ERR_INPROGRESS  -5
+#define ERR_ARG         -16
+
+typedef void ( *dns_found_callback )( const char *name, const ip_addr_t *ipaddr, void *callback_arg );
+
+err_t dns_gethostbyname( const char *hostname, ip_addr_t *addr, dns_found_callback found, void *callback_arg );
+
+#endif  // _JAROFLIGHT_TEST_LWIP_DNS_H_
@@ -0,0 +1,22 @@
+#ifndef _JAROFLIGHT_TEST_LWIP_IP_ADDR_H_
+#define _JAROFLIGHT_TEST_LWIP_IP_ADDR_H_
+
+/*======================================================================
+FILE:
+lwip/ip_addr.h
+
+DESCRIPTION:
+lwIP's (IPv4 only) address, first octet in the low byte.
+
+======================================================================*/
+
+#include <stdint.h>
+
+struct ip_addr_t
+{
+    uint32_t addr;
+};
+
+#define ip_addr_get_ip4_u32( ipaddr ) ( ( ipaddr )->addr )
+
+#endif  // _JAROFLIGHT_TEST_LWIP_IP_ADDR_H_
@@ -0,0 +1,285 @@
+/*======================================================================
+FILE:
+network.cpp
+
+DESCRIPTION:
+The simulated network behind the WiFi, WiFiUDP, ESPAsyncTCP and lwIP
+lookup stubs.
+
+======================================================================*/
+
+#include <ESP8266WiFi.h>
+#include <ESPAsyncTCP.h>
+#include <WiFiUdp.h>
+#include <lwip/dns.h>
+
+#include <stdio.h>
+
+#include <algorithm>
+
+ESP8266WiFiClass WiFi;
+
+// Everything that can receive
+static std::vector< WiFiUDP * > s_sockets;
+
+static uint32_t s_packetsSent = 0;
+static uint32_t s_dropEvery = 0;
+
+// The TCP servers, and every connection made to them by id (the
+// client is gone once the server has deleted it)
+struct Peer
+{
+    AsyncClient *client;
+    std::string sent;
+};
+
+static std::vector< AsyncServer * > s_servers;
+static std::vector< Peer > s_peers;
+
+WiFiUDP::WiFiUDP() : _port( 0 ), _readOffset( 0 ), _sendPort( 0 )
+{
+    s_sockets.push_back( this );
+}
+
+WiFiUDP::~WiFiUDP()
+{
+    s_sockets.erase( std::remove( s_sockets.begin(), s_sockets.end(), this ), s_sockets.end() );
+}
+
+err_t dns_gethostbyname( const char *hostname, ip_addr_t *addr, dns_found_callback found, void *callback_arg )
+{
+    (void) found;
+    (void) callback_arg;
+
+    unsigned int a, b, c, d;
+    char extra;
+
+    if ( sscanf( hostname, "%u.%u.%u.%u%c", &a, &b, &c, &d, &extra ) != 4 ||
+         a > 255 || b > 255 || c > 255 || d > 255 )
+    {
+        return ERR_ARG;
+    }
+
+    addr->addr = (uint32_t) IPAddress( a, b, c, d );
+
+    return ERR_OK;
+}
+
+uint8_t WiFiUDP::begin( uint16_t port )
+{
+    _port = port;
+    return 1;
+}
+
+uint8_t WiFiUDP::beginMulticast( IPAddress interfaceAddress, IPAddress group, uint16_t port )
+{
+    (void) interfaceAddress;
+    (void) group;
+
+    return begin( port );
+}
+
+void WiFiUDP::stop()
+{
+    _port = 0;
+    _queue.clear();
+}
+
+int WiFiUDP::parsePacket()
+{
+    flush();
+
+    if ( _queue.empty() == true )
+    {
+        return 0;
+    }
+
+    _current = _queue.front();
+    _queue.pop_front();
+
+    return (int) _current.data.size();
+}
+
+int WiFiUDP::read()
+{
+    uint8_t value;
+    return ( read( &value, 1 ) == 1 ) ? value : -1;
+}
+
+int WiFiUDP::read( uint8_t *buffer, size_t length )
+{
+    size_t count = std::min( length, (size_t) available() );
+
+    memcpy( buffer, _current.data.data() + _readOffset, count );
+    _readOffset += count;
+
+    return (int) count;
+}
+
+void WiFiUDP::flush()
+{
+    _current.data.clear();
+    _readOffset = 0;
+}
+
+int WiFiUDP::beginPacket( IPAddress address, uint16_t port )
+{
+    (void) address;
+
+    _sendPort = port;
+    _sending.clear();
+    return 1;
+}
+
+int WiFiUDP::beginPacketMulticast( IPAddress group, uint16_t port, IPAddress interfaceAddress, int ttl )
+{
+    (void) interfaceAddress;
+    (void) ttl;
+
+    return beginPacket( group, port );
+}
+
+size_t WiFiUDP::write( const uint8_t *buffer, size_t length )
+{
+    _sending.insert( _sending.end(), buffer, buffer + length );
+    return length;
+}
+
+int WiFiUDP::endPacket()
+{
+    s_packetsSent++;
+
+    if ( s_dropEvery != 0 && s_packetsSent % s_dropEvery == 0 )
+    {
+        return 1;
+    }
+
+    Packet packet;
+    packet.from = WiFi.localIP();
+    packet.fromPort = ( _port != 0 ) ? _port : 40000;
+    packet.data = _sending;
+
+    for ( size_t i = 0; i < s_sockets.size(); i++ )
+    {
+        if ( s_sockets[i]->_port == _sendPort )
+        {
+            s_sockets[i]->_queue.push_back( packet );
+        }
+    }
+
+    return 1;
+}
+
+uint32_t WiFiUDP::HostPacketsSent() { return s_packetsSent; }
+void WiFiUDP::HostDropEvery( uint32_t n ) { s_dropEvery = n; }
+
+AsyncClient::AsyncClient() : _id( (int) s_peers.size() ), _open( true ), _unacked( 0 )
+{
+    Peer peer;
+    peer.client = this;
+
+    s_peers.push_back( peer );
+}
+
+AsyncClient::~AsyncClient()
+{
+    s_peers[_id].client = nullptr;
+}
+
+size_t AsyncClient::add( const char *data, size_t length, uint8_t flags )
+{
+    (void) flags;
+
+    length = std::min( length, space() );
+
+    s_peers[_id].sent.append( data, length );
+    _unacked += length;
+
+    return length;
+}
+
+void AsyncClient::close( bool now )
+{
+    (void) now;
+
+    if ( _open == false )
+    {
+        return;
+    }
+
+    _open = false;
+
+    // The handler may delete us, and the handler with us
+    AcConnectHandler handler = _onDisconnect;
+
+    if ( handler )
+    {
+        handler( nullptr, this );
+    }
+}
+
+void AsyncClient::HostReceive( int id, const std::string &data )
+{
+    AsyncClient *client = s_peers[id].client;
+
+    if ( client != nullptr && client->_open == true && client->_onData )
+    {
+        std::string copy = data;
+
+        client->_onData( nullptr, client, &copy[0], copy.size() );
+    }
+}
+
+void AsyncClient::HostAck( int id )
+{
+    AsyncClient *client = s_peers[id].client;
+
+    if ( client != nullptr && client->_open == true && client->_unacked > 0 )
+    {
+        size_t length = client->_unacked;
+
+        client->_unacked = 0;
+
+        if ( client->_onAck )
+        {
+            client->_onAck( nullptr, client, length, 0 );
+        }
+    }
+}
+
+std::string AsyncClient::HostSent( int id ) { return s_peers[id].sent; }
+
+bool AsyncClient::HostIsOpen( int id )
+{
+    return s_peers[id].client != nullptr && s_peers[id].client->_open == true;
+}
+
+AsyncServer::AsyncServer( uint16_t port ) : _port( port ), _listening( false )
+{
+    s_servers.push_back( this );
+}
+
+AsyncServer::~AsyncServer()
+{
+    s_servers.erase( std::remove( s_servers.begin(), s_servers.end(), this ), s_servers.end() );
+}
+
+int AsyncServer::HostConnect( uint16_t port )
+{
+    for ( size_t i = 0; i < s_servers.size(); i++ )
+    {
+        AsyncServer *server = s_servers[i];
+
+        if ( server->_port == port && server->_listening == true && server->_onClient )
+        {
+            AsyncClient *client = new AsyncClient();
+            int id = client->_id;
+
+            server->_onClient( nullptr, client );
+
+            return id;
+        }
+    }
+
+    return -1;
+}
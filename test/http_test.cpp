@@ -0,0 +1,868 @@
+/*======================================================================
+FILE:
+http_test.cpp
+
+DESCRIPTION:
+Tests HttpServer's request handling, and the requests WebserverProxy
+answers with it, over the simulated TCP connections in
+host/ESPAsyncTCP.h.
+
+The parser is fed requests a byte at a time, and ones it has to turn
+down: a body too big for the buffer (413), headers that never end
+(431), a chunked body (501) and garbage (400).  Pipelined requests are
+sent in one go, a POST's body running straight into the next request,
+and have to be answered in order.  Connections are checked for being
+kept open or closed as HTTP/1.0, HTTP/1.1 and Connection: ask, and for
+being closed at the gap when more was pipelined than fits.  With every connection
+in use, the one idle the longest makes room for a new client, and with
+none idle the new client is turned away.
+
+The router is checked with routes that split each other's nodes, a 
+literal that is a prefix of what a parameter matches, paths that stop
+short of a route or run past it, a route with two parameters, patterns
+it has to turn down, and running out of nodes.
+
+WebserverProxy's /led/set and /led/command/{name} are checked for the
+looks they take and the ones they answer 400, changing nothing.
+
+It exits non-zero if anything doesn't hold.
+
+USAGE:
+http_test
+
+======================================================================*/
+
+#include "httpserver.h"
+#include "ledanimator.h"
+#include "recordingpixeldriver.h"
+#include "webserverproxy.h"
+
+#include <ESPAsyncTCP.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Where the servers listen
+static const uint16_t TEST_PORT = 8080;
+static const uint16_t ROUTER_PORT = 8081;
+static const uint16_t PROXY_PORT = 80;
+
+// A request to pipeline many of
+static const std::string PIPELINED_GET = "GET /echo HTTP/1.1\r\n\r\n";
+
+static int s_failures = 0;
+
+/*======================================================================
+FUNCTION:
+check()
+
+DESCRIPTION:
+Reports a result, and counts it if it failed.
+
+RETURN VALUE:
+none.
+
+======================================================================*/
+static void check( bool ok, const char *what )
+{
+    printf( "  %-58s %s\n", what, ( ok == true ) ? "ok" : "FAILED" );
+
+    s_failures += ( ok == true ) ? 0 : 1;
+}
+
+/*======================================================================
+FUNCTION:
+responses()
+
+DESCRIPTION:
+Splits what a connection was sent into responses, by their
+Content-Length.
+
+RETURN VALUE:
+The responses, headers and body, in order.
+
+======================================================================*/
+static std::vector< std::string > responses( const std::string &sent )
+{
+    std::vector< std::string > found;
+    size_t start = 0;
+
+    while ( start < sent.size() )
+    {
+        size_t end = sent.find( "\r\n\r\n", start );
+
+        if ( end == std::string::npos )
+        {
+            break;
+        }
+
+        size_t length = 0;
+        size_t header = sent.find( "Content-Length: ", start );
+
+        if ( header != std::string::npos && header < end )
+        {
+            length = strtoul( sent.c_str() + header + 16, nullptr, 10 );
+        }
+
+        end += 4 + length;
+
+        found.push_back( sent.substr( start, end - start ) );
+        start = end;
+    }
+
+    return found;
+}
+
+/*======================================================================
+FUNCTION:
+status()
+
+DESCRIPTION:
+The status code of a response.
+
+RETURN VALUE:
+The code, 0 if it doesn't have a status line.
+
+======================================================================*/
+static int status( const std::string &response )
+{
+    if ( response.compare( 0, 9, "HTTP/1.1 " ) != 0 )
+    {
+        return 0;
+    }
+
+    return atoi( response.c_str() + 9 );
+}
+
+/*======================================================================
+FUNCTION:
+body()
+
+DESCRIPTION:
+The body of a response.
+
+RETURN VALUE:
+The body.
+
+======================================================================*/
+static std::string body( const std::string &response )
+{
+    size_t end = response.find( "\r\n\r\n" );
+
+    return ( end == std::string::npos ) ? "" : response.substr( end + 4 );
+}
+
+/*======================================================================
+FUNCTION:
+closing()
+
+DESCRIPTION:
+Whether a response says the connection will be closed after it.
+
+RETURN VALUE:
+true for Connection: close.
+
+======================================================================*/
+static bool closing( const std::string &response )
+{
+    return response.find( "Connection: close\r\n" ) != std::string::npos;
+}
+
+/*======================================================================
+FUNCTION:
+pump()
+
+DESCRIPTION:
+Runs a server's Process() and acknowledges whatever connection id has
+been sent, over and over, so everything it has in hand is answered
+(and anything it means to close is closed).
+
+RETURN VALUE:
+none.
+
+======================================================================*/
+static void pump( std::function< void( void ) > process, int id )
+{
+    for ( int i = 0; i < 200; i++ )
+    {
+        process();
+        AsyncClient::HostAck( id );
+    }
+}
+
+/*======================================================================
+FUNCTION:
+exchange()
+
+DESCRIPTION:
+Sends text on a new connection to port and answers it.
+
+RETURN VALUE:
+The connection's id.
+
+======================================================================*/
+static int exchange( std::function< void( void ) > process, uint16_t port, const std::string &text )
+{
+    int id = AsyncServer::HostConnect( port );
+
+    AsyncClient::HostReceive( id, text );
+    pump( process, id );
+
+    return id;
+}
+
+/*======================================================================
+FUNCTION:
+get()
+
+DESCRIPTION:
+A GET of path, on a connection of its own that is closed after.
+
+RETURN VALUE:
+The response, "" if there wasn't exactly one.
+
+======================================================================*/
+static std::string get( HttpServer &server, uint16_t port, const std::string &path )
+{
+    int id = exchange( [&server]() { server.Process(); }, port,
+                       "GET " + path + " HTTP/1.1\r\nConnection: close\r\n\r\n" );
+
+    std::vector< std::string > answers = responses( AsyncClient::HostSent( id ) );
+
+    return ( answers.size() == 1 ) ? answers[0] : "";
+}
+
+/*======================================================================
+FUNCTION:
+closeAll()
+
+DESCRIPTION:
+Lets every connection time out, so a test starts with all of them
+free.
+
+RETURN VALUE:
+none.
+
+======================================================================*/
+static void closeAll( HttpServer &server )
+{
+    HostAdvanceMicros( ( HttpServer::KEEP_ALIVE_TIMEOUT_MS + HttpServer::REQUEST_TIMEOUT_MS ) * 1000ULL );
+    server.Process();
+}
+
+/*======================================================================
+FUNCTION:
+testSplit()
+
+DESCRIPTION:
+A POST, and a form POST, that come in a byte at a time - so the blank
+line after the headers, and the body, are split every way they can
+be.  Nothing should be answered until the last byte is in.
+
+RETURN VALUE:
+none.
+
+======================================================================*/
+static void testSplit( HttpServer &server )
+{
+    printf( "Requests a byte at a time\n" );
+
+    auto process = [&server]() { server.Process(); };
+
+    const std::string post = "POST /echo?a=1 HTTP/1.1\r\nHost: jar\r\nContent-Type: text/plain\r\n"
+                             "Content-Length: 11\r\n\r\nhello world";
+
+    int id = AsyncServer::HostConnect( TEST_PORT );
+    bool early = false;
+
+    for ( size_t i = 0; i < post.size(); i++ )
+    {
+        AsyncClient::HostReceive( id, post.substr( i, 1 ) );
+        server.Process();
+
+        early = early || ( i + 1 < post.size() && AsyncClient::HostSent( id ).empty() == false );
+    }
+
+    pump( process, id );
+
+    std::vector< std::string > answers = responses( AsyncClient::HostSent( id ) );
+
+    check( early == false, "nothing is answered before the request is in" );
+    check( answers.size() == 1 && status( answers[0] ) == 200 &&
+           body( answers[0] ) == "POST /echo body=hello world a=1",
+           "the split request, body and query string" );
+    check( AsyncClient::HostIsOpen( id ) == true, "and the connection is kept open" );
+
+    const std::string form = "POST /echo HTTP/1.1\r\nContent-Type: application/x-www-form-urlencoded\r\n"
+                             "Content-Length: 20\r\n\r\nx=1&y=two+words%21";
+
+    size_t before = responses( AsyncClient::HostSent( id ) ).size();
+
+    for ( size_t i = 0; i < form.size(); i++ )
+    {
+        AsyncClient::HostReceive( id, form.substr( i, 1 ) );
+        server.Process();
+    }
+
+    // Two short of its Content-Length, so still waiting
+    pump( process, id );
+
+    check( responses( AsyncClient::HostSent( id ) ).size() == before, "a short body is waited for" );
+
+    AsyncClient::HostReceive( id, "&z" );
+    pump( process, id );
+
+    answers = responses( AsyncClient::HostSent( id ) );
+
+    check( answers.size() == before + 1 &&
+           body( answers.back() ) == "POST /echo body=x=1&y=two+words%21&z x=1 y=two words! z=",
+           "a form body's fields are arguments, decoded" );
+
+    closeAll( server );
+}
+
+/*======================================================================
+FUNCTION:
+testTooBig()
+
+DESCRIPTION:
+Requests the server can't take: a body bigger than the buffer, headers
+that fill it without ending, and a chunked body.  Each gets its status
+and the connection is closed, since where the next request would
+start can't be told.
+
+RETURN VALUE:
+none.
+
+======================================================================*/
+static void testTooBig( HttpServer &server )
+{
+    printf( "Requests that don't fit\n" );
+
+    auto process = [&server]() { server.Process(); };
+
+    int id = exchange( process, TEST_PORT, "POST /echo HTTP/1.1\r\nContent-Length: 5000\r\n\r\nhello" );
+    std::vector< std::string > answers = responses( AsyncClient::HostSent( id ) );
+
+    check( answers.size() == 1 && status( answers[0] ) == 413 && closing( answers[0] ) == true &&
+           AsyncClient::HostIsOpen( id ) == false,
+           "a body bigger than the buffer is a 413, and closes" );
+
+    std::string longHeader = "GET /echo HTTP/1.1\r\nX-Long: " + std::string( HttpServer::REQUEST_BUFFER_SIZE, 'a' );
+
+    id = exchange( process, TEST_PORT, longHeader );
+    answers = responses( AsyncClient::HostSent( id ) );
+
+    check( answers.size() == 1 && status( answers[0] ) == 431 && closing( answers[0] ) == true &&
+           AsyncClient::HostIsOpen( id ) == false,
+           "headers that fill the buffer are a 431, and close" );
+
+    id = exchange( process, TEST_PORT, "POST /echo HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n5\r\nhello\r\n0\r\n\r\n" );
+    answers = responses( AsyncClient::HostSent( id ) );
+
+    check( answers.size() == 1 && status( answers[0] ) == 501 && closing( answers[0] ) == true &&
+           AsyncClient::HostIsOpen( id ) == false,
+           "a chunked body is a 501, and closes" );
+
+    id = exchange( process, TEST_PORT, "GET echo HTTP/1.1\r\n\r\n" );
+    answers = responses( AsyncClient::HostSent( id ) );
+
+    check( answers.size() == 1 && status( answers[0] ) == 400 && AsyncClient::HostIsOpen( id ) == false,
+           "a target that isn't a path is a 400" );
+
+    id = exchange( process, TEST_PORT, std::string( "\0GET /echo HTTP/1.1\r\n\r\n", 23 ) );
+    answers = responses( AsyncClient::HostSent( id ) );
+
+    check( answers.size() == 1 && status( answers[0] ) == 400 && AsyncClient::HostIsOpen( id ) == false,
+           "a request that starts with a nul is a 400" );
+
+    closeAll( server );
+}
+
+/*======================================================================
+FUNCTION:
+testPipelining()
+
+DESCRIPTION:
+A POST with the next request right behind its body, in one packet.
+The body is cut off with a nul while the POST is handled, and the
+byte it covers has to be put back for the GET to parse.
+
+RETURN VALUE:
+none.
+
+======================================================================*/
+static void testPipelining( HttpServer &server )
+{
+    printf( "Pipelining\n" );
+
+    auto process = [&server]() { server.Process(); };
+
+    int id = exchange( process, TEST_PORT,
+                       "POST /echo HTTP/1.1\r\nContent-Length: 5\r\n\r\nhelloGET /echo?x=1 HTTP/1.1\r\n\r\n" );
+
+    std::vector< std::string > answers = responses( AsyncClient::HostSent( id ) );
+
+    check( answers.size() == 2, "both requests are answered" );
+    check( answers.size() == 2 && status( answers[0] ) == 200 && body( answers[0] ) == "POST /echo body=hello",
+           "the POST, with its body cut off before the GET" );
+    check( answers.size() == 2 && status( answers[1] ) == 200 && body( answers[1] ) == "GET /echo body= x=1",
+           "then the GET, whole" );
+    check( AsyncClient::HostIsOpen( id ) == true, "and the connection is kept open" );
+
+    closeAll( server );
+}
+
+/*======================================================================
+FUNCTION:
+testConnectionClose()
+
+DESCRIPTION:
+Whether a connection is kept open after its answer: HTTP/1.1 unless
+it asks to close, HTTP/1.0 only if it asks to be kept alive.
+
+RETURN VALUE:
+none.
+
+======================================================================*/
+static void testConnectionClose( HttpServer &server )
+{
+    printf( "Keeping connections open\n" );
+
+    auto process = [&server]() { server.Process(); };
+
+    struct Case
+    {
+        const char *request;
+        bool keptOpen;
+        const char *what;
+    };
+
+    static const Case CASES[] =
+    {
+        { "GET /echo HTTP/1.1\r\n\r\n",                             true,   "HTTP/1.1 is kept open" },
+        { "GET /echo HTTP/1.1\r\nConnection: close\r\n\r\n",        false,  "HTTP/1.1 with Connection: close is closed" },
+        { "GET /echo HTTP/1.0\r\n\r\n",                             false,  "HTTP/1.0 is closed" },
+        { "GET /echo HTTP/1.0\r\nConnection: keep-alive\r\n\r\n",   true,   "HTTP/1.0 with Connection: keep-alive is kept open" }
+    };
+
+    for ( size_t i = 0; i < sizeof( CASES ) / sizeof( CASES[0] ); i++ )
+    {
+        int id = exchange( process, TEST_PORT, CASES[i].request );
+        std::vector< std::string > answers = responses( AsyncClient::HostSent( id ) );
+
+        check( answers.size() == 1 && status( answers[0] ) == 200 &&
+               closing( answers[0] ) == !CASES[i].keptOpen &&
+               AsyncClient::HostIsOpen( id ) == CASES[i].keptOpen,
+               CASES[i].what );
+
+        closeAll( server );
+    }
+
+    int id = exchange( process, TEST_PORT, "GET /echo HTTP/1.1\r\n\r\n" );
+
+    HostAdvanceMicros( ( HttpServer::KEEP_ALIVE_TIMEOUT_MS - 1 ) * 1000ULL );
+    server.Process();
+
+    bool open = AsyncClient::HostIsOpen( id );
+
+    HostAdvanceMicros( 2000 );
+    server.Process();
+
+    check( open == true && AsyncClient::HostIsOpen( id ) == false,
+           "an idle connection is closed after the keep-alive timeout" );
+}
+
+/*======================================================================
+FUNCTION:
+testTruncatedPipeline()
+
+DESCRIPTION:
+More pipelined requests than fit in the buffer at once.  The ones that
+fit are answered, and the connection is closed where the rest were cut
+off, rather than parsing half a request.
+
+RETURN VALUE:
+none.
+
+======================================================================*/
+static void testTruncatedPipeline( HttpServer &server )
+{
+    printf( "Pipelining more than fits\n" );
+
+    auto process = [&server]() { server.Process(); };
+
+    std::string requests;
+
+    for ( size_t i = 0; i < 50; i++ )
+    {
+        requests += PIPELINED_GET;
+    }
+
+    int id = exchange( process, TEST_PORT, requests );
+
+    std::vector< std::string > answers = responses( AsyncClient::HostSent( id ) );
+    size_t fit = HttpServer::REQUEST_BUFFER_SIZE / PIPELINED_GET.size();
+    bool allOk = true;
+
+    for ( size_t i = 0; i < answers.size(); i++ )
+    {
+        allOk = allOk && status( answers[i] ) == 200 && body( answers[i] ) == "GET /echo body=";
+    }
+
+    check( answers.size() == fit && allOk == true, "the requests that fit are answered" );
+    check( AsyncClient::HostIsOpen( id ) == false, "and the connection is closed at the gap" );
+
+    closeAll( server );
+}
+
+/*======================================================================
+FUNCTION:
+testIdleSlots()
+
+DESCRIPTION:
+A new client when every connection is taken.  The one that has been
+idle between requests the longest is closed to make room.  If they
+are all in the middle of a request, the new client is turned away.
+
+RETURN VALUE:
+none.
+
+======================================================================*/
+static void testIdleSlots( HttpServer &server )
+{
+    printf( "Connection slots\n" );
+
+    auto process = [&server]() { server.Process(); };
+
+    std::vector< int > ids;
+
+    for ( size_t i = 0; i < HttpServer::MAX_CONNECTIONS; i++ )
+    {
+        ids.push_back( exchange( process, TEST_PORT, "GET /echo HTTP/1.1\r\n\r\n" ) );
+        HostAdvanceMicros( 10000 );
+    }
+
+    // The first one is the idlest, unless it does something
+    AsyncClient::HostReceive( ids[0], "GET /echo HTTP/1.1\r\n\r\n" );
+    pump( process, ids[0] );
+
+    int newcomer = exchange( process, TEST_PORT, "GET /echo HTTP/1.1\r\n\r\n" );
+
+    check( AsyncClient::HostIsOpen( ids[1] ) == false, "the idlest connection makes room" );
+    check( AsyncClient::HostIsOpen( ids[0] ) == true && AsyncClient::HostIsOpen( ids[2] ) == true &&
+           AsyncClient::HostIsOpen( ids[3] ) == true,
+           "the others are left alone" );
+    check( AsyncClient::HostIsOpen( newcomer ) == true &&
+           responses( AsyncClient::HostSent( newcomer ) ).size() == 1,
+           "and the new client is served" );
+
+    // All of them halfway through a request
+    AsyncClient::HostReceive( ids[0], "GET /ec" );
+    AsyncClient::HostReceive( ids[2], "GET /ec" );
+    AsyncClient::HostReceive( ids[3], "GET /ec" );
+    AsyncClient::HostReceive( newcomer, "GET /ec" );
+
+    int turnedAway = AsyncServer::HostConnect( TEST_PORT );
+
+    check( AsyncClient::HostIsOpen( turnedAway ) == false, "with none idle, a new client is turned away" );
+    check( AsyncClient::HostIsOpen( ids[0] ) == true && AsyncClient::HostIsOpen( newcomer ) == true,
+           "and the busy ones are left alone" );
+
+    closeAll( server );
+}
+
+/*======================================================================
+FUNCTION:
+testRoutes()
+
+DESCRIPTION:
+Routes that share prefixes, so adding them splits nodes, with literals
+and parameters at the same place.  Each handler answers with its tag
+and the parameters it got - "nam" never should be one, so a lookup by
+a prefix of a name shows up as a wrong answer.  Then the patterns that
+have to be turned down, after which the routes still have to work.
+
+RETURN VALUE:
+none.
+
+======================================================================*/
+static void testRoutes()
+{
+    printf( "Routes\n" );
+
+    HttpServer router( ROUTER_PORT );
+
+    auto answer = [&router]( const char *tag ) -> HttpServer::Handler
+    {
+        return [&router, tag]()
+        {
+            static const char *NAMES[] = { "index", "name", "nam" };
+
+            std::string text = tag;
+
+            for ( size_t i = 0; i < sizeof( NAMES ) / sizeof( NAMES[0] ); i++ )
+            {
+                if ( router.GetPathArg( NAMES[i] ) != nullptr )
+                {
+                    text += std::string( " " ) + NAMES[i] + "=" + router.GetPathArg( NAMES[i] );
+                }
+            }
+
+            router.Send( 200, "text/plain", text.c_str() );
+        };
+    };
+
+    bool added = router.On( "/led/command/{name}", answer( "command" ) ) &&
+                 router.On( "/led/command/demo", answer( "demo" ) ) &&
+                 router.On( "/led/set", answer( "set" ) ) &&
+                 router.On( "/led/schedule", answer( "schedule" ) ) &&
+                 router.On( "/layer/{index}/color/{name}", answer( "color" ) ) &&
+                 router.On( "/layer/{index}/size", answer( "size" ) );
+
+    check( added == true, "routes that split each other's nodes are added" );
+
+    struct Rejected
+    {
+        const char *pattern;
+        const char *what;
+    };
+
+    static const Rejected REJECTED[] =
+    {
+        { "/led/set",                   "a route that is already taken" },
+        { "/led/command/{name}",        "a parameter route that is already taken" },
+        { "/led/command/{other}",       "a second name for a parameter" },
+        { "/layer/{i}/speed",           "a second name for a parameter, further in" },
+        { "led/set",                    "a pattern that isn't a path" },
+        { "/led/{}",                    "a parameter with no name" },
+        { "/led/{name",                 "a parameter that isn't closed" },
+        { "/led/x{name}",               "a parameter that starts mid segment" },
+        { "/led/{name}x",               "a parameter that ends mid segment" }
+    };
+
+    for ( size_t i = 0; i < sizeof( REJECTED ) / sizeof( REJECTED[0] ); i++ )
+    {
+        check( router.On( REJECTED[i].pattern, answer( "rejected" ) ) == false, REJECTED[i].what );
+    }
+
+    router.Begin();
+
+    struct Case
+    {
+        const char *path;
+        const char *body;
+        const char *what;
+    };
+
+    // A nullptr body is a 404
+    static const Case CASES[] =
+    {
+        { "/led/command/demo",          "demo",                     "a literal wins over a parameter" },
+        { "/led/command/%64emo",        "demo",                     "after the path is decoded" },
+        { "/led/command/demox",         "command name=demox",       "past the literal, the parameter takes it" },
+        { "/led/command/dem",           "command name=dem",         "and short of it" },
+        { "/led/command/pulse",         "command name=pulse",       "a parameter" },
+        { "/led/command/",              nullptr,                    "a parameter doesn't match nothing" },
+        { "/led/command/a/b",           nullptr,                    "or more than one segment" },
+        { "/led/command",               nullptr,                    "a path that stops short of a parameter" },
+        { "/led/set",                   "set",                      "a split node's first route" },
+        { "/led/schedule",              "schedule",                 "and the one that split it" },
+        { "/led/s",                     nullptr,                    "the split itself isn't a route" },
+        { "/led/sets",                  nullptr,                    "a path that runs past a route" },
+        { "/led/",                      nullptr,                    "a prefix of several routes" },
+        { "/layer/2/color/red",         "color index=2 name=red",   "two parameters" },
+        { "/layer/2/size",              "size index=2",             "a literal after a parameter" },
+        { "/layer/2/color/",            nullptr,                    "the second parameter missing" }
+    };
+
+    for ( size_t i = 0; i < sizeof( CASES ) / sizeof( CASES[0] ); i++ )
+    {
+        std::string response = get( router, ROUTER_PORT, CASES[i].path );
+
+        check( ( CASES[i].body == nullptr ) ? status( response ) == 404
+                                            : status( response ) == 200 && body( response ) == CASES[i].body,
+               CASES[i].what );
+    }
+
+    closeAll( router );
+}
+
+/*======================================================================
+FUNCTION:
+testRouteNodes()
+
+DESCRIPTION:
+Adds routes of three or more nodes each until the trie's nodes run
+out, which has to happen before MAX_ROUTES does.  The route that
+didn't fit is turned down, and the ones before it still match.
+
+RETURN VALUE:
+none.
+
+======================================================================*/
+static void testRouteNodes()
+{
+    printf( "Running out of route nodes\n" );
+
+    HttpServer router( ROUTER_PORT );
+
+    // The patterns aren't copied, so they are kept here
+    static char patterns[HttpServer::MAX_ROUTES][24];
+
+    size_t added = 0;
+
+    while ( added < HttpServer::MAX_ROUTES )
+    {
+        snprintf( patterns[added], sizeof( patterns[added] ), "/n%u/{p}/end", (unsigned) ( added + 10 ) );
+
+        HttpServer::Handler handler = [&router]() { router.Send( 200, "text/plain", router.GetPathArg( "p" ) ); };
+
+        if ( router.On( patterns[added], handler ) == false )
+        {
+            break;
+        }
+
+        added++;
+    }
+
+    check( added > 0 && added < HttpServer::MAX_ROUTES, "the nodes run out before the routes do" );
+
+    router.Begin();
+
+    bool allMatch = true;
+
+    for ( size_t i = 0; i < added; i++ )
+    {
+        std::string path = patterns[i];
+
+        path.replace( path.find( "{p}" ), 3, "x" );
+
+        std::string response = get( router, ROUTER_PORT, path );
+
+        allMatch = allMatch && status( response ) == 200 && body( response ) == "x";
+    }
+
+    check( allMatch == true, "the routes that fit all match" );
+
+    if ( added < HttpServer::MAX_ROUTES )
+    {
+        std::string path = patterns[added];
+
+        path.replace( path.find( "{p}" ), 3, "x" );
+
+        check( status( get( router, ROUTER_PORT, path ) ) == 404, "the one that didn't fit doesn't" );
+    }
+
+    closeAll( router );
+}
+
+/*======================================================================
+FUNCTION:
+testLooks()
+
+DESCRIPTION:
+WebserverProxy's /led/set and /led/command/{name}: the looks they take,
+and the ones that don't go together, which are a 400 and change
+nothing.
+
+RETURN VALUE:
+none.
+
+======================================================================*/
+static void testLooks( WebserverProxy &proxy, LedAnimator &animator )
+{
+    printf( "Looks\n" );
+
+    auto process = [&proxy]() { proxy.Process(); };
+
+    struct Case
+    {
+        const char *path;
+        int status;
+        const char *body;
+        const char *what;
+    };
+
+    static const Case CASES[] =
+    {
+        { "/led/set?color=ff0000",                  200,    "set",      "a color on its own" },
+        { "/led/set?animation=wheel&color=0,0,255", 200,    "wheel",    "an animation and color" },
+        { "/led/set?transition=500",                400,    nullptr,    "a transition with no animation to fade to" },
+        { "/led/set?animation=demo&color=ff0000",   400,    nullptr,    "the demo with a color" },
+        { "/led/set?color=red",                     400,    nullptr,    "a color that doesn't parse" },
+        { "/led/command/pulse?transition=100",      200,    "pulse",    "a command with a transition" },
+        { "/led/command/pulse?animation=wheel",     400,    nullptr,    "a command with an animation argument" },
+        { "/led/command/demo",                      200,    "demo",     "the demo command" },
+        { "/led/command/demox",                     404,    nullptr,    "a command for an animation we don't have" }
+    };
+
+    for ( size_t i = 0; i < sizeof( CASES ) / sizeof( CASES[0] ); i++ )
+    {
+        int id = exchange( process, PROXY_PORT, std::string( "GET " ) + CASES[i].path + " HTTP/1.1\r\n\r\n" );
+        std::vector< std::string > answers = responses( AsyncClient::HostSent( id ) );
+
+        bool changed = ( animator.IsStartPending() == true || animator.IsColorPending() == true );
+
+        // Whatever it changed is picked up before the next one
+        HostAdvanceMicros( 1000000ULL / LedAnimator::DEFAULT_FRAME_RATE );
+        animator.Process();
+
+        check( answers.size() == 1 && status( answers[0] ) == CASES[i].status &&
+               ( CASES[i].body == nullptr || body( answers[0] ) == CASES[i].body ) &&
+               changed == ( CASES[i].status == 200 ),
+               CASES[i].what );
+    }
+}
+
+int main()
+{
+    HostQuiet( true );
+
+    HttpServer server( TEST_PORT );
+
+    // Answers with the method, path, body and arguments it was given
+    server.On( "/echo", [&server]()
+    {
+        std::string text = ( server.GetMethod() == HttpServer::METHOD_POST ) ? "POST " : "GET ";
+
+        text += server.GetUri();
+        text += " body=";
+        text += ( server.GetBody() != nullptr ) ? server.GetBody() : "";
+
+        for ( size_t i = 0; i < server.GetArgCount(); i++ )
+        {
+            text += std::string( " " ) + server.GetArgName( i ) + "=" + server.GetArg( i );
+        }
+
+        server.Send( 200, "text/plain", text.c_str() );
+    } );
+
+    server.Begin();
+
+    std::shared_ptr< LedAnimator > animator =
+        std::make_shared< LedAnimator >( std::unique_ptr< PixelDriver >( new RecordingPixelDriver( 8 ) ), 8 );
+
+    WebserverProxy proxy( animator, PROXY_PORT );
+    proxy.Begin();
+
+    testSplit( server );
+    testTooBig( server );
+    testPipelining( server );
+    testConnectionClose( server );
+    testTruncatedPipeline( server );
+    testIdleSlots( server );
+    testRoutes();
+    testRouteNodes();
+    testLooks( proxy, *animator );
+
+    printf( "%s\n", ( s_failures == 0 ) ? "PASSED" : "FAILED" );
+
+    return ( s_failures == 0 ) ? 0 : 1;
+}
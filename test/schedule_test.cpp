@@ -0,0 +1,591 @@
+/*======================================================================
+FILE:
+schedule_test.cpp
+
+DESCRIPTION:
+Tests the schedule and the time zone rules it runs on.
+
+TimeZone is checked against the C library's own reading of the same
+POSIX TZ rules (glibc's localtime_r()) every quarter hour over a few
+years, for zones either side of the equator and either side of UTC,
+and then by hand around the US changes: the offsets either side of
+each one, the local times a spring forward skips and a fall back
+repeats, and rules it has to turn down.
+
+ScheduleStore is checked for its parsing and validation, the catch up
+when the clock first arrives, when it fires next (across a DST change
+too), and that the rules come back from flash.  The clock is TimeLib's
+(see host/TimeLib.h), which TimeProxy hands out until NTP has synced.
+
+It exits non-zero if anything doesn't hold.
+
+USAGE:
+schedule_test
+
+======================================================================*/
+
+#include "ledanimator.h"
+#include "recordingpixeldriver.h"
+#include "schedulestore.h"
+#include "timeproxy.h"
+#include "timezone.h"
+
+#include <LittleFS.h>
+#include <TimeLib.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <memory>
+
+static const char *US_EASTERN = "EST5EDT,M3.2.0,M11.1.0";
+
+// Rules the C library is asked about too
+static const char *ZONES[] =
+{
+    "EST5EDT,M3.2.0,M11.1.0",
+    "CET-1CEST,M3.5.0,M10.5.0/3",
+    "AEST-10AEDT,M10.1.0,M4.1.0/3",
+    "NZST-12NZDT,M9.5.0,M4.1.0/3",
+    "<+1245>-12:45<+1345>,M9.5.0/2:45,M4.1.0/3:45",
+    "<-03>3<-02>,M3.5.0/-2,M10.5.0/-1",
+    "IST-5:30",
+    "UTC0"
+};
+
+static int s_failures = 0;
+
+/*======================================================================
+FUNCTION:
+check()
+
+DESCRIPTION:
+Reports a result, and counts it if it failed.
+
+RETURN VALUE:
+none.
+
+======================================================================*/
+static void check( bool ok, const char *what )
+{
+    printf( "  %-58s %s\n", what, ( ok == true ) ? "ok" : "FAILED" );
+
+    s_failures += ( ok == true ) ? 0 : 1;
+}
+
+/*======================================================================
+FUNCTION:
+at()
+
+DESCRIPTION:
+A calendar time as a time_t, without any zone.  Given UTC this is the
+UTC time, given a local time it is the "local time_t" that ToLocal()
+and ToUTC() deal in.
+
+RETURN VALUE:
+The time.
+
+======================================================================*/
+static time_t at( int year, int month, int day, int hour, int minute )
+{
+    struct tm tm;
+
+    memset( &tm, 0, sizeof( tm ) );
+
+    tm.tm_year = year - 1900;
+    tm.tm_mon = month - 1;
+    tm.tm_mday = day;
+    tm.tm_hour = hour;
+    tm.tm_min = minute;
+
+    return timegm( &tm );
+}
+
+/*======================================================================
+FUNCTION:
+libcOffset()
+
+DESCRIPTION:
+The offset the C library works out for the rule in TZ at utc.
+
+RETURN VALUE:
+Seconds east of UTC.
+
+======================================================================*/
+static int32_t libcOffset( time_t utc )
+{
+    struct tm tm;
+
+    localtime_r( &utc, &tm );
+
+    return (int32_t) tm.tm_gmtoff;
+}
+
+/*======================================================================
+FUNCTION:
+testAgainstLibc()
+
+DESCRIPTION:
+Walks each of ZONES a quarter hour at a time from 2023 to 2027, then
+jumps around the same years, comparing our offset with the C
+library's.  The jumps make sure the cached transitions don't only
+work going forwards.
+
+RETURN VALUE:
+none.
+
+======================================================================*/
+static void testAgainstLibc()
+{
+    printf( "TimeZone against the C library\n" );
+
+    const time_t from = at( 2023, 1, 1, 0, 0 );
+    const time_t until = at( 2027, 1, 1, 0, 0 );
+
+    for ( size_t z = 0; z < sizeof( ZONES ) / sizeof( ZONES[0] ); z++ )
+    {
+        TimeZone zone;
+
+        bool set = zone.Set( ZONES[z] );
+
+        setenv( "TZ", ZONES[z], 1 );
+        tzset();
+
+        int mismatches = 0;
+
+        for ( time_t t = from; t < until && set == true; t += 900 )
+        {
+            mismatches += ( zone.GetOffset( t ) != libcOffset( t ) ) ? 1 : 0;
+        }
+
+        srand( 1 );
+
+        for ( int i = 0; i < 20000 && set == true; i++ )
+        {
+            time_t t = from + (time_t) ( ( (uint64_t) rand() * RAND_MAX + rand() ) % (uint64_t) ( until - from ) );
+
+            mismatches += ( zone.GetOffset( t ) != libcOffset( t ) ) ? 1 : 0;
+        }
+
+        char what[80];
+        snprintf( what, sizeof( what ), "%s", ZONES[z] );
+
+        check( set == true && mismatches == 0, what );
+    }
+
+    unsetenv( "TZ" );
+    tzset();
+}
+
+/*======================================================================
+FUNCTION:
+testTransitions()
+
+DESCRIPTION:
+US Eastern by hand: either side of each change, the skipped and
+repeated local times, and the rules Set() should turn down.
+
+RETURN VALUE:
+none.
+
+======================================================================*/
+static void testTransitions()
+{
+    printf( "TimeZone around the changes\n" );
+
+    TimeZone zone;
+
+    check( zone.Set( US_EASTERN ) == true, "US Eastern parses" );
+
+    // 2024-03-10 02:00 EST is 07:00 UTC
+    time_t spring = at( 2024, 3, 10, 7, 0 );
+
+    check( zone.GetOffset( spring - 1 ) == -5 * 3600 && zone.IsDST( spring - 1 ) == false,
+           "standard time up to the spring change" );
+    check( zone.GetOffset( spring ) == -4 * 3600 && zone.IsDST( spring ) == true,
+           "daylight time from the spring change" );
+    check( zone.ToLocal( spring ) == at( 2024, 3, 10, 3, 0 ),
+           "02:00 becomes 03:00" );
+
+    // 2024-11-03 02:00 EDT is 06:00 UTC
+    time_t fall = at( 2024, 11, 3, 6, 0 );
+
+    check( zone.GetOffset( fall - 1 ) == -4 * 3600 && zone.GetOffset( fall ) == -5 * 3600,
+           "back to standard time at the fall change" );
+    check( zone.ToLocal( fall ) == at( 2024, 11, 3, 1, 0 ),
+           "02:00 becomes 01:00" );
+
+    // 02:30 on the spring day never happens, 01:30 on the fall day
+    // happens twice.  Both are read as standard time.
+    check( zone.ToUTC( at( 2024, 3, 10, 2, 30 ) ) == at( 2024, 3, 10, 7, 30 ),
+           "a skipped local time reads as standard time" );
+    check( zone.ToUTC( at( 2024, 11, 3, 1, 30 ) ) == at( 2024, 11, 3, 6, 30 ),
+           "a repeated local time reads as standard time" );
+
+    int roundTrips = 0;
+
+    for ( time_t t = at( 2024, 1, 1, 0, 0 ); t < at( 2025, 1, 1, 0, 0 ); t += 600 )
+    {
+        bool repeated = ( t >= fall - 3600 && t < fall );
+
+        roundTrips += ( repeated == true || zone.ToUTC( zone.ToLocal( t ) ) == t ) ? 0 : 1;
+    }
+
+    check( roundTrips == 0, "ToUTC() undoes ToLocal() outside the repeated hour" );
+
+    check( zone.Set( "EST5EDT" ) == true && zone.GetOffset( spring ) == -4 * 3600 &&
+           zone.GetOffset( fall ) == -5 * 3600,
+           "no dates means the US ones" );
+
+    // A start date with no end date, and some other nonsense.  The
+    // zone that was there stays.
+    zone.SetFixed( 3600 );
+
+    check( zone.Set( "EST5EDT,M3.2.0" ) == false, "a start date on its own is refused" );
+    check( zone.Set( "EST5EDT,M3.2.0," ) == false, "an empty end date is refused" );
+    check( zone.Set( "EST5EDT,M13.2.0,M11.1.0" ) == false, "month 13 is refused" );
+    check( zone.Set( "EST5EDT,M3.2.0,M11.1.0,M12.1.0" ) == false, "a third date is refused" );
+    check( zone.Set( "E5" ) == false, "a short name is refused" );
+    check( zone.GetOffset( spring ) == 3600 && zone.IsDST( spring ) == false,
+           "a refused rule leaves the zone alone" );
+
+    // Just after midnight local on New Year's Day, when UTC is still
+    // in the old year.  The year the changes are worked out for comes
+    // from local time.
+    check( zone.Set( "NZST-12NZDT,M9.5.0,M4.1.0/3" ) == true &&
+           zone.GetOffset( at( 2024, 12, 31, 11, 30 ) ) == 13 * 3600 &&
+           zone.ToLocal( at( 2024, 12, 31, 11, 30 ) ) == at( 2025, 1, 1, 0, 30 ),
+           "New Zealand at New Year" );
+}
+
+/*======================================================================
+FUNCTION:
+testParsing()
+
+DESCRIPTION:
+The day and time parsing, and what Add() lets in.
+
+RETURN VALUE:
+none.
+
+======================================================================*/
+static void testParsing( std::shared_ptr< LedAnimator > animator )
+{
+    printf( "ScheduleStore parsing\n" );
+
+    uint8_t days = 0;
+
+    check( ScheduleStore::ParseDays( "all", days ) == true && days == ScheduleStore::DAYS_ALL &&
+           ScheduleStore::ParseDays( "weekdays", days ) == true && days == ScheduleStore::DAYS_WEEKDAYS &&
+           ScheduleStore::ParseDays( "weekends", days ) == true && days == ScheduleStore::DAYS_WEEKENDS,
+           "all, weekdays and weekends" );
+    check( ScheduleStore::ParseDays( "mon,wed,fri", days ) == true && days == 0x2A,
+           "a list of days" );
+    check( ScheduleStore::ParseDays( "", days ) == false &&
+           ScheduleStore::ParseDays( "mon,", days ) == false &&
+           ScheduleStore::ParseDays( "mon,xyz", days ) == false &&
+           ScheduleStore::ParseDays( "monday", days ) == false,
+           "bad day lists are refused" );
+
+    char text[32];
+    ScheduleStore::FormatDays( 0x2A, text, sizeof( text ) );
+
+    check( strcmp( text, "mon,wed,fri" ) == 0, "days format back the same" );
+
+    uint8_t hour = 0;
+    uint8_t minute = 0;
+
+    check( ScheduleStore::ParseTime( "07:05", hour, minute ) == true && hour == 7 && minute == 5 &&
+           ScheduleStore::ParseTime( "23:59", hour, minute ) == true && hour == 23 && minute == 59,
+           "times" );
+    check( ScheduleStore::ParseTime( "24:00", hour, minute ) == false &&
+           ScheduleStore::ParseTime( "12:60", hour, minute ) == false &&
+           ScheduleStore::ParseTime( "12", hour, minute ) == false &&
+           ScheduleStore::ParseTime( "12:30pm", hour, minute ) == false &&
+           ScheduleStore::ParseTime( ":30", hour, minute ) == false,
+           "bad times are refused" );
+
+    ScheduleStore schedule( animator, "/parsing.bin" );
+    schedule.Begin();
+
+    ScheduleStore::Rule rule = { ScheduleStore::DAYS_ALL, 7, 0, 0xFF0000, "wheel" };
+
+    ScheduleStore::Rule noDays = rule;
+    noDays.days = 0;
+    ScheduleStore::Rule badDays = rule;
+    badDays.days = 0x80;
+    ScheduleStore::Rule badHour = rule;
+    badHour.hour = 24;
+    ScheduleStore::Rule badMinute = rule;
+    badMinute.minute = 60;
+
+    check( schedule.Add( noDays ) == false && schedule.Add( badDays ) == false &&
+           schedule.Add( badHour ) == false && schedule.Add( badMinute ) == false &&
+           schedule.GetCount() == 0,
+           "rules that make no sense are refused" );
+
+    size_t added = 0;
+
+    while ( schedule.Add( rule ) == true )
+    {
+        added++;
+    }
+
+    check( added == ScheduleStore::MAX_RULES, "the schedule fills up at MAX_RULES" );
+}
+
+/*======================================================================
+FUNCTION:
+fired()
+
+DESCRIPTION:
+Whether the schedule started something on its last Process(), and
+runs the animator for a frame to pick it up, so the next one can be
+seen too.
+
+RETURN VALUE:
+true if a rule fired.
+
+======================================================================*/
+static bool fired( LedAnimator &animator )
+{
+    bool started = animator.IsStartPending();
+
+    HostAdvanceMicros( 1000000ULL / LedAnimator::DEFAULT_FRAME_RATE );
+    animator.Process();
+
+    return started;
+}
+
+/*======================================================================
+FUNCTION:
+testFiring()
+
+DESCRIPTION:
+Catching up when the clock first arrives, when the next rule fires,
+and firing it - including across the spring and fall changes.
+
+RETURN VALUE:
+none.
+
+======================================================================*/
+static void testFiring( std::shared_ptr< LedAnimator > animator )
+{
+    printf( "ScheduleStore firing\n" );
+
+    TimeProxy timeProxy( "10.0.0.1" );
+    timeProxy.SetTimezone( US_EASTERN );
+
+    ScheduleStore schedule( animator, "/firing.bin" );
+    schedule.Begin();
+
+    ScheduleStore::Rule morning = { ScheduleStore::DAYS_WEEKDAYS, 7, 0, 0xFF0000, "wheel" };
+    ScheduleStore::Rule weekend = { ScheduleStore::DAYS_WEEKENDS, 9, 30, 0x00FF00, "pulse" };
+    ScheduleStore::Rule night = { ScheduleStore::DAYS_ALL, 22, 0, 0x0000FF, "flicker" };
+
+    schedule.Add( morning );
+    schedule.Add( weekend );
+    schedule.Add( night );
+
+    check( schedule.GetNextFireTime() == 0, "nothing is scheduled before there is a time" );
+
+    // Wednesday 2024-06-12, 12:00 EDT.  The morning rule is the last
+    // one that should have fired.
+    setTime( at( 2024, 6, 12, 16, 0 ) );
+    schedule.Process( timeProxy );
+
+    check( fired( *animator ) == true && strcmp( animator->GetAnimationName(), "wheel" ) == 0 &&
+           animator->GetColor() == 0xFF0000,
+           "catches up on the morning rule" );
+    check( schedule.GetNextFireTime() == at( 2024, 6, 13, 2, 0 ),
+           "next is 22:00 EDT" );
+
+    schedule.Process( timeProxy );
+
+    check( fired( *animator ) == false, "and doesn't fire again" );
+
+    // The clock arriving on a Sunday afternoon catches up on the
+    // weekend rule, from the start of a new schedule
+    ScheduleStore sunday( animator, "/firing.bin" );
+    sunday.Begin();
+
+    setTime( at( 2024, 6, 16, 18, 0 ) );
+    sunday.Process( timeProxy );
+
+    check( fired( *animator ) == true && strcmp( animator->GetAnimationName(), "pulse" ) == 0,
+           "catches up on Sunday's rule" );
+
+    // Back to Wednesday, a minute at a time up to and past 22:00
+    setTime( at( 2024, 6, 13, 1, 58 ) );
+    schedule.Process( timeProxy );
+
+    check( schedule.GetNextFireTime() == at( 2024, 6, 13, 2, 0 ),
+           "the clock going back is noticed" );
+
+    int fires = 0;
+
+    for ( int i = 0; i < 4; i++ )
+    {
+        schedule.Process( timeProxy );
+        fires += fired( *animator ) ? 1 : 0;
+
+        HostAdvanceMicros( 60 * 1000000ULL );
+    }
+
+    check( fires == 1 && strcmp( animator->GetAnimationName(), "flicker" ) == 0,
+           "the night rule fires once at 22:00" );
+    check( schedule.GetNextFireTime() == at( 2024, 6, 13, 11, 0 ),
+           "then the morning rule is next" );
+
+    // Adding a rule that comes sooner moves the next fire time up
+    ScheduleStore::Rule early = { ScheduleStore::DAYS_ALL, 0, 30, 0xFFFFFF, "strobe" };
+    schedule.Add( early );
+    schedule.Process( timeProxy );
+
+    check( schedule.GetNextFireTime() == at( 2024, 6, 13, 4, 30 ),
+           "an added rule is taken into account" );
+
+    // A rule in the hour the spring forward skips fires once, at the
+    // standard time reading.  One in the hour the fall back repeats
+    // fires once too.
+    ScheduleStore changes( animator, "/changes.bin" );
+    changes.Begin();
+
+    ScheduleStore::Rule skipped = { ScheduleStore::DAYS_ALL, 2, 30, 0x010101, "wheel" };
+    ScheduleStore::Rule repeated = { ScheduleStore::DAYS_ALL, 1, 30, 0x020202, "pulse" };
+
+    changes.Add( skipped );
+
+    setTime( at( 2024, 3, 10, 5, 0 ) );
+    changes.Process( timeProxy );
+    fired( *animator );
+
+    check( changes.GetNextFireTime() == at( 2024, 3, 10, 7, 30 ),
+           "02:30 on the spring day fires at 03:30 EDT" );
+
+    fires = 0;
+
+    for ( int i = 0; i < 6 * 60; i++ )
+    {
+        changes.Process( timeProxy );
+        fires += fired( *animator ) ? 1 : 0;
+
+        HostAdvanceMicros( 60 * 1000000ULL );
+    }
+
+    check( fires == 1, "and only once" );
+
+    changes.Clear();
+    changes.Add( repeated );
+
+    setTime( at( 2024, 11, 3, 4, 0 ) );
+    changes.Process( timeProxy );
+    fired( *animator );
+
+    fires = 0;
+    time_t firstFire = 0;
+
+    for ( int i = 0; i < 6 * 60; i++ )
+    {
+        changes.Process( timeProxy );
+
+        if ( fired( *animator ) == true )
+        {
+            fires++;
+            firstFire = ( firstFire == 0 ) ? now() : firstFire;
+        }
+
+        HostAdvanceMicros( 60 * 1000000ULL );
+    }
+
+    check( fires == 1 && firstFire >= at( 2024, 11, 3, 6, 30 ) && firstFire < at( 2024, 11, 3, 6, 31 ),
+           "01:30 on the fall day fires once, at 01:30 EST" );
+}
+
+/*======================================================================
+FUNCTION:
+testPersistence()
+
+DESCRIPTION:
+The rules come back in a schedule constructed again, and a damaged
+file is ignored.
+
+RETURN VALUE:
+none.
+
+======================================================================*/
+static void testPersistence( std::shared_ptr< LedAnimator > animator )
+{
+    printf( "ScheduleStore on flash\n" );
+
+    {
+        ScheduleStore schedule( animator, "/saved.bin" );
+
+        check( schedule.Begin() == false, "nothing saved to start with" );
+
+        ScheduleStore::Rule first = { ScheduleStore::DAYS_WEEKDAYS, 6, 45, 0x123456, "wheel" };
+        ScheduleStore::Rule second = { 0x14, 20, 15, 0x654321, "demo" };
+        ScheduleStore::Rule third = { ScheduleStore::DAYS_ALL, 23, 0, 0, "off" };
+
+        schedule.Add( first );
+        schedule.Add( second );
+        schedule.Add( third );
+        schedule.Remove( 0 );
+    }
+
+    ScheduleStore schedule( animator, "/saved.bin" );
+
+    check( schedule.Begin() == true && schedule.GetCount() == 2, "the rules are read back" );
+
+    const ScheduleStore::Rule &rule = schedule.Get( 0 );
+
+    check( rule.days == 0x14 && rule.hour == 20 && rule.minute == 15 &&
+           rule.color == 0x654321 && strcmp( rule.animation, "demo" ) == 0 &&
+           strcmp( schedule.Get( 1 ).animation, "off" ) == 0,
+           "as they were, less the removed one" );
+    check( LittleFS.exists( "/saved.bin.tmp" ) == false, "no temporary file is left behind" );
+
+    schedule.Clear();
+
+    ScheduleStore cleared( animator, "/saved.bin" );
+
+    check( cleared.Begin() == false && cleared.GetCount() == 0, "a clear is saved too" );
+
+    // Flip a byte in the middle of a saved schedule
+    schedule.Add( rule );
+
+    File file = LittleFS.open( "/saved.bin", "r" );
+    std::string contents( file.size(), 0 );
+    file.read( (uint8_t *) &contents[0], contents.size() );
+    file.close();
+
+    contents[contents.size() / 2] ^= 0x40;
+
+    file = LittleFS.open( "/saved.bin", "w" );
+    file.write( (const uint8_t *) contents.data(), contents.size() );
+    file.close();
+
+    ScheduleStore damaged( animator, "/saved.bin" );
+
+    check( damaged.Begin() == false && damaged.GetCount() == 0, "a damaged file is ignored" );
+}
+
+int main()
+{
+    HostQuiet( true );
+
+    std::shared_ptr< LedAnimator > animator =
+        std::make_shared< LedAnimator >( std::unique_ptr< PixelDriver >( new RecordingPixelDriver( 8 ) ), 8 );
+
+    testAgainstLibc();
+    testTransitions();
+    testParsing( animator );
+    testFiring( animator );
+    testPersistence( animator );
+
+    printf( "%s\n", ( s_failures == 0 ) ? "PASSED" : "FAILED" );
+
+    return ( s_failures == 0 ) ? 0 : 1;
+}
@@ -0,0 +1,424 @@
+/*======================================================================
+FILE:
+sync_sim.cpp
+
+DESCRIPTION:
+Simulation: a group of jars kept in step by SyncProxy, all in one 
+process on a simulated network (see host/WiFiUdp.h).
+
+Each jar has its own LedAnimator, RecordingPixelDriver and SyncProxy,
+and its own idea of the shared clock - the true time plus a fixed 
+error, like NTP leaves it.  Jars boot at different times, one gets its
+clock late, and commands go to different jars along the way.  Along
+the way it checks:
+
+    - every jar settles on the same start time, so its phase error 
+      is exactly its clock error relative to the others
+    - a jar that joins late, or hears of a command, snaps into step
+      within a beacon interval
+    - a recolor reaches every jar, and two at once settle on one
+    - with perfect clocks, every jar shows the same pixels on every 
+      frame once the joining crossfade is done
+    - nothing goes out per frame
+    - all of that still holds with packets going missing
+
+It exits non-zero if any of that doesn't hold.
+
+USAGE:
+sync_sim
+
+======================================================================*/
+
+#include "ledanimator.h"
+#include "recordingpixeldriver.h"
+#include "syncproxy.h"
+
+#include <ESP8266WiFi.h>
+#include <WiFiUdp.h>
+
+#include <memory>
+#include <vector>
+
+// The shared clock is unix time in microseconds, this is the start
+static const uint64_t EPOCH_US = 1700000000ULL * 1000000ULL;
+
+static const uint32_t PIXELS = 16;
+
+static const uint64_t FRAME_US = 1000000ULL / LedAnimator::DEFAULT_FRAME_RATE;
+
+static const uint64_t RUN_US = 60 * 1000000ULL;
+
+// How long a jar has to fall into step with a change
+static const uint64_t SETTLE_US = ( SyncProxy::BEACON_INTERVAL_MS + 100 ) * 1000ULL;
+
+// Long enough for the joining crossfade to be over
+static const uint64_t CROSSFADE_US = ( LedAnimator::DEFAULT_TRANSITION_MS + 100 ) * 1000ULL;
+
+struct Jar
+{
+    const char *name;
+    IPAddress address;
+
+    // When it boots, when its clock comes good, and how far off the
+    // clock is
+    uint64_t bootUS;
+    uint64_t clockUS;
+    int64_t clockErrorUS;
+
+    bool running;
+    RecordingPixelDriver *driver;
+    std::shared_ptr<LedAnimator> animator;
+    std::unique_ptr<SyncProxy> sync;
+};
+
+// Simulated time since the run started
+static uint64_t s_nowUS = 0;
+
+static int s_failures = 0;
+
+/*======================================================================
+FUNCTION:
+check()
+
+DESCRIPTION:
+Reports a result, and counts it if it failed.
+
+RETURN VALUE:
+none.
+
+======================================================================*/
+static void check( bool ok, const char *what )
+{
+    printf( "  %-58s %s\n", what, ( ok == true ) ? "ok" : "FAILED" );
+
+    s_failures += ( ok == true ) ? 0 : 1;
+}
+
+/*======================================================================
+FUNCTION:
+boot()
+
+DESCRIPTION:
+Powers a jar up: its animator (on the default animation), and its 
+sync proxy.  The clock isn't there until clockUS.
+
+RETURN VALUE:
+none.
+
+======================================================================*/
+static void boot( Jar &jar )
+{
+    jar.driver = new RecordingPixelDriver( PIXELS );
+    jar.animator = std::make_shared<LedAnimator>( std::unique_ptr<PixelDriver>( jar.driver ), PIXELS );
+
+    Jar *self = &jar;
+
+    jar.animator->SetClock( [self]() -> uint64_t
+    {
+        if ( s_nowUS < self->clockUS )
+        {
+            return 0;
+        }
+        return EPOCH_US + s_nowUS + self->clockErrorUS;
+    } );
+
+    WiFi.HostSetLocalIP( jar.address );
+
+    jar.sync.reset( new SyncProxy( jar.animator ) );
+    jar.sync->Begin();
+
+    jar.running = true;
+}
+
+/*======================================================================
+FUNCTION:
+step()
+
+DESCRIPTION:
+Runs every jar that is up for one frame, and moves time on.
+
+RETURN VALUE:
+none.
+
+======================================================================*/
+static void step( std::vector< Jar > &jars )
+{
+    for ( size_t i = 0; i < jars.size(); i++ )
+    {
+        if ( jars[i].running == false && s_nowUS >= jars[i].bootUS )
+        {
+            boot( jars[i] );
+        }
+
+        if ( jars[i].running == true )
+        {
+            WiFi.HostSetLocalIP( jars[i].address );
+
+            jars[i].sync->Process();
+            jars[i].animator->Process();
+        }
+    }
+
+    s_nowUS += FRAME_US;
+    HostAdvanceMicros( FRAME_US );
+}
+
+/*======================================================================
+FUNCTION:
+inStep()
+
+DESCRIPTION:
+Checks whether every jar is running off the same start time, in the
+same color, as the first.
+
+RETURN VALUE:
+true if they all are.
+
+======================================================================*/
+static bool inStep( const std::vector< Jar > &jars )
+{
+    for ( size_t i = 0; i < jars.size(); i++ )
+    {
+        if ( jars[i].running == false || 
+             jars[i].animator->IsSynced() == false ||
+             jars[i].animator->GetStartTime() != jars[0].animator->GetStartTime() ||
+             jars[i].animator->GetColor() != jars[0].animator->GetColor() ||
+             strcmp( jars[i].animator->GetAnimationName(), jars[0].animator->GetAnimationName() ) != 0 )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*======================================================================
+FUNCTION:
+phaseResidualUS()
+
+DESCRIPTION:
+How far each jar's phase (its clock less its start time) is from the
+first jar's, once their clock errors are taken out.
+
+RETURN VALUE:
+The worst of them, in microseconds.
+
+======================================================================*/
+static int64_t phaseResidualUS( const std::vector< Jar > &jars )
+{
+    int64_t reference = (int64_t) ( EPOCH_US + s_nowUS + jars[0].clockErrorUS - jars[0].animator->GetStartTime() );
+    int64_t worst = 0;
+
+    for ( size_t i = 1; i < jars.size(); i++ )
+    {
+        int64_t phase = (int64_t) ( EPOCH_US + s_nowUS + jars[i].clockErrorUS - jars[i].animator->GetStartTime() );
+        int64_t residual = ( phase - reference ) - ( jars[i].clockErrorUS - jars[0].clockErrorUS );
+
+        residual = ( residual < 0 ) ? -residual : residual;
+        worst = ( residual > worst ) ? residual : worst;
+    }
+    return worst;
+}
+
+/*======================================================================
+FUNCTION:
+samePixels()
+
+DESCRIPTION:
+Compares the last frame every jar showed.
+
+RETURN VALUE:
+true if they are all the same.
+
+======================================================================*/
+static bool samePixels( const std::vector< Jar > &jars )
+{
+    for ( size_t i = 1; i < jars.size(); i++ )
+    {
+        for ( uint32_t p = 0; p < PIXELS; p++ )
+        {
+            if ( jars[i].driver->GetPixel( p ) != jars[0].driver->GetPixel( p ) )
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/*======================================================================
+FUNCTION:
+run()
+
+DESCRIPTION:
+Runs the scenario with the given clock errors, checking as it goes.
+
+    0s      jar a boots
+    0.5s    jar b boots
+    1s      a is told to play the wheel
+    6.7s    jar c boots, late
+    10.3s   jar d boots, but only gets its clock at 12.3s
+    20s     b is told to run the demo
+    45s     c is told to flicker
+    50s     a is recolored (no restart)
+    55s     b and d are recolored on the same frame
+
+RETURN VALUE:
+none.
+
+======================================================================*/
+static void run( const int64_t clockErrorUS[4], bool comparePixels )
+{
+    s_nowUS = 0;
+
+    std::vector< Jar > jars( 4 );
+
+    const char *names[] = { "a", "b", "c", "d" };
+    const uint64_t bootUS[] = { 0, 500000, 6700000, 10300000 };
+    const uint64_t clockUS[] = { 0, 500000, 6700000, 12300000 };
+
+    for ( size_t i = 0; i < jars.size(); i++ )
+    {
+        jars[i].name = names[i];
+        jars[i].address = IPAddress( 192, 168, 1, 10 + i );
+        jars[i].bootUS = bootUS[i];
+        jars[i].clockUS = clockUS[i];
+        jars[i].clockErrorUS = clockErrorUS[i];
+        jars[i].running = false;
+    }
+
+    printf( "clock errors (us): a %+lld, b %+lld, c %+lld, d %+lld\n", 
+            (long long) clockErrorUS[0], (long long) clockErrorUS[1], 
+            (long long) clockErrorUS[2], (long long) clockErrorUS[3] );
+
+    uint32_t packetsAtStart = WiFiUDP::HostPacketsSent();
+
+    // When the last change was made, and when everyone was last 
+    // seen in step after it
+    uint64_t changeUS = 0;
+    bool settled = false;
+    uint64_t worstSettleUS = 0;
+
+    int64_t worstResidualUS = 0;
+    uint32_t comparedFrames = 0;
+    uint32_t differentFrames = 0;
+    uint64_t inStepSinceUS = 0;
+    bool blueEverywhere = false;
+
+    while ( s_nowUS < RUN_US )
+    {
+        // The commands, each as a web request to one jar would 
+        // make it
+        if ( s_nowUS == 1000000 )
+        {
+            jars[0].animator->Start( "wheel", LedAnimator::Color( 255, 0, 0 ), 500 );
+        }
+        else if ( s_nowUS == 20000000 )
+        {
+            jars[1].animator->DemoAt( 500, 0 );
+        }
+        else if ( s_nowUS == 45000000 )
+        {
+            jars[2].animator->Start( "flicker", LedAnimator::Color( 255, 120, 0 ), 500 );
+        }
+        else if ( s_nowUS == 50000000 )
+        {
+            jars[0].animator->QueueColor( LedAnimator::Color( 0, 0, 255 ) );
+        }
+        else if ( s_nowUS == 54000000 )
+        {
+            blueEverywhere = inStep( jars ) && jars[3].animator->GetColor() == LedAnimator::Color( 0, 0, 255 );
+        }
+        else if ( s_nowUS == 55000000 )
+        {
+            jars[1].animator->QueueColor( LedAnimator::Color( 0, 255, 0 ) );
+            jars[3].animator->QueueColor( LedAnimator::Color( 255, 0, 255 ) );
+        }
+
+        bool event = ( s_nowUS == 1000000 || s_nowUS == 20000000 || s_nowUS == 45000000 || 
+                       s_nowUS == 50000000 || s_nowUS == 55000000 );
+
+        for ( size_t i = 0; i < jars.size(); i++ )
+        {
+            event = event || ( s_nowUS == jars[i].bootUS ) || ( s_nowUS == jars[i].clockUS );
+        }
+
+        if ( event == true )
+        {
+            changeUS = s_nowUS;
+            settled = false;
+        }
+
+        step( jars );
+
+        if ( inStep( jars ) == false )
+        {
+            inStepSinceUS = 0;
+            continue;
+        }
+
+        if ( inStepSinceUS == 0 )
+        {
+            inStepSinceUS = s_nowUS;
+        }
+
+        if ( settled == false )
+        {
+            settled = true;
+            worstSettleUS = ( s_nowUS - changeUS > worstSettleUS ) ? s_nowUS - changeUS : worstSettleUS;
+        }
+
+        int64_t residual = phaseResidualUS( jars );
+        worstResidualUS = ( residual > worstResidualUS ) ? residual : worstResidualUS;
+
+        if ( comparePixels == true && s_nowUS - inStepSinceUS >= CROSSFADE_US )
+        {
+            comparedFrames++;
+            differentFrames += ( samePixels( jars ) == true ) ? 0 : 1;
+        }
+    }
+
+    uint32_t packets = WiFiUDP::HostPacketsSent() - packetsAtStart;
+    uint32_t frames = (uint32_t) ( RUN_US / FRAME_US );
+
+    printf( "  in step within %llums of every change, %u packets over %u frames\n", 
+            (unsigned long long) ( worstSettleUS / 1000 ), packets, frames );
+
+    check( inStep( jars ) == true, "all jars end up on the same run" );
+    check( worstResidualUS == 0, "phase error is exactly the clock error" );
+    check( worstSettleUS <= SETTLE_US, "joins and commands reach everyone within a beacon" );
+    check( packets < frames / 10, "nothing goes out per frame" );
+
+    check( blueEverywhere == true, "the recolor reached every jar" );
+    uint32_t finalColor = jars[0].animator->GetColor();
+
+    check( inStep( jars ) == true && 
+           ( finalColor == LedAnimator::Color( 0, 255, 0 ) || finalColor == LedAnimator::Color( 255, 0, 255 ) ), 
+           "two recolors at once settle on one of them" );
+
+    if ( comparePixels == true )
+    {
+        printf( "  %u of %u settled frames differed between jars\n", differentFrames, comparedFrames );
+        check( comparedFrames > 0 && differentFrames == 0, "with perfect clocks every jar shows the same frame" );
+    }
+
+    printf( "\n" );
+}
+
+int main()
+{
+    HostQuiet( true );
+
+    const int64_t ntpErrors[] = { 0, 1500, -2000, 3000 };
+    const int64_t perfect[] = { 0, 0, 0, 0 };
+
+    run( ntpErrors, false );
+    run( perfect, true );
+
+    printf( "losing every third packet, " );
+    WiFiUDP::HostDropEvery( 3 );
+    run( ntpErrors, false );
+
+    printf( ( s_failures == 0 ) ? "sync simulation passed\n" : "sync simulation FAILED\n" );
+
+    return ( s_failures == 0 ) ? 0 : 1;
+}
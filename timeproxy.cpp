@@ -54,6 +54,11 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <ESP8266WiFi.h>
 #include <WiFiUdp.h>
 
+#include <strings.h>
+
+// Asynchronous DNS lookups
+#include <lwip/dns.h>
+
 
 //----------------------------------------------------------------------
 // Type Declarations
@@ -68,6 +73,30 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 // NTP time is in the first 48 bytes of message
 const int NTP_PACKET_SIZE = 48; 
 
+// NTP requests are to port 123
+const int NTP_PORT = 123;
+
+// Seconds between the NTP epoch (1900) and the unix one (1970)
+const unsigned long NTP_UNIX_OFFSET = 2208988800UL;
+
+// NTP seconds wrap every 2^32 seconds (an era).  Era 1 starts in 2036.
+const int64_t NTP_ERA_SECONDS = 0x100000000LL;
+
+// Timestamps below this are taken to be in era 1 - it is early 1968 
+// in era 0, long before anything we'll ever be told
+const uint32_t NTP_ERA_PIVOT = 0x80000000UL;
+
+// Where the timestamps are in a packet
+const int NTP_ORIGINATE_OFFSET = 24;
+const int NTP_RECEIVE_OFFSET = 32;
+const int NTP_TRANSMIT_OFFSET = 40;
+
+// Keep the clock's line short so the rate math can't overflow
+const uint64_t REANCHOR_INTERVAL_US = 3600000000ULL;
+
+// How much of each frequency estimate we take
+const int32_t FREQUENCY_GAIN = 2;
+
 //----------------------------------------------------------------------
 // Global Data Definitions
 //----------------------------------------------------------------------
@@ -78,14 +107,6 @@ const int NTP_PACKET_SIZE = 48;
 // Static Variable Definitions 
 //----------------------------------------------------------------------
 
-WiFiUDP TimeProxy::_udp;
-
-String TimeProxy::_ntpServer;
-
-// We haven't built functionality to reference back to 
-// UTC yet, so we need to start at UTC time for now.
-int TimeProxy::_timezone = TimeProxy::TimeZones::UTC;
-
 // NTP Servers:
 //static const char ntpServerName[] = "us.pool.ntp.org";
 //static const char ntpServerName[] = "time.nist.gov";
@@ -97,7 +118,8 @@ int TimeProxy::_timezone = TimeProxy::TimeZones::UTC;
 // Function Prototypes
 //----------------------------------------------------------------------
 
-// None.
+static int64_t readTimestamp( const uint8_t *buffer );
+static void writeTimestamp( uint8_t *buffer, int64_t timeUS );
 
 //----------------------------------------------------------------------
 // Required Libraries
@@ -125,9 +147,60 @@ none
 
 ======================================================================*/
 TimeProxy::TimeProxy( const String &ntpServer, unsigned int syncIntervalS )
-    :_syncIntervalS( syncIntervalS )
+    : _serverCount( 0 ),
+      _serverIndex( 0 ),
+      _failedServers( 0 ),
+      _syncIntervalS( syncIntervalS ),
+      _state( SYNC_IDLE ),
+      _stateStartMS( 0 ),
+      _synced( false ),
+      _lastSyncMS( 0 ),
+      _nextSyncMS( 0 ),
+      _serverAddressValid( false ),
+      _serverAddressMS( 0 ),
+      _anchorLocalUS( 0 ),
+      _anchorTimeUS( 0 ),
+      _frequencyPPB( 0 ),
+      _slewPPB( 0 ),
+      _slewDurationUS( 0 ),
+      _lastDisciplineLocalUS( 0 ),
+      _requestTimeUS( 0 ),
+      _samples( 0 ),
+      _bestOffsetUS( 0 ),
+      _bestDelayUS( 0 ),
+      _offsetUS( 0 ),
+      _delayUS( 0 ),
+      _resolveDone( false ),
+      _resolvedAddress( 0 )
 {
-    _ntpServer = ntpServer;
+    AddServer( ntpServer );
+}
+
+/*======================================================================
+FUNCTION:
+AddServer()
+
+DESCRIPTION:
+Adds a server to the list.  Servers are tried in the order they were
+added; if one doesn't answer we move on to the next.
+
+RETURN VALUE:
+true if added, false if the list is full.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+bool TimeProxy::AddServer( const String &ntpServer )
+{
+    if ( _serverCount >= MAX_SERVERS )
+    {
+        return false;
+    }
+
+    _ntpServers[_serverCount++] = ntpServer;
+
+    return true;
 }
 
 /*======================================================================
@@ -135,8 +208,9 @@ FUNCTION:
 Begin()
 
 DESCRIPTION:
-Starts the udp subsystem and sets the callback handlers needed by
-the TimeLib routines
+Starts the udp subsystem.  The first sync starts on the next call to
+Process().
+
 RETURN VALUE:
 none.
 
@@ -151,129 +225,220 @@ void TimeProxy::Begin()
         Serial.printf( "starting udp on port %d failed\n", _localport );
     }
 
-    setSyncProvider( &TimeProxy::getNtpTime );
-    setSyncInterval( _syncIntervalS );
+    // We set the time ourselves when a reply comes in, TimeLib 
+    // calling out to us (and waiting) is what we are avoiding
+    setSyncProvider( nullptr );
+
+    _nextSyncMS = millis();
+
+    reanchor( micros64() );
 }
 
 /*======================================================================
 FUNCTION:
-GetCurrentTimeUTC()
+Process()
 
 DESCRIPTION:
-Returns the current time relative to UTC in a c-style time_t dude
+Runs the sync state machine.  Each state either moves on right away or
+returns; nothing in here waits on the network.
 
 RETURN VALUE:
-UTC offset time_t value 
+none.
 
 SIDE EFFECTS:
 none
 
 ======================================================================*/
-time_t TimeProxy::GetCurrentTimeUTC()
+void TimeProxy::Process()
 {
-    // TODO - handle fixups in case we are not using a UTC referenced 
-    // timezone
-    return now();
+    unsigned long elapsed = millis() - _stateStartMS;
+
+    switch ( _state )
+    {
+        case SYNC_IDLE:
+
+            if ( micros64() - _anchorLocalUS >= REANCHOR_INTERVAL_US )
+            {
+                reanchor( micros64() );
+            }
+
+            // Signed math so this is right across the millis() wrap
+            if ( (long) ( millis() - _nextSyncMS ) >= 0 )
+            {
+                startSync();
+            }
+            break;
+
+        case SYNC_RESOLVING:
+
+            if ( _resolveDone == true )
+            {
+                if ( _resolvedAddress != 0 )
+                {
+                    _serverAddress = IPAddress( _resolvedAddress );
+                    _serverAddressValid = true;
+                    _serverAddressMS = millis();
+
+                    sendRequest();
+                }
+                else
+                {
+                    Serial.printf( "NTP: couldn't resolve %s\n", _ntpServers[_serverIndex].c_str() );
+                    serverFailed();
+                }
+            }
+            else if ( elapsed >= RESOLVE_TIMEOUT_MS )
+            {
+                Serial.printf( "NTP: timed out resolving %s\n", _ntpServers[_serverIndex].c_str() );
+                serverFailed();
+            }
+            break;
+
+        case SYNC_WAITING:
+
+            if ( readReply() == true && ++_samples < SAMPLES_PER_SYNC )
+            {
+                // Go again, the next one may have a shorter trip
+                sendRequest();
+            }
+            else if ( _samples >= SAMPLES_PER_SYNC || 
+                      ( _samples > 0 && elapsed >= REPLY_TIMEOUT_MS ) )
+            {
+                // Use the best we have
+                discipline( _bestOffsetUS, micros64() );
+
+                _delayUS = _bestDelayUS;
+                _synced = true;
+                _lastSyncMS = millis();
+                _failedServers = 0;
+                _nextSyncMS = _lastSyncMS + _syncIntervalS * 1000UL;
+
+                // For the TimeLib users.  TimeLib keeps UTC, see 
+                // ToLocal() for local time.
+                setTime( (time_t) ( GetTimeMicros() / 1000000ULL ) );
+
+                changeState( SYNC_IDLE );
+            }
+            else if ( elapsed >= REPLY_TIMEOUT_MS )
+            {
+                Serial.printf( "NTP: no response from %s\n", _ntpServers[_serverIndex].c_str() );
+                serverFailed();
+            }
+            break;
+    }
 }
 
 /*======================================================================
 FUNCTION:
-GetTimeStringUTC()
+startSync()
 
 DESCRIPTION:
-Returns an ISO 8601 date/time string relative to UTC time.
-https://en.wikipedia.org/wiki/ISO_8601
-Example time string: 2017-11-10T01:28:49Z
+Starts a sync with the current server, looking its address up first 
+if we don't have it or it is too old.
 
 RETURN VALUE:
-ISO 8601 date/time string
+none.
 
 SIDE EFFECTS:
 none
 
 ======================================================================*/
-String TimeProxy::GetTimeStringUTC()
+void TimeProxy::startSync()
 {
-    time_t t = GetCurrentTimeUTC();
-
-    const int BUF_SIZE = 30;
-    char buffer[BUF_SIZE + 1] = { 0 };
-
-    // TODO - handle fixups in case we are not using a UTC referenced 
-    // timezone
-    snprintf( buffer, BUF_SIZE, "%d-%02d-%02dT%02d:%02d:%02dZ",
-              year( t ),
-              month( t ),
-              day( t ),
-              hour( t ),
-              minute( t ),
-              second( t )
-    );
+    _samples = 0;
 
-    // Note - a String object will implicitly be
-    // constructed and returned
-    return buffer;
+    if ( _serverAddressValid == true && millis() - _serverAddressMS < ADDRESS_TTL_MS )
+    {
+        sendRequest();
+    }
+    else
+    {
+        startResolve();
+    }
 }
 
 /*======================================================================
 FUNCTION:
-getNtpTime()
+startResolve()
 
 DESCRIPTION:
-This is the callback handler that is called from the TimeLib
-routines.  This calls out to the NTP server and returns the 
-time_t value used by the TimeLib routines to manage time.  This code is 
-based on the TimeNTP_ESP8266WIFI example (there is no copyright/author 
-info in the file to give credit to - thanks and you rock!)
+Starts looking up the current server.  lwIP either answers from its
+cache right away (and we send the request), or calls onResolved() 
+later on.
 
 RETURN VALUE:
-time_t value 
+none.
 
 SIDE EFFECTS:
 none
 
 ======================================================================*/
-time_t TimeProxy::getNtpTime()
+void TimeProxy::startResolve()
 {
-    IPAddress ntpServerIP; // NTP server's ip address
+    ip_addr_t address;
 
-    while ( _udp.parsePacket() > 0 ); // discard any previously received packets
-    Serial.println( "Transmit NTP Request" );
-    
-    // get a random server from the pool
-    WiFi.hostByName( _ntpServer.c_str(), ntpServerIP );
-    Serial.print( _ntpServer.c_str() );
-    Serial.print( ": " );
-    Serial.println( ntpServerIP );
-    sendNTPpacket( ntpServerIP );
-    uint32_t beginWait = millis();
+    _serverAddressValid = false;
+    _resolveDone = false;
+    _resolvedAddress = 0;
 
-    //buffer to hold incoming & outgoing packets
-    byte packetBuffer[NTP_PACKET_SIZE]; 
+    changeState( SYNC_RESOLVING );
+
+    err_t result = dns_gethostbyname( _ntpServers[_serverIndex].c_str(), &address, &TimeProxy::onResolved, this );
 
-    while ( millis() - beginWait < 1500 )
+    if ( result == ERR_OK )
     {
-        int size = _udp.parsePacket();
-        if ( size >= NTP_PACKET_SIZE )
-        {
-            Serial.println( "Receive NTP Response" );
-            _udp.read( packetBuffer, NTP_PACKET_SIZE );  // read packet into the buffer
-            unsigned long secsSince1900;
-            // convert four bytes starting at location 40 to a long integer
-            secsSince1900 = (unsigned long) packetBuffer[40] << 24;
-            secsSince1900 |= (unsigned long) packetBuffer[41] << 16;
-            secsSince1900 |= (unsigned long) packetBuffer[42] << 8;
-            secsSince1900 |= (unsigned long) packetBuffer[43];
-            return secsSince1900 - 2208988800UL + _timezone * SECS_PER_HOUR;
-        }
+        // It was in lwIP's cache, no need to wait for Process()
+        _serverAddress = IPAddress( ip_addr_get_ip4_u32( &address ) );
+        _serverAddressValid = true;
+        _serverAddressMS = millis();
+
+        sendRequest();
+    }
+    else if ( result != ERR_INPROGRESS )
+    {
+        // Leaves _resolvedAddress at 0, which Process() sees 
+        // as a failure
+        _resolveDone = true;
     }
-    Serial.println( "No NTP Response :-(" );
-    return 0; // return 0 if unable to get the time
 }
 
 /*======================================================================
 FUNCTION:
-sendNTPpacket()
+onResolved()
+
+DESCRIPTION:
+Called by lwIP when a lookup we started finishes (or fails, in which
+case address is null).  Just hands the result over to Process().  
+A lookup we gave up on can still finish after we've moved on to the 
+next server, so the answer is only taken if it is for the server 
+we're resolving now.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void TimeProxy::onResolved( const char *name, const ip_addr_t *address, void *context )
+{
+    TimeProxy *self = static_cast<TimeProxy *>( context );
+
+    // Too late, we already gave up on this one
+    if ( self->_state != SYNC_RESOLVING || 
+         name == nullptr ||
+         strcasecmp( name, self->_ntpServers[self->_serverIndex].c_str() ) != 0 )
+    {
+        return;
+    }
+
+    self->_resolvedAddress = ( address != nullptr ) ? ip_addr_get_ip4_u32( address ) : 0;
+    self->_resolveDone = true;
+}
+
+/*======================================================================
+FUNCTION:
+sendRequest()
 
 DESCRIPTION:
 This method formats an NTP request and stuffs it into a UDP packet
@@ -288,8 +453,14 @@ SIDE EFFECTS:
 none
 
 ======================================================================*/
-void TimeProxy::sendNTPpacket( IPAddress &address )
+void TimeProxy::sendRequest()
 {
+    // discard any previously received packets
+    while ( _udp.parsePacket() > 0 )
+    {
+        _udp.flush();
+    }
+
     //buffer to hold incoming & outgoing packets
     byte packetBuffer[NTP_PACKET_SIZE];
 
@@ -307,14 +478,463 @@ void TimeProxy::sendNTPpacket( IPAddress &address )
     packetBuffer[13] = 0x4E;
     packetBuffer[14] = 49;
     packetBuffer[15] = 52;
+
+    // Our time goes in the transmit timestamp.  The server hands it
+    // back as the originate timestamp, which both tells us this is
+    // the answer to this request and saves us remembering T1.
+    _requestTimeUS = timeAt( micros64() );
+    writeTimestamp( &packetBuffer[NTP_TRANSMIT_OFFSET], _requestTimeUS );
+    memcpy( _requestStamp, &packetBuffer[NTP_TRANSMIT_OFFSET], sizeof( _requestStamp ) );
     
     // all NTP fields have been given values, now
     // you can send a packet requesting a timestamp:
-    // NTP requests are to port 123
-    const int NTP_PORT = 123;
-    _udp.beginPacket( address, NTP_PORT );
+    _udp.beginPacket( _serverAddress, NTP_PORT );
     _udp.write( packetBuffer, NTP_PACKET_SIZE );
     _udp.endPacket();
+
+    changeState( SYNC_WAITING );
+}
+
+/*======================================================================
+FUNCTION:
+readReply()
+
+DESCRIPTION:
+Checks for a reply from the server, and works out our offset and the
+round trip delay from the four timestamps:
+
+    T1 - we sent the request (our clock)
+    T2 - the server received it (server clock)
+    T3 - the server sent the reply (server clock)
+    T4 - we received the reply (our clock)
+
+    offset = ( ( T2 - T1 ) + ( T3 - T4 ) ) / 2
+    delay  = ( T4 - T1 ) - ( T3 - T2 )
+
+The sample with the shortest delay is kept, the offset is most 
+trustworthy when the trip was quick.
+
+Anything that isn't a server reply to our request (from the address 
+we asked) is dropped, as are kiss-o'-death (stratum 0) replies.
+
+RETURN VALUE:
+true if we got a sample.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+bool TimeProxy::readReply()
+{
+    int size = _udp.parsePacket();
+
+    // Take T4 before anything else
+    int64_t t4 = timeAt( micros64() );
+
+    if ( size < NTP_PACKET_SIZE )
+    {
+        if ( size > 0 )
+        {
+            _udp.flush();
+        }
+
+        return false;
+    }
+
+    //buffer to hold incoming & outgoing packets
+    byte packetBuffer[NTP_PACKET_SIZE];
+
+    _udp.read( packetBuffer, NTP_PACKET_SIZE );  // read packet into the buffer
+    _udp.flush();
+
+    const uint8_t MODE_SERVER = 4;
+
+    if ( _udp.remoteIP() != _serverAddress || 
+         ( packetBuffer[0] & 0x07 ) != MODE_SERVER ||
+         packetBuffer[1] == 0 ||
+         memcmp( &packetBuffer[NTP_ORIGINATE_OFFSET], _requestStamp, sizeof( _requestStamp ) ) != 0 )
+    {
+        return false;
+    }
+
+    int64_t t1 = _requestTimeUS;
+    int64_t t2 = readTimestamp( &packetBuffer[NTP_RECEIVE_OFFSET] );
+    int64_t t3 = readTimestamp( &packetBuffer[NTP_TRANSMIT_OFFSET] );
+
+    int64_t offset = ( ( t2 - t1 ) + ( t3 - t4 ) ) / 2;
+    int64_t delay = ( t4 - t1 ) - ( t3 - t2 );
+
+    if ( _samples == 0 || delay < _bestDelayUS )
+    {
+        _bestOffsetUS = offset;
+        _bestDelayUS = delay;
+    }
+
+    return true;
+}
+
+/*======================================================================
+FUNCTION:
+serverFailed()
+
+DESCRIPTION:
+The current server didn't work out.  Forget its address and move on
+to the next one.  Once they have all failed, we wait a while before 
+going around again.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void TimeProxy::serverFailed()
+{
+    _serverAddressValid = false;
+
+    _serverIndex = ( _serverIndex + 1 ) % _serverCount;
+    _failedServers++;
+
+    if ( _failedServers >= _serverCount )
+    {
+        _failedServers = 0;
+        _nextSyncMS = millis() + RETRY_INTERVAL_MS;
+    }
+    else
+    {
+        _nextSyncMS = millis();
+    }
+
+    changeState( SYNC_IDLE );
+}
+
+/*======================================================================
+FUNCTION:
+timeAt()
+
+DESCRIPTION:
+Works out the disciplined time at the given micros64() reading: the
+time at the anchor, plus the time since, corrected for frequency and 
+any slew still under way.
+
+RETURN VALUE:
+Microseconds since the unix epoch.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+int64_t TimeProxy::timeAt( uint64_t localUS ) const
+{
+    int64_t elapsed = (int64_t) ( localUS - _anchorLocalUS );
+    int64_t slewElapsed = ( (uint64_t) elapsed < _slewDurationUS ) ? elapsed : (int64_t) _slewDurationUS;
+
+    return _anchorTimeUS + elapsed + 
+           ( elapsed * _frequencyPPB ) / 1000000000LL +
+           ( slewElapsed * _slewPPB ) / 1000000000LL;
+}
+
+/*======================================================================
+FUNCTION:
+reanchor()
+
+DESCRIPTION:
+Moves the anchor up to localUS.  The clock reads the same before and 
+after, only the slew still to go is carried over.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void TimeProxy::reanchor( uint64_t localUS )
+{
+    int64_t now = timeAt( localUS );
+    uint64_t elapsed = localUS - _anchorLocalUS;
+
+    _slewDurationUS = ( elapsed < _slewDurationUS ) ? _slewDurationUS - elapsed : 0;
+
+    if ( _slewDurationUS == 0 )
+    {
+        _slewPPB = 0;
+    }
+
+    _anchorLocalUS = localUS;
+    _anchorTimeUS = now;
+}
+
+/*======================================================================
+FUNCTION:
+discipline()
+
+DESCRIPTION:
+Corrects the clock by offsetUS.  The first sync, and any offset too
+big to slew, steps the clock.  Anything else is slewed out at 
+MAX_SLEW_PPB, so the clock never jumps.
+
+What is left over at a sync (once the last slew is done) is down to
+our crystal being off, so a share of it goes into the frequency
+correction.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void TimeProxy::discipline( int64_t offsetUS, uint64_t localUS )
+{
+    reanchor( localUS );
+
+    _offsetUS = offsetUS;
+
+    // Whatever slew was left is included in the new offset
+    _slewPPB = 0;
+    _slewDurationUS = 0;
+
+    int64_t magnitude = ( offsetUS < 0 ) ? -offsetUS : offsetUS;
+
+    if ( _synced == false || magnitude > STEP_THRESHOLD_US )
+    {
+        Serial.printf( "NTP: stepping clock by %lld us\n", (long long) offsetUS );
+
+        _anchorTimeUS += offsetUS;
+    }
+    else
+    {
+        uint64_t interval = localUS - _lastDisciplineLocalUS;
+
+        if ( interval > 0 )
+        {
+            int64_t frequency = _frequencyPPB + ( offsetUS * 1000000000LL / (int64_t) interval ) / FREQUENCY_GAIN;
+
+            if ( frequency > MAX_FREQUENCY_PPB ) frequency = MAX_FREQUENCY_PPB;
+            if ( frequency < -MAX_FREQUENCY_PPB ) frequency = -MAX_FREQUENCY_PPB;
+
+            _frequencyPPB = (int32_t) frequency;
+        }
+
+        _slewPPB = ( offsetUS < 0 ) ? -MAX_SLEW_PPB : MAX_SLEW_PPB;
+        _slewDurationUS = (uint64_t) magnitude * 1000000000ULL / MAX_SLEW_PPB;
+    }
+
+    _lastDisciplineLocalUS = localUS;
+}
+
+/*======================================================================
+FUNCTION:
+Report()
+
+DESCRIPTION:
+Formats the clock's state for a status page.
+
+RETURN VALUE:
+The report.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+String TimeProxy::Report() const
+{
+    char buffer[200];
+    char local[TimeZone::ISO8601_SIZE];
+
+    time_t utc = (time_t) ( GetTimeMicros() / 1000000ULL );
+
+    _timezone.FormatISO8601( utc, local, sizeof( local ) );
+
+    snprintf( buffer, sizeof( buffer ),
+              "synced:    %s\n"
+              "server:    %s\n"
+              "local:     %s%s\n"
+              "time:      %llu us\n"
+              "offset:    %lld us\n"
+              "delay:     %lld us\n"
+              "frequency: %ld ppb\n",
+              _synced ? "yes" : "no",
+              _ntpServers[_serverIndex].c_str(),
+              local,
+              _timezone.IsDST( utc ) ? " (DST)" : "",
+              (unsigned long long) GetTimeMicros(),
+              (long long) _offsetUS,
+              (long long) _delayUS,
+              (long) _frequencyPPB );
+
+    return buffer;
+}
+
+/*======================================================================
+FUNCTION:
+readTimestamp()
+
+DESCRIPTION:
+Reads a 64-bit NTP timestamp (32 bits of seconds since 1900, 32 bits
+of fraction, big endian).  The seconds wrap in February 2036, so a 
+small value is read as being in the next era (see NTP_ERA_PIVOT), 
+which keeps us right from 1968 to 2104.
+
+RETURN VALUE:
+Microseconds since the unix epoch.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+static int64_t readTimestamp( const uint8_t *buffer )
+{
+    uint32_t seconds = ( (uint32_t) buffer[0] << 24 ) | ( (uint32_t) buffer[1] << 16 ) |
+                       ( (uint32_t) buffer[2] << 8 ) | buffer[3];
+
+    uint32_t fraction = ( (uint32_t) buffer[4] << 24 ) | ( (uint32_t) buffer[5] << 16 ) |
+                        ( (uint32_t) buffer[6] << 8 ) | buffer[7];
+
+    int64_t ntpSeconds = seconds;
+
+    if ( seconds < NTP_ERA_PIVOT )
+    {
+        ntpSeconds += NTP_ERA_SECONDS;
+    }
+
+    return ( ntpSeconds - (int64_t) NTP_UNIX_OFFSET ) * 1000000LL + 
+           (int64_t) ( ( (uint64_t) fraction * 1000000ULL ) >> 32 );
+}
+
+/*======================================================================
+FUNCTION:
+writeTimestamp()
+
+DESCRIPTION:
+Writes timeUS as a 64-bit NTP timestamp.  See readTimestamp().  Only
+the low 32 bits of the seconds go out, which is the era 1 value for 
+a time past 2036.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+static void writeTimestamp( uint8_t *buffer, int64_t timeUS )
+{
+    // Rounded down, so the fraction is never negative
+    int64_t unixSeconds = timeUS / 1000000LL;
+    int64_t micros = timeUS % 1000000LL;
+
+    if ( micros < 0 )
+    {
+        unixSeconds--;
+        micros += 1000000LL;
+    }
+
+    uint32_t seconds = (uint32_t) ( unixSeconds + (int64_t) NTP_UNIX_OFFSET );
+    uint32_t fraction = (uint32_t) ( ( (uint64_t) micros << 32 ) / 1000000ULL );
+
+    for ( int i = 0; i < 4; i++ )
+    {
+        buffer[i] = (uint8_t) ( seconds >> ( 24 - i * 8 ) );
+        buffer[4 + i] = (uint8_t) ( fraction >> ( 24 - i * 8 ) );
+    }
+}
+
+/*======================================================================
+FUNCTION:
+changeState()
+
+DESCRIPTION:
+Moves to a new state, and notes when.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void TimeProxy::changeState( SyncState state )
+{
+    _state = state;
+    _stateStartMS = millis();
+}
+
+/*======================================================================
+FUNCTION:
+GetCurrentTimeUTC()
+
+DESCRIPTION:
+Returns the current time relative to UTC in a c-style time_t dude
+
+RETURN VALUE:
+UTC offset time_t value 
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+time_t TimeProxy::GetCurrentTimeUTC()
+{
+    // TimeLib keeps UTC too, so before the first sync this is still
+    // UTC (just not a very good one)
+    if ( _synced == true )
+    {
+        return (time_t) ( GetTimeMicros() / 1000000ULL );
+    }
+
+    return now();
+}
+
+/*======================================================================
+FUNCTION:
+GetTimeStringUTC()
+
+DESCRIPTION:
+Returns an ISO 8601 date/time string relative to UTC time.
+https://en.wikipedia.org/wiki/ISO_8601
+Example time string: 2017-11-10T01:28:49Z
+
+RETURN VALUE:
+ISO 8601 date/time string
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+String TimeProxy::GetTimeStringUTC()
+{
+    char buffer[TimeZone::ISO8601_SIZE];
+
+    TimeZone::FormatISO8601UTC( GetCurrentTimeUTC(), buffer, sizeof( buffer ) );
+
+    // Note - a String object will implicitly be
+    // constructed and returned
+    return buffer;
+}
+
+/*======================================================================
+FUNCTION:
+GetTimeStringLocal()
+
+DESCRIPTION:
+Writes the current local time as an ISO 8601 string with its offset,
+e.g. 2017-11-09T20:28:49-05:00, into the caller's buffer.  Nothing is
+allocated, so this is fine to call from a hot path.
+
+RETURN VALUE:
+Length written, 0 if the buffer is smaller than 
+TimeZone::ISO8601_SIZE.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+size_t TimeProxy::GetTimeStringLocal( char *buffer, size_t size )
+{
+    return _timezone.FormatISO8601( GetCurrentTimeUTC(), buffer, size );
 }
 
 /*=====================================================================
@@ -48,9 +48,15 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 // Include Files
 //----------------------------------------------------------------------
 
+#include <time.h>
+#include <stdint.h>
+
 #include <WiFiUdp.h>
+#include <lwip/ip_addr.h>
 #include "WString.h"
 
+#include "timezone.h"
+
 //----------------------------------------------------------------------
 // Type Declarations
 //----------------------------------------------------------------------
@@ -99,10 +105,27 @@ DESCRIPTION:
 Uses Network Time Protocol (NTP) to seed the timing routines and provides
 some helper methods to abstract the use of TimeLib calls.
 
+Nothing in here waits on the network.  A sync is a small state 
+machine run from Process(): look up the server (asynchronously), send
+the request, and pick up the reply on a later call.  Each step has a
+timeout, and a server that doesn't answer is skipped in favour of the
+next one.
+
+Each sync sends a short burst of requests and keeps the one with the
+shortest round trip, using all four NTP timestamps (with their 
+fractions) to work out our offset from the server.  Small offsets are
+slewed out - the clock runs a little fast or slow until it has caught
+up - rather than stepped, and the clock's frequency error is learned 
+from sync to sync.  GetTimeMicros() never jumps around, so effects 
+keyed off it stay smooth while staying in step with other devices.
+
 HOW TO USE:
 1. Construct with the ntp server to use. 
-2. Call Begin() to initialze and start everything
-3. Call the helper methods to get the time.
+2. Optionally AddServer() some fallback servers
+3. Call Begin() to initialze and start everything
+4. Call Process() often (every few milliseconds) - the reply is 
+picked up from there
+5. Call the helper methods to get the time.
 
 ======================================================================*/
 class TimeProxy
@@ -123,6 +146,39 @@ class TimeProxy
         PDT = -7
     };
 
+    static const size_t MAX_SERVERS = 4;
+
+    // How long we wait on a DNS lookup, and on a reply
+    static const uint32_t RESOLVE_TIMEOUT_MS = 5000;
+    static const uint32_t REPLY_TIMEOUT_MS = 1500;
+
+    // How long we keep using a server's address before looking it up
+    // again.  lwIP has its own cache that honours the record's TTL,
+    // so a lookup inside of that is answered without any traffic;
+    // this just bounds how long we stick with one pool address.
+    static const uint32_t ADDRESS_TTL_MS = 3600000UL;
+
+    // If every server failed, wait this long before starting over
+    static const uint32_t RETRY_INTERVAL_MS = 30000;
+
+    // Requests per sync; we keep the one with the shortest round trip
+    static const size_t SAMPLES_PER_SYNC = 4;
+
+    // Offsets bigger than this are stepped rather than slewed
+    static const int64_t STEP_THRESHOLD_US = 128000;
+
+    // How hard we can lean on the clock, in parts per billion.  At
+    // the slew rate, STEP_THRESHOLD_US takes about four minutes.
+    static const int32_t MAX_SLEW_PPB = 500000;
+    static const int32_t MAX_FREQUENCY_PPB = 500000;
+
+    enum SyncState
+    {
+        SYNC_IDLE = 0,
+        SYNC_RESOLVING,
+        SYNC_WAITING
+    };
+
     //=================================================================
     // CLIENT INTERFACE
     //=================================================================
@@ -130,12 +186,54 @@ class TimeProxy
     TimeProxy( const String &ntpServer,
                unsigned int syncIntervalS = 300 );
 
+    // Adds a server to fall back on if the ones before it don't answer
+    bool AddServer( const String &ntpServer );
+
     void Begin();
 
+    // Call this often - it runs the sync, and never blocks
+    void Process();
+
+    // True once we have synced at least once
+    bool IsSynced() const { return _synced; }
+
+    SyncState GetSyncState() const { return _state; }
+
+    // Microseconds since the unix epoch (UTC).  Only ever moves 
+    // forward, except when a sync has to step the clock.
+    uint64_t GetTimeMicros() const { return (uint64_t) timeAt( micros64() ); }
+
+    // What the last sync measured, and what we have learned about 
+    // our clock
+    int64_t GetOffsetMicros() const { return _offsetUS; }
+    int64_t GetDelayMicros() const { return _delayUS; }
+    int32_t GetFrequencyPPB() const { return _frequencyPPB; }
+
+    // The above, formatted for a status page
+    String Report() const;
+
     time_t GetCurrentTimeUTC();
 
     String GetTimeStringUTC();
 
+    // Writes the current local time as ISO 8601 into buffer, which 
+    // should be at least TimeZone::ISO8601_SIZE.  Doesn't allocate.
+    size_t GetTimeStringLocal( char *buffer, size_t size );
+
+    // A POSIX TZ rule, e.g. "EST5EDT,M3.2.0,M11.1.0" (see TimeZone).
+    // Returns false and keeps the old zone if it doesn't parse.
+    bool SetTimezone( const char *rule ) { return _timezone.Set( rule ); }
+
+    // A fixed offset in hours, see TimeZones
+    void SetTimezone( int hours ) { _timezone.SetFixed( hours * 3600L ); }
+
+    const TimeZone &GetTimezone() const { return _timezone; }
+
+    time_t ToLocal( time_t utc ) const { return _timezone.ToLocal( utc ); }
+    time_t ToUTC( time_t local ) const { return _timezone.ToUTC( local ); }
+
+    time_t GetCurrentTimeLocal() { return ToLocal( GetCurrentTimeUTC() ); }
+
     protected:
 
     //=================================================================
@@ -146,10 +244,6 @@ class TimeProxy
 
     private:
 
-    static time_t getNtpTime();
-
-    static void sendNTPpacket( IPAddress &address );
-
     //=================================================================
     // CUSTOMIZATION INTERFACE    
     //=================================================================
@@ -164,20 +258,89 @@ class TimeProxy
     // error
     TimeProxy( const TimeProxy &rhs );
 
+    void startSync();
+    void startResolve();
+    void sendRequest();
+    bool readReply();
+    void serverFailed();
+    void changeState( SyncState state );
+
+    // The disciplined clock at the given micros64()
+    int64_t timeAt( uint64_t localUS ) const;
+
+    // Starts the clock's line over from localUS, without moving it
+    void reanchor( uint64_t localUS );
+
+    // Corrects the clock by the measured offset
+    void discipline( int64_t offsetUS, uint64_t localUS );
+
+    // lwIP calls this when a lookup finishes
+    static void onResolved( const char *name, const ip_addr_t *address, void *context );
+
     //=================================================================
     // DATA MEMBERS    
     //=================================================================
 
-    static int _timezone;
+    TimeZone _timezone;
 
-    static String _ntpServer;
+    // The servers, in the order we try them
+    String _ntpServers[MAX_SERVERS];
+    size_t _serverCount;
+    size_t _serverIndex;
+
+    // How many servers have failed in a row this time around
+    size_t _failedServers;
 
     // How often should we resync time (seconds) with our 
     // NTP time source?
     unsigned int _syncIntervalS;
 
-    static WiFiUDP _udp;
+    WiFiUDP _udp;
     unsigned int _localport = 8888;
+
+    SyncState _state;
+    unsigned long _stateStartMS;
+
+    bool _synced;
+    unsigned long _lastSyncMS;
+
+    // When to start the next sync (millis())
+    unsigned long _nextSyncMS;
+
+    // The current server's address, and when we looked it up
+    IPAddress _serverAddress;
+    bool _serverAddressValid;
+    unsigned long _serverAddressMS;
+
+    // The clock is a line through (_anchorLocalUS, _anchorTimeUS).  
+    // It runs _frequencyPPB fast, plus _slewPPB for the first 
+    // _slewDurationUS after the anchor.
+    uint64_t _anchorLocalUS;
+    int64_t _anchorTimeUS;
+    int32_t _frequencyPPB;
+    int32_t _slewPPB;
+    uint64_t _slewDurationUS;
+
+    // When we last disciplined the clock (micros64())
+    uint64_t _lastDisciplineLocalUS;
+
+    // The request we are waiting on: when we sent it, and the 
+    // transmit timestamp the server should hand back
+    int64_t _requestTimeUS;
+    uint8_t _requestStamp[8];
+
+    // This sync's best sample
+    size_t _samples;
+    int64_t _bestOffsetUS;
+    int64_t _bestDelayUS;
+
+    // The last sync's result
+    int64_t _offsetUS;
+    int64_t _delayUS;
+
+    // Set from onResolved()
+    volatile bool _resolveDone;
+    volatile uint32_t _resolvedAddress;
         
 };
 
@@ -0,0 +1,813 @@
+/*======================================================================
+FILE:
+timezone.cpp
+
+CREATOR:
+Sean Foley
+
+GENERAL DESCRIPTION:
+POSIX TZ rule based time zone conversions.
+
+PUBLIC CLASSES AND FUNCTIONS:
+TimeZone
+
+INITIALIZATION AND SEQUENCING REQUIREMENTS:
+None.
+
+Copyright (C) 2017 Sean Foley  All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted.  Enjoy.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+======================================================================*/
+
+//======================================================================
+// INCLUDES AND VARIABLE DEFINITIONS
+//======================================================================
+
+//----------------------------------------------------------------------
+// Defines
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Include Files
+//----------------------------------------------------------------------
+
+#include <stdlib.h>
+#include <ctype.h>
+
+#include "timezone.h"
+
+//----------------------------------------------------------------------
+// Type Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Constant Definitions
+//----------------------------------------------------------------------
+
+const int64_t SECONDS_PER_DAY = 86400;
+
+// Bounds for a stretch that never ends
+const int64_t TIME_MIN = INT64_MIN;
+const int64_t TIME_MAX = INT64_MAX;
+
+//----------------------------------------------------------------------
+// Global Data Definitions
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Static Variable Definitions 
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Function Prototypes
+//----------------------------------------------------------------------
+
+static int64_t daysFromCivil( int year, unsigned month, unsigned day );
+static void civilFromDays( int64_t days, int &year, unsigned &month, unsigned &day );
+static bool isLeapYear( int year );
+static const char *parseName( const char *text );
+static const char *parseOffset( const char *text, int32_t &seconds );
+static char *writeNumber( char *out, unsigned value, int digits );
+
+//----------------------------------------------------------------------
+// Required Libraries
+//----------------------------------------------------------------------
+
+// None. (Where supported these should be in the form
+// of C++ pragmas).
+
+//======================================================================
+// FUNCTION IMPLEMENTATIONS
+//======================================================================
+
+/*======================================================================
+FUNCTION:
+C-tor()
+
+DESCRIPTION:
+Constructs a zone that is UTC.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+TimeZone::TimeZone()
+{
+    SetFixed( 0 );
+}
+
+/*======================================================================
+FUNCTION:
+SetFixed()
+
+DESCRIPTION:
+Sets a fixed offset (east positive) with no DST.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void TimeZone::SetFixed( int32_t offsetSeconds )
+{
+    _stdOffset = offsetSeconds;
+    _dstOffset = offsetSeconds;
+    _hasDST = false;
+
+    // One stretch that covers all of time
+    _cacheFrom = TIME_MIN;
+    _cacheUntil = TIME_MAX;
+    _cacheOffset = offsetSeconds;
+}
+
+/*======================================================================
+FUNCTION:
+Set()
+
+DESCRIPTION:
+Parses a POSIX TZ rule:
+
+    std offset [dst [offset] [,start[/time],end[/time]]]
+
+Names are 3 or more letters, or anything in <>.  Offsets are 
+[+-]hh[:mm[:ss]] west of UTC (so EST is 5).  The DST offset defaults 
+to an hour ahead of standard.  Rules are Jn, n or Mm.w.d, with an 
+optional [+-]hh[:mm[:ss]] time that defaults to 02:00.  If there is a
+DST name but no rules, the US rules are assumed.
+
+RETURN VALUE:
+true if it parsed.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+bool TimeZone::Set( const char *rule )
+{
+    const char *p = parseName( rule );
+
+    int32_t west = 0;
+
+    if ( p == nullptr || ( p = parseOffset( p, west ) ) == nullptr )
+    {
+        return false;
+    }
+
+    int32_t stdOffset = -west;
+
+    if ( *p == 0 )
+    {
+        SetFixed( stdOffset );
+        return true;
+    }
+
+    p = parseName( p );
+
+    if ( p == nullptr )
+    {
+        return false;
+    }
+
+    int32_t dstOffset = stdOffset + 3600;
+
+    if ( *p != 0 && *p != ',' )
+    {
+        if ( ( p = parseOffset( p, west ) ) == nullptr )
+        {
+            return false;
+        }
+
+        dstOffset = -west;
+    }
+
+    Rule rules[2];
+
+    if ( *p == 0 )
+    {
+        // M3.2.0,M11.1.0
+        rules[0] = { Rule::MONTH_WEEK_DAY, 0, 3, 2, 7200 };
+        rules[1] = { Rule::MONTH_WEEK_DAY, 0, 11, 1, 7200 };
+    }
+
+    int parsed = ( *p == 0 ) ? 2 : 0;
+
+    for ( int i = 0; i < 2 && *p != 0; i++ )
+    {
+        if ( *p++ != ',' )
+        {
+            return false;
+        }
+
+        Rule &r = rules[i];
+        char *end = nullptr;
+
+        r.month = 0;
+        r.week = 0;
+        r.timeSeconds = 7200;
+
+        if ( *p == 'M' )
+        {
+            r.type = Rule::MONTH_WEEK_DAY;
+            r.month = (uint8_t) strtol( p + 1, &end, 10 );
+
+            if ( *end != '.' ) return false;
+            r.week = (uint8_t) strtol( end + 1, &end, 10 );
+
+            if ( *end != '.' ) return false;
+            r.day = (int16_t) strtol( end + 1, &end, 10 );
+
+            if ( r.month < 1 || r.month > 12 || r.week < 1 || r.week > 5 || r.day < 0 || r.day > 6 )
+            {
+                return false;
+            }
+        }
+        else if ( *p == 'J' )
+        {
+            r.type = Rule::JULIAN_NO_LEAP;
+            r.day = (int16_t) strtol( p + 1, &end, 10 );
+
+            if ( end == p + 1 || r.day < 1 || r.day > 365 ) return false;
+        }
+        else
+        {
+            r.type = Rule::JULIAN;
+            r.day = (int16_t) strtol( p, &end, 10 );
+
+            if ( end == p || r.day < 0 || r.day > 365 ) return false;
+        }
+
+        p = end;
+
+        if ( *p == '/' )
+        {
+            // Same syntax as an offset, but not negated
+            if ( ( p = parseOffset( p + 1, r.timeSeconds ) ) == nullptr )
+            {
+                return false;
+            }
+        }
+
+        if ( i == 1 && *p != 0 )
+        {
+            return false;
+        }
+
+        parsed++;
+    }
+
+    // A start date needs an end date to go with it
+    if ( parsed != 2 )
+    {
+        return false;
+    }
+
+    _stdOffset = stdOffset;
+    _dstOffset = dstOffset;
+    _hasDST = true;
+    _start = rules[0];
+    _end = rules[1];
+
+    // Empty, the next conversion fills it
+    _cacheFrom = 0;
+    _cacheUntil = 0;
+
+    return true;
+}
+
+/*======================================================================
+FUNCTION:
+GetOffset()
+
+DESCRIPTION:
+Gets the offset in effect at utc.  Inside the cached stretch this is
+a compare; outside it we work out the stretch utc is in first.
+
+RETURN VALUE:
+Offset from UTC in seconds, east positive.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+int32_t TimeZone::GetOffset( time_t utc ) const
+{
+    if ( (int64_t) utc < _cacheFrom || (int64_t) utc >= _cacheUntil )
+    {
+        fillCache( utc );
+    }
+
+    return _cacheOffset;
+}
+
+/*======================================================================
+FUNCTION:
+ToUTC()
+
+DESCRIPTION:
+Converts a local time to UTC.  The offset depends on the UTC time we
+are trying to find, so guess with the standard offset and correct 
+once.
+
+RETURN VALUE:
+UTC time.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+time_t TimeZone::ToUTC( time_t local ) const
+{
+    time_t utc = local - _stdOffset;
+
+    int32_t offset = GetOffset( utc );
+
+    if ( offset != _stdOffset )
+    {
+        time_t adjusted = local - offset;
+
+        // Only take the DST reading if it holds up, otherwise we 
+        // are in the spring forward gap
+        if ( GetOffset( adjusted ) == offset )
+        {
+            utc = adjusted;
+        }
+    }
+
+    return utc;
+}
+
+/*======================================================================
+FUNCTION:
+fillCache()
+
+DESCRIPTION:
+Finds the DST transitions around utc (the year before through the 
+year after, so we always have the one before and the one after), 
+and caches the stretch between them that utc is in.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void TimeZone::fillCache( int64_t utc ) const
+{
+    if ( _hasDST == false )
+    {
+        _cacheFrom = TIME_MIN;
+        _cacheUntil = TIME_MAX;
+        _cacheOffset = _stdOffset;
+        return;
+    }
+
+    int year;
+    unsigned month;
+    unsigned day;
+
+    civilFromDays( ( utc + _stdOffset ) / SECONDS_PER_DAY, year, month, day );
+
+    // Each transition, and the offset it changes to.  DST starts at
+    // a standard time, and ends at a daylight time.
+    int64_t when[6];
+    int32_t offset[6];
+
+    for ( int i = 0; i < 3; i++ )
+    {
+        int y = year - 1 + i;
+
+        when[i * 2] = ruleDay( _start, y ) * SECONDS_PER_DAY + _start.timeSeconds - _stdOffset;
+        offset[i * 2] = _dstOffset;
+
+        when[i * 2 + 1] = ruleDay( _end, y ) * SECONDS_PER_DAY + _end.timeSeconds - _dstOffset;
+        offset[i * 2 + 1] = _stdOffset;
+    }
+
+    // Six entries, and in the southern hemisphere only a couple out
+    // of order - an insertion sort is plenty
+    for ( int i = 1; i < 6; i++ )
+    {
+        for ( int j = i; j > 0 && when[j] < when[j - 1]; j-- )
+        {
+            int64_t w = when[j]; when[j] = when[j - 1]; when[j - 1] = w;
+            int32_t o = offset[j]; offset[j] = offset[j - 1]; offset[j - 1] = o;
+        }
+    }
+
+    _cacheFrom = TIME_MIN;
+    _cacheUntil = TIME_MAX;
+
+    // Before the first transition we know of, we are in whatever the
+    // one before it left us in
+    _cacheOffset = ( offset[0] == _dstOffset ) ? _stdOffset : _dstOffset;
+
+    for ( int i = 0; i < 6; i++ )
+    {
+        if ( when[i] <= utc )
+        {
+            _cacheFrom = when[i];
+            _cacheOffset = offset[i];
+        }
+        else
+        {
+            _cacheUntil = when[i];
+            break;
+        }
+    }
+}
+
+/*======================================================================
+FUNCTION:
+ruleDay()
+
+DESCRIPTION:
+Works out the date a DST rule falls on in the given year.
+
+RETURN VALUE:
+Days since 1970-01-01.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+int64_t TimeZone::ruleDay( const Rule &rule, int year )
+{
+    int64_t first = daysFromCivil( year, 1, 1 );
+
+    switch ( rule.type )
+    {
+        case Rule::JULIAN_NO_LEAP:
+
+            // Feb 29 is skipped, so day 60 is always Mar 1
+            return first + rule.day - 1 + ( ( isLeapYear( year ) && rule.day >= 60 ) ? 1 : 0 );
+
+        case Rule::JULIAN:
+
+            return first + rule.day;
+
+        case Rule::MONTH_WEEK_DAY:
+        default:
+        {
+            int64_t monthStart = daysFromCivil( year, rule.month, 1 );
+            int64_t nextMonth = ( rule.month == 12 ) ? daysFromCivil( year + 1, 1, 1 ) : daysFromCivil( year, rule.month + 1, 1 );
+
+            // 1970-01-01 was a Thursday (4)
+            int weekday = (int) ( ( ( monthStart + 4 ) % 7 + 7 ) % 7 );
+
+            int64_t day = monthStart + ( rule.day - weekday + 7 ) % 7 + ( rule.week - 1 ) * 7;
+
+            // Week 5 is the last one, which may be the 4th
+            while ( day >= nextMonth )
+            {
+                day -= 7;
+            }
+
+            return day;
+        }
+    }
+}
+
+/*======================================================================
+FUNCTION:
+FormatISO8601()
+
+DESCRIPTION:
+Writes utc as an ISO 8601 local time with its offset.  Doesn't 
+allocate, doesn't call into TimeLib, and the digits are written by 
+hand rather than through printf.
+
+RETURN VALUE:
+Length written, 0 if the buffer is too small.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+size_t TimeZone::FormatISO8601( time_t utc, char *buffer, size_t size ) const
+{
+    int32_t offset = GetOffset( utc );
+
+    return format( (int64_t) utc + offset, offset, buffer, size );
+}
+
+/*======================================================================
+FUNCTION:
+FormatISO8601UTC()
+
+DESCRIPTION:
+Writes utc as an ISO 8601 UTC time, 2017-11-10T01:28:49Z.
+
+RETURN VALUE:
+Length written, 0 if the buffer is too small.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+size_t TimeZone::FormatISO8601UTC( time_t utc, char *buffer, size_t size )
+{
+    return format( (int64_t) utc, 0, buffer, size );
+}
+
+/*======================================================================
+FUNCTION:
+format()
+
+DESCRIPTION:
+Does the work for the ISO 8601 formatters.
+
+RETURN VALUE:
+Length written, 0 if the buffer is too small.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+size_t TimeZone::format( int64_t local, int32_t offset, char *buffer, size_t size )
+{
+    if ( size < ISO8601_SIZE )
+    {
+        return 0;
+    }
+
+    int64_t days = local / SECONDS_PER_DAY;
+    int64_t seconds = local % SECONDS_PER_DAY;
+
+    if ( seconds < 0 )
+    {
+        seconds += SECONDS_PER_DAY;
+        days--;
+    }
+
+    int year;
+    unsigned month;
+    unsigned day;
+
+    civilFromDays( days, year, month, day );
+
+    char *out = buffer;
+
+    out = writeNumber( out, (unsigned) year, 4 );
+    *out++ = '-';
+    out = writeNumber( out, month, 2 );
+    *out++ = '-';
+    out = writeNumber( out, day, 2 );
+    *out++ = 'T';
+    out = writeNumber( out, (unsigned) ( seconds / 3600 ), 2 );
+    *out++ = ':';
+    out = writeNumber( out, (unsigned) ( seconds / 60 % 60 ), 2 );
+    *out++ = ':';
+    out = writeNumber( out, (unsigned) ( seconds % 60 ), 2 );
+
+    if ( offset == 0 )
+    {
+        *out++ = 'Z';
+    }
+    else
+    {
+        *out++ = ( offset < 0 ) ? '-' : '+';
+
+        uint32_t magnitude = ( offset < 0 ) ? -offset : offset;
+
+        out = writeNumber( out, magnitude / 3600, 2 );
+        *out++ = ':';
+        out = writeNumber( out, magnitude / 60 % 60, 2 );
+    }
+
+    *out = 0;
+
+    return out - buffer;
+}
+
+/*======================================================================
+FUNCTION:
+daysFromCivil()
+
+DESCRIPTION:
+Days since 1970-01-01 of a (proleptic Gregorian) date.  This is 
+Howard Hinnant's days_from_civil, see the implementation notes.
+
+RETURN VALUE:
+Days since 1970-01-01.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+static int64_t daysFromCivil( int year, unsigned month, unsigned day )
+{
+    year -= ( month <= 2 ) ? 1 : 0;
+
+    int64_t era = ( year >= 0 ? year : year - 399 ) / 400;
+    unsigned yearOfEra = (unsigned) ( year - era * 400 );
+    unsigned dayOfYear = ( 153 * ( month > 2 ? month - 3 : month + 9 ) + 2 ) / 5 + day - 1;
+    unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+
+    return era * 146097 + (int64_t) dayOfEra - 719468;
+}
+
+/*======================================================================
+FUNCTION:
+civilFromDays()
+
+DESCRIPTION:
+The inverse of daysFromCivil().
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+static void civilFromDays( int64_t days, int &year, unsigned &month, unsigned &day )
+{
+    days += 719468;
+
+    int64_t era = ( days >= 0 ? days : days - 146096 ) / 146097;
+    unsigned dayOfEra = (unsigned) ( days - era * 146097 );
+    unsigned yearOfEra = ( dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096 ) / 365;
+    unsigned dayOfYear = dayOfEra - ( 365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100 );
+    unsigned mp = ( 5 * dayOfYear + 2 ) / 153;
+
+    day = dayOfYear - ( 153 * mp + 2 ) / 5 + 1;
+    month = ( mp < 10 ) ? mp + 3 : mp - 9;
+    year = (int) ( yearOfEra + era * 400 ) + ( ( month <= 2 ) ? 1 : 0 );
+}
+
+/*======================================================================
+FUNCTION:
+isLeapYear()
+
+DESCRIPTION:
+Gregorian leap year test.
+
+RETURN VALUE:
+true if year is a leap year.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+static bool isLeapYear( int year )
+{
+    return ( year % 4 == 0 && year % 100 != 0 ) || year % 400 == 0;
+}
+
+/*======================================================================
+FUNCTION:
+parseName()
+
+DESCRIPTION:
+Skips over a zone name: 3 or more letters, or anything in <>.
+
+RETURN VALUE:
+Where the name ends, nullptr if it isn't one.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+static const char *parseName( const char *text )
+{
+    const char *p = text;
+
+    if ( *p == '<' )
+    {
+        while ( *p != 0 && *p != '>' )
+        {
+            p++;
+        }
+
+        return ( *p == '>' ) ? p + 1 : nullptr;
+    }
+
+    while ( isalpha( (unsigned char) *p ) )
+    {
+        p++;
+    }
+
+    return ( p - text >= 3 ) ? p : nullptr;
+}
+
+/*======================================================================
+FUNCTION:
+parseOffset()
+
+DESCRIPTION:
+Parses [+-]hh[:mm[:ss]] into seconds.
+
+RETURN VALUE:
+Where the offset ends, nullptr if it isn't one.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+static const char *parseOffset( const char *text, int32_t &seconds )
+{
+    const char *p = text;
+    int32_t sign = 1;
+
+    if ( *p == '+' || *p == '-' )
+    {
+        sign = ( *p == '-' ) ? -1 : 1;
+        p++;
+    }
+
+    if ( isdigit( (unsigned char) *p ) == false )
+    {
+        return nullptr;
+    }
+
+    int32_t total = 0;
+
+    // Hours, then minutes and seconds
+    for ( int part = 0; part < 3; part++ )
+    {
+        char *end = nullptr;
+        long value = strtol( p, &end, 10 );
+
+        if ( end == p || value < 0 || ( part == 0 ? value > 167 : value > 59 ) )
+        {
+            return nullptr;
+        }
+
+        total += value * ( part == 0 ? 3600 : ( part == 1 ? 60 : 1 ) );
+        p = end;
+
+        if ( *p != ':' || part == 2 )
+        {
+            break;
+        }
+
+        p++;
+    }
+
+    seconds = sign * total;
+
+    return p;
+}
+
+/*======================================================================
+FUNCTION:
+writeNumber()
+
+DESCRIPTION:
+Writes value as a zero padded decimal number of the given width.
+
+RETURN VALUE:
+Just past what was written.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+static char *writeNumber( char *out, unsigned value, int digits )
+{
+    for ( int i = digits - 1; i >= 0; i-- )
+    {
+        out[i] = (char) ( '0' + value % 10 );
+        value /= 10;
+    }
+
+    return out + digits;
+}
+
+/*=====================================================================
+// IMPLEMENTATION NOTES
+//=====================================================================
+
+The date conversions are Howard Hinnant's days_from_civil() and 
+civil_from_days(), from http://howardhinnant.github.io/date_algorithms.html
+They work on the proleptic Gregorian calendar, so any year, with no 
+tables.
+
+=====================================================================*/
@@ -0,0 +1,239 @@
+#ifndef _JAROFLIGHT_TIMEZONE_H_
+#define _JAROFLIGHT_TIMEZONE_H_
+
+/*======================================================================
+FILE:
+timezone.h
+
+CREATOR:
+Sean Foley
+
+DESCRIPTION:
+POSIX TZ rule based time zone conversions.
+
+PUBLIC CLASSES AND FUNCTIONS:
+TimeZone
+
+Copyright (C) 2017 Sean Foley  All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted.  Enjoy.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+======================================================================*/
+
+//======================================================================
+// INCLUDES AND PUBLIC DATA DECLARATIONS
+//======================================================================
+
+//----------------------------------------------------------------------
+// Defines
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Include Files
+//----------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+
+//----------------------------------------------------------------------
+// Type Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Constant Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Data Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//======================================================================
+// WARNINGS!!!
+//======================================================================
+
+// None.
+
+//======================================================================
+// FUNCTION DECLARATIONS
+//======================================================================
+
+// None.
+
+//=====================================================================
+// EXCEPTION CLASS DEFINITIONS
+//=====================================================================
+
+// None.
+
+//======================================================================
+// CLASS DEFINITIONS
+//======================================================================
+
+/*======================================================================
+CLASS:
+TimeZone
+
+DESCRIPTION:
+Converts between UTC and local time for a POSIX TZ rule, e.g.
+
+    EST5EDT,M3.2.0,M11.1.0            US Eastern
+    CET-1CEST,M3.5.0,M10.5.0/3        Central Europe
+    AEST-10AEDT,M10.1.0,M4.1.0/3      Sydney (DST over new year)
+    <+0530>-5:30                      India, no DST
+
+The rule is parsed once.  Converting a time works out the DST 
+transitions around it and keeps the stretch between the two it falls
+in, along with that stretch's offset.  Every time in the same stretch
+(which is months long) is then converted with a compare and an add,
+no calendar math.
+
+HOW TO USE:
+1. Set() a POSIX TZ rule, or SetFixed() an offset
+2. ToLocal() / ToUTC() to convert
+3. FormatISO8601() to write a local time out without allocating
+
+======================================================================*/
+class TimeZone
+{
+    public:
+
+    //=================================================================
+    // TYPE DECLARATIONS AND CONSTANTS    
+    //=================================================================
+
+    // Longest ISO 8601 string FormatISO8601() writes, plus the 
+    // terminator: 2017-11-10T01:28:49+05:30
+    static const size_t ISO8601_SIZE = 26;
+
+    //=================================================================
+    // CLIENT INTERFACE
+    //=================================================================
+
+    TimeZone();
+
+    // Parses a POSIX TZ rule.  Returns false (and leaves the zone
+    // alone) if it doesn't parse.
+    bool Set( const char *rule );
+
+    // A fixed offset from UTC, east positive, no DST
+    void SetFixed( int32_t offsetSeconds );
+
+    // The offset from UTC (east positive) in effect at utc
+    int32_t GetOffset( time_t utc ) const;
+
+    time_t ToLocal( time_t utc ) const { return utc + GetOffset( utc ); }
+
+    // Local times that don't exist (skipped by a spring forward) or 
+    // happen twice (a fall back) come out as the standard time one
+    time_t ToUTC( time_t local ) const;
+
+    bool IsDST( time_t utc ) const { return _hasDST == true && GetOffset( utc ) == _dstOffset; }
+
+    // Writes utc as local time, 2017-11-10T01:28:49-05:00 (or 
+    // with a Z when the offset is 0).  Returns the length written,
+    // 0 if the buffer is too small (see ISO8601_SIZE).
+    size_t FormatISO8601( time_t utc, char *buffer, size_t size ) const;
+
+    // The same, in UTC
+    static size_t FormatISO8601UTC( time_t utc, char *buffer, size_t size );
+
+    protected:
+
+    //=================================================================
+    // SUBCLASS INTERFACE   
+    //=================================================================
+
+    // None.
+
+    private:
+
+    //=================================================================
+    // CUSTOMIZATION INTERFACE    
+    //=================================================================
+
+    // None.
+
+    //=================================================================
+    // IMPLEMENTATION INTERFACE    
+    //=================================================================
+
+    // When DST starts or ends each year
+    struct Rule
+    {
+        enum Type
+        {
+            JULIAN_NO_LEAP = 0,     // Jn, 1..365, Feb 29 never counted
+            JULIAN,                 // n, 0..365
+            MONTH_WEEK_DAY          // Mm.w.d
+        };
+
+        Type type;
+        int16_t day;
+        uint8_t month;
+        uint8_t week;
+        int32_t timeSeconds;
+    };
+
+    // Days since 1970-01-01 of the rule's date in year
+    static int64_t ruleDay( const Rule &rule, int year );
+
+    // Refills the cache with the stretch around utc
+    void fillCache( int64_t utc ) const;
+
+    static size_t format( int64_t local, int32_t offset, char *buffer, size_t size );
+
+    //=================================================================
+    // DATA MEMBERS    
+    //=================================================================
+
+    int32_t _stdOffset;
+    int32_t _dstOffset;
+    bool _hasDST;
+
+    Rule _start;
+    Rule _end;
+
+    // The stretch of time we last converted in, and its offset.  
+    // Mutable, it is only a cache.
+    mutable int64_t _cacheFrom;
+    mutable int64_t _cacheUntil;
+    mutable int32_t _cacheOffset;
+};
+
+//======================================================================
+// INLINE FUNCTION DEFINITIONS
+//======================================================================
+
+// None.
+
+
+/*======================================================================
+// DOCUMENTATION
+========================================================================
+
+None.
+
+======================================================================*/
+
+#endif	// #ifendif _JAROFLIGHT_TIMEZONE_H_
@@ -0,0 +1,444 @@
+/*======================================================================
+FILE:
+uartpixeldriver.cpp
+
+CREATOR:
+Sean Foley
+
+GENERAL DESCRIPTION:
+Non-blocking neopixel output driver using the ESP8266 UART1.
+
+PUBLIC CLASSES AND FUNCTIONS:
+UartPixelDriver
+
+INITIALIZATION AND SEQUENCING REQUIREMENTS:
+None.
+
+Copyright (C) 2017 Sean Foley  All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted.  Enjoy.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+======================================================================*/
+
+//======================================================================
+// INCLUDES AND VARIABLE DEFINITIONS
+//======================================================================
+
+//----------------------------------------------------------------------
+// Defines
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Include Files
+//----------------------------------------------------------------------
+
+#include "uartpixeldriver.h"
+
+#include <esp8266_peripherals.h>
+
+//----------------------------------------------------------------------
+// Type Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Constant Definitions
+//----------------------------------------------------------------------
+
+// 4 UART bits per neopixel bit at 800KHz
+const uint32_t UART_BAUD = 3200000UL;
+
+// Hardware TX FIFO depth
+const uint32_t UART_FIFO_SIZE = 128;
+
+// Refill the FIFO when it drops below this many bytes
+const uint32_t UART_FIFO_THRESHOLD = 32;
+
+// Newer WS2812 parts need the line low for 280us to latch a frame,
+// give it some margin
+const uint32_t LATCH_US = 300;
+
+// Each neopixel byte is 4 UART bytes, and we send r, g, b, w
+const uint32_t UART_BYTES_PER_PIXEL = 16;
+
+// Two neopixel bits (msb first) -> one 6 bit UART byte.  The TX line
+// is inverted, so the start bit is the high part of the first bit and
+// the stop bit is the low tail of the second.
+static const uint8_t ENCODE_TABLE[4] = 
+{
+    0b110111,   // 0 0
+    0b000111,   // 0 1
+    0b110100,   // 1 0
+    0b000100    // 1 1
+};
+
+//----------------------------------------------------------------------
+// Global Data Definitions
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Static Variable Definitions 
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Function Prototypes
+//----------------------------------------------------------------------
+
+// Only one driver can own UART1
+static UartPixelDriver *s_activeDriver = nullptr;
+
+//----------------------------------------------------------------------
+// Required Libraries
+//----------------------------------------------------------------------
+
+// None. (Where supported these should be in the form
+// of C++ pragmas).
+
+//======================================================================
+// FUNCTION IMPLEMENTATIONS
+//======================================================================
+
+/*======================================================================
+FUNCTION:
+UartPixelDriver()
+
+DESCRIPTION:
+C-tor
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+UartPixelDriver::UartPixelDriver( uint32_t pixelCount )
+    : _pixelCount( pixelCount ),
+      _frameBytes( pixelCount * UART_BYTES_PER_PIXEL ),
+      _front( new uint8_t[pixelCount * UART_BYTES_PER_PIXEL] ),
+      _back( new uint8_t[pixelCount * UART_BYTES_PER_PIXEL] )
+{
+}
+
+/*======================================================================
+FUNCTION:
+~UartPixelDriver()
+
+DESCRIPTION:
+D-tor.  Stops the interrupt handler if it is ours.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+UartPixelDriver::~UartPixelDriver()
+{
+    if ( s_activeDriver == this )
+    {
+        USIE( UART1 ) = 0;
+        s_activeDriver = nullptr;
+    }
+}
+
+/*======================================================================
+FUNCTION:
+Begin()
+
+DESCRIPTION:
+Sets UART1 up as a WS2812 encoder: 3.2Mbaud, 6 data bits, 1 stop 
+bit, inverted TX, then hooks up our interrupt handler.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+Takes over the (shared) UART interrupt
+
+======================================================================*/
+void UartPixelDriver::Begin()
+{
+    s_activeDriver = this;
+
+    pinMode( GPIO_DATA_PIN, SPECIAL );
+
+    USD( UART1 ) = ESP8266_CLOCK / UART_BAUD;
+
+    // 6 data bits (UCBN = 1), 1 stop bit (UCSBN = 1), inverted TX
+    USC0( UART1 ) = ( 1 << UCBN ) | ( 1 << UCSBN ) | ( 1 << UCTXI );
+
+    // Reset the FIFOs
+    USC0( UART1 ) |= ( 1 << UCTXRST ) | ( 1 << UCRXRST );
+    USC0( UART1 ) &= ~( ( 1 << UCTXRST ) | ( 1 << UCRXRST ) );
+
+    // Interrupt when the TX FIFO drops below the threshold
+    USC1( UART1 ) = ( UART_FIFO_THRESHOLD << UCFET );
+
+    USIE( UART1 ) = 0;
+    USIC( UART1 ) = 0xFFFF;
+
+    ETS_UART_INTR_ATTACH( &UartPixelDriver::uartInterrupt, this );
+    ETS_UART_INTR_ENABLE();
+}
+
+/*======================================================================
+FUNCTION:
+Show()
+
+DESCRIPTION:
+Encodes the frame into the back buffer and kicks it off if the line 
+is free.  This never waits on the hardware.  If the previous frame is 
+still going out, the new one waits in the back buffer (replacing any
+other frame that was waiting there) until Process() can start it.
+
+RETURN VALUE:
+true, the frame is always taken
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+bool UartPixelDriver::Show( const uint32_t *pixels, uint32_t count )
+{
+    if ( count > _pixelCount )
+    {
+        count = _pixelCount;
+    }
+
+    uint8_t *out = _back.get();
+
+    for ( uint32_t i = 0; i < count; i++ )
+    {
+        uint32_t c = pixels[i];
+
+        // Wire order is g, r, b, w, the same as NEO_GRBW
+        uint8_t bytes[4] = 
+        { 
+            (uint8_t) ( c >> 8 ), 
+            (uint8_t) ( c >> 16 ), 
+            (uint8_t) c, 
+            (uint8_t) ( c >> 24 ) 
+        };
+
+        for ( int j = 0; j < 4; j++ )
+        {
+            uint8_t b = bytes[j];
+
+            *out++ = ENCODE_TABLE[( b >> 6 ) & 0x03];
+            *out++ = ENCODE_TABLE[( b >> 4 ) & 0x03];
+            *out++ = ENCODE_TABLE[( b >> 2 ) & 0x03];
+            *out++ = ENCODE_TABLE[b & 0x03];
+        }
+    }
+
+    _pending = true;
+
+    startNextFrame();
+
+    return true;
+}
+
+/*======================================================================
+FUNCTION:
+Process()
+
+DESCRIPTION:
+Starts a waiting frame once the line is free.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void UartPixelDriver::Process()
+{
+    if ( _pending == true )
+    {
+        startNextFrame();
+    }
+}
+
+/*======================================================================
+FUNCTION:
+latchDone()
+
+DESCRIPTION:
+Checks if the previous frame has completely left the UART and the
+line has been idle long enough for the pixels to latch it.
+
+RETURN VALUE:
+true if we can start another frame
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+bool UartPixelDriver::latchDone()
+{
+    if ( _sending == true )
+    {
+        _idle = false;
+        return false;
+    }
+
+    // The interrupt handler is done once the last byte is in the 
+    // FIFO, but the FIFO still has to drain
+    uint32_t fifoCount = ( USS( UART1 ) >> USTXC ) & 0xFF;
+
+    if ( fifoCount > 0 )
+    {
+        _idle = false;
+        return false;
+    }
+
+    if ( _idle == false )
+    {
+        _idle = true;
+        _idleSinceUS = micros();
+    }
+
+    return ( micros() - _idleSinceUS ) >= LATCH_US;
+}
+
+/*======================================================================
+FUNCTION:
+startNextFrame()
+
+DESCRIPTION:
+Swaps the waiting back buffer to the front and starts sending it, as
+long as the line is free.  The interrupt handler never touches the back
+buffer, so the swap is safe while it is idle.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void UartPixelDriver::startNextFrame()
+{
+    if ( _pending == false || latchDone() == false )
+    {
+        return;
+    }
+
+    _front.swap( _back );
+    _pending = false;
+
+    _txPos = _front.get();
+    _txEnd = _front.get() + _frameBytes;
+    _sending = true;
+    _idle = false;
+
+    // Prime the FIFO, then let the interrupt keep it fed
+    fillFifo();
+
+    USIC( UART1 ) = ( 1 << UIFE );
+    USIE( UART1 ) |= ( 1 << UIFE );
+}
+
+/*======================================================================
+FUNCTION:
+fillFifo()
+
+DESCRIPTION:
+Tops up the UART TX FIFO from the front buffer.  Runs from the 
+interrupt handler, so it lives in IRAM.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void IRAM_ATTR UartPixelDriver::fillFifo()
+{
+    const uint8_t *pos = _txPos;
+    const uint8_t *end = _txEnd;
+
+    uint32_t room = UART_FIFO_SIZE - ( ( USS( UART1 ) >> USTXC ) & 0xFF );
+
+    while ( room > 0 && pos < end )
+    {
+        USF( UART1 ) = *pos++;
+        room--;
+    }
+
+    _txPos = pos;
+
+    if ( pos >= end )
+    {
+        // Everything is queued up - no more interrupts needed
+        USIE( UART1 ) &= ~( 1 << UIFE );
+        _sending = false;
+    }
+}
+
+/*======================================================================
+FUNCTION:
+uartInterrupt()
+
+DESCRIPTION:
+UART interrupt handler.  The interrupt is shared between both UARTs, 
+and this replaces the core's handler, so we clear (and drop) anything
+UART0 raises - which is what stops Serial receive.  See the NOTE in 
+the header.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void IRAM_ATTR UartPixelDriver::uartInterrupt( void *arg, void *frame )
+{
+    (void) frame;
+
+    UartPixelDriver *self = static_cast< UartPixelDriver * >( arg );
+
+    uint32_t status = USIS( UART1 );
+
+    if ( status & ( 1 << UIFE ) )
+    {
+        self->fillFifo();
+    }
+
+    USIC( UART1 ) = status;
+
+    // Not ours, but it has to be cleared or we'd be called forever
+    USIC( 0 ) = USIS( 0 );
+}
+
+/*=====================================================================
+// IMPLEMENTATION NOTES
+//=====================================================================
+
+None
+
+=====================================================================*/
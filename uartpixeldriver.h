@@ -0,0 +1,231 @@
+#ifndef _JAROFLIGHT_UARTPIXELDRIVER_H_
+#define _JAROFLIGHT_UARTPIXELDRIVER_H_
+
+/*======================================================================
+FILE:
+uartpixeldriver.h
+
+CREATOR:
+Sean Foley
+
+DESCRIPTION:
+Non-blocking neopixel output driver using the ESP8266 UART1.
+
+PUBLIC CLASSES AND FUNCTIONS:
+UartPixelDriver
+
+Copyright (C) 2017 Sean Foley  All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted.  Enjoy.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+======================================================================*/
+
+//======================================================================
+// INCLUDES AND PUBLIC DATA DECLARATIONS
+//======================================================================
+
+//----------------------------------------------------------------------
+// Defines
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Include Files
+//----------------------------------------------------------------------
+
+#include <stdint.h>
+
+#include <memory>
+
+#include <Arduino.h>
+
+#include "pixeldriver.h"
+
+//----------------------------------------------------------------------
+// Type Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Constant Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Data Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//======================================================================
+// WARNINGS!!!
+//======================================================================
+
+// None.
+
+//======================================================================
+// FUNCTION DECLARATIONS
+//======================================================================
+
+// None.
+
+//=====================================================================
+// EXCEPTION CLASS DEFINITIONS
+//=====================================================================
+
+// None.
+
+//======================================================================
+// CLASS DEFINITIONS
+//======================================================================
+
+/*======================================================================
+CLASS:
+UartPixelDriver
+
+DESCRIPTION:
+Non-blocking PixelDriver for the ESP8266.  It uses UART1 as a WS2812
+encoder: at 3.2Mbaud with 6 data bits and an inverted TX line, every 
+UART byte (start + 6 data + stop bits) is exactly two neopixel bits.  
+The UART is fed from its TX FIFO empty interrupt, so the CPU is free 
+(with interrupts on) while the frame goes out.
+
+Frames are double buffered.  Show() encodes into the back buffer and
+returns right away; the back buffer is swapped to the front and sent 
+as soon as the previous frame (and the reset/latch time after it) is 
+done.  If frames come in faster than they can be sent, the newest one
+wins.
+
+HOW TO USE:
+1. Construct with the # of pixels
+2. Hand it to a LedAnimator (which calls Show()/Process() for you)
+
+NOTE: UART1 TX only comes out on GPIO2, so the neopixel data line has
+to be wired to GPIO2.  This also means GPIO2 can't be used for anything
+else (like the network status LED).
+
+NOTE: Both UARTs share one interrupt, and the SDK only keeps one 
+handler for it, with no way to get the old one back to chain to.  So 
+this driver takes the interrupt over from the core's Serial: anything
+received on UART0 is thrown away, and Serial.available()/read() never
+see it.  Transmit (Serial.printf() etc.) doesn't use the interrupt and
+is fine.  Call Serial.begin() before constructing the driver - 
+Serial.begin() attaches the core's handler again, which would stop 
+the pixels instead.
+
+======================================================================*/
+class UartPixelDriver : public PixelDriver
+{
+    public:
+
+    //=================================================================
+    // TYPE DECLARATIONS AND CONSTANTS    
+    //=================================================================
+
+    // UART1 TX is hard wired to this pin
+    static const uint8_t GPIO_DATA_PIN = 2;
+
+    //=================================================================
+    // CLIENT INTERFACE
+    //=================================================================
+
+    explicit UartPixelDriver( uint32_t pixelCount );
+    virtual ~UartPixelDriver();
+
+    virtual void Begin();
+
+    virtual bool Show( const uint32_t *pixels, uint32_t count );
+
+    virtual void Process();
+
+    bool IsSending() const { return _sending; }
+
+    protected:
+
+    //=================================================================
+    // SUBCLASS INTERFACE   
+    //=================================================================
+
+    // None.
+
+    private:
+
+    //=================================================================
+    // CUSTOMIZATION INTERFACE    
+    //=================================================================
+
+    // None.
+
+    //=================================================================
+    // IMPLEMENTATION INTERFACE    
+    //=================================================================
+
+    // No copying - intentionally not defining the implementation
+    // to throw a link error if someone somehow invokes a copy.
+    UartPixelDriver( const UartPixelDriver &rhs );
+
+    void startNextFrame();
+    bool latchDone();
+
+    static void IRAM_ATTR uartInterrupt( void *arg, void *frame );
+    void IRAM_ATTR fillFifo();
+
+    //=================================================================
+    // DATA MEMBERS    
+    //=================================================================
+
+    uint32_t _pixelCount;
+
+    // # of encoded bytes in one frame
+    uint32_t _frameBytes;
+
+    // The two encoded frame buffers.  The interrupt handler only
+    // ever reads from the front buffer.
+    std::unique_ptr< uint8_t[] > _front;
+    std::unique_ptr< uint8_t[] > _back;
+
+    // The back buffer holds a frame that hasn't been sent yet
+    bool _pending = false;
+
+    // Read/written by the interrupt handler
+    volatile bool _sending = false;
+    const uint8_t * volatile _txPos = nullptr;
+    const uint8_t * volatile _txEnd = nullptr;
+
+    // micros() when we first noticed the line went idle, used to time
+    // the reset/latch gap between frames
+    bool _idle = true;
+    uint32_t _idleSinceUS = 0;
+};
+
+//======================================================================
+// INLINE FUNCTION DEFINITIONS
+//======================================================================
+
+// None.
+
+
+/*======================================================================
+// DOCUMENTATION
+========================================================================
+
+None.
+
+======================================================================*/
+
+#endif	// #ifendif _JAROFLIGHT_UARTPIXELDRIVER_H_
@@ -49,8 +49,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "webserverproxy.h"
 
-// std::bind support
-#include <functional>
+#include <string.h>
 
 //----------------------------------------------------------------------
 // Type Declarations
@@ -74,7 +73,25 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 // Static Variable Definitions 
 //----------------------------------------------------------------------
 
-// None
+// Every endpoint.  {name} in a path matches one segment, and the 
+// handler gets it from the server's GetPathArg().
+const WebserverProxy::Route WebserverProxy::ROUTES[] =
+{
+    { "/",                      &WebserverProxy::handleRoot },
+    { "/led/command/{name}",    &WebserverProxy::handleCommand },
+    { "/led/set",               &WebserverProxy::handleSet },
+    { "/led/batch",             &WebserverProxy::handleBatch },
+    { "/led/animations",        &WebserverProxy::handleAnimations },
+    { "/led/layer",             &WebserverProxy::handleLayer }
+};
+
+const WebserverProxy::Route WebserverProxy::SCHEDULE_ROUTES[] =
+{
+    { "/schedule",              &WebserverProxy::handleSchedule },
+    { "/schedule/add",          &WebserverProxy::handleScheduleAdd },
+    { "/schedule/remove",       &WebserverProxy::handleScheduleRemove },
+    { "/schedule/clear",        &WebserverProxy::handleScheduleClear }
+};
 
 //----------------------------------------------------------------------
 // Function Prototypes
@@ -130,7 +147,33 @@ none
 ======================================================================*/
 void WebserverProxy::Begin()
 {
-    _server.begin();
+    _server.Begin();
+}
+
+/*======================================================================
+FUNCTION:
+AddStatusPage()
+
+DESCRIPTION:
+Adds a plain text page at the given URI.  The provider is called to
+build the page every time it is requested.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void WebserverProxy::AddStatusPage( const char *uri, std::function< String( void ) > provider )
+{
+    _server.On( uri, [this, provider]()
+    {
+        String message = provider();
+
+        setNoCacheHeaders();
+        _server.Send( 200, "text/plain", message );
+    } );
 }
 
 /*======================================================================
@@ -139,7 +182,8 @@ Process()
 
 DESCRIPTION:
 Let's the web server do its thing. If you don't call this periodically
-(like in a tight loop) the web server will be unresponsive to clients.
+(like in a tight loop) requests will sit there unanswered.  It never
+waits on a client.
 
 RETURN VALUE:
 none.
@@ -150,11 +194,9 @@ none
 ======================================================================*/
 void WebserverProxy::Process()
 {
-    // Pump the server so it can do things
-    _server.handleClient();
-
-    // Just in case the caller is calling this in a tight loop
-    yield();
+    // Runs the handler for a request that has come in (the server
+    // reads them from the network in the background)
+    _server.Process();
 }
 
 /*======================================================================
@@ -174,25 +216,20 @@ none
 ======================================================================*/
 void WebserverProxy::init()
 {
-    _server.on( "/", std::bind( &WebserverProxy::handleRoot, this ) );
-    _server.on( "/", std::bind( &WebserverProxy::handleNotFound, this ) );
-
-    _server.on( "/led/command/on", std::bind( &WebserverProxy::handleAllOn, this ));
-    _server.on( "/led/command/off", std::bind( &WebserverProxy::handleAllOff, this ) );
-    _server.on( "/led/command/wheel", std::bind( &WebserverProxy::handleColorWheel, this ) );
-    _server.on( "/led/command/pulse", std::bind( &WebserverProxy::handlePulse, this ) );
-    _server.on( "/led/command/strobe", std::bind( &WebserverProxy::handleStrobe, this ));
-    _server.on( "/led/command/flicker", std::bind( &WebserverProxy::handleFlicker, this ) );
-    _server.on( "/led/command/demo", std::bind( &WebserverProxy::handleDemo, this ) );
+    addRoutes( ROUTES, sizeof( ROUTES ) / sizeof( ROUTES[0] ) );
+
+    _server.OnNotFound( [this]() { handleNotFound(); } );
+
+    AddStatusPage( "/status/web", [this]() { return _server.Report(); } );
 }
 
 /*======================================================================
 FUNCTION:
-handleAlOn()
+addRoutes()
 
 DESCRIPTION:
-Callback handler that will then use the led animator to turn all the
-neopixels on.
+Adds a table of routes to the server, each calling its handler on
+this object.
 
 RETURN VALUE:
 none.
@@ -201,23 +238,220 @@ SIDE EFFECTS:
 none
 
 ======================================================================*/
-void WebserverProxy::handleAllOn()
+void WebserverProxy::addRoutes( const Route *routes, size_t count )
 {
-    _ledAnimator->TurnAllOn();
+    for ( size_t i = 0; i < count; i++ )
+    {
+        RouteHandler handler = routes[i].handler;
+
+        _server.On( routes[i].pattern, [this, handler]() { ( this->*handler )(); } );
+    }
+}
+
+/*======================================================================
+FUNCTION:
+handleCommand()
+
+DESCRIPTION:
+Callback handler for /led/command/{name}, which starts the named 
+animation from the registry (or the demo, for "demo").  Takes the 
+optional color, brightness, speed and transition arguments that 
+/led/set does, but not animation - the path has already said which.
+An animation we don't have is a 404, as if it had its own endpoint.
 
-    String message = "on";
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void WebserverProxy::handleCommand()
+{
+    RequestParams::Look look;
+    RequestParams::Clear( look );
+
+    if ( RequestParams::ParseAnimation( _server.GetPathArg( "name" ), look.animation ) == false )
+    {
+        handleNotFound();
+        return;
+    }
+
+    bool ok = ( parseLook( look ) == true &&
+                ( look.fields & RequestParams::FIELD_ANIMATION ) == 0 );
+
+    look.fields |= RequestParams::FIELD_ANIMATION;
+
+    sendLook( ok, look );
+}
+
+/*======================================================================
+FUNCTION:
+handleSet()
+
+DESCRIPTION:
+Callback handler for /led/set, which sets a full look in one request:
+    animation=<name>     from the registry, or demo
+    color=<color>        rrggbb or wwrrggbb in hex, or r,g,b[,w]
+    brightness=<0..255>
+    speed=<0..1000>      percent of normal
+    transition=<ms>      crossfade time
+All of them are optional, but at least one is needed.  Anything not
+given is left as it is.  If any of them are bad, nothing is changed
+and the answer is a 400.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void WebserverProxy::handleSet()
+{
+    RequestParams::Look look;
+    RequestParams::Clear( look );
+
+    bool ok = parseLook( look ) && look.fields != 0;
+
+    sendLook( ok, look );
+}
+
+/*======================================================================
+FUNCTION:
+handleBatch()
+
+DESCRIPTION:
+Callback handler for /led/batch, which takes a list of the /led/set
+parameters in the body of a POST, one name=value per line:
+
+    animation=pulse
+    color=ff0000
+    brightness=128
+
+They are all checked before anything is changed, then applied 
+together at the next frame, so no frame ever shows half of the batch.
+A form encoded body (or a query string) works too - its fields are
+decoded by the server, so they are read from the arguments.  The 
+answer is what is running, or a 400 that says which item (counting 
+from 1, blank lines aside) was bad.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void WebserverProxy::handleBatch()
+{
+    RequestParams::Look look;
+    RequestParams::Clear( look );
+
+    // The body sits in the server's request buffer, so it can be 
+    // split up right where it is
+    char *body = _server.GetBody();
+
+    if ( body == nullptr || _server.IsForm() == true )
+    {
+        sendLook( parseLook( look ) && look.fields != 0, look );
+        return;
+    }
+
+    size_t badItem = 0;
+
+    if ( RequestParams::ParseList( body, look, badItem ) == true )
+    {
+        sendLook( look.fields != 0, look );
+        return;
+    }
+
+    char message[40];
+    snprintf( message, sizeof( message ), "bad batch item %u", (unsigned) badItem );
+
+    setNoCacheHeaders();
+    _server.Send( 400, "text/plain", message );
+}
+
+/*======================================================================
+FUNCTION:
+parseLook()
+
+DESCRIPTION:
+Parses all of the request's arguments into look.  The arguments are 
+compared where they sit in the request, so nothing is allocated.
+
+RETURN VALUE:
+false if any argument is unknown or bad.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+bool WebserverProxy::parseLook( RequestParams::Look &look )
+{
+    for ( size_t i = 0; i < _server.GetArgCount(); i++ )
+    {
+        if ( RequestParams::Parse( _server.GetArgName( i ), _server.GetArg( i ), look ) == false )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*======================================================================
+FUNCTION:
+sendLook()
+
+DESCRIPTION:
+Applies a parsed look, if it parsed, and answers the request with 
+what is now running (or a 400).
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void WebserverProxy::sendLook( bool ok, const RequestParams::Look &look )
+{
+    const char *message = "bad led request";
+
+    if ( ok == true )
+    {
+        ok = RequestParams::Apply( look, *_ledAnimator );
+    }
+
+    if ( ok == true )
+    {
+        if ( ( look.fields & RequestParams::FIELD_ANIMATION ) == 0 )
+        {
+            message = "set";
+        }
+        else if ( look.animation == RequestParams::DEMO )
+        {
+            message = "demo";
+        }
+        else
+        {
+            message = AnimationRegistry::Get( look.animation )->Name();
+        }
+    }
 
     setNoCacheHeaders();
-    _server.sendHeader( "Content-Length", String( message.length() ) );
-    _server.send( 200, "text/plain", message );
+    _server.Send( ( ok == true ) ? 200 : 400, "text/plain", message );
 }
 
 /*======================================================================
 FUNCTION:
-handleAllOff()
+handleAnimations()
 
 DESCRIPTION:
-Callback handler that will turn all of the leds off
+Callback handler that lists all of the animations we know about, one
+per line.
 
 RETURN VALUE:
 none.
@@ -226,24 +460,34 @@ SIDE EFFECTS:
 none
 
 ======================================================================*/
-void WebserverProxy::handleAllOff()
+void WebserverProxy::handleAnimations()
 {
-    _ledAnimator->TurnAllOff();
+    String message;
+
+    for ( uint32_t i = 0; i < AnimationRegistry::Count(); i++ )
+    {
+        message += AnimationRegistry::Get( i )->Name();
+        message += "\n";
+    }
 
-    String message = "off";
+    message += "demo\n";
 
     setNoCacheHeaders();
-    _server.sendHeader( "Content-Length", String( message.length() ) );
-    _server.send( 200, "text/plain", message );
+    _server.Send( 200, "text/plain", message );
 }
 
 /*======================================================================
 FUNCTION:
-handleColorWheel()
+handleLayer()
 
 DESCRIPTION:
-Callback handler that will cause the leds to cycle thru a color wheel
-of animation
+Callback handler that sets (or clears) one of the overlay layers.
+Arguments are:
+    layer=<0..n>       which layer, defaults to 0
+    animation=<name>   what to run on it, "none" clears the layer
+    mode=<name>        normal, add, multiply or max, defaults to normal
+    opacity=<0..255>   defaults to 255
+    color=<color>      defaults to the current color
 
 RETURN VALUE:
 none.
@@ -252,23 +496,50 @@ SIDE EFFECTS:
 none
 
 ======================================================================*/
-void WebserverProxy::handleColorWheel()
+void WebserverProxy::handleLayer()
 {
-    _ledAnimator->CycleThruColorWheel();
+    const char *layerArg = _server.GetArg( "layer" );
+    const char *opacityArg = _server.GetArg( "opacity" );
+    const char *modeArg = _server.GetArg( "mode" );
+    const char *colorArg = _server.GetArg( "color" );
+    const char *animation = _server.GetArg( "animation" );
 
-    String message = "wheel";
+    uint32_t layer = 0;
+    uint32_t opacity = 255;
+    uint32_t color = _ledAnimator->GetColor();
+
+    Compositor::BlendMode mode = Compositor::BLEND_NORMAL;
+
+    bool ok = ( animation != nullptr ) &&
+              ( layerArg == nullptr || RequestParams::ParseUnsigned( layerArg, _ledAnimator->GetLayerCount() - 1, layer ) ) &&
+              ( opacityArg == nullptr || RequestParams::ParseUnsigned( opacityArg, 255, opacity ) ) &&
+              ( modeArg == nullptr || Compositor::FindBlendMode( modeArg, mode ) ) &&
+              ( colorArg == nullptr || RequestParams::ParseColor( colorArg, color ) );
+
+    if ( ok == true )
+    {
+        if ( strcmp( animation, "none" ) == 0 )
+        {
+            _ledAnimator->ClearLayer( (uint8_t) layer );
+        }
+        else
+        {
+            ok = _ledAnimator->SetLayer( (uint8_t) layer, animation, color, (uint8_t) opacity, mode );
+        }
+    }
+
+    String message = ( ok == true ) ? "layer" : "bad layer request";
 
     setNoCacheHeaders();
-    _server.sendHeader( "Content-Length", String( message.length() ) );
-    _server.send( 200, "text/plain", message );
+    _server.Send( ( ok == true ) ? 200 : 400, "text/plain", message );
 }
 
 /*======================================================================
 FUNCTION:
-handlePulse()
+SetSchedule()
 
 DESCRIPTION:
-Callback handler that will make the leds pulse
+Hooks up the schedule and the /schedule endpoints that manage it.
 
 RETURN VALUE:
 none.
@@ -277,23 +548,47 @@ SIDE EFFECTS:
 none
 
 ======================================================================*/
-void WebserverProxy::handlePulse()
+void WebserverProxy::SetSchedule( std::shared_ptr<ScheduleStore> schedule )
 {
-    _ledAnimator->AllPulse();
+    _schedule = schedule;
+
+    addRoutes( SCHEDULE_ROUTES, sizeof( SCHEDULE_ROUTES ) / sizeof( SCHEDULE_ROUTES[0] ) );
+}
+
+/*======================================================================
+FUNCTION:
+handleSchedule()
+
+DESCRIPTION:
+Callback handler that lists the schedule's rules.
+
+RETURN VALUE:
+none.
 
-    String message = "pulse";
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void WebserverProxy::handleSchedule()
+{
+    String message = _schedule->Report();
 
     setNoCacheHeaders();
-    _server.sendHeader( "Content-Length", String( message.length() ) );
-    _server.send( 200, "text/plain", message );
+    _server.Send( 200, "text/plain", message );
 }
 
 /*======================================================================
 FUNCTION:
-handleStrobe()
+handleScheduleAdd()
 
 DESCRIPTION:
-Callback handler that will cause the leds to strobe
+Callback handler that adds a rule to the schedule.  Arguments are:
+    time=<hh:mm>       local time, 24 hour clock
+    days=<days>        all, weekdays, weekends, or a list like 
+                       mon,wed,fri.  Defaults to all.
+    animation=<name>   what to start, "demo" for the demo
+    color=<color>      rrggbb or wwrrggbb in hex, or r,g,b[,w].
+                       Defaults to the current color.
 
 RETURN VALUE:
 none.
@@ -302,23 +597,47 @@ SIDE EFFECTS:
 none
 
 ======================================================================*/
-void WebserverProxy::handleStrobe()
+void WebserverProxy::handleScheduleAdd()
 {
-    _ledAnimator->AllStrobe();
+    ScheduleStore::Rule rule;
+    memset( &rule, 0, sizeof( rule ) );
+
+    rule.days = ScheduleStore::DAYS_ALL;
+    rule.color = _ledAnimator->GetColor();
+
+    const char *time = _server.GetArg( "time" );
+    const char *days = _server.GetArg( "days" );
+    const char *color = _server.GetArg( "color" );
+    const char *animation = _server.GetArg( "animation" );
+
+    uint32_t index = 0;
+
+    bool ok = ( time != nullptr && ScheduleStore::ParseTime( time, rule.hour, rule.minute ) ) &&
+              RequestParams::ParseAnimation( animation, index ) &&
+              strlen( animation ) < sizeof( rule.animation ) &&
+              ( days == nullptr || ScheduleStore::ParseDays( days, rule.days ) ) &&
+              ( color == nullptr || RequestParams::ParseColor( color, rule.color ) );
 
-    String message = "strobe";
+    if ( ok == true )
+    {
+        strncpy( rule.animation, animation, sizeof( rule.animation ) - 1 );
+
+        ok = _schedule->Add( rule );
+    }
+
+    String message = ( ok == true ) ? "added" : "bad schedule request";
 
     setNoCacheHeaders();
-    _server.sendHeader( "Content-Length", String( message.length() ) );
-    _server.send( 200, "text/plain", message );
+    _server.Send( ( ok == true ) ? 200 : 400, "text/plain", message );
 }
 
 /*======================================================================
 FUNCTION:
-handleFlicker()
+handleScheduleRemove()
 
 DESCRIPTION:
-Callback handler that will cause the leds to do a flicker animation
+Callback handler that removes a rule from the schedule.  id=<n> is 
+the rule's number in the /schedule list.
 
 RETURN VALUE:
 none.
@@ -327,23 +646,25 @@ SIDE EFFECTS:
 none
 
 ======================================================================*/
-void WebserverProxy::handleFlicker()
+void WebserverProxy::handleScheduleRemove()
 {
-    _ledAnimator->Flicker();
+    uint32_t index = 0;
+
+    bool ok = RequestParams::ParseUnsigned( _server.GetArg( "id" ), ScheduleStore::MAX_RULES, index ) &&
+              _schedule->Remove( index );
 
-    String message = "flicker";
+    String message = ( ok == true ) ? "removed" : "bad schedule request";
 
     setNoCacheHeaders();
-    _server.sendHeader( "Content-Length", String( message.length() ) );
-    _server.send( 200, "text/plain", message );
+    _server.Send( ( ok == true ) ? 200 : 400, "text/plain", message );
 }
 
 /*======================================================================
 FUNCTION:
-handleDemo()
+handleScheduleClear()
 
 DESCRIPTION:
-Callback handler that puts the leds into demo animation mode
+Callback handler that removes all of the rules from the schedule.
 
 RETURN VALUE:
 none.
@@ -352,15 +673,14 @@ SIDE EFFECTS:
 none
 
 ======================================================================*/
-void WebserverProxy::handleDemo()
+void WebserverProxy::handleScheduleClear()
 {
-    _ledAnimator->Demo();
+    _schedule->Clear();
 
-    String message = "demo";
+    String message = "cleared";
 
     setNoCacheHeaders();
-    _server.sendHeader( "Content-Length", String( message.length() ) );
-    _server.send( 200, "text/plain", message );
+    _server.Send( 200, "text/plain", message );
 }
 
 /*======================================================================
@@ -382,21 +702,24 @@ void WebserverProxy::handleNotFound()
 {
     String message = "File Not Found\n\n";
     message += "URI: ";
-    message += _server.uri();
+    message += _server.GetUri();
     message += "\nMethod: ";
-    message += ( _server.method() == HTTP_GET ) ? "GET" : "POST";
+    message += ( _server.GetMethod() == HttpServer::METHOD_GET ) ? "GET" : "POST";
     message += "\nArguments: ";
-    message += _server.args();
+    message += (unsigned) _server.GetArgCount();
     message += "\n";
 
-    for ( uint8_t i = 0; i < _server.args(); i++ )
+    for ( size_t i = 0; i < _server.GetArgCount(); i++ )
     {
-        message += " " + _server.argName( i ) + ": " + _server.arg( i ) + "\n";
+        message += " ";
+        message += _server.GetArgName( i );
+        message += ": ";
+        message += _server.GetArg( i );
+        message += "\n";
     }
 
     setNoCacheHeaders();
-    _server.sendHeader( "Content-Length", String( message.length() ) );
-    _server.send( 404, "text/plain", message );
+    _server.Send( 404, "text/plain", message );
 }
 
 /*======================================================================
@@ -418,8 +741,7 @@ void WebserverProxy::handleRoot()
     String message = "Hi there from the jar-o-light!";
 
     setNoCacheHeaders();
-    _server.sendHeader( "Content-Length", String( message.length() ) );
-    _server.send( 200, "text/plain", message );
+    _server.Send( 200, "text/plain", message );
 }
 
 
@@ -440,9 +762,9 @@ none
 ======================================================================*/
 void WebserverProxy::setNoCacheHeaders()
 {
-    _server.sendHeader( "Cache-Control", "no-cache, no-store, must-revalidate" );
-    _server.sendHeader( "Pragma", "no-cache" );
-    _server.sendHeader( "Expires", "-1" );
+    _server.SendHeader( "Cache-Control", "no-cache, no-store, must-revalidate" );
+    _server.SendHeader( "Pragma", "no-cache" );
+    _server.SendHeader( "Expires", "-1" );
 }
 
 /*=====================================================================
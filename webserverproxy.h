@@ -46,9 +46,12 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 // Include Files
 //----------------------------------------------------------------------
 
-#include <ESP8266WebServer.h>
+#include <functional>
 
+#include "httpserver.h"
 #include "ledanimator.h"
+#include "requestparams.h"
+#include "schedulestore.h"
 
 //----------------------------------------------------------------------
 // Type Declarations
@@ -98,11 +101,17 @@ DESCRIPTION:
 Proxy class to hide the complexity of using a webserver.  This class
 sets up our REST-like endpoints.
 
+The endpoints are all in one static table (ROUTES), which the server
+turns into its route trie at startup.  Every animation in the 
+registry is reached through the one /led/command/{name} route, and
+anything that matches nothing gets handleNotFound().
+
 HOW TO USE:
 1. Construct with the required parameters
 2. Call Begin() to start everything
 3. Periodically call Process() to allow the web server handlers to
-do their thing.
+do their thing.  Requests are read from the network in the 
+background (see HttpServer), so this is quick.
 
 ======================================================================*/
 class WebserverProxy
@@ -125,6 +134,13 @@ class WebserverProxy
 
     void Process();
 
+    // Serves the text the provider returns at the given URI.  Handy
+    // for exposing diagnostics from other parts of the program.
+    void AddStatusPage( const char *uri, std::function< String( void ) > provider );
+
+    // Adds the /schedule endpoints for managing the schedule
+    void SetSchedule( std::shared_ptr<ScheduleStore> schedule );
+
     protected:
 
     //=================================================================
@@ -136,13 +152,15 @@ class WebserverProxy
     //
     void handleRoot();
     void handleNotFound();
-    void handleAllOn();
-    void handleAllOff();
-    void handleColorWheel();
-    void handlePulse();
-    void handleStrobe();
-    void handleFlicker();
-    void handleDemo();
+    void handleCommand();
+    void handleSet();
+    void handleBatch();
+    void handleAnimations();
+    void handleLayer();
+    void handleSchedule();
+    void handleScheduleAdd();
+    void handleScheduleRemove();
+    void handleScheduleClear();
 
     // Sets the HTTP response headers to 
     // tell the client to not cache the response
@@ -166,13 +184,36 @@ class WebserverProxy
 
     void init();
 
+    // Parses every argument of the request into look
+    bool parseLook( RequestParams::Look &look );
+
+    // Applies look if ok, and answers the request either way
+    void sendLook( bool ok, const RequestParams::Look &look );
+
+    typedef void ( WebserverProxy::*RouteHandler )( void );
+
+    struct Route
+    {
+        const char *pattern;
+        RouteHandler handler;
+    };
+
+    // Hands each of the routes to the server
+    void addRoutes( const Route *routes, size_t count );
+
     //=================================================================
     // DATA MEMBERS    
     //=================================================================
 
-    ESP8266WebServer _server;
+    // Our endpoints, and the /schedule ones added by SetSchedule()
+    static const Route ROUTES[];
+    static const Route SCHEDULE_ROUTES[];
+
+    HttpServer _server;
 
     std::shared_ptr<LedAnimator> _ledAnimator;
+
+    std::shared_ptr<ScheduleStore> _schedule;
 };
 
 //======================================================================
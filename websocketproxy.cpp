@@ -0,0 +1,461 @@
+/*======================================================================
+FILE:
+websocketproxy.cpp
+
+CREATOR:
+Sean Foley
+
+GENERAL DESCRIPTION:
+WebSocket control and frame streaming.
+
+PUBLIC CLASSES AND FUNCTIONS:
+WebSocketProxy
+
+INITIALIZATION AND SEQUENCING REQUIREMENTS:
+A valid network connection must exist
+
+Copyright (C) 2017 Sean Foley  All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted.  Enjoy.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+======================================================================*/
+
+//======================================================================
+// INCLUDES AND VARIABLE DEFINITIONS
+//======================================================================
+
+//----------------------------------------------------------------------
+// Defines
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Include Files
+//----------------------------------------------------------------------
+
+#include "websocketproxy.h"
+#include "requestparams.h"
+
+#include <string.h>
+
+//----------------------------------------------------------------------
+// Type Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Constant Definitions
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Data Definitions
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Static Variable Definitions 
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Function Prototypes
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Required Libraries
+//----------------------------------------------------------------------
+
+// None. (Where supported these should be in the form
+// of C++ pragmas).
+
+//======================================================================
+// FUNCTION IMPLEMENTATIONS
+//======================================================================
+
+/*======================================================================
+FUNCTION:
+WebSocketProxy()
+
+DESCRIPTION:
+C-tor
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+WebSocketProxy::WebSocketProxy( std::shared_ptr<LedAnimator> ledAnimator, uint16_t port )
+    : _server( port ),
+      _ledAnimator( ledAnimator ),
+      _lastNotifyMS( 0 ),
+      _messagesReceived( 0 ),
+      _messagesRejected( 0 )
+{
+    memset( _lastState, 0, sizeof( _lastState ) );
+}
+
+/*======================================================================
+FUNCTION:
+Begin()
+
+DESCRIPTION:
+Starts listening for connections.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void WebSocketProxy::Begin()
+{
+    _server.onEvent( [this]( uint8_t client, WStype_t type, uint8_t *payload, size_t length )
+    {
+        onEvent( client, type, payload, length );
+    } );
+
+    _server.begin();
+
+    // Drop clients that went away without saying so (a phone that
+    // went to sleep), otherwise they hold a slot forever
+    _server.enableHeartbeat( 15000, 3000, 2 );
+}
+
+/*======================================================================
+FUNCTION:
+Process()
+
+DESCRIPTION:
+Reads whatever the clients sent, then lets them know if what is 
+showing changed.  Changes are checked for here rather than where they
+are made, so changes from the web server, the schedule and the other
+jars are all passed on too.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void WebSocketProxy::Process()
+{
+    _server.loop();
+
+    if ( _server.connectedClients() == 0 || millis() - _lastNotifyMS < NOTIFY_INTERVAL_MS )
+    {
+        return;
+    }
+
+    uint8_t state[STATE_SIZE];
+
+    buildState( state );
+
+    if ( memcmp( state, _lastState, STATE_SIZE ) != 0 )
+    {
+        memcpy( _lastState, state, STATE_SIZE );
+        _lastNotifyMS = millis();
+
+        _server.broadcastBIN( state, STATE_SIZE );
+    }
+}
+
+/*======================================================================
+FUNCTION:
+onEvent()
+
+DESCRIPTION:
+Called by the server for everything that happens on a socket.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void WebSocketProxy::onEvent( uint8_t client, WStype_t type, uint8_t *payload, size_t length )
+{
+    switch ( type )
+    {
+        case WStype_CONNECTED:
+        {
+            uint8_t state[STATE_SIZE];
+
+            buildState( state );
+            _server.sendBIN( client, state, STATE_SIZE );
+            break;
+        }
+
+        case WStype_BIN:
+
+            _messagesReceived++;
+
+            if ( handleBinary( client, payload, length ) == false )
+            {
+                _messagesRejected++;
+                sendError( client, ( length > 0 ) ? payload[0] : 0, 0 );
+            }
+            break;
+
+        case WStype_TEXT:
+        {
+            // The server hands us a terminated, writable copy, so the
+            // batch can be split up in place
+            size_t badItem = 0;
+
+            _messagesReceived++;
+
+            if ( handleText( (char *) payload, badItem ) == false )
+            {
+                _messagesRejected++;
+                sendError( client, 0, badItem );
+            }
+            break;
+        }
+
+        default:
+
+            break;
+    }
+}
+
+/*======================================================================
+FUNCTION:
+handleBinary()
+
+DESCRIPTION:
+Checks and applies one binary message.  See the protocol in the header.
+
+RETURN VALUE:
+false if the message is bad.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+bool WebSocketProxy::handleBinary( uint8_t client, const uint8_t *payload, size_t length )
+{
+    if ( length == 0 )
+    {
+        return false;
+    }
+
+    switch ( payload[0] )
+    {
+        case OP_COLOR:
+
+            if ( length != 4 && length != 5 )
+            {
+                return false;
+            }
+
+            _ledAnimator->QueueColor( LedAnimator::Color( payload[1], payload[2], payload[3], 
+                                                          ( length == 5 ) ? payload[4] : 0 ) );
+            return true;
+
+        case OP_BRIGHTNESS:
+
+            if ( length != 2 )
+            {
+                return false;
+            }
+
+            _ledAnimator->QueuePixelBrightness( payload[1] );
+            return true;
+
+        case OP_SPEED:
+        {
+            if ( length != 3 )
+            {
+                return false;
+            }
+
+            uint16_t speed = (uint16_t) ( payload[1] | ( payload[2] << 8 ) );
+
+            if ( speed > LedAnimator::MAX_SPEED )
+            {
+                return false;
+            }
+
+            _ledAnimator->QueueSpeed( speed );
+            return true;
+        }
+
+        case OP_ANIMATION:
+        {
+            if ( length != 2 && length != 4 )
+            {
+                return false;
+            }
+
+            uint32_t transitionMS = ( length == 4 ) ? (uint32_t) ( payload[2] | ( payload[3] << 8 ) ) 
+                                                    : _ledAnimator->GetTransitionTime();
+
+            if ( payload[1] == ANIMATION_DEMO )
+            {
+                _ledAnimator->DemoAt( transitionMS, 0 );
+                return true;
+            }
+
+            return _ledAnimator->Start( payload[1], _ledAnimator->GetColor(), transitionMS );
+        }
+
+        case OP_FRAME:
+        {
+            if ( length < 4 )
+            {
+                return false;
+            }
+
+            uint8_t flags = payload[1];
+            uint32_t offset = payload[2] | ( payload[3] << 8 );
+            uint8_t channels = ( ( flags & FRAME_RGBW ) != 0 ) ? 4 : 3;
+
+            if ( ( length - 4 ) % channels != 0 )
+            {
+                return false;
+            }
+
+            _ledAnimator->SetLivePixels( offset, payload + 4, ( length - 4 ) / channels, channels );
+
+            if ( ( flags & FRAME_MORE ) == 0 )
+            {
+                _ledAnimator->ShowLive();
+            }
+
+            return true;
+        }
+
+        case OP_GET_STATE:
+        {
+            uint8_t state[STATE_SIZE];
+
+            buildState( state );
+            _server.sendBIN( client, state, STATE_SIZE );
+            return true;
+        }
+
+        default:
+
+            return false;
+    }
+}
+
+/*======================================================================
+FUNCTION:
+handleText()
+
+DESCRIPTION:
+Applies a text message, which is a /led/batch list.
+
+RETURN VALUE:
+false if the list is bad (with badItem set), or doesn't go together.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+bool WebSocketProxy::handleText( char *payload, size_t &badItem )
+{
+    RequestParams::Look look;
+    RequestParams::Clear( look );
+
+    if ( RequestParams::ParseList( payload, look, badItem ) == false || look.fields == 0 )
+    {
+        return false;
+    }
+
+    return RequestParams::Apply( look, *_ledAnimator );
+}
+
+/*======================================================================
+FUNCTION:
+buildState()
+
+DESCRIPTION:
+Fills in an OP_STATE message with what is showing.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void WebSocketProxy::buildState( uint8_t *buffer ) const
+{
+    uint32_t animation = AnimationRegistry::Find( _ledAnimator->GetAnimationName() );
+    uint32_t color = _ledAnimator->GetColor();
+    uint16_t speed = _ledAnimator->GetSpeed();
+
+    if ( _ledAnimator->IsDemo() == true || animation > 0xFF )
+    {
+        animation = ANIMATION_DEMO;
+    }
+
+    buffer[0] = OP_STATE;
+    buffer[1] = (uint8_t) animation;
+    buffer[2] = (uint8_t) color;
+    buffer[3] = (uint8_t) ( color >> 8 );
+    buffer[4] = (uint8_t) ( color >> 16 );
+    buffer[5] = (uint8_t) ( color >> 24 );
+    buffer[6] = _ledAnimator->GetPixelBrightness();
+    buffer[7] = (uint8_t) speed;
+    buffer[8] = (uint8_t) ( speed >> 8 );
+    buffer[9] = ( _ledAnimator->IsDemo() ? 0x01 : 0 ) | ( _ledAnimator->IsLive() ? 0x02 : 0 );
+}
+
+/*======================================================================
+FUNCTION:
+sendError()
+
+DESCRIPTION:
+Tells a client its message was bad, and for a text message which item
+in it (1 based, 0 if they all parsed but don't go together).  An item
+past 255 is reported as 255.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void WebSocketProxy::sendError( uint8_t client, uint8_t opcode, size_t item )
+{
+    uint8_t message[3] = { OP_ERROR, opcode, (uint8_t) ( ( item > 255 ) ? 255 : item ) };
+
+    _server.sendBIN( client, message, sizeof( message ) );
+}
+
+/*=====================================================================
+// IMPLEMENTATION NOTES
+//=====================================================================
+
+None
+
+=====================================================================*/
@@ -0,0 +1,272 @@
+#ifndef _JAROFLIGHT_WEBSOCKETPROXY_H_
+#define _JAROFLIGHT_WEBSOCKETPROXY_H_
+
+/*======================================================================
+FILE:
+websocketproxy.h
+
+CREATOR:
+Sean Foley
+
+DESCRIPTION:
+WebSocket control and frame streaming.
+
+PUBLIC CLASSES AND FUNCTIONS:
+WebSocketProxy
+
+Copyright (C) 2017 Sean Foley  All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted.  Enjoy.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+======================================================================*/
+
+//======================================================================
+// INCLUDES AND PUBLIC DATA DECLARATIONS
+//======================================================================
+
+//----------------------------------------------------------------------
+// Defines
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Include Files
+//----------------------------------------------------------------------
+
+#include <stdint.h>
+
+#include <memory>
+
+#include <WebSocketsServer.h>
+
+#include "ledanimator.h"
+
+//----------------------------------------------------------------------
+// Type Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Constant Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Data Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//======================================================================
+// WARNINGS!!!
+//======================================================================
+
+// None.
+
+//======================================================================
+// FUNCTION DECLARATIONS
+//======================================================================
+
+// None.
+
+//=====================================================================
+// EXCEPTION CLASS DEFINITIONS
+//=====================================================================
+
+// None.
+
+//======================================================================
+// CLASS DEFINITIONS
+//======================================================================
+
+/*======================================================================
+CLASS:
+WebSocketProxy
+
+DESCRIPTION:
+A WebSocket server (port 81) that keeps a connection open to each 
+client, for the things HTTP is too slow for: dragging a color picker
+around, or streaming whole frames.  Each message is one small binary
+command, applied at the animator's next frame, and every client is 
+told whenever what is showing changes.  See the DOCUMENTATION section
+at the bottom of this file for the protocol.
+
+HOW TO USE:
+1. Construct with the animator to drive
+2. Call Begin() to start listening
+3. Call Process() as often as you can - it is what reads the 
+sockets, so it sets the latency
+
+======================================================================*/
+class WebSocketProxy
+{
+    public:
+
+    //=================================================================
+    // TYPE DECLARATIONS AND CONSTANTS    
+    //=================================================================
+
+    static const uint16_t DEFAULT_PORT = 81;
+
+    // Most often we tell the clients what changed
+    static const uint32_t NOTIFY_INTERVAL_MS = 50;
+
+    // Message types, the first byte of every binary message
+    enum Opcode
+    {
+        OP_COLOR = 0x01,
+        OP_BRIGHTNESS = 0x02,
+        OP_SPEED = 0x03,
+        OP_ANIMATION = 0x04,
+        OP_FRAME = 0x05,
+        OP_GET_STATE = 0x10,
+
+        // From us
+        OP_STATE = 0x80,
+        OP_ERROR = 0x81
+    };
+
+    // OP_FRAME flags
+    enum FrameFlags
+    {
+        FRAME_RGBW = 0x01,      // 4 bytes per pixel, not 3
+        FRAME_MORE = 0x02       // more of this frame coming, hold off
+    };
+
+    // OP_ANIMATION and OP_STATE animation for the demo
+    static const uint8_t ANIMATION_DEMO = 0xFF;
+
+    static const size_t STATE_SIZE = 10;
+
+    //=================================================================
+    // CLIENT INTERFACE
+    //=================================================================
+
+    WebSocketProxy( std::shared_ptr<LedAnimator> ledAnimator, uint16_t port = DEFAULT_PORT );
+
+    void Begin();
+
+    void Process();
+
+    uint32_t GetMessagesReceived() const { return _messagesReceived; }
+    uint32_t GetMessagesRejected() const { return _messagesRejected; }
+
+    protected:
+
+    //=================================================================
+    // SUBCLASS INTERFACE   
+    //=================================================================
+
+    // None.
+
+    private:
+
+    //=================================================================
+    // CUSTOMIZATION INTERFACE    
+    //=================================================================
+
+    // None.
+
+    //=================================================================
+    // IMPLEMENTATION INTERFACE    
+    //=================================================================
+
+    // No copying - intentionally not defining the implementation
+    // to throw a link error if someone somehow invokes a copy.
+    WebSocketProxy( const WebSocketProxy &rhs );
+
+    void onEvent( uint8_t client, WStype_t type, uint8_t *payload, size_t length );
+
+    // Returns false if the message is bad
+    bool handleBinary( uint8_t client, const uint8_t *payload, size_t length );
+    bool handleText( char *payload, size_t &badItem );
+
+    // Fills in an OP_STATE message
+    void buildState( uint8_t *buffer ) const;
+
+    void sendError( uint8_t client, uint8_t opcode, size_t item );
+
+    //=================================================================
+    // DATA MEMBERS    
+    //=================================================================
+
+    WebSocketsServer _server;
+
+    std::shared_ptr<LedAnimator> _ledAnimator;
+
+    // What we last told the clients, and when
+    uint8_t _lastState[STATE_SIZE];
+    uint32_t _lastNotifyMS;
+
+    uint32_t _messagesReceived;
+    uint32_t _messagesRejected;
+};
+
+//======================================================================
+// INLINE FUNCTION DEFINITIONS
+//======================================================================
+
+// None.
+
+
+/*======================================================================
+// DOCUMENTATION
+========================================================================
+
+Binary messages start with an opcode byte.  Numbers wider than a byte
+are little endian.
+
+From a client:
+
+    01 r g b [w]                    Color.  Recolors what is running
+                                    without restarting it.
+    02 level                        Brightness, 0..255
+    03 lo hi                        Speed, percent of normal, 0..1000
+    04 index [lo hi]                Start the animation at index in 
+                                    the /led/animations list (FF for 
+                                    the demo), with an optional 
+                                    transition in ms
+    05 flags lo hi pixels...        Live frame, starting at pixel 
+                                    lo hi.  r,g,b per pixel, or 
+                                    r,g,b,w with FRAME_RGBW.  Shown 
+                                    unless FRAME_MORE is set, so a big
+                                    frame can be sent in pieces.
+    10                              Send me the state
+
+Text messages are a /led/batch list (e.g. "animation=pulse&color=
+ff0000"), applied the same way.
+
+From us:
+
+    80 index color(4) level speed(2) flags
+                                    The state: animation index (FF 
+                                    for the demo), color wwrrggbb, 
+                                    brightness, speed, and flags (01 
+                                    demo, 02 showing live frames).  
+                                    Sent on connect, on request, and
+                                    whenever it changes.
+    81 opcode item                  That message was bad.  For a text
+                                    message the opcode is 00 and item
+                                    is the (1 based) one in the list 
+                                    that didn't parse, or 00 if they 
+                                    all did but don't go together.  
+                                    Item is 00 for a binary message.
+
+======================================================================*/
+
+#endif	// #ifendif _JAROFLIGHT_WEBSOCKETPROXY_H_
@@ -0,0 +1,436 @@
+/*======================================================================
+FILE:
+wifiproxy.cpp
+
+CREATOR:
+Sean Foley
+
+GENERAL DESCRIPTION:
+Non-blocking WiFi station connection management.
+
+PUBLIC CLASSES AND FUNCTIONS:
+WifiProxy
+
+INITIALIZATION AND SEQUENCING REQUIREMENTS:
+None.
+
+Copyright (C) 2017 Sean Foley  All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted.  Enjoy.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+======================================================================*/
+
+//======================================================================
+// INCLUDES AND VARIABLE DEFINITIONS
+//======================================================================
+
+//----------------------------------------------------------------------
+// Defines
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Include Files
+//----------------------------------------------------------------------
+
+#include <string.h>
+
+#include <functional>
+
+#include "wifiproxy.h"
+
+//----------------------------------------------------------------------
+// Type Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Constant Definitions
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Data Definitions
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Static Variable Definitions 
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Function Prototypes
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Required Libraries
+//----------------------------------------------------------------------
+
+// None. (Where supported these should be in the form
+// of C++ pragmas).
+
+//======================================================================
+// FUNCTION IMPLEMENTATIONS
+//======================================================================
+
+/*======================================================================
+FUNCTION:
+C-tor()
+
+DESCRIPTION:
+Constructs the proxy.  Nothing happens until Begin() is called.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+WifiProxy::WifiProxy( const char *ssid, const char *password )
+    : _ssid( ssid ), _password( password ), _state( STATE_IDLE ), _stateStartMS( 0 ),
+      _usingFastConnect( false ), _fastConnectGeneration( 0 ), _backoffMS( MIN_BACKOFF_MS ), 
+      _failures( 0 ), _lastConnectMS( 0 ), _gotIP( false ), _disconnected( false ),
+      _disconnectReason( WIFI_DISCONNECT_REASON_UNSPECIFIED )
+{
+    memset( &_fastConnect, 0, sizeof( _fastConnect ) );
+}
+
+/*======================================================================
+FUNCTION:
+Begin()
+
+DESCRIPTION:
+Sets up the station, hooks the WiFi events and starts the first 
+connect.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void WifiProxy::Begin()
+{
+    WiFi.persistent( false );
+    WiFi.mode( WIFI_STA );
+
+    // We do our own reconnecting, with backoff
+    WiFi.setAutoReconnect( false );
+
+    _gotIPHandler = WiFi.onStationModeGotIP( 
+        std::bind( &WifiProxy::onGotIP, this, std::placeholders::_1 ) );
+
+    _disconnectedHandler = WiFi.onStationModeDisconnected( 
+        std::bind( &WifiProxy::onDisconnected, this, std::placeholders::_1 ) );
+
+    startConnect();
+}
+
+/*======================================================================
+FUNCTION:
+Process()
+
+DESCRIPTION:
+Runs the state machine.  The WiFi events only set flags; this is where
+we act on them, and where the timeouts and backoff are handled.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void WifiProxy::Process()
+{
+    unsigned long elapsed = millis() - _stateStartMS;
+
+    switch ( _state )
+    {
+        case STATE_IDLE:
+            break;
+
+        case STATE_CONNECTING:
+        {
+            uint32_t timeout = _usingFastConnect ? FAST_CONNECT_TIMEOUT_MS : CONNECT_TIMEOUT_MS;
+
+            if ( _gotIP == true )
+            {
+                connected();
+            }
+            else if ( ( _disconnected == true && isFatal( _disconnectReason ) == true ) || 
+                      elapsed >= timeout )
+            {
+                failed();
+            }
+        }
+        break;
+
+        case STATE_CONNECTED:
+
+            if ( _disconnected == true )
+            {
+                Serial.println( "WifiProxy: connection lost, reconnecting" );
+
+                // Straight back in, the fast path should 
+                // still be good
+                startConnect();
+            }
+            break;
+
+        case STATE_BACKOFF:
+
+            if ( elapsed >= _backoffMS )
+            {
+                _backoffMS = ( _backoffMS * 2 > MAX_BACKOFF_MS ) ? MAX_BACKOFF_MS : _backoffMS * 2;
+
+                startConnect();
+            }
+            break;
+    }
+}
+
+/*======================================================================
+FUNCTION:
+startConnect()
+
+DESCRIPTION:
+Kicks off a connect.  If we have a fast connect record we go straight
+to the access point on its channel with our old IP address, otherwise
+it is a normal scan + DHCP connect.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void WifiProxy::startConnect()
+{
+    _gotIP = false;
+    _disconnected = false;
+
+    _usingFastConnect = _fastConnect.valid;
+
+    if ( _usingFastConnect == true )
+    {
+        WiFi.config( IPAddress( _fastConnect.ip ), 
+                     IPAddress( _fastConnect.gateway ),
+                     IPAddress( _fastConnect.subnet ),
+                     IPAddress( _fastConnect.dns ) );
+
+        WiFi.begin( _ssid, _password, _fastConnect.channel, _fastConnect.bssid );
+    }
+    else
+    {
+        // All zeros puts us back on DHCP
+        WiFi.config( IPAddress( 0, 0, 0, 0 ), IPAddress( 0, 0, 0, 0 ), IPAddress( 0, 0, 0, 0 ) );
+
+        WiFi.begin( _ssid, _password );
+    }
+
+    _state = STATE_CONNECTING;
+    _stateStartMS = millis();
+}
+
+/*======================================================================
+FUNCTION:
+connected()
+
+DESCRIPTION:
+We have an IP address.  Remember everything we need to get back here
+quickly next time.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void WifiProxy::connected()
+{
+    _lastConnectMS = millis() - _stateStartMS;
+
+    Serial.printf( "WifiProxy: connected to %s in %lums (%s), ip address %s\n",
+                   _ssid,
+                   (unsigned long) _lastConnectMS,
+                   _usingFastConnect ? "fast" : "normal",
+                   WiFi.localIP().toString().c_str() );
+
+    // Zeroed first so the padding compares equal too
+    FastConnect fastConnect;
+    memset( &fastConnect, 0, sizeof( fastConnect ) );
+
+    fastConnect.valid = true;
+    memcpy( fastConnect.bssid, WiFi.BSSID(), sizeof( fastConnect.bssid ) );
+    fastConnect.channel = WiFi.channel();
+    fastConnect.ip = WiFi.localIP();
+    fastConnect.gateway = WiFi.gatewayIP();
+    fastConnect.subnet = WiFi.subnetMask();
+    fastConnect.dns = WiFi.dnsIP();
+
+    if ( memcmp( &fastConnect, &_fastConnect, sizeof( fastConnect ) ) != 0 )
+    {
+        _fastConnect = fastConnect;
+        _fastConnectGeneration++;
+    }
+
+    _failures = 0;
+    _backoffMS = MIN_BACKOFF_MS;
+
+    _state = STATE_CONNECTED;
+    _stateStartMS = millis();
+}
+
+/*======================================================================
+FUNCTION:
+failed()
+
+DESCRIPTION:
+The connect didn't work.  If it was the fast path, the access point 
+may have moved channels or the lease may be gone, so we drop the fast
+connect record and try a normal connect right away.  Otherwise we 
+back off before trying again.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void WifiProxy::failed()
+{
+    WiFi.disconnect();
+
+    _failures++;
+
+    if ( _usingFastConnect == true )
+    {
+        Serial.println( "WifiProxy: fast connect failed, falling back to a normal connect" );
+
+        _fastConnect.valid = false;
+        _fastConnectGeneration++;
+
+        startConnect();
+        return;
+    }
+
+    Serial.printf( "WifiProxy: connect failed, retrying in %lums\n", (unsigned long) _backoffMS );
+
+    _state = STATE_BACKOFF;
+    _stateStartMS = millis();
+}
+
+/*======================================================================
+FUNCTION:
+onGotIP()
+
+DESCRIPTION:
+WiFi event handler for getting an IP address.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void WifiProxy::onGotIP( const WiFiEventStationModeGotIP &event )
+{
+    (void) event;
+
+    _gotIP = true;
+}
+
+/*======================================================================
+FUNCTION:
+onDisconnected()
+
+DESCRIPTION:
+WiFi event handler for losing (or failing to make) a connection.
+
+RETURN VALUE:
+none.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+void WifiProxy::onDisconnected( const WiFiEventStationModeDisconnected &event )
+{
+    // That's us leaving, from failed() (or WiFi.begin() leaving the 
+    // old access point), not the connection going away
+    if ( event.reason == WIFI_DISCONNECT_REASON_ASSOC_LEAVE )
+    {
+        return;
+    }
+
+    _disconnectReason = event.reason;
+    _disconnected = true;
+}
+
+/*======================================================================
+FUNCTION:
+isFatal()
+
+DESCRIPTION:
+Sorts the reasons a connect attempt can be turned down.  The access 
+point not being there, or not taking our password, won't change by 
+waiting.  Anything else (a timed out handshake, a lost beacon) the 
+SDK tries again on its own.
+
+RETURN VALUE:
+true if the connect should be given up on now.
+
+SIDE EFFECTS:
+none
+
+======================================================================*/
+bool WifiProxy::isFatal( WiFiDisconnectReason reason )
+{
+    switch ( reason )
+    {
+        case WIFI_DISCONNECT_REASON_NO_AP_FOUND:
+        case WIFI_DISCONNECT_REASON_AUTH_FAIL:
+        case WIFI_DISCONNECT_REASON_ASSOC_FAIL:
+
+            return true;
+
+        default:
+
+            return false;
+    }
+}
+
+/*=====================================================================
+// IMPLEMENTATION NOTES
+//=====================================================================
+
+None
+
+=====================================================================*/
@@ -0,0 +1,273 @@
+#ifndef _JAROFLIGHT_WIFIPROXY_H_
+#define _JAROFLIGHT_WIFIPROXY_H_
+
+/*======================================================================
+FILE:
+wifiproxy.h
+
+CREATOR:
+Sean Foley
+
+DESCRIPTION:
+Non-blocking WiFi station connection management.
+
+PUBLIC CLASSES AND FUNCTIONS:
+WifiProxy
+
+Copyright (C) 2017 Sean Foley  All Rights Reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted.  Enjoy.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+======================================================================*/
+
+//======================================================================
+// INCLUDES AND PUBLIC DATA DECLARATIONS
+//======================================================================
+
+//----------------------------------------------------------------------
+// Defines
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Include Files
+//----------------------------------------------------------------------
+
+#include <stdint.h>
+
+#include <ESP8266WiFi.h>
+
+//----------------------------------------------------------------------
+// Type Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Constant Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//----------------------------------------------------------------------
+// Global Data Declarations
+//----------------------------------------------------------------------
+
+// None.
+
+//======================================================================
+// WARNINGS!!!
+//======================================================================
+
+// None.
+
+//======================================================================
+// FUNCTION DECLARATIONS
+//======================================================================
+
+// None.
+
+//=====================================================================
+// EXCEPTION CLASS DEFINITIONS
+//=====================================================================
+
+// None.
+
+//======================================================================
+// CLASS DEFINITIONS
+//======================================================================
+
+/*======================================================================
+CLASS:
+WifiProxy
+
+DESCRIPTION:
+Hides the WiFi station connection behind a small state machine.  
+Nothing in here waits on the network: Process() looks at what the 
+WiFi events told us and moves things along, so the rest of the 
+program (the animations in particular) keeps running while we 
+connect, reconnect, or sit out a missing access point.
+
+After the first connection, the access point's BSSID and channel and
+our DHCP lease are cached.  Reconnects use them to skip the scan and
+DHCP, which takes a connect from seconds down to a few hundred 
+milliseconds.  If the fast path fails once, we fall back to a normal
+connect.
+
+Failed connects back off exponentially, so a missing access point 
+doesn't have us hammering the radio.
+
+While connecting, the SDK retries on its own and reports a disconnect
+for every try that doesn't pan out.  Only the ones that mean it won't
+ever work (a bad password, no such access point) end a connect early,
+the rest are left to the timeout.  Our own WiFi.disconnect() comes 
+back as an event too, usually after the next connect has started, so
+it is ignored.
+
+HOW TO USE:
+1. Construct with the SSID and password
+2. Optionally SetFastConnect() with a cached record (see 
+SettingsStore)
+3. Call Begin() to start connecting
+4. Call Process() periodically, and check IsConnected()
+
+======================================================================*/
+class WifiProxy
+{
+    public:
+
+    //=================================================================
+    // TYPE DECLARATIONS AND CONSTANTS    
+    //=================================================================
+
+    enum State
+    {
+        STATE_IDLE = 0,
+        STATE_CONNECTING,
+        STATE_CONNECTED,
+        STATE_BACKOFF
+    };
+
+    // Everything we need to reconnect without a scan or DHCP
+    struct FastConnect
+    {
+        bool valid;
+        uint8_t bssid[6];
+        int32_t channel;
+        uint32_t ip;
+        uint32_t gateway;
+        uint32_t subnet;
+        uint32_t dns;
+    };
+
+    // How long we give a connect before calling it failed.  The fast
+    // path either works right away or not at all.
+    static const uint32_t CONNECT_TIMEOUT_MS = 15000;
+    static const uint32_t FAST_CONNECT_TIMEOUT_MS = 3000;
+
+    // Backoff after a failed connect, doubling each time
+    static const uint32_t MIN_BACKOFF_MS = 1000;
+    static const uint32_t MAX_BACKOFF_MS = 60000;
+
+    //=================================================================
+    // CLIENT INTERFACE
+    //=================================================================
+
+    WifiProxy( const char *ssid, const char *password );
+
+    // Starts connecting.  Doesn't wait.
+    void Begin();
+
+    // Moves the state machine along.  Cheap, call it often.
+    void Process();
+
+    bool IsConnected() const { return _state == STATE_CONNECTED; }
+    State GetState() const { return _state; }
+
+    // Cached connection details, so they can be saved and handed
+    // back after a reboot
+    const FastConnect &GetFastConnect() const { return _fastConnect; }
+    void SetFastConnect( const FastConnect &fastConnect ) { _fastConnect = fastConnect; }
+
+    // Bumped every time the fast connect record changes
+    uint32_t GetFastConnectGeneration() const { return _fastConnectGeneration; }
+
+    // How long the last successful connect took, and how many
+    // connects in a row have failed
+    uint32_t GetLastConnectMS() const { return _lastConnectMS; }
+    uint32_t GetFailures() const { return _failures; }
+
+    protected:
+
+    //=================================================================
+    // SUBCLASS INTERFACE   
+    //=================================================================
+
+    // None.
+
+    private:
+
+    //=================================================================
+    // CUSTOMIZATION INTERFACE    
+    //=================================================================
+
+    // None.
+
+    //=================================================================
+    // IMPLEMENTATION INTERFACE    
+    //=================================================================
+
+    // No copying - intentionally not defining the implementation
+    // to throw a link error if someone somehow invokes a copy.
+    WifiProxy( const WifiProxy &rhs );
+
+    void startConnect();
+    void connected();
+    void failed();
+
+    void onGotIP( const WiFiEventStationModeGotIP &event );
+    void onDisconnected( const WiFiEventStationModeDisconnected &event );
+
+    // True for a disconnect reason that means the connect is not
+    // going to work, however long we give it
+    static bool isFatal( WiFiDisconnectReason reason );
+
+    //=================================================================
+    // DATA MEMBERS    
+    //=================================================================
+
+    const char *_ssid;
+    const char *_password;
+
+    State _state;
+
+    // millis() when we entered the current state
+    unsigned long _stateStartMS;
+
+    bool _usingFastConnect;
+    FastConnect _fastConnect;
+    uint32_t _fastConnectGeneration;
+
+    uint32_t _backoffMS;
+    uint32_t _failures;
+    uint32_t _lastConnectMS;
+
+    // Set by the WiFi event handlers, picked up by Process()
+    volatile bool _gotIP;
+    volatile bool _disconnected;
+    volatile WiFiDisconnectReason _disconnectReason;
+
+    // Keep the event handlers registered for as long as we live
+    WiFiEventHandler _gotIPHandler;
+    WiFiEventHandler _disconnectedHandler;
+};
+
+//======================================================================
+// INLINE FUNCTION DEFINITIONS
+//======================================================================
+
+// None.
+
+
+/*======================================================================
+// DOCUMENTATION
+========================================================================
+
+None.
+
+======================================================================*/
+
+#endif	// #ifendif _JAROFLIGHT_WIFIPROXY_H_